@@ -48,6 +48,8 @@ static gboolean ovirt_action_rest_call_class_serialize_params(RestProxyCall *cal
     g_return_val_if_fail(content != NULL, FALSE);
     g_return_val_if_fail(content_len != NULL, FALSE);
 
+    ovirt_rest_call_discard_cached_responses(call);
+
     params = rest_proxy_call_get_params(call);
     if (!rest_params_are_strings(params)) {
         g_set_error(error, OVIRT_REST_CALL_ERROR, 0,
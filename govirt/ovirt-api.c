@@ -23,6 +23,8 @@
 
 #include <config.h>
 
+#include <glib/gi18n-lib.h>
+
 #include "ovirt-enum-types.h"
 #include "ovirt-error.h"
 #include "ovirt-proxy.h"
@@ -380,3 +382,204 @@ OvirtCollection *ovirt_api_search_data_centers(OvirtApi *api, const char *query)
                                                          "data_center",
                                                          query);
 }
+
+
+static const struct {
+    const char *name;
+    OvirtCollection *(*get)(OvirtApi *api);
+} ovirt_api_collections[] = {
+    { "clusters", ovirt_api_get_clusters },
+    { "datacenters", ovirt_api_get_data_centers },
+    { "hosts", ovirt_api_get_hosts },
+    { "storagedomains", ovirt_api_get_storage_domains },
+    { "vms", ovirt_api_get_vms },
+    { "vmpools", ovirt_api_get_vm_pools },
+};
+
+typedef struct {
+    OvirtProxy *proxy;
+    guint max_in_flight;
+    guint in_flight;
+    /* Index in ovirt_api_collections of the next collection to fetch */
+    guint next;
+    /* collection name -> GError */
+    GHashTable *errors;
+} OvirtApiFetchCollectionsData;
+
+typedef struct {
+    GTask *task;
+    const char *name;
+} OvirtApiFetchCollectionData;
+
+static void
+ovirt_api_fetch_collections_data_free(OvirtApiFetchCollectionsData *data)
+{
+    g_clear_object(&data->proxy);
+    g_clear_pointer(&data->errors, g_hash_table_unref);
+    g_slice_free(OvirtApiFetchCollectionsData, data);
+}
+
+static void ovirt_api_fetch_next_collections(GTask *task);
+
+static void ovirt_api_fetch_collection_cb(GObject *source_object,
+                                          GAsyncResult *result,
+                                          gpointer user_data)
+{
+    OvirtApiFetchCollectionData *collection_data = user_data;
+    OvirtApiFetchCollectionsData *data;
+    GError *error = NULL;
+
+    data = g_task_get_task_data(collection_data->task);
+    data->in_flight--;
+    if (!ovirt_collection_fetch_finish(OVIRT_COLLECTION(source_object),
+                                       result, &error)) {
+        g_hash_table_insert(data->errors,
+                            (gpointer)collection_data->name, error);
+    }
+
+    ovirt_api_fetch_next_collections(collection_data->task);
+    g_slice_free(OvirtApiFetchCollectionData, collection_data);
+}
+
+/* Starts fetching collections until there are max_in_flight fetches in
+ * flight, and completes @task once all of them are done. Takes ownership
+ * of a reference on @task.
+ */
+static void ovirt_api_fetch_next_collections(GTask *task)
+{
+    OvirtApi *api = OVIRT_API(g_task_get_source_object(task));
+    OvirtApiFetchCollectionsData *data = g_task_get_task_data(task);
+
+    while (data->next < G_N_ELEMENTS(ovirt_api_collections) &&
+           ((data->max_in_flight == 0) || (data->in_flight < data->max_in_flight))) {
+        OvirtApiFetchCollectionData *collection_data;
+        OvirtCollection *collection;
+
+        collection = ovirt_api_collections[data->next].get(api);
+        if (collection == NULL) {
+            /* Not advertised by the server */
+            data->next++;
+            continue;
+        }
+
+        collection_data = g_slice_new0(OvirtApiFetchCollectionData);
+        collection_data->task = g_object_ref(task);
+        collection_data->name = ovirt_api_collections[data->next].name;
+        data->next++;
+        data->in_flight++;
+        ovirt_collection_fetch_async(collection, data->proxy,
+                                     g_task_get_cancellable(task),
+                                     ovirt_api_fetch_collection_cb,
+                                     collection_data);
+    }
+
+    if ((data->in_flight == 0) && (data->next == G_N_ELEMENTS(ovirt_api_collections))) {
+        if (g_task_return_error_if_cancelled(task)) {
+            /* Nothing to do */
+        } else if (g_hash_table_size(data->errors) != 0) {
+            GList *names;
+            GString *names_str;
+            GList *it;
+
+            names = g_list_sort(g_hash_table_get_keys(data->errors),
+                                (GCompareFunc)strcmp);
+            names_str = g_string_new(NULL);
+            for (it = names; it != NULL; it = it->next) {
+                if (it != names) {
+                    g_string_append(names_str, ", ");
+                }
+                g_string_append(names_str, it->data);
+            }
+            g_task_return_new_error(task, OVIRT_ERROR, OVIRT_ERROR_FAILED,
+                                    _("Failed to fetch collections: %s"),
+                                    names_str->str);
+            g_string_free(names_str, TRUE);
+            g_list_free(names);
+        } else {
+            g_task_return_boolean(task, TRUE);
+        }
+    }
+    g_object_unref(task);
+}
+
+
+/**
+ * ovirt_api_fetch_collections_async:
+ * @api: a #OvirtApi
+ * @proxy: a #OvirtProxy
+ * @max_in_flight: maximum number of collections being fetched at the same
+ * time, or 0 for no limit
+ * @cancellable: (allow-none): a #GCancellable
+ * @callback: (scope async): completion callback
+ * @user_data: (closure): opaque data for callback
+ *
+ * Fetches all the top-level collections of @api (clusters, data centers,
+ * hosts, storage domains, VMs and VM pools) concurrently. Each collection
+ * is parsed as soon as its content has been received. Collections which
+ * are not advertised by the server are skipped.
+ *
+ * Since: 0.3.12
+ */
+void ovirt_api_fetch_collections_async(OvirtApi *api,
+                                       OvirtProxy *proxy,
+                                       guint max_in_flight,
+                                       GCancellable *cancellable,
+                                       GAsyncReadyCallback callback,
+                                       gpointer user_data)
+{
+    OvirtApiFetchCollectionsData *data;
+    GTask *task;
+
+    g_return_if_fail(OVIRT_IS_API(api));
+    g_return_if_fail(OVIRT_IS_PROXY(proxy));
+    g_return_if_fail((cancellable == NULL) || G_IS_CANCELLABLE(cancellable));
+
+    task = g_task_new(G_OBJECT(api), cancellable, callback, user_data);
+    data = g_slice_new0(OvirtApiFetchCollectionsData);
+    data->proxy = g_object_ref(proxy);
+    data->max_in_flight = max_in_flight;
+    data->errors = g_hash_table_new_full(g_str_hash, g_str_equal,
+                                         NULL, (GDestroyNotify)g_error_free);
+    g_task_set_task_data(task, data,
+                         (GDestroyNotify)ovirt_api_fetch_collections_data_free);
+
+    ovirt_api_fetch_next_collections(task);
+}
+
+
+/**
+ * ovirt_api_fetch_collections_finish:
+ * @api: a #OvirtApi
+ * @result: async method result
+ * @errors: (out) (optional) (element-type utf8 GError) (transfer full):
+ * return location for a hash table mapping the names of the collections
+ * which could not be fetched ("clusters", "datacenters", "hosts",
+ * "storagedomains", "vms" or "vmpools") to the corresponding error, or
+ * NULL if all collections were fetched
+ * @err: #GError to set on error, or NULL
+ *
+ * Return value: TRUE if all collections were successfully fetched, FALSE
+ * otherwise, with @err set.
+ *
+ * Since: 0.3.12
+ */
+gboolean ovirt_api_fetch_collections_finish(OvirtApi *api,
+                                            GAsyncResult *result,
+                                            GHashTable **errors,
+                                            GError **err)
+{
+    OvirtApiFetchCollectionsData *data;
+
+    g_return_val_if_fail(OVIRT_IS_API(api), FALSE);
+    g_return_val_if_fail(g_task_is_valid(G_TASK(result), api), FALSE);
+
+    data = g_task_get_task_data(G_TASK(result));
+    if (errors != NULL) {
+        *errors = NULL;
+        if (g_hash_table_size(data->errors) != 0) {
+            *errors = g_hash_table_ref(data->errors);
+        }
+    }
+
+    return g_task_propagate_boolean(G_TASK(result), err);
+}
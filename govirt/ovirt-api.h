@@ -73,6 +73,17 @@ OvirtCollection *ovirt_api_search_vms(OvirtApi *api, const char *query);
 OvirtCollection *ovirt_api_get_vm_pools(OvirtApi *api);
 OvirtCollection *ovirt_api_search_vm_pools(OvirtApi *api, const char *query);
 
+void ovirt_api_fetch_collections_async(OvirtApi *api,
+                                       OvirtProxy *proxy,
+                                       guint max_in_flight,
+                                       GCancellable *cancellable,
+                                       GAsyncReadyCallback callback,
+                                       gpointer user_data);
+gboolean ovirt_api_fetch_collections_finish(OvirtApi *api,
+                                            GAsyncResult *result,
+                                            GHashTable **errors,
+                                            GError **err);
+
 G_END_DECLS
 
 #endif /* __OVIRT_API_H__ */
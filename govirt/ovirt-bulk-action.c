@@ -0,0 +1,451 @@
+/*
+ * ovirt-bulk-action.c: run an action on many oVirt resources
+ *
+ * Copyright (C) 2026 Red Hat, Inc.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library. If not, see
+ * <http://www.gnu.org/licenses/>.
+ */
+
+#include <config.h>
+
+#include <glib/gi18n-lib.h>
+
+#include "ovirt-bulk-action.h"
+#include "ovirt-error.h"
+#include "govirt-private.h"
+
+/**
+ * SECTION:ovirt-bulk-action
+ * @short_description: run an action on many resources
+ *
+ * #OvirtBulkAction runs the same action ("start", "stop", "ticket", ...) on
+ * a set of resources. At most #OvirtBulkAction:window actions are sent to
+ * the server at the same time, the next one being sent as soon as one of
+ * them completes. The #OvirtBulkAction::progress signal is emitted each
+ * time an action completes.
+ */
+
+struct _OvirtBulkActionPrivate {
+    OvirtProxy *proxy;
+    char *action;
+    guint window;
+    gboolean stop_on_error;
+};
+
+G_DEFINE_TYPE_WITH_PRIVATE(OvirtBulkAction, ovirt_bulk_action, G_TYPE_OBJECT);
+
+
+enum {
+    PROP_0,
+    PROP_PROXY,
+    PROP_ACTION,
+    PROP_WINDOW,
+    PROP_STOP_ON_ERROR,
+};
+
+enum {
+    PROGRESS,
+    LAST_SIGNAL
+};
+
+static guint signals[LAST_SIGNAL];
+
+
+static void ovirt_bulk_action_get_property(GObject *object,
+                                           guint prop_id,
+                                           GValue *value,
+                                           GParamSpec *pspec)
+{
+    OvirtBulkAction *bulk = OVIRT_BULK_ACTION(object);
+
+    switch (prop_id) {
+    case PROP_PROXY:
+        g_value_set_object(value, bulk->priv->proxy);
+        break;
+    case PROP_ACTION:
+        g_value_set_string(value, bulk->priv->action);
+        break;
+    case PROP_WINDOW:
+        g_value_set_uint(value, bulk->priv->window);
+        break;
+    case PROP_STOP_ON_ERROR:
+        g_value_set_boolean(value, bulk->priv->stop_on_error);
+        break;
+    default:
+        G_OBJECT_WARN_INVALID_PROPERTY_ID(object, prop_id, pspec);
+        break;
+    }
+}
+
+
+static void ovirt_bulk_action_set_property(GObject *object,
+                                           guint prop_id,
+                                           const GValue *value,
+                                           GParamSpec *pspec)
+{
+    OvirtBulkAction *bulk = OVIRT_BULK_ACTION(object);
+
+    switch (prop_id) {
+    case PROP_PROXY:
+        bulk->priv->proxy = g_value_dup_object(value);
+        break;
+    case PROP_ACTION:
+        bulk->priv->action = g_value_dup_string(value);
+        break;
+    case PROP_WINDOW:
+        bulk->priv->window = g_value_get_uint(value);
+        break;
+    case PROP_STOP_ON_ERROR:
+        bulk->priv->stop_on_error = g_value_get_boolean(value);
+        break;
+    default:
+        G_OBJECT_WARN_INVALID_PROPERTY_ID(object, prop_id, pspec);
+        break;
+    }
+}
+
+
+static void ovirt_bulk_action_dispose(GObject *object)
+{
+    OvirtBulkAction *bulk = OVIRT_BULK_ACTION(object);
+
+    g_clear_object(&bulk->priv->proxy);
+
+    G_OBJECT_CLASS(ovirt_bulk_action_parent_class)->dispose(object);
+}
+
+
+static void ovirt_bulk_action_finalize(GObject *object)
+{
+    OvirtBulkAction *bulk = OVIRT_BULK_ACTION(object);
+
+    g_free(bulk->priv->action);
+
+    G_OBJECT_CLASS(ovirt_bulk_action_parent_class)->finalize(object);
+}
+
+
+static void ovirt_bulk_action_class_init(OvirtBulkActionClass *klass)
+{
+    GObjectClass *object_class = G_OBJECT_CLASS(klass);
+    GParamSpec *param_spec;
+
+    object_class->dispose = ovirt_bulk_action_dispose;
+    object_class->finalize = ovirt_bulk_action_finalize;
+    object_class->get_property = ovirt_bulk_action_get_property;
+    object_class->set_property = ovirt_bulk_action_set_property;
+
+    param_spec = g_param_spec_object("proxy",
+                                     "Proxy",
+                                     "Proxy used to send the actions",
+                                     OVIRT_TYPE_PROXY,
+                                     G_PARAM_READWRITE |
+                                     G_PARAM_CONSTRUCT_ONLY |
+                                     G_PARAM_STATIC_STRINGS);
+    g_object_class_install_property(object_class,
+                                    PROP_PROXY,
+                                    param_spec);
+
+    param_spec = g_param_spec_string("action",
+                                     "Action",
+                                     "Name of the action to run",
+                                     NULL,
+                                     G_PARAM_READWRITE |
+                                     G_PARAM_CONSTRUCT_ONLY |
+                                     G_PARAM_STATIC_STRINGS);
+    g_object_class_install_property(object_class,
+                                    PROP_ACTION,
+                                    param_spec);
+
+    param_spec = g_param_spec_uint("window",
+                                   "Window",
+                                   "Maximum number of actions sent at the same time",
+                                   1, G_MAXUINT,
+                                   8,
+                                   G_PARAM_READWRITE |
+                                   G_PARAM_CONSTRUCT |
+                                   G_PARAM_STATIC_STRINGS);
+    g_object_class_install_property(object_class,
+                                    PROP_WINDOW,
+                                    param_spec);
+
+    param_spec = g_param_spec_boolean("stop-on-error",
+                                      "Stop on error",
+                                      "Whether to stop sending actions after the first failure",
+                                      FALSE,
+                                      G_PARAM_READWRITE |
+                                      G_PARAM_STATIC_STRINGS);
+    g_object_class_install_property(object_class,
+                                    PROP_STOP_ON_ERROR,
+                                    param_spec);
+
+    /**
+     * OvirtBulkAction::progress:
+     * @bulk: the #OvirtBulkAction
+     * @resource: the #OvirtResource the action was run on
+     * @error: (allow-none): the #GError describing why the action failed,
+     * or NULL if it succeeded
+     * @completed: number of actions which completed so far
+     * @total: total number of resources
+     *
+     * Emitted each time an action completes.
+     *
+     * Since: 0.3.12
+     */
+    signals[PROGRESS] = g_signal_new("progress",
+                                     OVIRT_TYPE_BULK_ACTION,
+                                     G_SIGNAL_RUN_LAST,
+                                     0, NULL, NULL, NULL,
+                                     G_TYPE_NONE, 4,
+                                     OVIRT_TYPE_RESOURCE,
+                                     G_TYPE_ERROR,
+                                     G_TYPE_UINT,
+                                     G_TYPE_UINT);
+}
+
+
+static void ovirt_bulk_action_init(OvirtBulkAction *bulk)
+{
+    bulk->priv = ovirt_bulk_action_get_instance_private(bulk);
+}
+
+
+/**
+ * ovirt_bulk_action_new:
+ * @proxy: a #OvirtProxy
+ * @action: name of the action to run
+ *
+ * Return value: (transfer full): a new #OvirtBulkAction running @action
+ *
+ * Since: 0.3.12
+ */
+OvirtBulkAction *ovirt_bulk_action_new(OvirtProxy *proxy, const char *action)
+{
+    g_return_val_if_fail(OVIRT_IS_PROXY(proxy), NULL);
+    g_return_val_if_fail(action != NULL, NULL);
+
+    return OVIRT_BULK_ACTION(g_object_new(OVIRT_TYPE_BULK_ACTION,
+                                          "proxy", proxy,
+                                          "action", action,
+                                          NULL));
+}
+
+
+typedef struct {
+    GPtrArray *resources;
+    /* Index in @resources of the next resource to run the action on */
+    guint next;
+    guint in_flight;
+    guint completed;
+    guint failed;
+    /* OvirtResource -> GError, NULL on success */
+    GHashTable *results;
+} OvirtBulkActionRun;
+
+static void ovirt_bulk_action_run_free(OvirtBulkActionRun *run)
+{
+    g_clear_pointer(&run->resources, g_ptr_array_unref);
+    g_clear_pointer(&run->results, g_hash_table_unref);
+    g_slice_free(OvirtBulkActionRun, run);
+}
+
+static void ovirt_bulk_action_error_free(gpointer error)
+{
+    if (error != NULL) {
+        g_error_free(error);
+    }
+}
+
+
+static void ovirt_bulk_action_complete(GTask *task,
+                                       OvirtResource *resource,
+                                       GError *error)
+{
+    OvirtBulkAction *bulk = OVIRT_BULK_ACTION(g_task_get_source_object(task));
+    OvirtBulkActionRun *run = g_task_get_task_data(task);
+
+    run->completed++;
+    if (error != NULL) {
+        run->failed++;
+    }
+    g_hash_table_insert(run->results, g_object_ref(resource), error);
+    g_signal_emit(bulk, signals[PROGRESS], 0, resource, error,
+                  run->completed, run->resources->len);
+}
+
+
+static void ovirt_bulk_action_run_next(GTask *task);
+
+static void ovirt_bulk_action_cb(GObject *source_object,
+                                 GAsyncResult *result,
+                                 gpointer user_data)
+{
+    GTask *task = G_TASK(user_data);
+    OvirtBulkAction *bulk = OVIRT_BULK_ACTION(g_task_get_source_object(task));
+    OvirtBulkActionRun *run = g_task_get_task_data(task);
+    OvirtResource *resource = OVIRT_RESOURCE(source_object);
+    GError *error = NULL;
+
+    run->in_flight--;
+    if (!ovirt_resource_action_finish(resource, result, &error) &&
+        (error == NULL)) {
+        error = g_error_new(OVIRT_ERROR, OVIRT_ERROR_ACTION_FAILED,
+                            _("Action '%s' failed"), bulk->priv->action);
+    }
+    ovirt_bulk_action_complete(task, resource, error);
+
+    ovirt_bulk_action_run_next(task);
+}
+
+
+/* Sends actions until there are 'window' of them in flight, and completes
+ * @task once they are all done. Takes ownership of a reference on @task.
+ */
+static void ovirt_bulk_action_run_next(GTask *task)
+{
+    OvirtBulkAction *bulk = OVIRT_BULK_ACTION(g_task_get_source_object(task));
+    OvirtBulkActionPrivate *priv = bulk->priv;
+    OvirtBulkActionRun *run = g_task_get_task_data(task);
+    GCancellable *cancellable = g_task_get_cancellable(task);
+    gboolean stopped = FALSE;
+
+    while (run->next < run->resources->len) {
+        OvirtResource *resource;
+        ActionResponseParser parser = NULL;
+
+        stopped = g_cancellable_is_cancelled(cancellable) ||
+                  (priv->stop_on_error && (run->failed != 0));
+        if (stopped || (run->in_flight >= priv->window)) {
+            break;
+        }
+
+        resource = g_ptr_array_index(run->resources, run->next);
+        run->next++;
+        if (ovirt_resource_get_action(resource, priv->action) == NULL) {
+            ovirt_bulk_action_complete(task, resource,
+                                       g_error_new(OVIRT_ERROR,
+                                                   OVIRT_ERROR_NOT_SUPPORTED,
+                                                   _("Action '%s' is not available for this resource"),
+                                                   priv->action));
+            continue;
+        }
+
+        if (OVIRT_IS_VM(resource)) {
+            parser = ovirt_vm_get_action_response_parser(priv->action);
+        }
+        run->in_flight++;
+        ovirt_resource_invoke_action_async(resource, priv->action,
+                                           priv->proxy, parser,
+                                           cancellable,
+                                           ovirt_bulk_action_cb,
+                                           g_object_ref(task));
+    }
+
+    if ((run->in_flight == 0) &&
+        (stopped || (run->next == run->resources->len))) {
+        if (g_task_return_error_if_cancelled(task)) {
+            /* Nothing to do */
+        } else if (run->failed != 0) {
+            g_task_return_new_error(task, OVIRT_ERROR, OVIRT_ERROR_ACTION_FAILED,
+                                    _("Action '%s' failed for %u of %u resources"),
+                                    priv->action, run->failed,
+                                    run->resources->len);
+        } else {
+            g_task_return_boolean(task, TRUE);
+        }
+    }
+    g_object_unref(task);
+}
+
+
+/**
+ * ovirt_bulk_action_run_async:
+ * @bulk: a #OvirtBulkAction
+ * @resources: (element-type OvirtResource): resources to run the action on
+ * @cancellable: (allow-none): a #GCancellable
+ * @callback: (scope async): completion callback
+ * @user_data: (closure): opaque data for callback
+ *
+ * Runs the action on all @resources, in order. When
+ * #OvirtBulkAction:stop-on-error is set, no new action is sent once one of
+ * them failed. The same happens when @cancellable is cancelled.
+ *
+ * Since: 0.3.12
+ */
+void ovirt_bulk_action_run_async(OvirtBulkAction *bulk,
+                                 GList *resources,
+                                 GCancellable *cancellable,
+                                 GAsyncReadyCallback callback,
+                                 gpointer user_data)
+{
+    OvirtBulkActionRun *run;
+    GTask *task;
+    GList *it;
+
+    g_return_if_fail(OVIRT_IS_BULK_ACTION(bulk));
+    g_return_if_fail((cancellable == NULL) || G_IS_CANCELLABLE(cancellable));
+    for (it = resources; it != NULL; it = it->next) {
+        g_return_if_fail(OVIRT_IS_RESOURCE(it->data));
+    }
+
+    task = g_task_new(G_OBJECT(bulk), cancellable, callback, user_data);
+    run = g_slice_new0(OvirtBulkActionRun);
+    run->resources = g_ptr_array_new_with_free_func(g_object_unref);
+    for (it = resources; it != NULL; it = it->next) {
+        g_ptr_array_add(run->resources, g_object_ref(it->data));
+    }
+    run->results = g_hash_table_new_full(g_direct_hash, g_direct_equal,
+                                         g_object_unref,
+                                         ovirt_bulk_action_error_free);
+    g_task_set_task_data(task, run,
+                         (GDestroyNotify)ovirt_bulk_action_run_free);
+
+    ovirt_bulk_action_run_next(task);
+}
+
+
+/**
+ * ovirt_bulk_action_run_finish:
+ * @bulk: a #OvirtBulkAction
+ * @result: async method result
+ * @results: (out) (optional) (element-type OvirtResource GError) (transfer full):
+ * return location for a hash table mapping each resource the action was
+ * run on to the #GError describing why it failed, or to NULL if it
+ * succeeded. Resources for which the action was not run because of
+ * #OvirtBulkAction:stop-on-error or cancellation are not in this table.
+ * @err: #GError to set on error, or NULL
+ *
+ * Return value: TRUE if the action succeeded on all resources, FALSE
+ * otherwise, with @err set.
+ *
+ * Since: 0.3.12
+ */
+gboolean ovirt_bulk_action_run_finish(OvirtBulkAction *bulk,
+                                      GAsyncResult *result,
+                                      GHashTable **results,
+                                      GError **err)
+{
+    OvirtBulkActionRun *run;
+
+    g_return_val_if_fail(OVIRT_IS_BULK_ACTION(bulk), FALSE);
+    g_return_val_if_fail(g_task_is_valid(G_TASK(result), bulk), FALSE);
+
+    run = g_task_get_task_data(G_TASK(result));
+    if (results != NULL) {
+        *results = g_hash_table_ref(run->results);
+    }
+
+    return g_task_propagate_boolean(G_TASK(result), err);
+}
@@ -0,0 +1,70 @@
+/*
+ * ovirt-bulk-action.h: run an action on many oVirt resources
+ *
+ * Copyright (C) 2026 Red Hat, Inc.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library. If not, see
+ * <http://www.gnu.org/licenses/>.
+ */
+#ifndef __OVIRT_BULK_ACTION_H__
+#define __OVIRT_BULK_ACTION_H__
+
+#include <gio/gio.h>
+#include <glib-object.h>
+#include <govirt/ovirt-types.h>
+
+G_BEGIN_DECLS
+
+#define OVIRT_TYPE_BULK_ACTION            (ovirt_bulk_action_get_type ())
+#define OVIRT_BULK_ACTION(obj)            (G_TYPE_CHECK_INSTANCE_CAST ((obj), OVIRT_TYPE_BULK_ACTION, OvirtBulkAction))
+#define OVIRT_BULK_ACTION_CLASS(klass)    (G_TYPE_CHECK_CLASS_CAST ((klass), OVIRT_TYPE_BULK_ACTION, OvirtBulkActionClass))
+#define OVIRT_IS_BULK_ACTION(obj)         (G_TYPE_CHECK_INSTANCE_TYPE ((obj), OVIRT_TYPE_BULK_ACTION))
+#define OVIRT_IS_BULK_ACTION_CLASS(klass) (G_TYPE_CHECK_CLASS_TYPE ((klass), OVIRT_TYPE_BULK_ACTION))
+#define OVIRT_BULK_ACTION_GET_CLASS(obj)  (G_TYPE_INSTANCE_GET_CLASS ((obj), OVIRT_TYPE_BULK_ACTION, OvirtBulkActionClass))
+
+typedef struct _OvirtBulkActionPrivate OvirtBulkActionPrivate;
+typedef struct _OvirtBulkActionClass OvirtBulkActionClass;
+
+struct _OvirtBulkAction
+{
+    GObject parent;
+
+    OvirtBulkActionPrivate *priv;
+
+    /* Do not add fields to this struct */
+};
+
+struct _OvirtBulkActionClass
+{
+    GObjectClass parent_class;
+
+    gpointer padding[20];
+};
+
+GType ovirt_bulk_action_get_type(void);
+
+OvirtBulkAction *ovirt_bulk_action_new(OvirtProxy *proxy, const char *action);
+void ovirt_bulk_action_run_async(OvirtBulkAction *bulk,
+                                 GList *resources,
+                                 GCancellable *cancellable,
+                                 GAsyncReadyCallback callback,
+                                 gpointer user_data);
+gboolean ovirt_bulk_action_run_finish(OvirtBulkAction *bulk,
+                                      GAsyncResult *result,
+                                      GHashTable **results,
+                                      GError **err);
+
+G_END_DECLS
+
+#endif /* __OVIRT_BULK_ACTION_H__ */
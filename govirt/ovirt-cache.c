@@ -0,0 +1,216 @@
+/*
+ * ovirt-cache.c: on-disk cache of oVirt REST API responses
+ *
+ * Copyright (C) 2026 Red Hat, Inc.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library. If not, see
+ * <http://www.gnu.org/licenses/>.
+ */
+
+#include <config.h>
+
+#include <string.h>
+
+#include <glib/gstdio.h>
+
+#include "ovirt-cache.h"
+
+/* Bumped whenever the format of the cache files changes, files using
+ * another format are ignored */
+#define OVIRT_CACHE_MAGIC "govirt-cache-1"
+
+struct _OvirtCache {
+    char *dir;
+};
+
+
+OvirtCache *ovirt_cache_new(const char *cache_dir,
+                            const char *url,
+                            const char *username,
+                            gboolean admin)
+{
+    OvirtCache *cache;
+    char *key;
+    char *checksum;
+
+    g_return_val_if_fail(cache_dir != NULL, NULL);
+    g_return_val_if_fail(url != NULL, NULL);
+
+    /* Different users, or the same user with and without admin
+     * privileges, do not see the same content */
+    key = g_strdup_printf("%s\n%s\n%d", url,
+                          (username != NULL) ? username : "", !!admin);
+    checksum = g_compute_checksum_for_string(G_CHECKSUM_SHA256, key, -1);
+    g_free(key);
+
+    cache = g_slice_new0(OvirtCache);
+    cache->dir = g_build_filename(cache_dir, checksum, NULL);
+    g_free(checksum);
+
+    return cache;
+}
+
+
+void ovirt_cache_free(OvirtCache *cache)
+{
+    if (cache == NULL) {
+        return;
+    }
+
+    g_free(cache->dir);
+    g_slice_free(OvirtCache, cache);
+}
+
+
+static char *ovirt_cache_get_filename(OvirtCache *cache, const char *href)
+{
+    char *checksum;
+    char *filename;
+
+    checksum = g_compute_checksum_for_string(G_CHECKSUM_SHA256, href, -1);
+    filename = g_build_filename(cache->dir, checksum, NULL);
+    g_free(checksum);
+
+    return filename;
+}
+
+
+/* Returns the line starting at *@pos, and moves *@pos to the next line */
+static char *ovirt_cache_next_line(char **pos, const char *end)
+{
+    char *line = *pos;
+    char *eol;
+
+    eol = memchr(line, '\n', end - line);
+    if (eol == NULL) {
+        return NULL;
+    }
+    *eol = '\0';
+    *pos = eol + 1;
+
+    return line;
+}
+
+
+gboolean ovirt_cache_lookup(OvirtCache *cache,
+                            const char *href,
+                            char **data,
+                            gsize *length,
+                            char **etag,
+                            char **last_modified)
+{
+    char *filename;
+    char *contents = NULL;
+    gsize contents_len;
+    char *pos;
+    char *end;
+    const char *magic;
+    const char *cached_href;
+    const char *cached_etag;
+    const char *cached_last_modified;
+    GError *error = NULL;
+
+    g_return_val_if_fail(cache != NULL, FALSE);
+    g_return_val_if_fail(href != NULL, FALSE);
+    g_return_val_if_fail(data != NULL, FALSE);
+
+    filename = ovirt_cache_get_filename(cache, href);
+    if (!g_file_get_contents(filename, &contents, &contents_len, &error)) {
+        if (!g_error_matches(error, G_FILE_ERROR, G_FILE_ERROR_NOENT)) {
+            g_debug("Failed to read cached response: %s", error->message);
+        }
+        g_clear_error(&error);
+        g_free(filename);
+        return FALSE;
+    }
+    g_free(filename);
+
+    pos = contents;
+    end = contents + contents_len;
+    magic = ovirt_cache_next_line(&pos, end);
+    cached_href = ovirt_cache_next_line(&pos, end);
+    cached_etag = ovirt_cache_next_line(&pos, end);
+    cached_last_modified = ovirt_cache_next_line(&pos, end);
+    if ((cached_last_modified == NULL) ||
+        (g_strcmp0(magic, OVIRT_CACHE_MAGIC) != 0) ||
+        (g_strcmp0(cached_href, href) != 0)) {
+        g_debug("Ignoring invalid cached response for '%s'", href);
+        g_free(contents);
+        return FALSE;
+    }
+
+    if (etag != NULL) {
+        *etag = (*cached_etag != '\0') ? g_strdup(cached_etag) : NULL;
+    }
+    if (last_modified != NULL) {
+        *last_modified = (*cached_last_modified != '\0') ? g_strdup(cached_last_modified) : NULL;
+    }
+
+    /* The payload is moved to the start of the buffer to avoid a copy,
+     * g_file_get_contents() NUL-terminated it */
+    contents_len = end - pos;
+    memmove(contents, pos, contents_len + 1);
+    *data = contents;
+    if (length != NULL) {
+        *length = contents_len;
+    }
+
+    return TRUE;
+}
+
+
+void ovirt_cache_store(OvirtCache *cache,
+                       const char *href,
+                       const char *data,
+                       gsize length,
+                       const char *etag,
+                       const char *last_modified)
+{
+    GString *contents;
+    char *filename;
+    GError *error = NULL;
+
+    g_return_if_fail(cache != NULL);
+    g_return_if_fail(href != NULL);
+    g_return_if_fail(data != NULL);
+
+    /* Responses can contain sensitive information, and the directory may
+     * already exist with looser permissions */
+    if (g_mkdir_with_parents(cache->dir, 0700) != 0) {
+        g_debug("Failed to create cache directory '%s'", cache->dir);
+        return;
+    }
+    if (g_chmod(cache->dir, 0700) != 0) {
+        g_debug("Failed to restrict permissions of cache directory '%s'",
+                cache->dir);
+        return;
+    }
+
+    contents = g_string_sized_new(length + 256);
+    g_string_append_printf(contents, "%s\n%s\n%s\n%s\n", OVIRT_CACHE_MAGIC, href,
+                           (etag != NULL) ? etag : "",
+                           (last_modified != NULL) ? last_modified : "");
+    g_string_append_len(contents, data, length);
+
+    filename = ovirt_cache_get_filename(cache, href);
+    /* Readers never see a partially written file */
+    if (!g_file_set_contents_full(filename, contents->str, contents->len,
+                                  G_FILE_SET_CONTENTS_CONSISTENT,
+                                  0600, &error)) {
+        g_debug("Failed to cache response for '%s': %s", href, error->message);
+        g_clear_error(&error);
+    }
+    g_free(filename);
+    g_string_free(contents, TRUE);
+}
@@ -0,0 +1,52 @@
+/*
+ * ovirt-cache.h: on-disk cache of oVirt REST API responses
+ *
+ * Copyright (C) 2026 Red Hat, Inc.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library. If not, see
+ * <http://www.gnu.org/licenses/>.
+ */
+#ifndef __OVIRT_CACHE_H__
+#define __OVIRT_CACHE_H__
+
+#include <glib.h>
+
+G_BEGIN_DECLS
+
+/* Each engine URL/user/admin mode combination gets its own subdirectory of
+ * the cache directory, in which each response is stored in a file named
+ * after its href, along with its ETag and Last-Modified headers. */
+typedef struct _OvirtCache OvirtCache;
+
+OvirtCache *ovirt_cache_new(const char *cache_dir,
+                            const char *url,
+                            const char *username,
+                            gboolean admin);
+void ovirt_cache_free(OvirtCache *cache);
+gboolean ovirt_cache_lookup(OvirtCache *cache,
+                            const char *href,
+                            char **data,
+                            gsize *length,
+                            char **etag,
+                            char **last_modified);
+void ovirt_cache_store(OvirtCache *cache,
+                       const char *href,
+                       const char *data,
+                       gsize length,
+                       const char *etag,
+                       const char *last_modified);
+
+G_END_DECLS
+
+#endif /* __OVIRT_CACHE_H__ */
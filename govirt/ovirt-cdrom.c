@@ -53,6 +53,8 @@ static void ovirt_cdrom_get_property(GObject *object,
 {
     OvirtCdrom *cdrom = OVIRT_CDROM(object);
 
+    ovirt_resource_materialize(OVIRT_RESOURCE(object));
+
     switch (prop_id) {
     case PROP_FILE:
         g_value_set_string(value, cdrom->priv->file);
@@ -71,6 +73,8 @@ static void ovirt_cdrom_set_property(GObject *object,
 {
     OvirtCdrom *cdrom = OVIRT_CDROM(object);
 
+    ovirt_resource_materialize(OVIRT_RESOURCE(object));
+
     switch (prop_id) {
     case PROP_FILE:
         g_free(cdrom->priv->file);
@@ -99,7 +103,7 @@ static gboolean ovirt_cdrom_init_from_xml(OvirtResource *resource,
 {
     char *name;
     OvirtResourceClass *parent_class;
-    OvirtXmlElement cdrom_elements[] = {
+    static const OvirtXmlElement cdrom_elements[] = {
         { .prop_name = "file",
           .xml_path = "file",
           .xml_attr = "id",
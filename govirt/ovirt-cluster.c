@@ -43,9 +43,11 @@ static const char *get_data_center_href(OvirtCluster *cluster)
 {
     if (cluster->priv->data_center_href == NULL &&
         cluster->priv->data_center_id != NULL) {
-        cluster->priv->data_center_href = g_strdup_printf("%s/%s",
-                                                          "/ovirt-engine/api/data_centers",
-                                                          cluster->priv->data_center_id);
+        char *href = g_strdup_printf("%s/%s",
+                                     "/ovirt-engine/api/data_centers",
+                                     cluster->priv->data_center_id);
+        ovirt_utils_set_interned_string(&cluster->priv->data_center_href, href);
+        g_free(href);
     }
 
     return cluster->priv->data_center_href;
@@ -58,6 +60,8 @@ static void ovirt_cluster_get_property(GObject *object,
 {
     OvirtCluster *cluster = OVIRT_CLUSTER(object);
 
+    ovirt_resource_materialize(OVIRT_RESOURCE(object));
+
     switch (prop_id) {
     case PROP_DATA_CENTER_HREF:
         g_value_set_string(value, get_data_center_href(cluster));
@@ -77,14 +81,14 @@ static void ovirt_cluster_set_property(GObject *object,
 {
     OvirtCluster *cluster = OVIRT_CLUSTER(object);
 
+    ovirt_resource_materialize(OVIRT_RESOURCE(object));
+
     switch (prop_id) {
     case PROP_DATA_CENTER_HREF:
-        g_free(cluster->priv->data_center_href);
-        cluster->priv->data_center_href = g_value_dup_string(value);
+        ovirt_utils_set_interned_string(&cluster->priv->data_center_href, g_value_get_string(value));
         break;
     case PROP_DATA_CENTER_ID:
-        g_free(cluster->priv->data_center_id);
-        cluster->priv->data_center_id = g_value_dup_string(value);
+        ovirt_utils_set_interned_string(&cluster->priv->data_center_id, g_value_get_string(value));
         break;
     default:
         G_OBJECT_WARN_INVALID_PROPERTY_ID(object, prop_id, pspec);
@@ -97,8 +101,8 @@ ovirt_cluster_dispose(GObject *obj)
 {
     OvirtCluster *cluster = OVIRT_CLUSTER(obj);
 
-    g_clear_pointer(&cluster->priv->data_center_href, g_free);
-    g_clear_pointer(&cluster->priv->data_center_id, g_free);
+    g_clear_pointer(&cluster->priv->data_center_href, g_ref_string_release);
+    g_clear_pointer(&cluster->priv->data_center_id, g_ref_string_release);
     g_clear_object(&cluster->priv->hosts);
 
     G_OBJECT_CLASS(ovirt_cluster_parent_class)->dispose(obj);
@@ -110,7 +114,7 @@ static gboolean ovirt_cluster_init_from_xml(OvirtResource *resource,
                                             GError **error)
 {
     OvirtResourceClass *parent_class;
-    OvirtXmlElement cluster_elements[] = {
+    static const OvirtXmlElement cluster_elements[] = {
         { .prop_name = "data-center-href",
           .xml_path = "data_center",
           .xml_attr = "href",
@@ -234,6 +238,10 @@ OvirtCollection *ovirt_cluster_get_hosts(OvirtCluster *cluster)
 OvirtDataCenter *ovirt_cluster_get_data_center(OvirtCluster *cluster)
 {
     g_return_val_if_fail(OVIRT_IS_CLUSTER(cluster), NULL);
+    ovirt_resource_materialize(OVIRT_RESOURCE(cluster));
     g_return_val_if_fail(cluster->priv->data_center_id != NULL, NULL);
-    return ovirt_data_center_new_from_id(cluster->priv->data_center_id, get_data_center_href(cluster));
+    return OVIRT_DATA_CENTER(ovirt_resource_get_related(OVIRT_RESOURCE(cluster),
+                                                        OVIRT_TYPE_DATA_CENTER,
+                                                        cluster->priv->data_center_id,
+                                                        get_data_center_href(cluster)));
 }
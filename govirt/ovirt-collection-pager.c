@@ -0,0 +1,370 @@
+/*
+ * ovirt-collection-pager.c: page by page iteration over oVirt collections
+ *
+ * Copyright (C) 2026 Red Hat, Inc.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library. If not, see
+ * <http://www.gnu.org/licenses/>.
+ */
+
+#include <config.h>
+
+#include "ovirt-collection-pager.h"
+#include "govirt-private.h"
+
+/**
+ * SECTION:ovirt-collection-pager
+ * @short_description: page by page iteration over a remote collection
+ *
+ * #OvirtCollectionPager fetches the content of a remote collection one page
+ * at a time. Each call to ovirt_collection_pager_next_async() returns a new
+ * #OvirtCollection holding the resources of the next page. As soon as a
+ * page has been handed to the caller, the following one is requested from
+ * the server so that it is usually available by the time the caller is
+ * done processing the current one.
+ */
+
+struct _OvirtCollectionPagerPrivate {
+    OvirtCollection *collection;
+    OvirtProxy *proxy;
+    guint page_size;
+
+    /* Number of the next page to request */
+    guint next_page;
+    /* Set once the last page has been received, or on error */
+    gboolean done;
+
+    GCancellable *cancellable;
+    /* Page which is being fetched */
+    OvirtCollection *fetching;
+    /* Page which was fetched but not returned to the caller yet */
+    OvirtCollection *prefetched;
+    GError *prefetch_error;
+    /* ovirt_collection_pager_next_async() call waiting for @fetching */
+    GTask *pending;
+};
+
+G_DEFINE_TYPE_WITH_PRIVATE(OvirtCollectionPager, ovirt_collection_pager, G_TYPE_OBJECT);
+
+
+enum {
+    PROP_0,
+    PROP_COLLECTION,
+    PROP_PROXY,
+    PROP_PAGE_SIZE,
+};
+
+
+static void ovirt_collection_pager_get_property(GObject *object,
+                                                guint prop_id,
+                                                GValue *value,
+                                                GParamSpec *pspec)
+{
+    OvirtCollectionPager *pager = OVIRT_COLLECTION_PAGER(object);
+
+    switch (prop_id) {
+    case PROP_COLLECTION:
+        g_value_set_object(value, pager->priv->collection);
+        break;
+    case PROP_PROXY:
+        g_value_set_object(value, pager->priv->proxy);
+        break;
+    case PROP_PAGE_SIZE:
+        g_value_set_uint(value, pager->priv->page_size);
+        break;
+    default:
+        G_OBJECT_WARN_INVALID_PROPERTY_ID(object, prop_id, pspec);
+        break;
+    }
+}
+
+
+static void ovirt_collection_pager_set_property(GObject *object,
+                                                guint prop_id,
+                                                const GValue *value,
+                                                GParamSpec *pspec)
+{
+    OvirtCollectionPager *pager = OVIRT_COLLECTION_PAGER(object);
+
+    switch (prop_id) {
+    case PROP_COLLECTION:
+        pager->priv->collection = g_value_dup_object(value);
+        break;
+    case PROP_PROXY:
+        pager->priv->proxy = g_value_dup_object(value);
+        break;
+    case PROP_PAGE_SIZE:
+        pager->priv->page_size = g_value_get_uint(value);
+        break;
+    default:
+        G_OBJECT_WARN_INVALID_PROPERTY_ID(object, prop_id, pspec);
+        break;
+    }
+}
+
+
+static void ovirt_collection_pager_dispose(GObject *object)
+{
+    OvirtCollectionPager *pager = OVIRT_COLLECTION_PAGER(object);
+
+    g_cancellable_cancel(pager->priv->cancellable);
+    g_clear_object(&pager->priv->collection);
+    g_clear_object(&pager->priv->proxy);
+    g_clear_object(&pager->priv->prefetched);
+
+    G_OBJECT_CLASS(ovirt_collection_pager_parent_class)->dispose(object);
+}
+
+
+static void ovirt_collection_pager_finalize(GObject *object)
+{
+    OvirtCollectionPager *pager = OVIRT_COLLECTION_PAGER(object);
+
+    g_clear_object(&pager->priv->cancellable);
+    g_clear_error(&pager->priv->prefetch_error);
+
+    G_OBJECT_CLASS(ovirt_collection_pager_parent_class)->finalize(object);
+}
+
+
+static void ovirt_collection_pager_class_init(OvirtCollectionPagerClass *klass)
+{
+    GObjectClass *object_class = G_OBJECT_CLASS(klass);
+    GParamSpec *param_spec;
+
+    object_class->dispose = ovirt_collection_pager_dispose;
+    object_class->finalize = ovirt_collection_pager_finalize;
+    object_class->get_property = ovirt_collection_pager_get_property;
+    object_class->set_property = ovirt_collection_pager_set_property;
+
+    param_spec = g_param_spec_object("collection",
+                                     "Collection",
+                                     "Collection to iterate over",
+                                     OVIRT_TYPE_COLLECTION,
+                                     G_PARAM_READWRITE |
+                                     G_PARAM_CONSTRUCT_ONLY |
+                                     G_PARAM_STATIC_STRINGS);
+    g_object_class_install_property(object_class,
+                                    PROP_COLLECTION,
+                                    param_spec);
+
+    param_spec = g_param_spec_object("proxy",
+                                     "Proxy",
+                                     "Proxy used to fetch the pages",
+                                     OVIRT_TYPE_PROXY,
+                                     G_PARAM_READWRITE |
+                                     G_PARAM_CONSTRUCT_ONLY |
+                                     G_PARAM_STATIC_STRINGS);
+    g_object_class_install_property(object_class,
+                                    PROP_PROXY,
+                                    param_spec);
+
+    param_spec = g_param_spec_uint("page-size",
+                                   "Page size",
+                                   "Maximum number of resources in a page",
+                                   1, G_MAXUINT,
+                                   100,
+                                   G_PARAM_READWRITE |
+                                   G_PARAM_CONSTRUCT_ONLY |
+                                   G_PARAM_STATIC_STRINGS);
+    g_object_class_install_property(object_class,
+                                    PROP_PAGE_SIZE,
+                                    param_spec);
+}
+
+
+static void ovirt_collection_pager_init(OvirtCollectionPager *pager)
+{
+    pager->priv = ovirt_collection_pager_get_instance_private(pager);
+    pager->priv->next_page = 1;
+    pager->priv->cancellable = g_cancellable_new();
+}
+
+
+/**
+ * ovirt_collection_pager_new:
+ * @collection: a #OvirtCollection
+ * @proxy: a #OvirtProxy
+ * @page_size: maximum number of resources in a page
+ *
+ * Creates a new pager iterating over the remote content of @collection.
+ * The content of @collection itself is not modified.
+ *
+ * Return value: (transfer full): a new #OvirtCollectionPager
+ *
+ * Since: 0.3.12
+ */
+OvirtCollectionPager *ovirt_collection_pager_new(OvirtCollection *collection,
+                                                 OvirtProxy *proxy,
+                                                 guint page_size)
+{
+    g_return_val_if_fail(OVIRT_IS_COLLECTION(collection), NULL);
+    g_return_val_if_fail(OVIRT_IS_PROXY(proxy), NULL);
+    g_return_val_if_fail(page_size > 0, NULL);
+
+    return OVIRT_COLLECTION_PAGER(g_object_new(OVIRT_TYPE_COLLECTION_PAGER,
+                                               "collection", collection,
+                                               "proxy", proxy,
+                                               "page-size", page_size,
+                                               NULL));
+}
+
+
+static void ovirt_collection_pager_fetch(OvirtCollectionPager *pager);
+
+static void ovirt_collection_pager_return(GTask *task,
+                                          OvirtCollection *page,
+                                          GError *error)
+{
+    if (error != NULL) {
+        g_task_return_error(task, error);
+    } else {
+        g_task_return_pointer(task, page, g_object_unref);
+    }
+    g_object_unref(task);
+}
+
+
+static void ovirt_collection_pager_fetch_cb(GObject *source_object,
+                                            GAsyncResult *result,
+                                            gpointer user_data)
+{
+    OvirtCollectionPager *pager = OVIRT_COLLECTION_PAGER(user_data);
+    OvirtCollectionPagerPrivate *priv = pager->priv;
+    OvirtCollection *page = OVIRT_COLLECTION(source_object);
+    GError *error = NULL;
+    GTask *task;
+
+    g_warn_if_fail(priv->fetching == page);
+    priv->fetching = NULL;
+
+    if (!ovirt_collection_fetch_finish(page, result, &error)) {
+        g_clear_object(&page);
+        priv->done = TRUE;
+    } else if (ovirt_collection_get_n_fetched(page) < priv->page_size) {
+        /* A short page is the last one, and an empty one is not worth
+         * returning to the caller */
+        if (ovirt_collection_get_n_fetched(page) == 0) {
+            g_clear_object(&page);
+        }
+        priv->done = TRUE;
+    }
+
+    task = priv->pending;
+    priv->pending = NULL;
+    if ((task != NULL) && g_task_return_error_if_cancelled(task)) {
+        /* Keep the page for the next call */
+        g_object_unref(task);
+        task = NULL;
+    }
+
+    if (task != NULL) {
+        ovirt_collection_pager_return(task, page, error);
+        ovirt_collection_pager_fetch(pager);
+    } else {
+        priv->prefetched = page;
+        priv->prefetch_error = error;
+    }
+
+    g_object_unref(pager);
+}
+
+
+/* Starts fetching the next page, unless one is already being fetched, or
+ * there are no more pages */
+static void ovirt_collection_pager_fetch(OvirtCollectionPager *pager)
+{
+    OvirtCollectionPagerPrivate *priv = pager->priv;
+
+    if (priv->done || (priv->fetching != NULL)) {
+        return;
+    }
+
+    priv->fetching = ovirt_collection_new_page(priv->collection,
+                                               priv->next_page,
+                                               priv->page_size);
+    priv->next_page++;
+    ovirt_collection_fetch_async(priv->fetching, priv->proxy,
+                                 priv->cancellable,
+                                 ovirt_collection_pager_fetch_cb,
+                                 g_object_ref(pager));
+}
+
+
+/**
+ * ovirt_collection_pager_next_async:
+ * @pager: a #OvirtCollectionPager
+ * @cancellable: (allow-none): a #GCancellable
+ * @callback: (scope async): completion callback
+ * @user_data: (closure): opaque data for callback
+ *
+ * Gets the next page of the remote collection. Only one call can be
+ * pending at a time.
+ *
+ * Since: 0.3.12
+ */
+void ovirt_collection_pager_next_async(OvirtCollectionPager *pager,
+                                       GCancellable *cancellable,
+                                       GAsyncReadyCallback callback,
+                                       gpointer user_data)
+{
+    OvirtCollectionPagerPrivate *priv;
+    OvirtCollection *page;
+    GError *error;
+    GTask *task;
+
+    g_return_if_fail(OVIRT_IS_COLLECTION_PAGER(pager));
+    g_return_if_fail((cancellable == NULL) || G_IS_CANCELLABLE(cancellable));
+    g_return_if_fail(pager->priv->pending == NULL);
+
+    priv = pager->priv;
+    task = g_task_new(G_OBJECT(pager), cancellable, callback, user_data);
+
+    if ((priv->prefetched != NULL) || (priv->prefetch_error != NULL) ||
+        (priv->done && (priv->fetching == NULL))) {
+        page = priv->prefetched;
+        error = priv->prefetch_error;
+        priv->prefetched = NULL;
+        priv->prefetch_error = NULL;
+        ovirt_collection_pager_return(task, page, error);
+        ovirt_collection_pager_fetch(pager);
+        return;
+    }
+
+    priv->pending = task;
+    ovirt_collection_pager_fetch(pager);
+}
+
+
+/**
+ * ovirt_collection_pager_next_finish:
+ * @pager: a #OvirtCollectionPager
+ * @result: async method result
+ * @err: #GError to set on error, or NULL
+ *
+ * Return value: (transfer full): a new #OvirtCollection holding the
+ * resources of the next page, or NULL when all pages have been returned or
+ * on error, with @err set.
+ *
+ * Since: 0.3.12
+ */
+OvirtCollection *ovirt_collection_pager_next_finish(OvirtCollectionPager *pager,
+                                                    GAsyncResult *result,
+                                                    GError **err)
+{
+    g_return_val_if_fail(OVIRT_IS_COLLECTION_PAGER(pager), NULL);
+    g_return_val_if_fail(g_task_is_valid(G_TASK(result), pager), NULL);
+
+    return g_task_propagate_pointer(G_TASK(result), err);
+}
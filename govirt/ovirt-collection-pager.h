@@ -0,0 +1,71 @@
+/*
+ * ovirt-collection-pager.h: page by page iteration over oVirt collections
+ *
+ * Copyright (C) 2026 Red Hat, Inc.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library. If not, see
+ * <http://www.gnu.org/licenses/>.
+ */
+#ifndef __OVIRT_COLLECTION_PAGER_H__
+#define __OVIRT_COLLECTION_PAGER_H__
+
+#include <gio/gio.h>
+#include <glib-object.h>
+#include <govirt/ovirt-collection.h>
+#include <govirt/ovirt-types.h>
+
+G_BEGIN_DECLS
+
+#define OVIRT_TYPE_COLLECTION_PAGER            (ovirt_collection_pager_get_type ())
+#define OVIRT_COLLECTION_PAGER(obj)            (G_TYPE_CHECK_INSTANCE_CAST ((obj), OVIRT_TYPE_COLLECTION_PAGER, OvirtCollectionPager))
+#define OVIRT_COLLECTION_PAGER_CLASS(klass)    (G_TYPE_CHECK_CLASS_CAST ((klass), OVIRT_TYPE_COLLECTION_PAGER, OvirtCollectionPagerClass))
+#define OVIRT_IS_COLLECTION_PAGER(obj)         (G_TYPE_CHECK_INSTANCE_TYPE ((obj), OVIRT_TYPE_COLLECTION_PAGER))
+#define OVIRT_IS_COLLECTION_PAGER_CLASS(klass) (G_TYPE_CHECK_CLASS_TYPE ((klass), OVIRT_TYPE_COLLECTION_PAGER))
+#define OVIRT_COLLECTION_PAGER_GET_CLASS(obj)  (G_TYPE_INSTANCE_GET_CLASS ((obj), OVIRT_TYPE_COLLECTION_PAGER, OvirtCollectionPagerClass))
+
+typedef struct _OvirtCollectionPagerPrivate OvirtCollectionPagerPrivate;
+typedef struct _OvirtCollectionPagerClass OvirtCollectionPagerClass;
+
+struct _OvirtCollectionPager
+{
+    GObject parent;
+
+    OvirtCollectionPagerPrivate *priv;
+
+    /* Do not add fields to this struct */
+};
+
+struct _OvirtCollectionPagerClass
+{
+    GObjectClass parent_class;
+
+    gpointer padding[20];
+};
+
+GType ovirt_collection_pager_get_type(void);
+
+OvirtCollectionPager *ovirt_collection_pager_new(OvirtCollection *collection,
+                                                 OvirtProxy *proxy,
+                                                 guint page_size);
+void ovirt_collection_pager_next_async(OvirtCollectionPager *pager,
+                                       GCancellable *cancellable,
+                                       GAsyncReadyCallback callback,
+                                       gpointer user_data);
+OvirtCollection *ovirt_collection_pager_next_finish(OvirtCollectionPager *pager,
+                                                    GAsyncResult *result,
+                                                    GError **err);
+
+G_END_DECLS
+
+#endif /* __OVIRT_COLLECTION_PAGER_H__ */
@@ -52,6 +52,17 @@ OvirtCollection *ovirt_sub_collection_new_from_resource_search(OvirtResource *re
                                                                GType resource_type,
                                                                const char *resource_name,
                                                                const char *query);
+OvirtCollection *ovirt_collection_new_page(OvirtCollection *collection,
+                                           guint page,
+                                           guint page_size);
+guint ovirt_collection_get_n_fetched(OvirtCollection *collection);
+const char *ovirt_collection_get_resource_xml_name(OvirtCollection *collection);
+gboolean ovirt_collection_update_resource_from_xml(OvirtCollection *collection,
+                                                   OvirtProxy *proxy,
+                                                   RestXmlNode *node,
+                                                   GError **error);
+gboolean ovirt_collection_remove_resource(OvirtCollection *collection,
+                                          const char *href);
 
 G_END_DECLS
 
@@ -27,6 +27,7 @@
 #include <glib/gi18n-lib.h>
 
 #include "ovirt-collection.h"
+#include "ovirt-enum-types.h"
 #include "ovirt-error.h"
 #include "govirt-private.h"
 
@@ -37,8 +38,43 @@ struct _OvirtCollectionPrivate {
     char *resource_xml_name;
 
     GHashTable *resources;
+    /* Indexes of the resources by guid and by href, they also contain the
+     * resources which could not be added to @resources because another
+     * resource has the same name */
+    GHashTable *resources_by_id;
+    GHashTable *resources_by_href;
+    /* Number of resource elements received during the last fetch,
+     * including those which could not be parsed */
+    guint n_fetched;
+    /* Hash of the XML description each resource had when the collection
+     * was last filled, by guid. Resources are shared with other
+     * collections, which can update them first, so whether they changed
+     * since the collection last saw them can't be told from the resources
+     * themselves. */
+    GHashTable *xml_hashes;
+
+    /* Set for collections created from a search link, the query will be
+     * appended to search_href */
+    char *search_href;
+    char *search_query;
+
+    gboolean streaming;
+    gboolean lazy;
+    OvirtXmlRetention xml_retention;
+    /* Related objects to inline in the resources, e.g. "host,cluster" */
+    char *follow;
+    OvirtContentLevel content_level;
+
+    /* Validators of the last response the collection was filled from */
+    OvirtCacheValidators *validators;
 };
 
+static void ovirt_collection_set_xml_retention(OvirtCollection *collection,
+                                               OvirtXmlRetention retention);
+static void ovirt_collection_update_xml_retention_holds(OvirtCollection *collection,
+                                                        GHashTable *resources,
+                                                        GHashTable *resources_by_id);
+
 G_DEFINE_TYPE_WITH_PRIVATE(OvirtCollection, ovirt_collection, G_TYPE_OBJECT);
 
 
@@ -49,8 +85,22 @@ enum {
     PROP_COLLECTION_XML_NAME,
     PROP_RESOURCE_XML_NAME,
     PROP_RESOURCES,
+    PROP_STREAMING,
+    PROP_LAZY,
+    PROP_XML_RETENTION,
+    PROP_FOLLOW,
+    PROP_CONTENT_LEVEL,
+};
+
+enum {
+    RESOURCE_ADDED,
+    RESOURCE_REMOVED,
+    RESOURCE_CHANGED,
+    LAST_SIGNAL
 };
 
+static guint signals[LAST_SIGNAL];
+
 
 static void ovirt_collection_get_property(GObject *object,
                                           guint prop_id,
@@ -69,6 +119,21 @@ static void ovirt_collection_get_property(GObject *object,
     case PROP_RESOURCES:
         g_value_set_boxed(value, collection->priv->resources);
         break;
+    case PROP_STREAMING:
+        g_value_set_boolean(value, collection->priv->streaming);
+        break;
+    case PROP_LAZY:
+        g_value_set_boolean(value, collection->priv->lazy);
+        break;
+    case PROP_XML_RETENTION:
+        g_value_set_enum(value, collection->priv->xml_retention);
+        break;
+    case PROP_FOLLOW:
+        g_value_set_string(value, collection->priv->follow);
+        break;
+    case PROP_CONTENT_LEVEL:
+        g_value_set_enum(value, collection->priv->content_level);
+        break;
     default:
         G_OBJECT_WARN_INVALID_PROPERTY_ID(object, prop_id, pspec);
         break;
@@ -99,6 +164,22 @@ static void ovirt_collection_set_property(GObject *object,
     case PROP_RESOURCES:
         ovirt_collection_set_resources(collection, g_value_get_boxed(value));
         break;
+    case PROP_STREAMING:
+        collection->priv->streaming = g_value_get_boolean(value);
+        break;
+    case PROP_LAZY:
+        collection->priv->lazy = g_value_get_boolean(value);
+        break;
+    case PROP_XML_RETENTION:
+        ovirt_collection_set_xml_retention(collection, g_value_get_enum(value));
+        break;
+    case PROP_FOLLOW:
+        g_free(collection->priv->follow);
+        collection->priv->follow = g_value_dup_string(value);
+        break;
+    case PROP_CONTENT_LEVEL:
+        collection->priv->content_level = g_value_get_enum(value);
+        break;
     default:
         G_OBJECT_WARN_INVALID_PROPERTY_ID(object, prop_id, pspec);
         break;
@@ -110,10 +191,18 @@ static void ovirt_collection_finalize(GObject *object)
 {
     OvirtCollection *collection = OVIRT_COLLECTION(object);
 
+    ovirt_collection_update_xml_retention_holds(collection, NULL, NULL);
     g_clear_pointer(&collection->priv->resources, g_hash_table_unref);
+    g_clear_pointer(&collection->priv->resources_by_id, g_hash_table_unref);
+    g_clear_pointer(&collection->priv->resources_by_href, g_hash_table_unref);
+    g_clear_pointer(&collection->priv->xml_hashes, g_hash_table_unref);
+    g_clear_pointer(&collection->priv->validators, ovirt_cache_validators_free);
     g_free(collection->priv->href);
     g_free(collection->priv->collection_xml_name);
     g_free(collection->priv->resource_xml_name);
+    g_free(collection->priv->search_href);
+    g_free(collection->priv->search_query);
+    g_free(collection->priv->follow);
 
     G_OBJECT_CLASS(ovirt_collection_parent_class)->finalize(object);
 }
@@ -181,6 +270,167 @@ static void ovirt_collection_class_init(OvirtCollectionClass *klass)
     g_object_class_install_property(object_class,
                                     PROP_RESOURCES,
                                     param_spec);
+
+    /**
+     * OvirtCollection:streaming:
+     *
+     * When set, ovirt_collection_fetch() and ovirt_collection_fetch_async()
+     * parse the collection as it is being received from the server, and
+     * each resource is created as soon as its XML element is complete.
+     * The XML description of the whole collection is never held in memory.
+     *
+     * Since: 0.3.12
+     */
+    param_spec = g_param_spec_boolean("streaming",
+                                      "Streaming",
+                                      "Whether to parse fetched data incrementally",
+                                      FALSE,
+                                      G_PARAM_READWRITE |
+                                      G_PARAM_STATIC_STRINGS);
+    g_object_class_install_property(object_class,
+                                    PROP_STREAMING,
+                                    param_spec);
+
+    /**
+     * OvirtCollection:lazy:
+     *
+     * When set, only the id, href and name of the fetched resources are
+     * parsed. Their other properties are parsed from the XML description
+     * of the resource the first time one of them is read, which makes
+     * listing large collections cheaper when only the names are needed.
+     *
+     * Since: 0.3.12
+     */
+    param_spec = g_param_spec_boolean("lazy",
+                                      "Lazy",
+                                      "Whether to delay parsing of resource properties until first use",
+                                      FALSE,
+                                      G_PARAM_READWRITE |
+                                      G_PARAM_STATIC_STRINGS);
+    g_object_class_install_property(object_class,
+                                    PROP_LAZY,
+                                    param_spec);
+
+    /**
+     * OvirtCollection:xml-retention:
+     *
+     * What the resources of the collection keep of the XML description
+     * they were parsed from. Resources which were fetched lazily keep
+     * their XML description until they are materialized even with
+     * %OVIRT_XML_RETENTION_DROP.
+     *
+     * Resources shared with other collections of the same #OvirtProxy
+     * keep the most any of the collections they belong to asks for.
+     *
+     * Since: 0.3.12
+     */
+    param_spec = g_param_spec_enum("xml-retention",
+                                   "XML retention",
+                                   "What resources keep of their XML description",
+                                   OVIRT_TYPE_XML_RETENTION,
+                                   OVIRT_XML_RETENTION_KEEP,
+                                   G_PARAM_READWRITE |
+                                   G_PARAM_STATIC_STRINGS);
+    g_object_class_install_property(object_class,
+                                    PROP_XML_RETENTION,
+                                    param_spec);
+
+    /**
+     * OvirtCollection:follow:
+     *
+     * Comma-separated list of the related objects the server should inline
+     * in the fetched resources, for example "host,cluster". Related objects
+     * which were inlined are returned by the resource accessors, such as
+     * ovirt_vm_get_host(), without further requests. The fetched resources
+     * use the same value for their #OvirtResource:follow property.
+     *
+     * Since: 0.3.12
+     */
+    param_spec = g_param_spec_string("follow",
+                                     "Follow",
+                                     "Related objects to inline in the fetched resources",
+                                     NULL,
+                                     G_PARAM_READWRITE |
+                                     G_PARAM_STATIC_STRINGS);
+    g_object_class_install_property(object_class,
+                                    PROP_FOLLOW,
+                                    param_spec);
+
+    /**
+     * OvirtCollection:content-level:
+     *
+     * How much of the resources is requested when the collection is
+     * fetched. Listing resources usually only needs the attributes the
+     * server returns by default, so only the resources which need their
+     * complete description, for instance to edit them, have to be
+     * refreshed with #OvirtResource:content-level set to
+     * %OVIRT_CONTENT_LEVEL_FULL.
+     *
+     * Since: 0.3.12
+     */
+    param_spec = g_param_spec_enum("content-level",
+                                   "Content level",
+                                   "How much of the resources is requested",
+                                   OVIRT_TYPE_CONTENT_LEVEL,
+                                   OVIRT_CONTENT_LEVEL_SUMMARY,
+                                   G_PARAM_READWRITE |
+                                   G_PARAM_STATIC_STRINGS);
+    g_object_class_install_property(object_class,
+                                    PROP_CONTENT_LEVEL,
+                                    param_spec);
+
+    /**
+     * OvirtCollection::resource-added:
+     * @collection: the #OvirtCollection
+     * @resource: the #OvirtResource which was added
+     *
+     * Emitted after a fetch when a resource which was not part of
+     * @collection has been received.
+     *
+     * Since: 0.3.12
+     */
+    signals[RESOURCE_ADDED] = g_signal_new("resource-added",
+                                           OVIRT_TYPE_COLLECTION,
+                                           G_SIGNAL_RUN_LAST,
+                                           0, NULL, NULL, NULL,
+                                           G_TYPE_NONE, 1,
+                                           OVIRT_TYPE_RESOURCE);
+
+    /**
+     * OvirtCollection::resource-removed:
+     * @collection: the #OvirtCollection
+     * @resource: the #OvirtResource which was removed
+     *
+     * Emitted after a fetch for each resource of @collection which was not
+     * part of the data received from the server.
+     *
+     * Since: 0.3.12
+     */
+    signals[RESOURCE_REMOVED] = g_signal_new("resource-removed",
+                                             OVIRT_TYPE_COLLECTION,
+                                             G_SIGNAL_RUN_LAST,
+                                             0, NULL, NULL, NULL,
+                                             G_TYPE_NONE, 1,
+                                             OVIRT_TYPE_RESOURCE);
+
+    /**
+     * OvirtCollection::resource-changed:
+     * @collection: the #OvirtCollection
+     * @resource: the #OvirtResource which changed
+     *
+     * Emitted after a fetch for each resource of @collection whose
+     * description changed on the server. Resources are matched by guid and
+     * updated in place, so @resource is the same object as before the
+     * fetch.
+     *
+     * Since: 0.3.12
+     */
+    signals[RESOURCE_CHANGED] = g_signal_new("resource-changed",
+                                             OVIRT_TYPE_COLLECTION,
+                                             G_SIGNAL_RUN_LAST,
+                                             0, NULL, NULL, NULL,
+                                             G_TYPE_NONE, 1,
+                                             OVIRT_TYPE_RESOURCE);
 }
 
 
@@ -201,6 +451,132 @@ GHashTable *ovirt_collection_get_resources(OvirtCollection *collection)
     return collection->priv->resources;
 }
 
+static GHashTable *ovirt_collection_resources_new(void)
+{
+    return g_hash_table_new_full(g_str_hash, g_str_equal,
+                                 g_free, (GDestroyNotify)g_object_unref);
+}
+
+
+static GHashTable *ovirt_collection_xml_hashes_new(void)
+{
+    return g_hash_table_new_full(g_str_hash, g_str_equal, g_free, g_free);
+}
+
+
+static void ovirt_collection_xml_hashes_insert(GHashTable *xml_hashes,
+                                               const char *guid,
+                                               guint64 hash)
+{
+    guint64 *value;
+
+    value = g_new(guint64, 1);
+    *value = hash;
+    g_hash_table_insert(xml_hashes, g_strdup(guid), value);
+}
+
+
+/* Returns TRUE when the XML description of the resource with the @guid id
+ * hashed differently the last time @xml_hashes was filled */
+static gboolean ovirt_collection_xml_hash_changed(GHashTable *xml_hashes,
+                                                  const char *guid,
+                                                  guint64 hash)
+{
+    const guint64 *last_hash;
+
+    if (xml_hashes == NULL) {
+        return FALSE;
+    }
+    last_hash = g_hash_table_lookup(xml_hashes, guid);
+
+    return (last_hash != NULL) && (*last_hash != hash);
+}
+
+
+/* Returns the set of all the resources in @resources and
+ * @resources_by_id */
+static GHashTable *ovirt_collection_get_members(GHashTable *resources,
+                                                GHashTable *resources_by_id)
+{
+    GHashTable *members;
+    GHashTableIter iter;
+    gpointer resource;
+
+    members = g_hash_table_new(g_direct_hash, g_direct_equal);
+    if (resources != NULL) {
+        g_hash_table_iter_init(&iter, resources);
+        while (g_hash_table_iter_next(&iter, NULL, &resource)) {
+            g_hash_table_add(members, resource);
+        }
+    }
+    if (resources_by_id != NULL) {
+        g_hash_table_iter_init(&iter, resources_by_id);
+        while (g_hash_table_iter_next(&iter, NULL, &resource)) {
+            g_hash_table_add(members, resource);
+        }
+    }
+
+    return members;
+}
+
+
+/* Makes each resource of the collection hold its xml-retention policy,
+ * see ovirt_resource_hold_xml_retention() */
+static void ovirt_collection_update_xml_retention_holds(OvirtCollection *collection,
+                                                        GHashTable *resources,
+                                                        GHashTable *resources_by_id)
+{
+    OvirtCollectionPrivate *priv = collection->priv;
+    GHashTable *old_members;
+    GHashTable *new_members;
+    GHashTableIter iter;
+    gpointer resource;
+
+    old_members = ovirt_collection_get_members(priv->resources, priv->resources_by_id);
+    new_members = ovirt_collection_get_members(resources, resources_by_id);
+
+    g_hash_table_iter_init(&iter, new_members);
+    while (g_hash_table_iter_next(&iter, &resource, NULL)) {
+        if (!g_hash_table_contains(old_members, resource)) {
+            ovirt_resource_hold_xml_retention(resource, priv->xml_retention);
+        }
+    }
+    g_hash_table_iter_init(&iter, old_members);
+    while (g_hash_table_iter_next(&iter, &resource, NULL)) {
+        if (!g_hash_table_contains(new_members, resource)) {
+            ovirt_resource_release_xml_retention(resource, priv->xml_retention);
+        }
+    }
+
+    g_hash_table_unref(old_members);
+    g_hash_table_unref(new_members);
+}
+
+
+static void ovirt_collection_set_resources_full(OvirtCollection *collection,
+                                                GHashTable *resources,
+                                                GHashTable *resources_by_id,
+                                                GHashTable *resources_by_href)
+{
+    OvirtCollectionPrivate *priv = collection->priv;
+
+    ovirt_collection_update_xml_retention_holds(collection, resources,
+                                                resources_by_id);
+
+    g_clear_pointer(&priv->resources, g_hash_table_unref);
+    g_clear_pointer(&priv->resources_by_id, g_hash_table_unref);
+    g_clear_pointer(&priv->resources_by_href, g_hash_table_unref);
+
+    if (resources != NULL) {
+        priv->resources = g_hash_table_ref(resources);
+        priv->resources_by_id = g_hash_table_ref(resources_by_id);
+        priv->resources_by_href = g_hash_table_ref(resources_by_href);
+    }
+
+    g_object_notify(G_OBJECT(collection), "resources");
+}
+
+
 /**
  * ovirt_collection_set_resources:
  * @collection:
@@ -208,35 +584,375 @@ GHashTable *ovirt_collection_get_resources(OvirtCollection *collection)
  */
 void ovirt_collection_set_resources(OvirtCollection *collection, GHashTable *resources)
 {
+    GHashTable *resources_by_id = NULL;
+    GHashTable *resources_by_href = NULL;
+
     g_return_if_fail(OVIRT_IS_COLLECTION(collection));
 
-    g_clear_pointer(&collection->priv->resources, g_hash_table_unref);
+    /* The content no longer matches the last fetched response */
+    g_clear_pointer(&collection->priv->validators, ovirt_cache_validators_free);
+    g_clear_pointer(&collection->priv->xml_hashes, g_hash_table_unref);
 
     if (resources != NULL) {
-        collection->priv->resources = g_hash_table_ref(resources);
+        GHashTableIter iter;
+        gpointer resource;
+
+        resources_by_id = ovirt_collection_resources_new();
+        resources_by_href = ovirt_collection_resources_new();
+        g_hash_table_iter_init(&iter, resources);
+        while (g_hash_table_iter_next(&iter, NULL, &resource)) {
+            char *guid;
+            char *href;
+
+            g_object_get(G_OBJECT(resource), "guid", &guid, "href", &href, NULL);
+            if (guid != NULL) {
+                g_hash_table_insert(resources_by_id, guid, g_object_ref(resource));
+            }
+            if (href != NULL) {
+                g_hash_table_insert(resources_by_href, href, g_object_ref(resource));
+            }
+        }
     }
 
-    g_object_notify(G_OBJECT(collection), "resources");
+    ovirt_collection_set_resources_full(collection, resources,
+                                        resources_by_id, resources_by_href);
+
+    g_clear_pointer(&resources_by_id, g_hash_table_unref);
+    g_clear_pointer(&resources_by_href, g_hash_table_unref);
 }
 
 
+/* Resources which were already created from a response @proxy received
+ * are reused, so that each remote object is represented by a single
+ * resource however many collections it belongs to. They are then updated
+ * in place, including when they are being read by another thread which
+ * fetched them through another collection, see ovirt_proxy_new(). */
 static OvirtResource *
 ovirt_collection_new_resource_from_xml(OvirtCollection *collection,
+                                       OvirtProxy *proxy,
                                        RestXmlNode *node,
+                                       GHashTable *prepared,
                                        GError **error)
 {
-    return ovirt_resource_new_from_xml(collection->priv->resource_type, node, error);
+    OvirtResource *resource = NULL;
+    OvirtResource *registered;
+    const char *guid;
+    gboolean changed;
+
+    guid = rest_xml_node_get_attr(node, "id");
+    if (proxy != NULL) {
+        resource = ovirt_proxy_lookup_identity(proxy,
+                                               collection->priv->resource_type,
+                                               guid);
+    }
+    if (resource != NULL) {
+        goto refresh;
+    }
+
+    if ((prepared != NULL) && (guid != NULL)) {
+        resource = g_hash_table_lookup(prepared, guid);
+    }
+    if (resource != NULL) {
+        g_object_ref(resource);
+    } else if (collection->priv->lazy) {
+        resource = ovirt_resource_new_lazy_from_xml(collection->priv->resource_type,
+                                                    node, error);
+    } else {
+        resource = ovirt_resource_new_from_xml(collection->priv->resource_type,
+                                               node, error);
+    }
+    if (resource == NULL) {
+        return NULL;
+    }
+    ovirt_resource_set_xml_retention(resource, collection->priv->xml_retention);
+    if (collection->priv->follow != NULL) {
+        g_object_set(G_OBJECT(resource), "follow", collection->priv->follow, NULL);
+    }
+    if (proxy == NULL) {
+        return resource;
+    }
+
+    registered = ovirt_proxy_add_identity(proxy, resource);
+    if (registered == resource) {
+        g_object_unref(registered);
+        return resource;
+    }
+    /* Another thread registered the same remote object in the meantime */
+    g_object_unref(resource);
+    resource = registered;
+
+refresh:
+    if (!ovirt_resource_refresh_from_xml(resource, node, &changed, error)) {
+        g_object_unref(resource);
+        return NULL;
+    }
+
+    return resource;
+}
+
+
+/* Resources with duplicate names are only indexed by id */
+static GHashTable *ovirt_collection_get_all_resources(OvirtCollection *collection)
+{
+    if (collection->priv->resources_by_id != NULL) {
+        return collection->priv->resources_by_id;
+    }
+
+    return collection->priv->resources;
+}
+
+
+static void ovirt_collection_set_xml_retention(OvirtCollection *collection,
+                                               OvirtXmlRetention retention)
+{
+    OvirtXmlRetention old_retention = collection->priv->xml_retention;
+    GHashTable *members;
+    GHashTableIter iter;
+    gpointer resource;
+
+    collection->priv->xml_retention = retention;
+
+    members = ovirt_collection_get_members(collection->priv->resources,
+                                           collection->priv->resources_by_id);
+    g_hash_table_iter_init(&iter, members);
+    while (g_hash_table_iter_next(&iter, &resource, NULL)) {
+        /* Holding the new policy first avoids releasing XML which is
+         * kept by both */
+        ovirt_resource_hold_xml_retention(resource, retention);
+        ovirt_resource_release_xml_retention(resource, old_retention);
+    }
+    g_hash_table_unref(members);
+}
+
+
+/* State of a refresh of the content of a collection. Resources which were
+ * already known are matched by guid and updated in place, the changes are
+ * only made visible by ovirt_collection_refresh_apply() once all nodes have
+ * been processed.
+ */
+typedef struct {
+    OvirtCollection *collection;
+    /* Proxy the content comes from, or NULL */
+    OvirtProxy *proxy;
+    GHashTable *resources;
+    GHashTable *resources_by_id;
+    GHashTable *resources_by_href;
+    /* Resources built in a worker thread for the nodes with an unknown
+     * id, or NULL */
+    GHashTable *prepared;
+    GPtrArray *added;
+    GPtrArray *changed;
+    GHashTable *xml_hashes;
+    /* Set when a known resource is stored under a different name or
+     * href */
+    gboolean keys_changed;
+    guint n_fetched;
+} OvirtCollectionRefresh;
+
+static OvirtCollectionRefresh *
+ovirt_collection_refresh_new(OvirtCollection *collection, OvirtProxy *proxy)
+{
+    OvirtCollectionRefresh *refresh;
+
+    refresh = g_slice_new0(OvirtCollectionRefresh);
+    refresh->collection = g_object_ref(collection);
+    if (proxy != NULL) {
+        refresh->proxy = g_object_ref(proxy);
+    }
+    refresh->resources = ovirt_collection_resources_new();
+    refresh->resources_by_id = ovirt_collection_resources_new();
+    refresh->resources_by_href = ovirt_collection_resources_new();
+    refresh->added = g_ptr_array_new();
+    refresh->changed = g_ptr_array_new();
+    refresh->xml_hashes = ovirt_collection_xml_hashes_new();
+
+    return refresh;
+}
+
+static void
+ovirt_collection_refresh_free(OvirtCollectionRefresh *refresh)
+{
+    g_clear_object(&refresh->collection);
+    g_clear_object(&refresh->proxy);
+    g_clear_pointer(&refresh->resources, g_hash_table_unref);
+    g_clear_pointer(&refresh->resources_by_id, g_hash_table_unref);
+    g_clear_pointer(&refresh->resources_by_href, g_hash_table_unref);
+    g_clear_pointer(&refresh->prepared, g_hash_table_unref);
+    g_clear_pointer(&refresh->added, g_ptr_array_unref);
+    g_clear_pointer(&refresh->changed, g_ptr_array_unref);
+    g_clear_pointer(&refresh->xml_hashes, g_hash_table_unref);
+    g_slice_free(OvirtCollectionRefresh, refresh);
+}
+
+static gboolean
+ovirt_collection_index_has_changed(GHashTable *index,
+                                   const char *key,
+                                   OvirtResource *resource)
+{
+    if (key == NULL) {
+        return FALSE;
+    }
+
+    return (index == NULL) || (g_hash_table_lookup(index, key) != resource);
+}
+
+static void
+ovirt_collection_refresh_add_node(OvirtCollectionRefresh *refresh,
+                                  RestXmlNode *node)
+{
+    OvirtCollectionPrivate *priv = refresh->collection->priv;
+    OvirtResource *resource = NULL;
+    GError *error = NULL;
+    const char *guid;
+    gboolean known = FALSE;
+    gboolean changed = TRUE;
+    guint64 hash = 0;
+    gchar *name;
+    gchar *href;
+
+    refresh->n_fetched++;
+
+    guid = rest_xml_node_get_attr(node, "id");
+    if (guid == NULL) {
+        /* Let the resource report the error */
+    } else if (g_hash_table_contains(refresh->resources_by_id, guid)) {
+        g_message("'%s' resource with the same id ('%s') already exists",
+                  priv->resource_xml_name, guid);
+        return;
+    } else if (priv->resources_by_id != NULL) {
+        resource = g_hash_table_lookup(priv->resources_by_id, guid);
+    }
+    if (resource != NULL) {
+        known = TRUE;
+        g_object_ref(resource);
+        if (!ovirt_resource_refresh_from_xml(resource, node, &changed, &error)) {
+            g_clear_object(&resource);
+        }
+    } else {
+        resource = ovirt_collection_new_resource_from_xml(refresh->collection,
+                                                          refresh->proxy,
+                                                          node,
+                                                          refresh->prepared,
+                                                          &error);
+    }
+    if (resource == NULL) {
+        if (error != NULL) {
+            g_message("Failed to parse '%s' node: %s",
+                      priv->resource_xml_name, error->message);
+        } else {
+            g_message("Failed to parse '%s' node",
+                      priv->resource_xml_name);
+        }
+        g_clear_error(&error);
+        return;
+    }
+    g_object_get(G_OBJECT(resource), "name", &name, "href", &href, NULL);
+    if (name == NULL) {
+        g_message("'%s' resource had no name in its XML description",
+                  priv->resource_xml_name);
+        g_object_unref(G_OBJECT(resource));
+        g_free(href);
+        return;
+    }
+
+    if (guid != NULL) {
+        hash = ovirt_rest_xml_node_hash(node);
+        ovirt_collection_xml_hashes_insert(refresh->xml_hashes, guid, hash);
+    }
+    if (known) {
+        /* Another collection may have updated the resource first */
+        if (changed ||
+            ovirt_collection_xml_hash_changed(priv->xml_hashes, guid, hash)) {
+            g_ptr_array_add(refresh->changed, resource);
+        }
+        if (ovirt_collection_index_has_changed(priv->resources, name, resource) ||
+            ovirt_collection_index_has_changed(priv->resources_by_href, href, resource)) {
+            refresh->keys_changed = TRUE;
+        }
+    } else {
+        g_ptr_array_add(refresh->added, resource);
+    }
+
+    /* Resources with duplicate names can only be looked up by id or href */
+    if (guid != NULL) {
+        g_hash_table_insert(refresh->resources_by_id, g_strdup(guid),
+                            g_object_ref(resource));
+    }
+    if (href != NULL) {
+        g_hash_table_insert(refresh->resources_by_href, href,
+                            g_object_ref(resource));
+    }
+    if (g_hash_table_lookup(refresh->resources, name) != NULL) {
+        g_message("'%s' resource with the same name ('%s') already exists",
+                  priv->resource_xml_name, name);
+        g_object_unref(G_OBJECT(resource));
+        g_free(name);
+        return;
+    }
+    g_hash_table_insert(refresh->resources, name, resource);
+}
+
+static void
+ovirt_collection_refresh_apply(OvirtCollectionRefresh *refresh)
+{
+    OvirtCollection *collection = refresh->collection;
+    OvirtCollectionPrivate *priv = collection->priv;
+    GList *removed = NULL;
+    GList *it;
+    guint i;
+
+    priv->n_fetched = refresh->n_fetched;
+    g_clear_pointer(&priv->xml_hashes, g_hash_table_unref);
+    priv->xml_hashes = g_steal_pointer(&refresh->xml_hashes);
+
+    if (priv->resources_by_id != NULL) {
+        GHashTableIter iter;
+        gpointer guid;
+        gpointer resource;
+
+        g_hash_table_iter_init(&iter, priv->resources_by_id);
+        while (g_hash_table_iter_next(&iter, &guid, &resource)) {
+            if (!g_hash_table_contains(refresh->resources_by_id, guid)) {
+                removed = g_list_prepend(removed, g_object_ref(resource));
+            }
+        }
+    }
+
+    /* The resources tables are only replaced when their content changes,
+     * so that polling an unchanged collection does not wake up listeners */
+    if ((priv->resources == NULL) || refresh->keys_changed ||
+        (removed != NULL) || (refresh->added->len != 0)) {
+        ovirt_collection_set_resources_full(collection,
+                                            refresh->resources,
+                                            refresh->resources_by_id,
+                                            refresh->resources_by_href);
+    }
+
+    for (it = removed; it != NULL; it = it->next) {
+        g_signal_emit(collection, signals[RESOURCE_REMOVED], 0, it->data);
+    }
+    for (i = 0; i < refresh->added->len; i++) {
+        g_signal_emit(collection, signals[RESOURCE_ADDED], 0,
+                      g_ptr_array_index(refresh->added, i));
+    }
+    for (i = 0; i < refresh->changed->len; i++) {
+        g_signal_emit(collection, signals[RESOURCE_CHANGED], 0,
+                      g_ptr_array_index(refresh->changed, i));
+    }
+    g_list_free_full(removed, g_object_unref);
 }
 
 
 static gboolean
 ovirt_collection_refresh_from_xml(OvirtCollection *collection,
+                                  OvirtProxy *proxy,
                                   RestXmlNode *root_node,
+                                  GHashTable *prepared,
                                   GError **error)
 {
+    OvirtCollectionRefresh *refresh;
     RestXmlNode *resources_node;
     RestXmlNode *node;
-    GHashTable *resources;
     const char *resource_key;
 
     g_return_val_if_fail(OVIRT_IS_COLLECTION(collection), FALSE);
@@ -251,108 +967,286 @@ ovirt_collection_refresh_from_xml(OvirtCollection *collection,
     }
 
     resource_key = g_intern_string(collection->priv->resource_xml_name);
-    resources = g_hash_table_new_full(g_str_hash, g_str_equal,
-                                      g_free, (GDestroyNotify)g_object_unref);
+    refresh = ovirt_collection_refresh_new(collection, proxy);
+    if (prepared != NULL) {
+        refresh->prepared = g_hash_table_ref(prepared);
+    }
     resources_node = g_hash_table_lookup(root_node->children, resource_key);
     for (node = resources_node; node != NULL; node = node->next) {
-        OvirtResource *resource;
-        gchar *name;
-
-        resource = ovirt_collection_new_resource_from_xml(collection, node, error);
-        if (resource == NULL) {
-            if ((error != NULL) && (*error != NULL)) {
-                g_message("Failed to parse '%s' node: %s",
-                          collection->priv->resource_xml_name, (*error)->message);
-            } else {
-                g_message("Failed to parse '%s' node",
-                          collection->priv->resource_xml_name);
-            }
-            g_clear_error(error);
-            continue;
-        }
-        g_object_get(G_OBJECT(resource), "name", &name, NULL);
-        if (name == NULL) {
-            g_message("'%s' resource had no name in its XML description",
-                      collection->priv->resource_xml_name);
-            g_object_unref(G_OBJECT(resource));
-            continue;
-        }
-        if (g_hash_table_lookup(resources, name) != NULL) {
-            g_message("'%s' resource with the same name ('%s') already exists",
-                      collection->priv->resource_xml_name, name);
-            g_object_unref(G_OBJECT(resource));
-            g_free(name);
-            continue;
-        }
-        g_hash_table_insert(resources, name, resource);
+        ovirt_collection_refresh_add_node(refresh, node);
     }
 
-    ovirt_collection_set_resources(OVIRT_COLLECTION(collection), resources);
-    g_hash_table_unref(resources);
+    ovirt_collection_refresh_apply(refresh);
+    ovirt_collection_refresh_free(refresh);
 
     return TRUE;
 }
 
 
-OvirtCollection *ovirt_collection_new(const char *href,
-                                      const char *collection_name,
-                                      GType resource_type,
-                                      const char *resource_name)
+static void ovirt_collection_index_resource(GHashTable *resources,
+                                            GHashTable *resources_by_id,
+                                            GHashTable *resources_by_href,
+                                            const char *guid,
+                                            OvirtResource *resource)
 {
-    OvirtCollection *self;
-
-    self = OVIRT_COLLECTION(g_object_new(OVIRT_TYPE_COLLECTION,
-                                         "href", href,
-                                         "collection-xml-name", collection_name,
-                                         "resource-type", resource_type,
-                                         "resource-xml-name", resource_name,
-                                         NULL));
+    char *name;
+    char *href;
 
-    return self;
+    g_object_get(G_OBJECT(resource), "name", &name, "href", &href, NULL);
+    g_hash_table_insert(resources_by_id, g_strdup(guid), g_object_ref(resource));
+    if (href != NULL) {
+        g_hash_table_insert(resources_by_href, href, g_object_ref(resource));
+    }
+    /* Resources with duplicate names can only be looked up by id or href */
+    if ((name != NULL) && !g_hash_table_contains(resources, name)) {
+        g_hash_table_insert(resources, name, g_object_ref(resource));
+    } else {
+        g_free(name);
+    }
 }
 
-
-OvirtCollection *ovirt_collection_new_from_xml(RestXmlNode *root_node,
-                                               GType collection_type,
-                                               const char *collection_name,
-                                               GType resource_type,
-                                               const char *resource_name,
-                                               GError **error)
+/* Rebuilds the resources tables once @added was added to the collection,
+ * or the resource with the @removed_guid id was removed from it */
+static void ovirt_collection_reindex(OvirtCollection *collection,
+                                     const char *added_guid,
+                                     OvirtResource *added,
+                                     const char *removed_guid)
 {
-    OvirtCollection *self;
+    GHashTable *resources;
+    GHashTable *resources_by_id;
+    GHashTable *resources_by_href;
+    GHashTableIter iter;
+    gpointer guid;
+    gpointer resource;
+
+    resources = ovirt_collection_resources_new();
+    resources_by_id = ovirt_collection_resources_new();
+    resources_by_href = ovirt_collection_resources_new();
+
+    if (collection->priv->resources_by_id != NULL) {
+        g_hash_table_iter_init(&iter, collection->priv->resources_by_id);
+        while (g_hash_table_iter_next(&iter, &guid, &resource)) {
+            if (g_strcmp0(guid, removed_guid) == 0) {
+                continue;
+            }
+            ovirt_collection_index_resource(resources, resources_by_id,
+                                            resources_by_href, guid,
+                                            resource);
+        }
+    }
+    if (added != NULL) {
+        ovirt_collection_index_resource(resources, resources_by_id,
+                                        resources_by_href, added_guid,
+                                        added);
+    }
 
-    self = OVIRT_COLLECTION(g_object_new(collection_type,
-                                         "collection-xml-name", collection_name,
-                                         "resource-type", resource_type,
-                                         "resource-xml-name", resource_name,
-                                         NULL));
-    ovirt_collection_refresh_from_xml(self, root_node, error);
+    ovirt_collection_set_resources_full(collection, resources,
+                                        resources_by_id, resources_by_href);
 
-    return self;
+    g_hash_table_unref(resources);
+    g_hash_table_unref(resources_by_id);
+    g_hash_table_unref(resources_by_href);
 }
 
 
-OvirtCollection *ovirt_sub_collection_new_from_resource(OvirtResource *resource,
-                                                        const char *href,
-                                                        const char *collection_name,
-                                                        GType resource_type,
-                                                        const char *resource_name)
+/* Updates, or adds, the resource described by @node without fetching the
+ * whole collection again. The same signals as for a fetch are emitted. */
+gboolean ovirt_collection_update_resource_from_xml(OvirtCollection *collection,
+                                                   OvirtProxy *proxy,
+                                                   RestXmlNode *node,
+                                                   GError **error)
 {
-    const char *link = ovirt_resource_get_sub_collection(resource, href);
+    OvirtCollectionPrivate *priv;
+    OvirtResource *resource;
+    const char *guid;
+    gboolean changed = FALSE;
+    guint64 hash;
+    char *old_name;
+    char *old_href;
+    char *name;
+    char *href;
 
-    if (link == NULL)
-        return NULL;
+    g_return_val_if_fail(OVIRT_IS_COLLECTION(collection), FALSE);
+    g_return_val_if_fail(node != NULL, FALSE);
+    g_return_val_if_fail((error == NULL) || (*error == NULL), FALSE);
 
-    return ovirt_collection_new(link, collection_name, resource_type, resource_name);
-}
+    priv = collection->priv;
+    if (strcmp(node->name, priv->resource_xml_name) != 0) {
+        g_set_error(error, OVIRT_ERROR, OVIRT_ERROR_PARSING_FAILED,
+                    _("Got '%s' node, expected '%s'"), node->name,
+                    priv->resource_xml_name);
+        return FALSE;
+    }
+    guid = rest_xml_node_get_attr(node, "id");
+    if (guid == NULL) {
+        g_set_error(error, OVIRT_ERROR, OVIRT_ERROR_PARSING_FAILED,
+                    _("Missing mandatory 'id' attribute"));
+        return FALSE;
+    }
 
-OvirtCollection *ovirt_sub_collection_new_from_resource_search(OvirtResource *resource,
-                                                               const char *href,
-                                                               const char *collection_name,
-                                                               GType resource_type,
-                                                               const char *resource_name,
-                                                               const char *query)
-{
+    hash = ovirt_rest_xml_node_hash(node);
+    if (priv->xml_hashes == NULL) {
+        priv->xml_hashes = ovirt_collection_xml_hashes_new();
+    }
+
+    resource = (priv->resources_by_id != NULL) ?
+               g_hash_table_lookup(priv->resources_by_id, guid) : NULL;
+    if (resource == NULL) {
+        resource = ovirt_collection_new_resource_from_xml(collection, proxy,
+                                                          node, NULL, error);
+        if (resource == NULL) {
+            return FALSE;
+        }
+        ovirt_collection_xml_hashes_insert(priv->xml_hashes, guid, hash);
+        ovirt_collection_reindex(collection, guid, resource, NULL);
+        g_signal_emit(collection, signals[RESOURCE_ADDED], 0, resource);
+        g_object_unref(resource);
+        return TRUE;
+    }
+
+    g_object_ref(resource);
+    g_object_get(G_OBJECT(resource), "name", &old_name, "href", &old_href, NULL);
+    if (!ovirt_resource_refresh_from_xml(resource, node, &changed, error)) {
+        g_object_unref(resource);
+        g_free(old_name);
+        g_free(old_href);
+        return FALSE;
+    }
+    /* Another collection may have updated the resource first */
+    if (ovirt_collection_xml_hash_changed(priv->xml_hashes, guid, hash)) {
+        changed = TRUE;
+    }
+    ovirt_collection_xml_hashes_insert(priv->xml_hashes, guid, hash);
+
+    g_object_get(G_OBJECT(resource), "name", &name, "href", &href, NULL);
+    if ((g_strcmp0(name, old_name) != 0) || (g_strcmp0(href, old_href) != 0)) {
+        ovirt_collection_reindex(collection, NULL, NULL, NULL);
+    }
+    if (changed) {
+        g_signal_emit(collection, signals[RESOURCE_CHANGED], 0, resource);
+    }
+    g_object_unref(resource);
+    g_free(old_name);
+    g_free(old_href);
+    g_free(name);
+    g_free(href);
+
+    return TRUE;
+}
+
+
+/* Removes the resource stored under @href without fetching the whole
+ * collection again, returns FALSE when there is no such resource */
+gboolean ovirt_collection_remove_resource(OvirtCollection *collection,
+                                          const char *href)
+{
+    OvirtResource *resource;
+    char *guid;
+
+    g_return_val_if_fail(OVIRT_IS_COLLECTION(collection), FALSE);
+    g_return_val_if_fail(href != NULL, FALSE);
+
+    if (collection->priv->resources_by_href == NULL) {
+        return FALSE;
+    }
+    resource = g_hash_table_lookup(collection->priv->resources_by_href, href);
+    if (resource == NULL) {
+        return FALSE;
+    }
+
+    g_object_ref(resource);
+    g_object_get(G_OBJECT(resource), "guid", &guid, NULL);
+    if ((guid != NULL) && (collection->priv->xml_hashes != NULL)) {
+        g_hash_table_remove(collection->priv->xml_hashes, guid);
+    }
+    ovirt_collection_reindex(collection, NULL, NULL, guid);
+    g_signal_emit(collection, signals[RESOURCE_REMOVED], 0, resource);
+    g_object_unref(resource);
+    g_free(guid);
+
+    return TRUE;
+}
+
+
+static gboolean ovirt_collection_stream_node_cb(RestXmlNode *node,
+                                                gpointer user_data,
+                                                G_GNUC_UNUSED GError **error)
+{
+    ovirt_collection_refresh_add_node(user_data, node);
+
+    return TRUE;
+}
+
+static OvirtXmlStream *
+ovirt_collection_stream_new(OvirtCollection *collection,
+                            OvirtCollectionRefresh *refresh)
+{
+    return ovirt_xml_stream_new(collection->priv->collection_xml_name,
+                                collection->priv->resource_xml_name,
+                                ovirt_collection_stream_node_cb,
+                                refresh);
+}
+
+
+OvirtCollection *ovirt_collection_new(const char *href,
+                                      const char *collection_name,
+                                      GType resource_type,
+                                      const char *resource_name)
+{
+    OvirtCollection *self;
+
+    self = OVIRT_COLLECTION(g_object_new(OVIRT_TYPE_COLLECTION,
+                                         "href", href,
+                                         "collection-xml-name", collection_name,
+                                         "resource-type", resource_type,
+                                         "resource-xml-name", resource_name,
+                                         NULL));
+
+    return self;
+}
+
+
+OvirtCollection *ovirt_collection_new_from_xml(RestXmlNode *root_node,
+                                               GType collection_type,
+                                               const char *collection_name,
+                                               GType resource_type,
+                                               const char *resource_name,
+                                               GError **error)
+{
+    OvirtCollection *self;
+
+    self = OVIRT_COLLECTION(g_object_new(collection_type,
+                                         "collection-xml-name", collection_name,
+                                         "resource-type", resource_type,
+                                         "resource-xml-name", resource_name,
+                                         NULL));
+    ovirt_collection_refresh_from_xml(self, NULL, root_node, NULL, error);
+
+    return self;
+}
+
+
+OvirtCollection *ovirt_sub_collection_new_from_resource(OvirtResource *resource,
+                                                        const char *href,
+                                                        const char *collection_name,
+                                                        GType resource_type,
+                                                        const char *resource_name)
+{
+    const char *link = ovirt_resource_get_sub_collection(resource, href);
+
+    if (link == NULL)
+        return NULL;
+
+    return ovirt_collection_new(link, collection_name, resource_type, resource_name);
+}
+
+OvirtCollection *ovirt_sub_collection_new_from_resource_search(OvirtResource *resource,
+                                                               const char *href,
+                                                               const char *collection_name,
+                                                               GType resource_type,
+                                                               const char *resource_name,
+                                                               const char *query)
+{
     const char *link;
     char *substr;
     gchar *link_query, *escaped_query;
@@ -372,12 +1266,181 @@ OvirtCollection *ovirt_sub_collection_new_from_resource_search(OvirtResource *re
     escaped_query = g_uri_escape_string(query, NULL, FALSE);
     link_query = g_strconcat(link, escaped_query, NULL);
     collection = ovirt_collection_new(link_query, collection_name, resource_type, resource_name);
+    collection->priv->search_href = g_strdup(link);
+    collection->priv->search_query = g_strdup(query);
     g_free(escaped_query);
     g_free(link_query);
 
     return collection;
 }
 
+
+/* The engine pages its results through its search backend: the page number
+ * is appended to the search query ("page 2"), and the page size is set with
+ * the 'max' parameter. Pages are numbered from 1.
+ */
+/* Href of a page of the collection, without the parameters added by
+ * ovirt_collection_add_fetch_params() */
+static char *ovirt_collection_get_search_page_href(OvirtCollection *collection,
+                                                   guint page,
+                                                   guint page_size)
+{
+    OvirtCollectionPrivate *priv = collection->priv;
+    char *query;
+    char *escaped_query;
+    char *href;
+
+    if ((priv->search_query != NULL) && (*priv->search_query != '\0')) {
+        query = g_strdup_printf("%s page %u", priv->search_query, page);
+    } else {
+        query = g_strdup_printf("page %u", page);
+    }
+    escaped_query = g_uri_escape_string(query, NULL, FALSE);
+
+    if (priv->search_href != NULL) {
+        href = g_strdup_printf("%s%s&max=%u", priv->search_href,
+                               escaped_query, page_size);
+    } else {
+        href = g_strdup_printf("%s%csearch=%s&max=%u", priv->href,
+                               (strchr(priv->href, '?') != NULL) ? '&' : '?',
+                               escaped_query, page_size);
+    }
+    g_free(escaped_query);
+    g_free(query);
+
+    return href;
+}
+
+
+/* Adds the content level and the related objects to inline to @href */
+static char *ovirt_collection_add_fetch_params(OvirtCollection *collection,
+                                               const char *href)
+{
+    char *content_href;
+    char *fetch_href;
+
+    content_href = ovirt_utils_href_add_all_content(href,
+                                                    collection->priv->content_level == OVIRT_CONTENT_LEVEL_FULL);
+    fetch_href = ovirt_utils_href_add_query_param(content_href, "follow",
+                                                  collection->priv->follow);
+    g_free(content_href);
+
+    return fetch_href;
+}
+
+
+static char *ovirt_collection_get_page_href(OvirtCollection *collection,
+                                            guint page,
+                                            guint page_size)
+{
+    char *page_href;
+    char *href;
+
+    page_href = ovirt_collection_get_search_page_href(collection, page, page_size);
+    href = ovirt_collection_add_fetch_params(collection, page_href);
+    g_free(page_href);
+
+    return href;
+}
+
+
+/* Href the content of the collection is fetched from */
+static char *ovirt_collection_get_href(OvirtCollection *collection)
+{
+    return ovirt_collection_add_fetch_params(collection, collection->priv->href);
+}
+
+
+OvirtCollection *ovirt_collection_new_page(OvirtCollection *collection,
+                                           guint page,
+                                           guint page_size)
+{
+    OvirtCollection *page_collection;
+    char *href;
+
+    g_return_val_if_fail(OVIRT_IS_COLLECTION(collection), NULL);
+    g_return_val_if_fail(collection->priv->href != NULL, NULL);
+    g_return_val_if_fail(page > 0, NULL);
+    g_return_val_if_fail(page_size > 0, NULL);
+
+    href = ovirt_collection_get_search_page_href(collection, page, page_size);
+    page_collection = ovirt_collection_new(href,
+                                           collection->priv->collection_xml_name,
+                                           collection->priv->resource_type,
+                                           collection->priv->resource_xml_name);
+    page_collection->priv->streaming = collection->priv->streaming;
+    page_collection->priv->lazy = collection->priv->lazy;
+    page_collection->priv->xml_retention = collection->priv->xml_retention;
+    page_collection->priv->follow = g_strdup(collection->priv->follow);
+    page_collection->priv->content_level = collection->priv->content_level;
+    g_free(href);
+
+    return page_collection;
+}
+
+
+guint ovirt_collection_get_n_fetched(OvirtCollection *collection)
+{
+    g_return_val_if_fail(OVIRT_IS_COLLECTION(collection), 0);
+
+    return collection->priv->n_fetched;
+}
+
+
+/* Name of the XML element describing each resource of @collection */
+const char *ovirt_collection_get_resource_xml_name(OvirtCollection *collection)
+{
+    g_return_val_if_fail(OVIRT_IS_COLLECTION(collection), NULL);
+
+    return collection->priv->resource_xml_name;
+}
+
+
+static gboolean ovirt_collection_fetch_href(OvirtCollection *collection,
+                                            OvirtProxy *proxy,
+                                            const char *href,
+                                            GError **error)
+{
+    RestXmlNode *xml;
+
+    if (collection->priv->streaming && ovirt_proxy_can_stream(proxy)) {
+        OvirtCollectionRefresh *refresh;
+        OvirtXmlStream *stream;
+        gboolean parsed;
+        gboolean modified;
+
+        refresh = ovirt_collection_refresh_new(collection, proxy);
+        stream = ovirt_collection_stream_new(collection, refresh);
+        parsed = ovirt_proxy_get_collection_xml_stream(proxy, href, stream,
+                                                       &collection->priv->validators,
+                                                       &modified, error);
+        if (parsed && modified) {
+            ovirt_collection_refresh_apply(refresh);
+        }
+        ovirt_xml_stream_free(stream);
+        ovirt_collection_refresh_free(refresh);
+
+        return parsed;
+    }
+
+    if (!ovirt_proxy_get_collection_xml_if_modified(proxy, href,
+                                                    collection->priv->collection_xml_name,
+                                                    &collection->priv->validators,
+                                                    &xml, NULL))
+        return FALSE;
+    if (xml == NULL) {
+        /* Not modified */
+        return TRUE;
+    }
+
+    ovirt_collection_refresh_from_xml(collection, proxy, xml, NULL, error);
+
+    rest_xml_node_unref(xml);
+
+    return TRUE;
+}
+
+
 /**
  * ovirt_collection_fetch:
  * @collection: a #OvirtCollection
@@ -388,34 +1451,305 @@ gboolean ovirt_collection_fetch(OvirtCollection *collection,
                                 OvirtProxy *proxy,
                                 GError **error)
 {
-    RestXmlNode *xml;
+    char *href;
+    gboolean fetched;
 
     g_return_val_if_fail(OVIRT_IS_COLLECTION(collection), FALSE);
     g_return_val_if_fail(OVIRT_IS_PROXY(proxy), FALSE);
     g_return_val_if_fail(collection->priv->href != NULL, FALSE);
 
-    xml = ovirt_proxy_get_collection_xml(proxy, collection->priv->href, NULL);
-    if (xml == NULL)
-        return FALSE;
+    href = ovirt_collection_get_href(collection);
+    fetched = ovirt_collection_fetch_href(collection, proxy, href, error);
+    g_free(href);
 
-    ovirt_collection_refresh_from_xml(collection, xml, error);
+    return fetched;
+}
+
+
+/**
+ * ovirt_collection_fetch_page:
+ * @collection: a #OvirtCollection
+ * @proxy: a #OvirtProxy
+ * @page: number of the page to fetch, starting from 1
+ * @page_size: maximum number of resources in a page
+ * @error: #GError to set on error, or NULL
+ *
+ * Fetches the resources of the remote collection which are on page @page
+ * when the collection is split in pages of @page_size resources, and
+ * replaces the content of @collection with them. For collections created
+ * from a search query, the query is preserved.
+ *
+ * Paging relies on the search capabilities of the engine, so it is only
+ * available for top-level collections.
+ *
+ * Return value: TRUE if successful, FALSE otherwise, with @error set.
+ *
+ * Since: 0.3.12
+ */
+gboolean ovirt_collection_fetch_page(OvirtCollection *collection,
+                                     OvirtProxy *proxy,
+                                     guint page,
+                                     guint page_size,
+                                     GError **error)
+{
+    char *href;
+    gboolean fetched;
+
+    g_return_val_if_fail(OVIRT_IS_COLLECTION(collection), FALSE);
+    g_return_val_if_fail(OVIRT_IS_PROXY(proxy), FALSE);
+    g_return_val_if_fail(collection->priv->href != NULL, FALSE);
+    g_return_val_if_fail(page > 0, FALSE);
+    g_return_val_if_fail(page_size > 0, FALSE);
+
+    href = ovirt_collection_get_page_href(collection, page, page_size);
+    fetched = ovirt_collection_fetch_href(collection, proxy, href, error);
+    g_free(href);
+
+    return fetched;
+}
 
-    rest_xml_node_unref(xml);
+
+static gboolean ovirt_collection_fetch_stream_cb(G_GNUC_UNUSED OvirtProxy *proxy,
+                                                 gpointer user_data,
+                                                 G_GNUC_UNUSED GError **error)
+{
+    ovirt_collection_refresh_apply(user_data);
 
     return TRUE;
 }
 
 
+/* Resources built in a worker thread from the response to an asynchronous
+ * fetch, for the nodes whose id the collection did not know when the fetch
+ * started, and which @proxy did not create through another collection. The
+ * collection only uses them for the nodes which are still unknown when it
+ * is refreshed from the response in its main context.
+ *
+ * The identity map of @proxy is looked up from the worker thread, under
+ * the lock of @proxy. This is a shared structure, and the last reference
+ * to it can be released from either thread. The resources it holds,
+ * including the shared ones in @registered, can then be released from the
+ * worker thread too.
+ */
+typedef struct {
+    OvirtCollection *collection;
+    OvirtProxy *proxy;
+    GType resource_type;
+    gboolean lazy;
+    char *collection_xml_name;
+    char *resource_xml_name;
+    GHashTable *known_ids;
+    GHashTable *resources;
+    /* Resources registered in the identity map of @proxy for some of the
+     * nodes, which are kept alive until the collection reuses them */
+    GPtrArray *registered;
+} OvirtCollectionPrepared;
+
+static OvirtCollectionPrepared *
+ovirt_collection_prepared_new(OvirtCollection *collection, OvirtProxy *proxy)
+{
+    OvirtCollectionPrivate *priv = collection->priv;
+    OvirtCollectionPrepared *prepared;
+
+    prepared = g_atomic_rc_box_new0(OvirtCollectionPrepared);
+    prepared->collection = g_object_ref(collection);
+    prepared->proxy = g_object_ref(proxy);
+    prepared->resource_type = priv->resource_type;
+    prepared->lazy = priv->lazy;
+    prepared->collection_xml_name = g_strdup(priv->collection_xml_name);
+    prepared->resource_xml_name = g_strdup(priv->resource_xml_name);
+    /* The tables of the collection are replaced, never modified, so
+     * this one can be read from another thread */
+    if (priv->resources_by_id != NULL) {
+        prepared->known_ids = g_hash_table_ref(priv->resources_by_id);
+    }
+    prepared->resources = ovirt_collection_resources_new();
+    prepared->registered = g_ptr_array_new_with_free_func(g_object_unref);
+
+    return prepared;
+}
+
+static void ovirt_collection_prepared_clear(OvirtCollectionPrepared *prepared)
+{
+    g_clear_object(&prepared->collection);
+    g_clear_object(&prepared->proxy);
+    g_free(prepared->collection_xml_name);
+    g_free(prepared->resource_xml_name);
+    g_clear_pointer(&prepared->known_ids, g_hash_table_unref);
+    g_clear_pointer(&prepared->resources, g_hash_table_unref);
+    g_clear_pointer(&prepared->registered, g_ptr_array_unref);
+}
+
+static OvirtCollectionPrepared *
+ovirt_collection_prepared_ref(OvirtCollectionPrepared *prepared)
+{
+    return g_atomic_rc_box_acquire(prepared);
+}
+
+static void ovirt_collection_prepared_unref(OvirtCollectionPrepared *prepared)
+{
+    g_atomic_rc_box_release_full(prepared,
+                                 (GDestroyNotify)ovirt_collection_prepared_clear);
+}
+
+
+/* Called from a worker thread, see ovirt_proxy_get_shared_async() */
+static void ovirt_collection_prepare(RestXmlNode *root_node,
+                                     gpointer prepare_data,
+                                     GCancellable *cancellable)
+{
+    OvirtCollectionPrepared *prepared = prepare_data;
+    RestXmlNode *node;
+    const char *resource_key;
+
+    if (strcmp(root_node->name, prepared->collection_xml_name) != 0) {
+        return;
+    }
+
+    resource_key = g_intern_string(prepared->resource_xml_name);
+    node = g_hash_table_lookup(root_node->children, resource_key);
+    for (; node != NULL; node = node->next) {
+        OvirtResource *resource;
+        const char *guid;
+
+        if (g_cancellable_is_cancelled(cancellable)) {
+            return;
+        }
+
+        guid = rest_xml_node_get_attr(node, "id");
+        if ((guid == NULL) ||
+            ((prepared->known_ids != NULL) && g_hash_table_contains(prepared->known_ids, guid)) ||
+            g_hash_table_contains(prepared->resources, guid)) {
+            continue;
+        }
+        /* ovirt_collection_new_resource_from_xml() would discard a
+         * resource built for a node which is already registered */
+        resource = ovirt_proxy_lookup_identity(prepared->proxy,
+                                               prepared->resource_type,
+                                               guid);
+        if (resource != NULL) {
+            g_ptr_array_add(prepared->registered, resource);
+            continue;
+        }
+
+        /* Errors are reported when the collection gets to this node */
+        if (prepared->lazy) {
+            resource = ovirt_resource_new_lazy_from_xml(prepared->resource_type,
+                                                        node, NULL);
+        } else {
+            resource = ovirt_resource_new_from_xml(prepared->resource_type,
+                                                   node, NULL);
+        }
+        if (resource != NULL) {
+            g_hash_table_insert(prepared->resources, g_strdup(guid), resource);
+        }
+    }
+}
+
+
 static gboolean ovirt_collection_fetch_async_cb(OvirtProxy* proxy,
                                                 RestXmlNode *root_node,
                                                 gpointer user_data,
                                                 GError **error)
 {
-    OvirtCollection *collection = OVIRT_COLLECTION(user_data);
+    OvirtCollectionPrepared *prepared = user_data;
+
+    g_return_val_if_fail(OVIRT_IS_COLLECTION(prepared->collection), FALSE);
+
+    return ovirt_collection_refresh_from_xml(prepared->collection, proxy,
+                                             root_node, prepared->resources,
+                                             error);
+}
+
+
+static void ovirt_collection_revalidate_done(GObject *source_object,
+                                            GAsyncResult *result,
+                                            gpointer user_data)
+{
+    OvirtProxy *proxy = OVIRT_PROXY(user_data);
+    GError *error = NULL;
+
+    if (!g_task_propagate_boolean(G_TASK(result), &error)) {
+        ovirt_proxy_revalidation_failed(proxy, source_object, error);
+        g_clear_error(&error);
+    }
+    g_object_unref(proxy);
+}
+
+
+/* Fills a collection which was never fetched from the on-disk cache of
+ * @proxy. Returns TRUE if it was, in which case its content must then be
+ * revalidated. */
+static gboolean ovirt_collection_refresh_from_cache(OvirtCollection *collection,
+                                                    OvirtProxy *proxy,
+                                                    const char *href)
+{
+    RestXmlNode *xml;
+    gboolean refreshed;
+
+    if (collection->priv->resources != NULL) {
+        return FALSE;
+    }
+    if (!ovirt_proxy_get_cached_collection_xml(proxy, href,
+                                               collection->priv->collection_xml_name,
+                                               &xml, &collection->priv->validators)) {
+        return FALSE;
+    }
 
-    g_return_val_if_fail(OVIRT_IS_COLLECTION(user_data), FALSE);
+    refreshed = ovirt_collection_refresh_from_xml(collection, proxy, xml, NULL, NULL);
+    rest_xml_node_unref(xml);
+    if (!refreshed) {
+        g_clear_pointer(&collection->priv->validators, ovirt_cache_validators_free);
+    }
 
-    return ovirt_collection_refresh_from_xml(collection, root_node, error);
+    return refreshed;
+}
+
+
+static void ovirt_collection_fetch_href_async(OvirtCollection *collection,
+                                              OvirtProxy *proxy,
+                                              const char *href,
+                                              GTask *task,
+                                              GCancellable *cancellable)
+{
+    OvirtCollectionPrepared *prepared;
+
+    if (collection->priv->streaming && ovirt_proxy_can_stream(proxy)) {
+        OvirtCollectionRefresh *refresh;
+
+        refresh = ovirt_collection_refresh_new(collection, proxy);
+        ovirt_proxy_get_collection_xml_stream_async(proxy, href,
+                                                    ovirt_collection_stream_new(collection, refresh),
+                                                    &collection->priv->validators,
+                                                    task, cancellable,
+                                                    ovirt_collection_fetch_stream_cb,
+                                                    refresh,
+                                                    (GDestroyNotify)ovirt_collection_refresh_free);
+        return;
+    }
+    if (ovirt_collection_refresh_from_cache(collection, proxy, href)) {
+        /* The caller gets the cached content right away, the signals
+         * emitted when the revalidation completes report what changed */
+        g_task_return_boolean(task, TRUE);
+        g_object_unref(task);
+        task = g_task_new(G_OBJECT(collection), NULL,
+                          ovirt_collection_revalidate_done,
+                          g_object_ref(proxy));
+        cancellable = NULL;
+    }
+    /* The resources are built in the thread parsing the response, only
+     * the changes to the collection are made from its main context */
+    prepared = ovirt_collection_prepared_new(collection, proxy);
+    ovirt_proxy_get_collection_xml_full_async(proxy, href,
+                                              collection->priv->collection_xml_name,
+                                              &collection->priv->validators,
+                                              task, cancellable,
+                                              ovirt_collection_prepare,
+                                              ovirt_collection_prepared_ref(prepared),
+                                              (GDestroyNotify)ovirt_collection_prepared_unref,
+                                              ovirt_collection_fetch_async_cb,
+                                              prepared,
+                                              (GDestroyNotify)ovirt_collection_prepared_unref);
 }
 
 
@@ -433,6 +1767,7 @@ void ovirt_collection_fetch_async(OvirtCollection *collection,
                                   gpointer user_data)
 {
     GTask *task;
+    char *href;
 
     g_return_if_fail(OVIRT_IS_COLLECTION(collection));
     g_return_if_fail(OVIRT_IS_PROXY(proxy));
@@ -442,10 +1777,10 @@ void ovirt_collection_fetch_async(OvirtCollection *collection,
                       cancellable,
                       callback,
                       user_data);
-    ovirt_proxy_get_collection_xml_async(proxy, collection->priv->href,
-                                         task, cancellable,
-                                         ovirt_collection_fetch_async_cb,
-                                         collection, NULL);
+    href = ovirt_collection_get_href(collection);
+    ovirt_collection_fetch_href_async(collection, proxy, href,
+                                      task, cancellable);
+    g_free(href);
 }
 
 
@@ -468,6 +1803,65 @@ gboolean ovirt_collection_fetch_finish(OvirtCollection *collection,
 }
 
 
+/**
+ * ovirt_collection_fetch_page_async:
+ * @collection: a #OvirtCollection
+ * @proxy: a #OvirtProxy
+ * @page: number of the page to fetch, starting from 1
+ * @page_size: maximum number of resources in a page
+ * @cancellable: (allow-none): a #GCancellable
+ * @callback: (scope async): completion callback
+ * @user_data: (closure): opaque data for callback
+ *
+ * Asynchronous version of ovirt_collection_fetch_page().
+ *
+ * Since: 0.3.12
+ */
+void ovirt_collection_fetch_page_async(OvirtCollection *collection,
+                                       OvirtProxy *proxy,
+                                       guint page,
+                                       guint page_size,
+                                       GCancellable *cancellable,
+                                       GAsyncReadyCallback callback,
+                                       gpointer user_data)
+{
+    GTask *task;
+    char *href;
+
+    g_return_if_fail(OVIRT_IS_COLLECTION(collection));
+    g_return_if_fail(OVIRT_IS_PROXY(proxy));
+    g_return_if_fail(page > 0);
+    g_return_if_fail(page_size > 0);
+    g_return_if_fail((cancellable == NULL) || G_IS_CANCELLABLE(cancellable));
+
+    task = g_task_new(G_OBJECT(collection),
+                      cancellable,
+                      callback,
+                      user_data);
+    href = ovirt_collection_get_page_href(collection, page, page_size);
+    ovirt_collection_fetch_href_async(collection, proxy, href,
+                                      task, cancellable);
+    g_free(href);
+}
+
+
+/**
+ * ovirt_collection_fetch_page_finish:
+ * @collection: a #OvirtCollection
+ * @result: async method result
+ *
+ * Return value: TRUE if successful, FALSE otherwise, with @error set.
+ *
+ * Since: 0.3.12
+ */
+gboolean ovirt_collection_fetch_page_finish(OvirtCollection *collection,
+                                            GAsyncResult *result,
+                                            GError **err)
+{
+    return ovirt_collection_fetch_finish(collection, result, err);
+}
+
+
 /**
  * ovirt_collection_lookup_resource:
  * @collection: a #OvirtCollection
@@ -502,3 +1896,111 @@ OvirtResource *ovirt_collection_lookup_resource(OvirtCollection *collection,
 
     return g_object_ref(resource);
 }
+
+
+/**
+ * ovirt_collection_lookup_resource_by_id:
+ * @collection: a #OvirtCollection
+ * @id: guid of the resource to lookup
+ *
+ * Looks up a resource in @collection whose guid is @id. If it cannot be
+ * found, NULL is returned. Unlike ovirt_collection_lookup_resource(), this
+ * can find resources whose name is shared with another resource of
+ * @collection. This method does not initiate any network activity, the
+ * remote collection content must have been fetched with
+ * ovirt_collection_fetch() or ovirt_collection_fetch_async() before
+ * calling this function.
+ *
+ * Return value: (transfer full): a #OvirtResource whose guid is @id
+ * or NULL
+ *
+ * Since: 0.3.12
+ */
+OvirtResource *ovirt_collection_lookup_resource_by_id(OvirtCollection *collection,
+                                                      const char *id)
+{
+    OvirtResource *resource;
+
+    g_return_val_if_fail(OVIRT_IS_COLLECTION(collection), NULL);
+    g_return_val_if_fail(id != NULL, NULL);
+
+    if (collection->priv->resources_by_id == NULL) {
+        return NULL;
+    }
+
+    resource = g_hash_table_lookup(collection->priv->resources_by_id, id);
+
+    if (resource == NULL) {
+        return NULL;
+    }
+
+    return g_object_ref(resource);
+}
+
+
+/**
+ * ovirt_collection_lookup_resource_by_href:
+ * @collection: a #OvirtCollection
+ * @href: href of the resource to lookup
+ *
+ * Looks up a resource in @collection whose href is @href. If it cannot be
+ * found, NULL is returned. See ovirt_collection_lookup_resource_by_id().
+ *
+ * Return value: (transfer full): a #OvirtResource whose href is @href
+ * or NULL
+ *
+ * Since: 0.3.12
+ */
+OvirtResource *ovirt_collection_lookup_resource_by_href(OvirtCollection *collection,
+                                                        const char *href)
+{
+    OvirtResource *resource;
+
+    g_return_val_if_fail(OVIRT_IS_COLLECTION(collection), NULL);
+    g_return_val_if_fail(href != NULL, NULL);
+
+    if (collection->priv->resources_by_href == NULL) {
+        return NULL;
+    }
+
+    resource = g_hash_table_lookup(collection->priv->resources_by_href, href);
+
+    if (resource == NULL) {
+        return NULL;
+    }
+
+    return g_object_ref(resource);
+}
+
+
+/**
+ * ovirt_collection_get_retained_xml_size:
+ * @collection: a #OvirtCollection
+ *
+ * Estimates how much memory is used by the XML descriptions the resources
+ * of @collection keep, see #OvirtCollection:xml-retention.
+ *
+ * Return value: the approximate size in bytes of the retained XML data
+ *
+ * Since: 0.3.12
+ */
+gsize ovirt_collection_get_retained_xml_size(OvirtCollection *collection)
+{
+    GHashTable *resources;
+    GHashTableIter iter;
+    gpointer value;
+    gsize size = 0;
+
+    g_return_val_if_fail(OVIRT_IS_COLLECTION(collection), 0);
+
+    resources = ovirt_collection_get_all_resources(collection);
+    if (resources == NULL) {
+        return 0;
+    }
+    g_hash_table_iter_init(&iter, resources);
+    while (g_hash_table_iter_next(&iter, NULL, &value)) {
+        size += ovirt_resource_get_retained_xml_size(OVIRT_RESOURCE(value));
+    }
+
+    return size;
+}
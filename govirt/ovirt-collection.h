@@ -60,6 +60,11 @@ GHashTable *ovirt_collection_get_resources(OvirtCollection *collection);
 
 OvirtResource *ovirt_collection_lookup_resource(OvirtCollection *collection,
                                                 const char *name);
+OvirtResource *ovirt_collection_lookup_resource_by_id(OvirtCollection *collection,
+                                                      const char *id);
+OvirtResource *ovirt_collection_lookup_resource_by_href(OvirtCollection *collection,
+                                                        const char *href);
+gsize ovirt_collection_get_retained_xml_size(OvirtCollection *collection);
 gboolean ovirt_collection_fetch(OvirtCollection *collection,
                                 OvirtProxy *proxy,
                                 GError **error);
@@ -71,6 +76,21 @@ void ovirt_collection_fetch_async(OvirtCollection *collection,
 gboolean ovirt_collection_fetch_finish(OvirtCollection *collection,
                                        GAsyncResult *result,
                                        GError **err);
+gboolean ovirt_collection_fetch_page(OvirtCollection *collection,
+                                     OvirtProxy *proxy,
+                                     guint page,
+                                     guint page_size,
+                                     GError **error);
+void ovirt_collection_fetch_page_async(OvirtCollection *collection,
+                                       OvirtProxy *proxy,
+                                       guint page,
+                                       guint page_size,
+                                       GCancellable *cancellable,
+                                       GAsyncReadyCallback callback,
+                                       gpointer user_data);
+gboolean ovirt_collection_fetch_page_finish(OvirtCollection *collection,
+                                            GAsyncResult *result,
+                                            GError **err);
 
 G_END_DECLS
 
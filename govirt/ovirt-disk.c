@@ -43,6 +43,8 @@ static void ovirt_disk_get_property(GObject *object,
 {
     OvirtDisk *disk = OVIRT_DISK(object);
 
+    ovirt_resource_materialize(OVIRT_RESOURCE(object));
+
     switch (prop_id) {
     case PROP_CONTENT_TYPE:
         g_value_set_enum(value, disk->priv->content_type);
@@ -60,6 +62,8 @@ static void ovirt_disk_set_property(GObject *object,
 {
     OvirtDisk *disk = OVIRT_DISK(object);
 
+    ovirt_resource_materialize(OVIRT_RESOURCE(object));
+
     switch (prop_id) {
     case PROP_CONTENT_TYPE:
         disk->priv->content_type = g_value_get_enum(value);
@@ -76,7 +80,7 @@ static gboolean ovirt_disk_init_from_xml(OvirtResource *resource,
 {
     gboolean parsed_ok;
     OvirtResourceClass *parent_class;
-    OvirtXmlElement disk_elements[] = {
+    static const OvirtXmlElement disk_elements[] = {
         { .prop_name = "content-type",
           .xml_path = "content_type",
         },
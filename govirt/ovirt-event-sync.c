@@ -0,0 +1,620 @@
+/*
+ * ovirt-event-sync.c: event-driven synchronization of oVirt collections
+ *
+ * Copyright (C) 2026 Red Hat, Inc.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library. If not, see
+ * <http://www.gnu.org/licenses/>.
+ */
+
+#include <config.h>
+
+#include <glib/gi18n-lib.h>
+
+#include "ovirt-error.h"
+#include "ovirt-event-sync.h"
+#include "govirt-private.h"
+
+/**
+ * SECTION:ovirt-event-sync
+ * @short_description: keeps collections up to date using the event feed
+ *
+ * #OvirtEventSync keeps the virtual machines, hosts and storage domains
+ * collections of the #OvirtApi of a proxy up to date without fetching them
+ * again and again. Each call to ovirt_event_sync_run_async() reads the
+ * events which occurred since the previous call, and only fetches again
+ * the resources these events refer to. The usual
+ * #OvirtCollection::resource-added, #OvirtCollection::resource-removed and
+ * #OvirtCollection::resource-changed signals are emitted for them.
+ *
+ * Only the collections which were fetched at least once are kept up to
+ * date. When the server no longer has all the events which occurred since
+ * the previous call, these collections are fetched again instead.
+ *
+ * The #OvirtEventSync:last-event-id property can be saved and restored to
+ * resume synchronization from the same point later on.
+ */
+
+struct _OvirtEventSyncPrivate {
+    OvirtProxy *proxy;
+    /* 0 until the first synchronization */
+    guint64 last_event_id;
+    gboolean running;
+};
+
+G_DEFINE_TYPE_WITH_PRIVATE(OvirtEventSync, ovirt_event_sync, G_TYPE_OBJECT);
+
+
+enum {
+    PROP_0,
+    PROP_PROXY,
+    PROP_LAST_EVENT_ID,
+};
+
+
+/* Collections kept up to date, and the name of the nodes through which
+ * events refer to their resources */
+static const struct {
+    const char *node_name;
+    OvirtCollection *(*get)(OvirtApi *api);
+} ovirt_event_sync_collections[] = {
+    { "host", ovirt_api_get_hosts },
+    { "storage_domain", ovirt_api_get_storage_domains },
+    { "vm", ovirt_api_get_vms },
+};
+
+
+static void ovirt_event_sync_get_property(GObject *object,
+                                          guint prop_id,
+                                          GValue *value,
+                                          GParamSpec *pspec)
+{
+    OvirtEventSync *sync = OVIRT_EVENT_SYNC(object);
+
+    switch (prop_id) {
+    case PROP_PROXY:
+        g_value_set_object(value, sync->priv->proxy);
+        break;
+    case PROP_LAST_EVENT_ID:
+        g_value_set_uint64(value, sync->priv->last_event_id);
+        break;
+    default:
+        G_OBJECT_WARN_INVALID_PROPERTY_ID(object, prop_id, pspec);
+        break;
+    }
+}
+
+
+static void ovirt_event_sync_set_property(GObject *object,
+                                          guint prop_id,
+                                          const GValue *value,
+                                          GParamSpec *pspec)
+{
+    OvirtEventSync *sync = OVIRT_EVENT_SYNC(object);
+
+    switch (prop_id) {
+    case PROP_PROXY:
+        sync->priv->proxy = g_value_dup_object(value);
+        break;
+    case PROP_LAST_EVENT_ID:
+        sync->priv->last_event_id = g_value_get_uint64(value);
+        break;
+    default:
+        G_OBJECT_WARN_INVALID_PROPERTY_ID(object, prop_id, pspec);
+        break;
+    }
+}
+
+
+static void ovirt_event_sync_dispose(GObject *object)
+{
+    OvirtEventSync *sync = OVIRT_EVENT_SYNC(object);
+
+    g_clear_object(&sync->priv->proxy);
+
+    G_OBJECT_CLASS(ovirt_event_sync_parent_class)->dispose(object);
+}
+
+
+static void ovirt_event_sync_class_init(OvirtEventSyncClass *klass)
+{
+    GObjectClass *object_class = G_OBJECT_CLASS(klass);
+    GParamSpec *param_spec;
+
+    object_class->dispose = ovirt_event_sync_dispose;
+    object_class->get_property = ovirt_event_sync_get_property;
+    object_class->set_property = ovirt_event_sync_set_property;
+
+    param_spec = g_param_spec_object("proxy",
+                                     "Proxy",
+                                     "Proxy whose collections are kept up to date",
+                                     OVIRT_TYPE_PROXY,
+                                     G_PARAM_READWRITE |
+                                     G_PARAM_CONSTRUCT_ONLY |
+                                     G_PARAM_STATIC_STRINGS);
+    g_object_class_install_property(object_class,
+                                    PROP_PROXY,
+                                    param_spec);
+
+    /**
+     * OvirtEventSync:last-event-id:
+     *
+     * Id of the most recent event which was processed, or 0 when the
+     * collections were never synchronized. It is updated once all the
+     * changes an event refers to have been applied.
+     *
+     * Since: 0.3.12
+     */
+    param_spec = g_param_spec_uint64("last-event-id",
+                                     "Last event id",
+                                     "Id of the most recent processed event",
+                                     0, G_MAXUINT64,
+                                     0,
+                                     G_PARAM_READWRITE |
+                                     G_PARAM_EXPLICIT_NOTIFY |
+                                     G_PARAM_STATIC_STRINGS);
+    g_object_class_install_property(object_class,
+                                    PROP_LAST_EVENT_ID,
+                                    param_spec);
+}
+
+
+static void ovirt_event_sync_init(OvirtEventSync *sync)
+{
+    sync->priv = ovirt_event_sync_get_instance_private(sync);
+}
+
+
+/**
+ * ovirt_event_sync_new:
+ * @proxy: a #OvirtProxy
+ *
+ * Creates a new object keeping the collections of the #OvirtApi of @proxy
+ * up to date. ovirt_proxy_fetch_api() must have been called on @proxy
+ * before synchronizing.
+ *
+ * Return value: (transfer full): a new #OvirtEventSync
+ *
+ * Since: 0.3.12
+ */
+OvirtEventSync *ovirt_event_sync_new(OvirtProxy *proxy)
+{
+    g_return_val_if_fail(OVIRT_IS_PROXY(proxy), NULL);
+
+    return OVIRT_EVENT_SYNC(g_object_new(OVIRT_TYPE_EVENT_SYNC,
+                                         "proxy", proxy,
+                                         NULL));
+}
+
+
+/* Task data of ovirt_event_sync_run_async() */
+typedef struct {
+    OvirtApi *api;
+    char *events_href;
+    /* Id of the most recent event the server returned */
+    guint64 newest_id;
+    /* Requests which did not complete yet */
+    guint pending;
+    /* Error of the first request which failed */
+    GError *error;
+} OvirtEventSyncRound;
+
+static void ovirt_event_sync_round_free(OvirtEventSyncRound *round)
+{
+    g_clear_object(&round->api);
+    g_free(round->events_href);
+    g_clear_error(&round->error);
+    g_slice_free(OvirtEventSyncRound, round);
+}
+
+
+/* GET of a resource an event referred to */
+typedef struct {
+    GTask *task;
+    OvirtCollection *collection;
+    char *href;
+} OvirtEventSyncUpdate;
+
+static void ovirt_event_sync_update_free(OvirtEventSyncUpdate *update)
+{
+    g_object_unref(update->collection);
+    g_free(update->href);
+    g_slice_free(OvirtEventSyncUpdate, update);
+}
+
+
+/* ovirt_proxy_get_collection_xml_async() is not used as these requests
+ * must never be answered from the response cache, and as resources which
+ * were removed are told apart from other errors by the HTTP status */
+static void ovirt_event_sync_get_async(OvirtEventSync *sync,
+                                       const char *href,
+                                       GCancellable *cancellable,
+                                       GAsyncReadyCallback callback,
+                                       gpointer user_data)
+{
+    RestProxyCall *call;
+
+    call = REST_PROXY_CALL(ovirt_action_rest_call_new(REST_PROXY(sync->priv->proxy)));
+    rest_proxy_call_set_method(call, "GET");
+    rest_proxy_call_set_function(call, href);
+    rest_proxy_call_invoke_async(call, cancellable, callback, user_data);
+    g_object_unref(call);
+}
+
+
+static void ovirt_event_sync_round_add_error(OvirtEventSyncRound *round,
+                                             GError *error)
+{
+    if (round->error == NULL) {
+        round->error = error;
+    } else {
+        g_error_free(error);
+    }
+}
+
+
+/* Called when a request of the round completes, the round is over once
+ * all of them did */
+static void ovirt_event_sync_request_done(GTask *task)
+{
+    OvirtEventSync *sync = OVIRT_EVENT_SYNC(g_task_get_source_object(task));
+    OvirtEventSyncRound *round = g_task_get_task_data(task);
+
+    g_return_if_fail(round->pending != 0);
+
+    round->pending--;
+    if (round->pending != 0) {
+        return;
+    }
+
+    sync->priv->running = FALSE;
+    if (round->error != NULL) {
+        /* The same events will be processed again by the next round */
+        g_task_return_error(task, round->error);
+        round->error = NULL;
+    } else {
+        if ((round->newest_id != 0) &&
+            (round->newest_id != sync->priv->last_event_id)) {
+            sync->priv->last_event_id = round->newest_id;
+            g_object_notify(G_OBJECT(sync), "last-event-id");
+        }
+        g_task_return_boolean(task, TRUE);
+    }
+    g_object_unref(task);
+}
+
+
+static void ovirt_event_sync_fetch_cb(GObject *source_object,
+                                      GAsyncResult *result,
+                                      gpointer user_data)
+{
+    GTask *task = G_TASK(user_data);
+    GError *error = NULL;
+
+    if (!ovirt_collection_fetch_finish(OVIRT_COLLECTION(source_object),
+                                       result, &error)) {
+        ovirt_event_sync_round_add_error(g_task_get_task_data(task), error);
+    }
+    ovirt_event_sync_request_done(task);
+}
+
+
+/* Fetches again all the collections which are kept up to date */
+static void ovirt_event_sync_fetch_all(GTask *task)
+{
+    OvirtEventSync *sync = OVIRT_EVENT_SYNC(g_task_get_source_object(task));
+    OvirtEventSyncRound *round = g_task_get_task_data(task);
+    guint i;
+
+    /* Keeps the round alive until all the fetches are started */
+    round->pending++;
+    ovirt_proxy_discard_parsed_responses(sync->priv->proxy);
+    for (i = 0; i < G_N_ELEMENTS(ovirt_event_sync_collections); i++) {
+        OvirtCollection *collection;
+
+        collection = ovirt_event_sync_collections[i].get(round->api);
+        if ((collection == NULL) ||
+            (ovirt_collection_get_resources(collection) == NULL)) {
+            continue;
+        }
+        round->pending++;
+        ovirt_collection_fetch_async(collection, sync->priv->proxy,
+                                     g_task_get_cancellable(task),
+                                     ovirt_event_sync_fetch_cb, task);
+    }
+    ovirt_event_sync_request_done(task);
+}
+
+
+static void ovirt_event_sync_update_cb(GObject *source_object,
+                                       GAsyncResult *result,
+                                       gpointer user_data)
+{
+    RestProxyCall *call = REST_PROXY_CALL(source_object);
+    OvirtEventSyncUpdate *update = user_data;
+    GTask *task = update->task;
+    OvirtEventSync *sync = OVIRT_EVENT_SYNC(g_task_get_source_object(task));
+    RestXmlNode *root;
+    GError *error = NULL;
+    gboolean succeeded;
+
+    succeeded = rest_proxy_call_invoke_finish(call, result, &error);
+    ovirt_proxy_account_response(sync->priv->proxy, call);
+    if (!succeeded) {
+        if (rest_proxy_call_get_status_code(call) == 404) {
+            g_clear_error(&error);
+            ovirt_collection_remove_resource(update->collection, update->href);
+        }
+    } else {
+        /* The root element of JSON responses can't be guessed from the
+         * href of a single resource */
+        root = ovirt_rest_xml_node_from_call_full(call,
+                                                  ovirt_collection_get_resource_xml_name(update->collection));
+        if (root == NULL) {
+            g_set_error(&error, OVIRT_ERROR, OVIRT_ERROR_PARSING_FAILED,
+                        _("Failed to parse response from resource"));
+        } else {
+            ovirt_collection_update_resource_from_xml(update->collection,
+                                                      sync->priv->proxy,
+                                                      root, &error);
+            rest_xml_node_unref(root);
+        }
+    }
+    if (error != NULL) {
+        ovirt_event_sync_round_add_error(g_task_get_task_data(task), error);
+    }
+
+    ovirt_event_sync_update_free(update);
+    ovirt_event_sync_request_done(task);
+}
+
+
+static void ovirt_event_sync_update(GTask *task,
+                                    OvirtCollection *collection,
+                                    const char *href)
+{
+    OvirtEventSync *sync = OVIRT_EVENT_SYNC(g_task_get_source_object(task));
+    OvirtEventSyncRound *round = g_task_get_task_data(task);
+    OvirtEventSyncUpdate *update;
+
+    update = g_slice_new0(OvirtEventSyncUpdate);
+    update->task = task;
+    update->collection = g_object_ref(collection);
+    update->href = g_strdup(href);
+
+    round->pending++;
+    ovirt_event_sync_get_async(sync, href, g_task_get_cancellable(task),
+                               ovirt_event_sync_update_cb, update);
+}
+
+
+static guint64 ovirt_event_sync_get_event_id(RestXmlNode *node)
+{
+    const char *id = rest_xml_node_get_attr(node, "id");
+
+    if (id == NULL) {
+        return 0;
+    }
+
+    return g_ascii_strtoull(id, NULL, 10);
+}
+
+
+/* Collects the hrefs of the resources @node refers to, each resource is
+ * only fetched once however many events refer to it */
+static void ovirt_event_sync_add_updates(OvirtEventSyncRound *round,
+                                         RestXmlNode *node,
+                                         GHashTable *updates)
+{
+    guint i;
+
+    for (i = 0; i < G_N_ELEMENTS(ovirt_event_sync_collections); i++) {
+        OvirtCollection *collection;
+        RestXmlNode *child;
+        const char *href;
+
+        child = g_hash_table_lookup(node->children,
+                                    g_intern_string(ovirt_event_sync_collections[i].node_name));
+        if (child == NULL) {
+            continue;
+        }
+        href = rest_xml_node_get_attr(child, "href");
+        if (href == NULL) {
+            continue;
+        }
+        collection = ovirt_event_sync_collections[i].get(round->api);
+        if ((collection == NULL) ||
+            (ovirt_collection_get_resources(collection) == NULL)) {
+            continue;
+        }
+        g_hash_table_insert(updates, (gpointer)href, collection);
+    }
+}
+
+
+static void ovirt_event_sync_events_cb(GObject *source_object,
+                                       GAsyncResult *result,
+                                       gpointer user_data)
+{
+    RestProxyCall *call = REST_PROXY_CALL(source_object);
+    GTask *task = G_TASK(user_data);
+    OvirtEventSync *sync = OVIRT_EVENT_SYNC(g_task_get_source_object(task));
+    OvirtEventSyncRound *round = g_task_get_task_data(task);
+    guint64 last_event_id = sync->priv->last_event_id;
+    RestXmlNode *root;
+    RestXmlNode *events;
+    RestXmlNode *node;
+    GHashTable *updates;
+    GHashTableIter iter;
+    gpointer href;
+    gpointer collection;
+    gboolean found_last = FALSE;
+    GError *error = NULL;
+    gboolean succeeded;
+
+    succeeded = rest_proxy_call_invoke_finish(call, result, &error);
+    ovirt_proxy_account_response(sync->priv->proxy, call);
+    if (!succeeded) {
+        ovirt_event_sync_round_add_error(round, error);
+        ovirt_event_sync_request_done(task);
+        return;
+    }
+    root = ovirt_rest_xml_node_from_call(call);
+    if ((root == NULL) || (g_strcmp0(root->name, "events") != 0)) {
+        g_set_error(&error, OVIRT_ERROR, OVIRT_ERROR_PARSING_FAILED,
+                    _("Failed to parse response from collection"));
+        ovirt_event_sync_round_add_error(round, error);
+        ovirt_event_sync_request_done(task);
+        if (root != NULL) {
+            rest_xml_node_unref(root);
+        }
+        return;
+    }
+
+    events = g_hash_table_lookup(root->children, g_intern_string("event"));
+    for (node = events; node != NULL; node = node->next) {
+        guint64 id = ovirt_event_sync_get_event_id(node);
+
+        round->newest_id = MAX(round->newest_id, id);
+        if ((id != 0) && (id == last_event_id)) {
+            found_last = TRUE;
+        }
+    }
+
+    /* The events are requested starting with the last processed one, if
+     * the server no longer has it, some of the events which followed it
+     * may be gone as well */
+    if (!found_last) {
+        if (last_event_id != 0) {
+            g_debug("Event %" G_GUINT64_FORMAT " is no longer available, "
+                    "fetching all the collections again", last_event_id);
+        }
+        ovirt_event_sync_fetch_all(task);
+        ovirt_event_sync_request_done(task);
+        rest_xml_node_unref(root);
+        return;
+    }
+
+    updates = g_hash_table_new(g_str_hash, g_str_equal);
+    for (node = events; node != NULL; node = node->next) {
+        if (ovirt_event_sync_get_event_id(node) > last_event_id) {
+            ovirt_event_sync_add_updates(round, node, updates);
+        }
+    }
+    if (g_hash_table_size(updates) != 0) {
+        ovirt_proxy_discard_parsed_responses(sync->priv->proxy);
+    }
+    g_hash_table_iter_init(&iter, updates);
+    while (g_hash_table_iter_next(&iter, &href, &collection)) {
+        ovirt_event_sync_update(task, OVIRT_COLLECTION(collection), href);
+    }
+    g_hash_table_unref(updates);
+    rest_xml_node_unref(root);
+
+    ovirt_event_sync_request_done(task);
+}
+
+
+/**
+ * ovirt_event_sync_run_async:
+ * @sync: a #OvirtEventSync
+ * @cancellable: (allow-none): a #GCancellable
+ * @callback: (scope async): completion callback
+ * @user_data: (closure): opaque data for callback
+ *
+ * Applies the changes described by the events which occurred since the
+ * previous call to the collections being kept up to date. The first call
+ * fetches these collections again, and records the id of the most recent
+ * event. Only one call can be pending at a time, the application is
+ * expected to call this method periodically.
+ *
+ * Since: 0.3.12
+ */
+void ovirt_event_sync_run_async(OvirtEventSync *sync,
+                                GCancellable *cancellable,
+                                GAsyncReadyCallback callback,
+                                gpointer user_data)
+{
+    OvirtEventSyncPrivate *priv;
+    OvirtEventSyncRound *round;
+    OvirtApi *api;
+    const char *events_href = NULL;
+    char *href;
+    GTask *task;
+
+    g_return_if_fail(OVIRT_IS_EVENT_SYNC(sync));
+    g_return_if_fail((cancellable == NULL) || G_IS_CANCELLABLE(cancellable));
+
+    priv = sync->priv;
+    task = g_task_new(G_OBJECT(sync), cancellable, callback, user_data);
+    if (priv->running) {
+        g_task_return_new_error(task, G_IO_ERROR, G_IO_ERROR_PENDING,
+                                _("Synchronization is already in progress"));
+        g_object_unref(task);
+        return;
+    }
+    api = ovirt_proxy_get_api(priv->proxy);
+    if (api != NULL) {
+        events_href = ovirt_resource_get_sub_collection(OVIRT_RESOURCE(api),
+                                                        "events");
+    }
+    if (events_href == NULL) {
+        g_task_return_new_error(task, OVIRT_ERROR, OVIRT_ERROR_FAILED,
+                                _("Could not find events collection"));
+        g_object_unref(task);
+        return;
+    }
+
+    round = g_slice_new0(OvirtEventSyncRound);
+    round->api = g_object_ref(api);
+    round->events_href = g_strdup(events_href);
+    round->pending = 1;
+    g_task_set_task_data(task, round,
+                         (GDestroyNotify)ovirt_event_sync_round_free);
+    priv->running = TRUE;
+
+    if (priv->last_event_id == 0) {
+        /* Only the id of the most recent event is needed */
+        href = g_strdup_printf("%s?max=1", events_href);
+    } else {
+        href = g_strdup_printf("%s?from=%" G_GUINT64_FORMAT, events_href,
+                               priv->last_event_id - 1);
+    }
+    ovirt_event_sync_get_async(sync, href, cancellable,
+                               ovirt_event_sync_events_cb, task);
+    g_free(href);
+}
+
+
+/**
+ * ovirt_event_sync_run_finish:
+ * @sync: a #OvirtEventSync
+ * @result: async method result
+ * @err: #GError to set on error, or NULL
+ *
+ * Return value: TRUE if all the changes were applied, FALSE otherwise,
+ * in which case they will be applied again by the next call to
+ * ovirt_event_sync_run_async().
+ *
+ * Since: 0.3.12
+ */
+gboolean ovirt_event_sync_run_finish(OvirtEventSync *sync,
+                                     GAsyncResult *result,
+                                     GError **err)
+{
+    g_return_val_if_fail(OVIRT_IS_EVENT_SYNC(sync), FALSE);
+    g_return_val_if_fail(g_task_is_valid(G_TASK(result), sync), FALSE);
+
+    return g_task_propagate_boolean(G_TASK(result), err);
+}
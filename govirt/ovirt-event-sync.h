@@ -0,0 +1,68 @@
+/*
+ * ovirt-event-sync.h: event-driven synchronization of oVirt collections
+ *
+ * Copyright (C) 2026 Red Hat, Inc.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library. If not, see
+ * <http://www.gnu.org/licenses/>.
+ */
+#ifndef __OVIRT_EVENT_SYNC_H__
+#define __OVIRT_EVENT_SYNC_H__
+
+#include <gio/gio.h>
+#include <glib-object.h>
+#include <govirt/ovirt-types.h>
+
+G_BEGIN_DECLS
+
+#define OVIRT_TYPE_EVENT_SYNC            (ovirt_event_sync_get_type ())
+#define OVIRT_EVENT_SYNC(obj)            (G_TYPE_CHECK_INSTANCE_CAST ((obj), OVIRT_TYPE_EVENT_SYNC, OvirtEventSync))
+#define OVIRT_EVENT_SYNC_CLASS(klass)    (G_TYPE_CHECK_CLASS_CAST ((klass), OVIRT_TYPE_EVENT_SYNC, OvirtEventSyncClass))
+#define OVIRT_IS_EVENT_SYNC(obj)         (G_TYPE_CHECK_INSTANCE_TYPE ((obj), OVIRT_TYPE_EVENT_SYNC))
+#define OVIRT_IS_EVENT_SYNC_CLASS(klass) (G_TYPE_CHECK_CLASS_TYPE ((klass), OVIRT_TYPE_EVENT_SYNC))
+#define OVIRT_EVENT_SYNC_GET_CLASS(obj)  (G_TYPE_INSTANCE_GET_CLASS ((obj), OVIRT_TYPE_EVENT_SYNC, OvirtEventSyncClass))
+
+typedef struct _OvirtEventSyncPrivate OvirtEventSyncPrivate;
+typedef struct _OvirtEventSyncClass OvirtEventSyncClass;
+
+struct _OvirtEventSync
+{
+    GObject parent;
+
+    OvirtEventSyncPrivate *priv;
+
+    /* Do not add fields to this struct */
+};
+
+struct _OvirtEventSyncClass
+{
+    GObjectClass parent_class;
+
+    gpointer padding[20];
+};
+
+GType ovirt_event_sync_get_type(void);
+
+OvirtEventSync *ovirt_event_sync_new(OvirtProxy *proxy);
+void ovirt_event_sync_run_async(OvirtEventSync *sync,
+                                GCancellable *cancellable,
+                                GAsyncReadyCallback callback,
+                                gpointer user_data);
+gboolean ovirt_event_sync_run_finish(OvirtEventSync *sync,
+                                     GAsyncResult *result,
+                                     GError **err);
+
+G_END_DECLS
+
+#endif /* __OVIRT_EVENT_SYNC_H__ */
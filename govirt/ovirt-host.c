@@ -44,9 +44,11 @@ static const char *get_cluster_href(OvirtHost *host)
 {
     if (host->priv->cluster_href == NULL &&
         host->priv->cluster_id != NULL) {
-        host->priv->cluster_href = g_strdup_printf("%s/%s",
-                                                   "/ovirt-engine/api/clusters",
-                                                   host->priv->cluster_id);
+        char *href = g_strdup_printf("%s/%s",
+                                     "/ovirt-engine/api/clusters",
+                                     host->priv->cluster_id);
+        ovirt_utils_set_interned_string(&host->priv->cluster_href, href);
+        g_free(href);
     }
 
     return host->priv->cluster_href;
@@ -59,6 +61,8 @@ static void ovirt_host_get_property(GObject *object,
 {
     OvirtHost *host = OVIRT_HOST(object);
 
+    ovirt_resource_materialize(OVIRT_RESOURCE(object));
+
     switch (prop_id) {
     case PROP_CLUSTER_HREF:
         g_value_set_string(value, get_cluster_href(host));
@@ -78,14 +82,14 @@ static void ovirt_host_set_property(GObject *object,
 {
     OvirtHost *host = OVIRT_HOST(object);
 
+    ovirt_resource_materialize(OVIRT_RESOURCE(object));
+
     switch (prop_id) {
     case PROP_CLUSTER_HREF:
-        g_free(host->priv->cluster_href);
-        host->priv->cluster_href = g_value_dup_string(value);
+        ovirt_utils_set_interned_string(&host->priv->cluster_href, g_value_get_string(value));
         break;
     case PROP_CLUSTER_ID:
-        g_free(host->priv->cluster_id);
-        host->priv->cluster_id = g_value_dup_string(value);
+        ovirt_utils_set_interned_string(&host->priv->cluster_id, g_value_get_string(value));
         break;
     default:
         G_OBJECT_WARN_INVALID_PROPERTY_ID(object, prop_id, pspec);
@@ -98,8 +102,8 @@ ovirt_host_dispose(GObject *obj)
 {
     OvirtHost *host = OVIRT_HOST(obj);
 
-    g_clear_pointer(&host->priv->cluster_href, g_free);
-    g_clear_pointer(&host->priv->cluster_id, g_free);
+    g_clear_pointer(&host->priv->cluster_href, g_ref_string_release);
+    g_clear_pointer(&host->priv->cluster_id, g_ref_string_release);
     g_clear_object(&host->priv->vms);
 
     G_OBJECT_CLASS(ovirt_host_parent_class)->dispose(obj);
@@ -111,7 +115,7 @@ static gboolean ovirt_host_init_from_xml(OvirtResource *resource,
                                          GError **error)
 {
     OvirtResourceClass *parent_class;
-    OvirtXmlElement host_elements[] = {
+    static const OvirtXmlElement host_elements[] = {
         { .prop_name = "cluster-href",
           .xml_path = "cluster",
           .xml_attr = "href",
@@ -235,6 +239,10 @@ OvirtCollection *ovirt_host_get_vms(OvirtHost *host)
 OvirtCluster *ovirt_host_get_cluster(OvirtHost *host)
 {
     g_return_val_if_fail(OVIRT_IS_HOST(host), NULL);
+    ovirt_resource_materialize(OVIRT_RESOURCE(host));
     g_return_val_if_fail(host->priv->cluster_id != NULL, NULL);
-    return ovirt_cluster_new_from_id(host->priv->cluster_id, get_cluster_href(host));
+    return OVIRT_CLUSTER(ovirt_resource_get_related(OVIRT_RESOURCE(host),
+                                                    OVIRT_TYPE_CLUSTER,
+                                                    host->priv->cluster_id,
+                                                    get_cluster_href(host)));
 }
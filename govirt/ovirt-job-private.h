@@ -0,0 +1,38 @@
+/*
+ * ovirt-job-private.h: oVirt job resource
+ *
+ * Copyright (C) 2026 Red Hat, Inc.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library. If not, see
+ * <http://www.gnu.org/licenses/>.
+ */
+#ifndef __OVIRT_JOB_PRIVATE_H__
+#define __OVIRT_JOB_PRIVATE_H__
+
+#include <govirt/ovirt-job.h>
+#include <rest/rest-xml-node.h>
+
+G_BEGIN_DECLS
+
+/* Polls the status of all the jobs being waited on through a given proxy */
+typedef struct _OvirtJobPoller OvirtJobPoller;
+
+OvirtJob *ovirt_job_new_from_xml(RestXmlNode *node, GError **error);
+void ovirt_job_set_status(OvirtJob *job, OvirtJobStatus status);
+
+void ovirt_job_poller_free(OvirtJobPoller *poller);
+
+G_END_DECLS
+
+#endif /* __OVIRT_JOB_PRIVATE_H__ */
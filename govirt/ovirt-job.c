@@ -0,0 +1,656 @@
+/*
+ * ovirt-job.c: oVirt job resource
+ *
+ * Copyright (C) 2026 Red Hat, Inc.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library. If not, see
+ * <http://www.gnu.org/licenses/>.
+ */
+
+#include <config.h>
+
+#include <glib/gi18n-lib.h>
+
+#include "ovirt-enum-types.h"
+#include "ovirt-error.h"
+#include "ovirt-job.h"
+#include "govirt-private.h"
+
+/**
+ * SECTION:ovirt-job
+ * @short_description: engine-side job tracking an action
+ *
+ * #OvirtJob is returned by ovirt_resource_submit_action_finish(). It
+ * tracks an action which the engine runs in the background, and
+ * ovirt_job_wait_async() can be used to be notified when it is over.
+ */
+
+/* Bounds of the delay between two polls of the jobs collection, in
+ * milliseconds. The delay is doubled each time a poll brings no news, and
+ * goes back to the minimum when a job changed or a new job is waited on. */
+#define OVIRT_JOB_POLL_MIN_INTERVAL 250
+#define OVIRT_JOB_POLL_MAX_INTERVAL 16000
+
+struct _OvirtJobPrivate {
+    char *description;
+    OvirtJobStatus status;
+};
+
+G_DEFINE_TYPE_WITH_PRIVATE(OvirtJob, ovirt_job, OVIRT_TYPE_RESOURCE);
+
+enum {
+    PROP_0,
+    PROP_DESCRIPTION,
+    PROP_STATUS,
+};
+
+
+static void ovirt_job_get_property(GObject *object,
+                                   guint prop_id,
+                                   GValue *value,
+                                   GParamSpec *pspec)
+{
+    OvirtJob *job = OVIRT_JOB(object);
+
+    ovirt_resource_materialize(OVIRT_RESOURCE(object));
+
+    switch (prop_id) {
+    case PROP_DESCRIPTION:
+        g_value_set_string(value, job->priv->description);
+        break;
+    case PROP_STATUS:
+        g_value_set_enum(value, job->priv->status);
+        break;
+    default:
+        G_OBJECT_WARN_INVALID_PROPERTY_ID(object, prop_id, pspec);
+    }
+}
+
+static void ovirt_job_set_property(GObject *object,
+                                   guint prop_id,
+                                   const GValue *value,
+                                   GParamSpec *pspec)
+{
+    OvirtJob *job = OVIRT_JOB(object);
+
+    ovirt_resource_materialize(OVIRT_RESOURCE(object));
+
+    switch (prop_id) {
+    case PROP_DESCRIPTION:
+        g_free(job->priv->description);
+        job->priv->description = g_value_dup_string(value);
+        break;
+    case PROP_STATUS:
+        job->priv->status = g_value_get_enum(value);
+        break;
+    default:
+        G_OBJECT_WARN_INVALID_PROPERTY_ID(object, prop_id, pspec);
+    }
+}
+
+
+static void ovirt_job_finalize(GObject *object)
+{
+    OvirtJob *job = OVIRT_JOB(object);
+
+    g_free(job->priv->description);
+
+    G_OBJECT_CLASS(ovirt_job_parent_class)->finalize(object);
+}
+
+
+static gboolean ovirt_job_init_from_xml(OvirtResource *resource,
+                                        RestXmlNode *node,
+                                        GError **error)
+{
+    OvirtResourceClass *parent_class;
+    static const OvirtXmlElement job_elements[] = {
+        { .prop_name = "description",
+          .xml_path = "description",
+        },
+        { .prop_name = "status",
+          .xml_path = "status",
+        },
+        { NULL , },
+    };
+
+    if (!ovirt_rest_xml_node_parse(node, G_OBJECT(resource), job_elements))
+        return FALSE;
+
+    parent_class = OVIRT_RESOURCE_CLASS(ovirt_job_parent_class);
+    return parent_class->init_from_xml(resource, node, error);
+}
+
+
+static void ovirt_job_class_init(OvirtJobClass *klass)
+{
+    GObjectClass *object_class = G_OBJECT_CLASS(klass);
+    OvirtResourceClass *resource_class = OVIRT_RESOURCE_CLASS(klass);
+    GParamSpec *param_spec;
+
+    resource_class->init_from_xml = ovirt_job_init_from_xml;
+    object_class->finalize = ovirt_job_finalize;
+    object_class->get_property = ovirt_job_get_property;
+    object_class->set_property = ovirt_job_set_property;
+
+    param_spec = g_param_spec_string("description",
+                                     "Description",
+                                     "Description of the job",
+                                     NULL,
+                                     G_PARAM_READWRITE |
+                                     G_PARAM_STATIC_STRINGS);
+    g_object_class_install_property(object_class,
+                                    PROP_DESCRIPTION,
+                                    param_spec);
+
+    param_spec = g_param_spec_enum("status",
+                                   "Status",
+                                   "Status of the job",
+                                   OVIRT_TYPE_JOB_STATUS,
+                                   OVIRT_JOB_STATUS_UNKNOWN,
+                                   G_PARAM_READWRITE |
+                                   G_PARAM_STATIC_STRINGS);
+    g_object_class_install_property(object_class,
+                                    PROP_STATUS,
+                                    param_spec);
+}
+
+static void ovirt_job_init(OvirtJob *job)
+{
+    job->priv = ovirt_job_get_instance_private(job);
+}
+
+G_GNUC_INTERNAL
+OvirtJob *ovirt_job_new_from_xml(RestXmlNode *node, GError **error)
+{
+    OvirtResource *job = ovirt_resource_new_from_xml(OVIRT_TYPE_JOB, node, error);
+    return OVIRT_JOB(job);
+}
+
+G_GNUC_INTERNAL
+void ovirt_job_set_status(OvirtJob *job, OvirtJobStatus status)
+{
+    g_object_set(G_OBJECT(job), "status", status, NULL);
+}
+
+/**
+ * ovirt_job_new:
+ *
+ * Return value: (transfer full): a new #OvirtJob
+ *
+ * Since: 0.3.12
+ */
+OvirtJob *ovirt_job_new(void)
+{
+    OvirtResource *job = ovirt_resource_new(OVIRT_TYPE_JOB);
+    return OVIRT_JOB(job);
+}
+
+
+static gboolean ovirt_job_is_over(OvirtJob *job, GError **error)
+{
+    switch (job->priv->status) {
+    case OVIRT_JOB_STATUS_FINISHED:
+        return TRUE;
+    case OVIRT_JOB_STATUS_FAILED:
+    case OVIRT_JOB_STATUS_ABORTED:
+        g_set_error(error, OVIRT_ERROR, OVIRT_ERROR_ACTION_FAILED,
+                    _("Job '%s' did not complete"),
+                    (job->priv->description != NULL) ? job->priv->description : "");
+        return TRUE;
+    case OVIRT_JOB_STATUS_UNKNOWN:
+    case OVIRT_JOB_STATUS_STARTED:
+    default:
+        return FALSE;
+    }
+}
+
+
+/* One poller is shared by all the jobs waited on through a given proxy: a
+ * single GET of the jobs collection updates all of them, so the number of
+ * requests does not grow with the number of jobs.
+ */
+struct _OvirtJobPoller {
+    /* Not owned, the proxy owns the poller */
+    OvirtProxy *proxy;
+    /* GTask for each ovirt_job_wait_async() call */
+    GPtrArray *waiting;
+
+    GCancellable *cancellable;
+    guint interval;
+    guint timeout_id;
+    gboolean polling;
+    /* Whether a job changed since the last poll */
+    gboolean changed;
+};
+
+/* Task data of ovirt_job_wait_async() */
+typedef struct {
+    /* Keeps the proxy, and thus the poller, alive while waiting */
+    OvirtProxy *proxy;
+    gulong cancelled_id;
+    GSource *cancelled_source;
+    /* Set while the job is refreshed on its own, as it was not in the
+     * jobs collection */
+    gboolean refreshing;
+} OvirtJobWait;
+
+static void ovirt_job_wait_free(OvirtJobWait *wait)
+{
+    g_warn_if_fail(wait->cancelled_source == NULL);
+    g_object_unref(wait->proxy);
+    g_slice_free(OvirtJobWait, wait);
+}
+
+static void ovirt_job_poller_poll(OvirtJobPoller *poller);
+
+static OvirtJobPoller *ovirt_job_poller_new(OvirtProxy *proxy)
+{
+    OvirtJobPoller *poller;
+
+    poller = g_slice_new0(OvirtJobPoller);
+    poller->proxy = proxy;
+    poller->waiting = g_ptr_array_new();
+    poller->cancellable = g_cancellable_new();
+    poller->interval = OVIRT_JOB_POLL_MIN_INTERVAL;
+
+    return poller;
+}
+
+G_GNUC_INTERNAL
+void ovirt_job_poller_free(OvirtJobPoller *poller)
+{
+    g_warn_if_fail(poller->waiting->len == 0);
+
+    if (poller->timeout_id != 0) {
+        g_source_remove(poller->timeout_id);
+    }
+    g_cancellable_cancel(poller->cancellable);
+    g_object_unref(poller->cancellable);
+    g_ptr_array_unref(poller->waiting);
+
+    g_slice_free(OvirtJobPoller, poller);
+}
+
+
+static gboolean ovirt_job_poller_timeout_cb(gpointer user_data)
+{
+    OvirtJobPoller *poller = user_data;
+
+    poller->timeout_id = 0;
+    ovirt_job_poller_poll(poller);
+
+    return G_SOURCE_REMOVE;
+}
+
+static void ovirt_job_poller_schedule(OvirtJobPoller *poller, guint interval)
+{
+    if (poller->timeout_id != 0) {
+        g_source_remove(poller->timeout_id);
+    }
+    poller->interval = interval;
+    poller->timeout_id = g_timeout_add(interval,
+                                       ovirt_job_poller_timeout_cb,
+                                       poller);
+}
+
+
+/* Removes @task from the waiting tasks, it is then returned by
+ * ovirt_job_poller_return() */
+static void ovirt_job_poller_take(OvirtJobPoller *poller,
+                                  guint index,
+                                  GQueue *done)
+{
+    GTask *task;
+    OvirtJobWait *wait;
+
+    task = g_ptr_array_index(poller->waiting, index);
+    g_ptr_array_remove_index(poller->waiting, index);
+    wait = g_task_get_task_data(task);
+    g_cancellable_disconnect(g_task_get_cancellable(task), wait->cancelled_id);
+    wait->cancelled_id = 0;
+    if (wait->cancelled_source != NULL) {
+        g_source_destroy(wait->cancelled_source);
+        g_clear_pointer(&wait->cancelled_source, g_source_unref);
+    }
+    g_queue_push_tail(done, task);
+}
+
+/* Completes the tasks once the poller state is consistent, as the task
+ * callbacks may wait on new jobs */
+static void ovirt_job_poller_return(GQueue *done, const GError *error)
+{
+    GTask *task;
+
+    while ((task = g_queue_pop_head(done)) != NULL) {
+        OvirtJob *job = OVIRT_JOB(g_task_get_source_object(task));
+        GError *job_error = NULL;
+
+        if (g_task_return_error_if_cancelled(task)) {
+            /* Nothing to do */
+        } else if (error != NULL) {
+            g_task_return_error(task, g_error_copy(error));
+        } else if (ovirt_job_is_over(job, &job_error) && (job_error != NULL)) {
+            g_task_return_error(task, job_error);
+        } else {
+            g_task_return_boolean(task, TRUE);
+        }
+        g_object_unref(task);
+    }
+}
+
+
+static gboolean ovirt_job_poller_cancelled_idle_cb(gpointer user_data)
+{
+    GTask *task = user_data;
+    OvirtJobWait *wait = g_task_get_task_data(task);
+    OvirtJobPoller *poller = wait->proxy->priv->job_poller;
+    GQueue done = G_QUEUE_INIT;
+    guint index;
+
+    if (g_ptr_array_find(poller->waiting, task, &index)) {
+        ovirt_job_poller_take(poller, index, &done);
+    }
+    ovirt_job_poller_return(&done, NULL);
+
+    return G_SOURCE_REMOVE;
+}
+
+/* GCancellable::cancelled handlers cannot disconnect themselves, so the
+ * cancelled task is returned from an idle in its own main context */
+static void ovirt_job_poller_cancelled_cb(G_GNUC_UNUSED GCancellable *cancellable,
+                                          gpointer user_data)
+{
+    GTask *task = user_data;
+    OvirtJobWait *wait = g_task_get_task_data(task);
+
+    if (wait->cancelled_source != NULL) {
+        return;
+    }
+    wait->cancelled_source = g_idle_source_new();
+    g_source_set_callback(wait->cancelled_source,
+                          ovirt_job_poller_cancelled_idle_cb, task, NULL);
+    g_source_attach(wait->cancelled_source, g_task_get_context(task));
+}
+
+
+/* Jobs are not always listed in the jobs collection, for example once the
+ * engine cleaned them up. Such jobs are refreshed on their own, and given
+ * up on if this fails. */
+static void ovirt_job_poller_refresh_cb(GObject *source_object,
+                                        GAsyncResult *result,
+                                        gpointer user_data)
+{
+    GTask *task = user_data;
+    OvirtJob *job = OVIRT_JOB(source_object);
+    OvirtJobWait *wait = g_task_get_task_data(task);
+    OvirtJobPoller *poller = wait->proxy->priv->job_poller;
+    GQueue done = G_QUEUE_INIT;
+    GError *error = NULL;
+    guint index;
+
+    wait->refreshing = FALSE;
+    ovirt_resource_refresh_finish(OVIRT_RESOURCE(job), result, &error);
+    if (g_ptr_array_find(poller->waiting, task, &index)) {
+        if (error != NULL) {
+            if (!g_error_matches(error, G_IO_ERROR, G_IO_ERROR_CANCELLED)) {
+                ovirt_job_poller_take(poller, index, &done);
+            }
+        } else if (ovirt_job_is_over(job, NULL)) {
+            ovirt_job_poller_take(poller, index, &done);
+        }
+    }
+    ovirt_job_poller_return(&done, error);
+
+    g_clear_error(&error);
+    g_object_unref(task);
+}
+
+
+static gboolean ovirt_job_poller_parse(G_GNUC_UNUSED OvirtProxy *proxy,
+                                       RestXmlNode *root,
+                                       gpointer user_data,
+                                       GError **error)
+{
+    OvirtJobPoller *poller = user_data;
+    GHashTable *nodes;
+    RestXmlNode *node;
+    GQueue done = G_QUEUE_INIT;
+    guint i;
+
+    if (g_strcmp0(root->name, "jobs") != 0) {
+        g_set_error(error, OVIRT_ERROR, OVIRT_ERROR_PARSING_FAILED,
+                    _("Got '%s' node, expected '%s'"), root->name, "jobs");
+        return FALSE;
+    }
+
+    nodes = g_hash_table_new(g_str_hash, g_str_equal);
+    node = g_hash_table_lookup(root->children, g_intern_string("job"));
+    for (; node != NULL; node = node->next) {
+        const char *id = rest_xml_node_get_attr(node, "id");
+        if (id != NULL) {
+            g_hash_table_insert(nodes, (gpointer)id, node);
+        }
+    }
+
+    for (i = poller->waiting->len; i > 0; i--) {
+        GTask *task = g_ptr_array_index(poller->waiting, i - 1);
+        OvirtJob *job = OVIRT_JOB(g_task_get_source_object(task));
+        gboolean changed = FALSE;
+        char *id;
+
+        g_object_get(G_OBJECT(job), "guid", &id, NULL);
+        node = g_hash_table_lookup(nodes, id);
+        g_free(id);
+        if (node == NULL) {
+            OvirtJobWait *wait = g_task_get_task_data(task);
+
+            if (!wait->refreshing) {
+                wait->refreshing = TRUE;
+                ovirt_resource_refresh_async(OVIRT_RESOURCE(job), poller->proxy,
+                                             poller->cancellable,
+                                             ovirt_job_poller_refresh_cb,
+                                             g_object_ref(task));
+            }
+            continue;
+        }
+        if (!ovirt_resource_refresh_from_xml(OVIRT_RESOURCE(job), node,
+                                             &changed, NULL)) {
+            g_warning("Failed to parse job");
+            continue;
+        }
+        poller->changed |= changed;
+        if (ovirt_job_is_over(job, NULL)) {
+            ovirt_job_poller_take(poller, i - 1, &done);
+        }
+    }
+    g_hash_table_unref(nodes);
+
+    ovirt_job_poller_return(&done, NULL);
+
+    return TRUE;
+}
+
+
+static void ovirt_job_poller_poll_cb(GObject *source_object,
+                                     GAsyncResult *result,
+                                     G_GNUC_UNUSED gpointer user_data)
+{
+    OvirtProxy *proxy = OVIRT_PROXY(source_object);
+    OvirtJobPoller *poller = proxy->priv->job_poller;
+    GError *error = NULL;
+
+    poller->polling = FALSE;
+    if (!ovirt_rest_call_finish(result, &error) &&
+        !g_error_matches(error, G_IO_ERROR, G_IO_ERROR_CANCELLED)) {
+        GQueue done = G_QUEUE_INIT;
+
+        /* Give up on all the jobs rather than polling a broken server
+         * forever */
+        while (poller->waiting->len != 0) {
+            ovirt_job_poller_take(poller, poller->waiting->len - 1, &done);
+        }
+        ovirt_job_poller_return(&done, error);
+    }
+    g_clear_error(&error);
+
+    if ((poller->waiting->len != 0) && (poller->timeout_id == 0)) {
+        guint interval;
+
+        if (poller->changed) {
+            interval = OVIRT_JOB_POLL_MIN_INTERVAL;
+        } else {
+            interval = MIN(poller->interval * 2, OVIRT_JOB_POLL_MAX_INTERVAL);
+        }
+        ovirt_job_poller_schedule(poller, interval);
+    }
+}
+
+
+static void ovirt_job_poller_poll(OvirtJobPoller *poller)
+{
+    OvirtResource *job;
+    GTask *task;
+    char *href;
+    char *jobs_href;
+
+    g_return_if_fail(poller->waiting->len != 0);
+    g_return_if_fail(!poller->polling);
+
+    /* All the jobs of a given engine are in the same collection */
+    task = g_ptr_array_index(poller->waiting, 0);
+    job = OVIRT_RESOURCE(g_task_get_source_object(task));
+    g_object_get(G_OBJECT(job), "href", &href, NULL);
+    jobs_href = g_path_get_dirname(href);
+    g_free(href);
+
+    poller->polling = TRUE;
+    poller->changed = FALSE;
+    /* The task keeps the proxy, and thus the poller, alive until
+     * ovirt_job_poller_poll_cb() is called */
+    task = g_task_new(G_OBJECT(poller->proxy), poller->cancellable,
+                      ovirt_job_poller_poll_cb, NULL);
+    ovirt_proxy_get_collection_xml_async(poller->proxy, jobs_href, "jobs", NULL, task,
+                                         poller->cancellable,
+                                         ovirt_job_poller_parse, poller,
+                                         NULL);
+    g_free(jobs_href);
+}
+
+
+static void ovirt_job_poller_add(OvirtJobPoller *poller, GTask *task)
+{
+    GCancellable *cancellable = g_task_get_cancellable(task);
+    OvirtJobWait *wait = g_task_get_task_data(task);
+
+    g_ptr_array_add(poller->waiting, task);
+    if (cancellable != NULL) {
+        wait->cancelled_id = g_cancellable_connect(cancellable,
+                                                   G_CALLBACK(ovirt_job_poller_cancelled_cb),
+                                                   task, NULL);
+    }
+
+    /* Check the new job soon even if the poller backed off */
+    if (!poller->polling &&
+        ((poller->timeout_id == 0) ||
+         (poller->interval > OVIRT_JOB_POLL_MIN_INTERVAL))) {
+        ovirt_job_poller_schedule(poller, OVIRT_JOB_POLL_MIN_INTERVAL);
+    }
+}
+
+
+/**
+ * ovirt_job_wait_async:
+ * @job: a #OvirtJob
+ * @proxy: a #OvirtProxy
+ * @cancellable: (allow-none): a #GCancellable
+ * @callback: (scope async): completion callback
+ * @user_data: (closure): opaque data for callback
+ *
+ * Waits until @job is over. All the jobs waited on through @proxy are
+ * polled together, less and less often as long as none of them changes.
+ * #OvirtJob:status is updated each time @job is polled.
+ *
+ * Since: 0.3.12
+ */
+void ovirt_job_wait_async(OvirtJob *job,
+                          OvirtProxy *proxy,
+                          GCancellable *cancellable,
+                          GAsyncReadyCallback callback,
+                          gpointer user_data)
+{
+    OvirtJobWait *wait;
+    GTask *task;
+    GError *error = NULL;
+    char *href;
+
+    g_return_if_fail(OVIRT_IS_JOB(job));
+    g_return_if_fail(OVIRT_IS_PROXY(proxy));
+    g_return_if_fail((cancellable == NULL) || G_IS_CANCELLABLE(cancellable));
+
+    task = g_task_new(G_OBJECT(job), cancellable, callback, user_data);
+    if (ovirt_job_is_over(job, &error)) {
+        if (error != NULL) {
+            g_task_return_error(task, error);
+        } else {
+            g_task_return_boolean(task, TRUE);
+        }
+        g_object_unref(task);
+        return;
+    }
+
+    g_object_get(G_OBJECT(job), "href", &href, NULL);
+    if (href == NULL) {
+        g_task_return_new_error(task, OVIRT_ERROR, OVIRT_ERROR_NOT_SUPPORTED,
+                                _("Job has no href, its status cannot be polled"));
+        g_object_unref(task);
+        return;
+    }
+    g_free(href);
+
+    if (g_task_return_error_if_cancelled(task)) {
+        g_object_unref(task);
+        return;
+    }
+
+    wait = g_slice_new0(OvirtJobWait);
+    wait->proxy = g_object_ref(proxy);
+    g_task_set_task_data(task, wait, (GDestroyNotify)ovirt_job_wait_free);
+    if (proxy->priv->job_poller == NULL) {
+        proxy->priv->job_poller = ovirt_job_poller_new(proxy);
+    }
+    ovirt_job_poller_add(proxy->priv->job_poller, task);
+}
+
+
+/**
+ * ovirt_job_wait_finish:
+ * @job: a #OvirtJob
+ * @result: async method result
+ * @err: #GError to set on error, or NULL
+ *
+ * Return value: TRUE if @job finished successfully, FALSE if it failed, was
+ * aborted, or if its status could not be polled.
+ *
+ * Since: 0.3.12
+ */
+gboolean ovirt_job_wait_finish(OvirtJob *job,
+                               GAsyncResult *result,
+                               GError **err)
+{
+    g_return_val_if_fail(OVIRT_IS_JOB(job), FALSE);
+    g_return_val_if_fail(g_task_is_valid(G_TASK(result), job), FALSE);
+
+    return g_task_propagate_boolean(G_TASK(result), err);
+}
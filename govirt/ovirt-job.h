@@ -0,0 +1,79 @@
+/*
+ * ovirt-job.h: oVirt job resource
+ *
+ * Copyright (C) 2026 Red Hat, Inc.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library. If not, see
+ * <http://www.gnu.org/licenses/>.
+ */
+#ifndef __OVIRT_JOB_H__
+#define __OVIRT_JOB_H__
+
+#include <gio/gio.h>
+#include <glib-object.h>
+#include <govirt/ovirt-resource.h>
+#include <govirt/ovirt-types.h>
+
+G_BEGIN_DECLS
+
+#define OVIRT_TYPE_JOB            (ovirt_job_get_type ())
+#define OVIRT_JOB(obj)            (G_TYPE_CHECK_INSTANCE_CAST ((obj), OVIRT_TYPE_JOB, OvirtJob))
+#define OVIRT_JOB_CLASS(klass)    (G_TYPE_CHECK_CLASS_CAST ((klass), OVIRT_TYPE_JOB, OvirtJobClass))
+#define OVIRT_IS_JOB(obj)         (G_TYPE_CHECK_INSTANCE_TYPE ((obj), OVIRT_TYPE_JOB))
+#define OVIRT_IS_JOB_CLASS(klass) (G_TYPE_CHECK_CLASS_TYPE ((klass), OVIRT_TYPE_JOB))
+#define OVIRT_JOB_GET_CLASS(obj)  (G_TYPE_INSTANCE_GET_CLASS ((obj), OVIRT_TYPE_JOB, OvirtJobClass))
+
+typedef struct _OvirtJobPrivate OvirtJobPrivate;
+typedef struct _OvirtJobClass OvirtJobClass;
+
+typedef enum {
+    OVIRT_JOB_STATUS_UNKNOWN,
+    OVIRT_JOB_STATUS_STARTED,
+    OVIRT_JOB_STATUS_FINISHED,
+    OVIRT_JOB_STATUS_FAILED,
+    OVIRT_JOB_STATUS_ABORTED,
+} OvirtJobStatus;
+
+struct _OvirtJob
+{
+    OvirtResource parent;
+
+    OvirtJobPrivate *priv;
+
+    /* Do not add fields to this struct */
+};
+
+struct _OvirtJobClass
+{
+    OvirtResourceClass parent_class;
+
+    gpointer padding[20];
+};
+
+GType ovirt_job_get_type(void);
+
+OvirtJob *ovirt_job_new(void);
+
+void ovirt_job_wait_async(OvirtJob *job,
+                          OvirtProxy *proxy,
+                          GCancellable *cancellable,
+                          GAsyncReadyCallback callback,
+                          gpointer user_data);
+gboolean ovirt_job_wait_finish(OvirtJob *job,
+                               GAsyncResult *result,
+                               GError **err);
+
+G_END_DECLS
+
+#endif /* __OVIRT_JOB_H__ */
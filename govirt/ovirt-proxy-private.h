@@ -27,11 +27,27 @@
 #include <libsoup/soup-session-feature.h>
 
 #include "ovirt-proxy.h"
+#include "ovirt-job-private.h"
 #include "ovirt-rest-call.h"
+#include "ovirt-xml-stream.h"
 
 G_BEGIN_DECLS
 
+/* Validators (ETag and Last-Modified headers) of the response a
+ * collection or resource was last updated from, they are used to only
+ * download it again when it changed on the server */
+typedef struct _OvirtCacheValidators OvirtCacheValidators;
+
 struct _OvirtProxyPrivate {
+    /* Guards the state below which synchronous calls made from several
+     * threads can use at the same time: the additional headers, session
+     * id and SSO token, temporary CA file, display CA, in-memory response
+     * cache, identity map and transfer statistics. It must not be held
+     * while updating resources, see ovirt_resource_refresh_from_xml() */
+    GRecMutex lock;
+    /* Serializes the synchronous fetches of @api */
+    GMutex api_lock;
+
     char *tmp_ca_file;
     GByteArray *display_ca;
     gboolean admin_mode;
@@ -45,22 +61,141 @@ struct _OvirtProxyPrivate {
 
     gboolean setting_ca_file;
     gulong ssl_ca_file_changed_id;
+
+    OvirtJobPoller *job_poller;
+
+    /* Directory of the on-disk response cache, NULL when disabled */
+    char *cache_dir;
+    OvirtWireFormat wire_format;
+    /* Validators of the response @api was created from */
+    OvirtCacheValidators *api_validators;
+
+    /* In-memory cache of parsed responses, see ovirt_proxy_set_response_ttl().
+     * @responses maps hrefs to links of @response_lru, which is sorted
+     * from the most to the least recently used response */
+    GHashTable *response_ttls;
+    GHashTable *responses;
+    GQueue response_lru;
+    /* Incremented each time the cached responses are discarded, responses
+     * to requests created before that are not cached */
+    guint response_generation;
+
+    /* GET requests in flight, which identical requests wait for instead
+     * of being sent again */
+    GHashTable *shared_gets;
+
+    /* Identity map of the resources created from responses, see
+     * ovirt_proxy_get_resource(). @identity_lru holds references to the
+     * @identity_lru_size most recently used ones */
+    GHashTable *identities;
+    GQueue identity_lru;
+    guint identity_lru_size;
+    guint identity_sweep_size;
+
+    /* Size of the response bodies as sent by the server, and once
+     * decompressed, see OvirtProxy:received-bytes */
+    guint64 received_bytes;
+    guint64 decoded_bytes;
 };
 
+void ovirt_cache_validators_free(OvirtCacheValidators *validators);
+void ovirt_cache_validators_add_headers(OvirtCacheValidators *validators,
+                                        RestProxyCall *call,
+                                        const char *href);
+void ovirt_cache_validators_update(OvirtCacheValidators **validators,
+                                   RestProxyCall *call,
+                                   const char *href);
+gboolean ovirt_rest_call_is_not_modified(RestProxyCall *call);
+
+gboolean ovirt_proxy_get_cached_collection_xml(OvirtProxy *proxy,
+                                               const char *href,
+                                               const char *root_name,
+                                               RestXmlNode **xml,
+                                               OvirtCacheValidators **validators);
+void ovirt_proxy_revalidation_failed(OvirtProxy *proxy,
+                                     GObject *object,
+                                     const GError *error);
+
+gboolean ovirt_proxy_lookup_parsed_response(OvirtProxy *proxy,
+                                            const char *href,
+                                            RestXmlNode **xml,
+                                            GError **error);
+void ovirt_proxy_cache_parsed_response(OvirtProxy *proxy,
+                                       RestProxyCall *call,
+                                       const char *href,
+                                       RestXmlNode *xml);
+void ovirt_proxy_cache_failed_response(OvirtProxy *proxy,
+                                       RestProxyCall *call);
+void ovirt_proxy_discard_parsed_responses(OvirtProxy *proxy);
+guint ovirt_proxy_get_response_generation(OvirtProxy *proxy);
+gboolean ovirt_proxy_can_stream(OvirtProxy *proxy);
+void ovirt_proxy_account_response(OvirtProxy *proxy, RestProxyCall *call);
+void ovirt_proxy_account_transfer(OvirtProxy *proxy,
+                                  RestProxyCall *call,
+                                  gsize decoded_size);
+
+OvirtResource *ovirt_proxy_lookup_identity(OvirtProxy *proxy,
+                                           GType type,
+                                           const char *guid);
+OvirtResource *ovirt_proxy_add_identity(OvirtProxy *proxy, OvirtResource *resource);
+
 RestXmlNode *ovirt_proxy_get_collection_xml(OvirtProxy *proxy,
                                             const char *href,
                                             GError **error);
+gboolean ovirt_proxy_get_collection_xml_if_modified(OvirtProxy *proxy,
+                                                    const char *href,
+                                                    const char *root_name,
+                                                    OvirtCacheValidators **validators,
+                                                    RestXmlNode **xml,
+                                                    GError **error);
 typedef gboolean (*OvirtProxyGetCollectionAsyncCb)(OvirtProxy* proxy,
                                                    RestXmlNode *root_node,
                                                    gpointer user_data,
                                                    GError **error);
 void ovirt_proxy_get_collection_xml_async(OvirtProxy *proxy,
                                           const char *href,
+                                          const char *root_name,
+                                          OvirtCacheValidators **validators,
                                           GTask *task,
                                           GCancellable *cancellable,
                                           OvirtProxyGetCollectionAsyncCb callback,
                                           gpointer user_data,
                                           GDestroyNotify destroy_func);
+/* Called from a worker thread with the parsed response, to do the work
+ * which does not need the main context of the caller */
+typedef void (*OvirtProxyPrepareFunc)(RestXmlNode *root_node,
+                                      gpointer prepare_data,
+                                      GCancellable *cancellable);
+void ovirt_proxy_get_collection_xml_full_async(OvirtProxy *proxy,
+                                               const char *href,
+                                               const char *root_name,
+                                               OvirtCacheValidators **validators,
+                                               GTask *task,
+                                               GCancellable *cancellable,
+                                               OvirtProxyPrepareFunc prepare,
+                                               gpointer prepare_data,
+                                               GDestroyNotify destroy_prepare_data,
+                                               OvirtProxyGetCollectionAsyncCb callback,
+                                               gpointer user_data,
+                                               GDestroyNotify destroy_func);
+gboolean ovirt_proxy_get_collection_xml_stream(OvirtProxy *proxy,
+                                               const char *href,
+                                               OvirtXmlStream *stream,
+                                               OvirtCacheValidators **validators,
+                                               gboolean *modified,
+                                               GError **error);
+typedef gboolean (*OvirtProxyGetCollectionStreamCb)(OvirtProxy *proxy,
+                                                    gpointer user_data,
+                                                    GError **error);
+void ovirt_proxy_get_collection_xml_stream_async(OvirtProxy *proxy,
+                                                 const char *href,
+                                                 OvirtXmlStream *stream,
+                                                 OvirtCacheValidators **validators,
+                                                 GTask *task,
+                                                 GCancellable *cancellable,
+                                                 OvirtProxyGetCollectionStreamCb callback,
+                                                 gpointer user_data,
+                                                 GDestroyNotify destroy_func);
 
 typedef gboolean (*OvirtProxyCallAsyncCb)(OvirtProxy *proxy,
                                           RestProxyCall *call,
@@ -74,6 +209,22 @@ void ovirt_rest_call_async(OvirtRestCall *call,
                            GDestroyNotify destroy_func);
 gboolean ovirt_rest_call_finish(GAsyncResult *result, GError **err);
 
+typedef gboolean (*OvirtProxySharedGetCb)(OvirtProxy *proxy,
+                                          RestProxyCall *call,
+                                          RestXmlNode *root,
+                                          gpointer user_data,
+                                          GError **error);
+void ovirt_proxy_get_shared_async(OvirtProxy *proxy,
+                                  RestProxyCall *call,
+                                  GTask *task,
+                                  GCancellable *cancellable,
+                                  OvirtProxyPrepareFunc prepare,
+                                  gpointer prepare_data,
+                                  GDestroyNotify destroy_prepare_data,
+                                  OvirtProxySharedGetCb callback,
+                                  gpointer user_data,
+                                  GDestroyNotify destroy_func);
+
 /* Work around G_GNUC_DEPRECATED attribute on ovirt_proxy_get_vms() */
 GList *ovirt_proxy_get_vms_internal(OvirtProxy *proxy);
 void ovirt_proxy_append_additional_headers(OvirtProxy *proxy,
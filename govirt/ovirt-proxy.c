@@ -23,6 +23,7 @@
 #undef OVIRT_DEBUG
 #include <config.h>
 
+#include "ovirt-enum-types.h"
 #include "ovirt-error.h"
 #include "ovirt-rest-call-error.h"
 #include "ovirt-proxy.h"
@@ -47,9 +48,20 @@ enum {
     PROP_CA_CERT,
     PROP_ADMIN,
     PROP_SESSION_ID,
-    PROP_SSO_TOKEN
+    PROP_SSO_TOKEN,
+    PROP_CACHE_DIR,
+    PROP_WIRE_FORMAT,
+    PROP_RECEIVED_BYTES,
+    PROP_DECODED_BYTES,
 };
 
+enum {
+    REVALIDATION_FAILED,
+    LAST_SIGNAL
+};
+
+static guint signals[LAST_SIGNAL];
+
 #define CA_CERT_FILENAME "ca.crt"
 
 static gboolean set_ca_cert_from_data(OvirtProxy *proxy,
@@ -158,215 +170,1724 @@ static RestProxyCall *ovirt_rest_call_new(OvirtProxy *proxy,
 }
 
 
-RestXmlNode *ovirt_proxy_get_collection_xml(OvirtProxy *proxy,
-                                            const char *href,
-                                            GError **error)
+struct _OvirtCacheValidators {
+    char *href;
+    char *etag;
+    char *last_modified;
+};
+
+G_GNUC_INTERNAL void ovirt_cache_validators_free(OvirtCacheValidators *validators)
 {
-    RestProxyCall *call;
-    RestXmlNode *root;
-    GError *err = NULL;
+    if (validators == NULL) {
+        return;
+    }
 
-    g_return_val_if_fail(OVIRT_IS_PROXY(proxy), NULL);
+    g_free(validators->href);
+    g_free(validators->etag);
+    g_free(validators->last_modified);
+    g_slice_free(OvirtCacheValidators, validators);
+}
 
-    call = ovirt_rest_call_new(proxy, "GET", href);
 
-    if (!rest_proxy_call_sync(call, &err)) {
-        if (g_error_matches(err, REST_PROXY_ERROR, REST_PROXY_ERROR_CANCELLED)) {
-            g_set_error_literal(error,
-                                OVIRT_REST_CALL_ERROR, OVIRT_REST_CALL_ERROR_CANCELLED,
-                                err->message);
-            g_clear_error(&err);
-        } else if (err != NULL) {
-            g_warning("Error while getting collection: %s", err->message);
-            g_propagate_error(error, err);
-        } else {
-            g_warning("Error while getting collection");
-        }
-        g_object_unref(G_OBJECT(call));
-        return NULL;
+/* Makes @call conditional if @validators were obtained from a previous
+ * request for @href */
+G_GNUC_INTERNAL void ovirt_cache_validators_add_headers(OvirtCacheValidators *validators,
+                                                        RestProxyCall *call,
+                                                        const char *href)
+{
+    if ((validators == NULL) || (g_strcmp0(validators->href, href) != 0)) {
+        return;
     }
 
-    root = ovirt_rest_xml_node_from_call(call);
-    g_object_unref(G_OBJECT(call));
+    if (validators->etag != NULL) {
+        rest_proxy_call_add_header(call, "If-None-Match", validators->etag);
+    }
+    if (validators->last_modified != NULL) {
+        rest_proxy_call_add_header(call, "If-Modified-Since", validators->last_modified);
+    }
+}
 
-    return root;
+
+/* Replaces @validators with the ones from the response to @call, which
+ * must have been successful */
+G_GNUC_INTERNAL void ovirt_cache_validators_update(OvirtCacheValidators **validators,
+                                                   RestProxyCall *call,
+                                                   const char *href)
+{
+    const char *etag;
+    const char *last_modified;
+
+    if (validators == NULL) {
+        return;
+    }
+
+    g_clear_pointer(validators, ovirt_cache_validators_free);
+
+    etag = rest_proxy_call_lookup_response_header(call, "ETag");
+    last_modified = rest_proxy_call_lookup_response_header(call, "Last-Modified");
+    if ((etag == NULL) && (last_modified == NULL)) {
+        return;
+    }
+
+    *validators = g_slice_new0(OvirtCacheValidators);
+    (*validators)->href = g_strdup(href);
+    (*validators)->etag = g_strdup(etag);
+    (*validators)->last_modified = g_strdup(last_modified);
 }
 
-typedef struct {
-    OvirtProxy *proxy;
-    GTask *task;
-    OvirtProxyCallAsyncCb call_async_cb;
-    gpointer call_user_data;
-    GDestroyNotify destroy_call_data;
-} OvirtProxyCallAsyncData;
 
-static void ovirt_proxy_call_async_data_free(OvirtProxyCallAsyncData *data)
+/* Only conditional requests get a 304 reply, for which librest reports an
+ * error */
+G_GNUC_INTERNAL gboolean ovirt_rest_call_is_not_modified(RestProxyCall *call)
 {
-    if (data->destroy_call_data != NULL) {
-        data->destroy_call_data(data->call_user_data);
+    return rest_proxy_call_get_status_code(call) == 304;
+}
+
+
+/* Returns the cache holding the responses sent by the engine to the
+ * current user, or NULL when the on-disk cache is disabled */
+static OvirtCache *ovirt_proxy_get_cache(OvirtProxy *proxy)
+{
+    OvirtCache *cache = NULL;
+    char *url;
+    char *username;
+
+    g_rec_mutex_lock(&proxy->priv->lock);
+    if (proxy->priv->cache_dir == NULL) {
+        goto end;
     }
 
-    g_clear_object(&data->proxy);
-    g_clear_object(&data->task);
+    g_object_get(G_OBJECT(proxy),
+                 "url-format", &url,
+                 "username", &username,
+                 NULL);
+    if (url != NULL) {
+        cache = ovirt_cache_new(proxy->priv->cache_dir, url, username,
+                                proxy->priv->admin_mode);
+    }
+    g_free(username);
+    g_free(url);
 
-    g_slice_free(OvirtProxyCallAsyncData, data);
+end:
+    g_rec_mutex_unlock(&proxy->priv->lock);
+
+    return cache;
 }
 
-static void rest_call_async_set_error(RestProxyCall *call, GTask *task, const GError *error)
+
+/* Stores the response to @call, which was successfully parsed, in the
+ * on-disk cache */
+static void ovirt_proxy_cache_response(OvirtProxy *proxy,
+                                       const char *href,
+                                       RestProxyCall *call)
 {
-    GError *local_error = NULL;
-    RestXmlNode *root = ovirt_rest_xml_node_from_call(call);
+    OvirtCache *cache;
+    const char *payload;
 
-    if (root != NULL && ovirt_utils_gerror_from_xml_fault(root, &local_error)) {
-        g_debug("ovirt_rest_call_async(): %s", local_error->message);
-        g_task_return_error(task, local_error);
-    } else {
-        g_task_return_error(task, (GError *) error);
+    cache = ovirt_proxy_get_cache(proxy);
+    if (cache == NULL) {
+        return;
     }
 
-    if (root != NULL) {
-        rest_xml_node_unref(root);
+    payload = rest_proxy_call_get_payload(call);
+    if (payload != NULL) {
+        ovirt_cache_store(cache, href, payload,
+                          rest_proxy_call_get_payload_length(call),
+                          rest_proxy_call_lookup_response_header(call, "ETag"),
+                          rest_proxy_call_lookup_response_header(call, "Last-Modified"));
     }
+    ovirt_cache_free(cache);
 }
 
-static void
-call_async_cb(GObject *source_obj,
-              GAsyncResult *result,
-              gpointer user_data)
+
+/*
+ * Looks up the last response to @href in the on-disk cache. On success,
+ * @xml is set to the parsed response, and @validators to the validators
+ * it came with, so that it can be revalidated with a conditional request.
+ */
+gboolean ovirt_proxy_get_cached_collection_xml(OvirtProxy *proxy,
+                                               const char *href,
+                                               const char *root_name,
+                                               RestXmlNode **xml,
+                                               OvirtCacheValidators **validators)
 {
-    RestProxyCall *call = REST_PROXY_CALL(source_obj);
-    GError *error = NULL;
-    OvirtProxyCallAsyncData *data = user_data;
-    GTask *task = data->task;
-    gboolean callback_result = TRUE;
+    OvirtCache *cache;
+    char *data;
+    gsize length;
+    char *etag = NULL;
+    char *last_modified = NULL;
+    gboolean found;
 
-    rest_proxy_call_invoke_finish(call, result, &error);
-    if (error != NULL) {
-        goto exit;
+    g_return_val_if_fail(OVIRT_IS_PROXY(proxy), FALSE);
+    g_return_val_if_fail(xml != NULL, FALSE);
+    g_return_val_if_fail(validators != NULL, FALSE);
+
+    *xml = NULL;
+    cache = ovirt_proxy_get_cache(proxy);
+    if (cache == NULL) {
+        return FALSE;
     }
 
-    if (data->call_async_cb != NULL) {
-        callback_result = data->call_async_cb(data->proxy, call,
-                                              data->call_user_data,
-                                              &error);
-        if (error != NULL) {
-            goto exit;
-        }
+    found = ovirt_cache_lookup(cache, href, &data, &length,
+                               &etag, &last_modified);
+    ovirt_cache_free(cache);
+    if (!found) {
+        return FALSE;
     }
 
-    g_task_return_boolean(task, callback_result);
+    *xml = ovirt_rest_xml_node_from_response(data, length, href, root_name);
+    g_free(data);
+    if (*xml == NULL) {
+        g_debug("Failed to parse cached response for '%s'", href);
+        g_free(etag);
+        g_free(last_modified);
+        return FALSE;
+    }
 
-exit:
-    if (error != NULL) {
-        rest_call_async_set_error(call, task, error);
+    g_clear_pointer(validators, ovirt_cache_validators_free);
+    if ((etag != NULL) || (last_modified != NULL)) {
+        *validators = g_slice_new0(OvirtCacheValidators);
+        (*validators)->href = g_strdup(href);
+        (*validators)->etag = etag;
+        (*validators)->last_modified = last_modified;
     }
-    ovirt_proxy_call_async_data_free(data);
+
+    return TRUE;
 }
 
 
-void ovirt_rest_call_async(OvirtRestCall *call,
-                           GTask *task,
-                           GCancellable *cancellable,
-                           OvirtProxyCallAsyncCb callback,
-                           gpointer user_data,
-                           GDestroyNotify destroy_func)
+/* Bounds the memory used by the in-memory response cache */
+#define OVIRT_PROXY_MAX_CACHED_RESPONSES 256
+/* Missing resources can be created at any time, so "not found" errors are
+ * not cached for long */
+#define OVIRT_PROXY_NOT_FOUND_TTL 5000
+
+typedef struct {
+    char *href;
+    /* Exactly one of @xml and @error is set */
+    RestXmlNode *xml;
+    GError *error;
+    gint64 expires;
+} OvirtCachedResponse;
+
+static void ovirt_cached_response_free(OvirtCachedResponse *response)
 {
-    OvirtProxy *proxy;
-    OvirtProxyCallAsyncData *data;
+    g_free(response->href);
+    if (response->xml != NULL) {
+        rest_xml_node_unref(response->xml);
+    }
+    g_clear_error(&response->error);
+    g_slice_free(OvirtCachedResponse, response);
+}
 
-    g_return_if_fail((cancellable == NULL) || G_IS_CANCELLABLE(cancellable));
-    g_object_get(G_OBJECT(call), "proxy", &proxy, NULL);
-    g_return_if_fail(OVIRT_IS_PROXY(proxy));
 
-    data = g_slice_new0(OvirtProxyCallAsyncData);
-    data->proxy = proxy;
-    data->task = task;
-    data->call_async_cb = callback;
-    data->call_user_data = user_data;
-    data->destroy_call_data = destroy_func;
+/* Returns how long responses to @href can be reused, in milliseconds, or 0
+ * if they must not be cached */
+static guint ovirt_proxy_get_response_ttl(OvirtProxy *proxy, const char *href)
+{
+    GHashTableIter iter;
+    gpointer prefix;
+    gpointer ttl;
+    gsize best_len = 0;
+    guint best_ttl = 0;
+    gboolean matched = FALSE;
+
+    if ((href == NULL) || (proxy->priv->response_ttls == NULL)) {
+        return 0;
+    }
 
-    rest_proxy_call_invoke_async(REST_PROXY_CALL (call), cancellable, call_async_cb, data);
+    g_hash_table_iter_init(&iter, proxy->priv->response_ttls);
+    while (g_hash_table_iter_next(&iter, &prefix, &ttl)) {
+        gsize len = strlen(prefix);
+
+        if (g_str_has_prefix(href, prefix) && (!matched || (len > best_len))) {
+            matched = TRUE;
+            best_len = len;
+            best_ttl = GPOINTER_TO_UINT(ttl);
+        }
+    }
+
+    return best_ttl;
 }
 
 
-gboolean ovirt_rest_call_finish(GAsyncResult *result, GError **err)
+static void ovirt_proxy_remove_cached_response(OvirtProxy *proxy, GList *link)
 {
-    return g_task_propagate_boolean(G_TASK(result), err);
+    OvirtCachedResponse *response = link->data;
+
+    g_hash_table_remove(proxy->priv->responses, response->href);
+    g_queue_delete_link(&proxy->priv->response_lru, link);
+    ovirt_cached_response_free(response);
 }
 
-typedef struct {
-    OvirtProxyGetCollectionAsyncCb parser;
-    gpointer user_data;
-    GDestroyNotify destroy_user_data;
-} OvirtProxyGetCollectionAsyncData;
 
-static void
-ovirt_proxy_get_collection_async_data_destroy(OvirtProxyGetCollectionAsyncData *data)
+static void ovirt_proxy_add_cached_response(OvirtProxy *proxy,
+                                            const char *href,
+                                            RestXmlNode *xml,
+                                            const GError *error,
+                                            guint ttl)
 {
-    if (data->destroy_user_data != NULL) {
-        data->destroy_user_data(data->user_data);
+    OvirtCachedResponse *response;
+    GList *link;
+
+    link = g_hash_table_lookup(proxy->priv->responses, href);
+    if (link != NULL) {
+        ovirt_proxy_remove_cached_response(proxy, link);
     }
-    g_slice_free(OvirtProxyGetCollectionAsyncData, data);
+    while (g_queue_get_length(&proxy->priv->response_lru) >= OVIRT_PROXY_MAX_CACHED_RESPONSES) {
+        ovirt_proxy_remove_cached_response(proxy,
+                                           g_queue_peek_tail_link(&proxy->priv->response_lru));
+    }
+
+    response = g_slice_new0(OvirtCachedResponse);
+    response->href = g_strdup(href);
+    if (xml != NULL) {
+        response->xml = rest_xml_node_ref(xml);
+    } else {
+        response->error = g_error_copy(error);
+    }
+    response->expires = g_get_monotonic_time() + (gint64)ttl * 1000;
+
+    g_queue_push_head(&proxy->priv->response_lru, response);
+    g_hash_table_insert(proxy->priv->responses, response->href,
+                        proxy->priv->response_lru.head);
 }
 
-static gboolean get_collection_xml_async_cb(OvirtProxy* proxy,
-                                            RestProxyCall *call,
-                                            gpointer user_data,
+
+/*
+ * Looks up a response to @href which can still be reused. If there is one,
+ * TRUE is returned, and either @xml is set to a new reference to the parsed
+ * response, or @error is set if the request failed.
+ */
+gboolean ovirt_proxy_lookup_parsed_response(OvirtProxy *proxy,
+                                            const char *href,
+                                            RestXmlNode **xml,
                                             GError **error)
 {
+    OvirtCachedResponse *response;
+    GList *link;
+
+    g_return_val_if_fail(OVIRT_IS_PROXY(proxy), FALSE);
+    g_return_val_if_fail(xml != NULL, FALSE);
+
+    *xml = NULL;
+    if (href == NULL) {
+        return FALSE;
+    }
+    g_rec_mutex_lock(&proxy->priv->lock);
+    link = g_hash_table_lookup(proxy->priv->responses, href);
+    if (link == NULL) {
+        g_rec_mutex_unlock(&proxy->priv->lock);
+        return FALSE;
+    }
+
+    response = link->data;
+    if (g_get_monotonic_time() >= response->expires) {
+        ovirt_proxy_remove_cached_response(proxy, link);
+        g_rec_mutex_unlock(&proxy->priv->lock);
+        return FALSE;
+    }
+
+    g_queue_unlink(&proxy->priv->response_lru, link);
+    g_queue_push_head_link(&proxy->priv->response_lru, link);
+
+    if (response->xml != NULL) {
+        *xml = rest_xml_node_ref(response->xml);
+    } else {
+        g_propagate_error(error, g_error_copy(response->error));
+    }
+    g_rec_mutex_unlock(&proxy->priv->lock);
+
+    return TRUE;
+}
+
+
+/* Responses to requests which were in flight while the cached responses
+ * were discarded may describe resources as they were before they got
+ * modified */
+static gboolean ovirt_proxy_response_is_current(OvirtProxy *proxy,
+                                                RestProxyCall *call)
+{
+    return (ovirt_rest_call_get_response_generation(call) ==
+            proxy->priv->response_generation);
+}
+
+
+void ovirt_proxy_cache_parsed_response(OvirtProxy *proxy,
+                                       RestProxyCall *call,
+                                       const char *href,
+                                       RestXmlNode *xml)
+{
+    guint ttl;
+
+    g_return_if_fail(OVIRT_IS_PROXY(proxy));
+    g_return_if_fail(xml != NULL);
+
+    g_rec_mutex_lock(&proxy->priv->lock);
+    ttl = ovirt_proxy_get_response_ttl(proxy, href);
+    if ((ttl != 0) && ovirt_proxy_response_is_current(proxy, call)) {
+        ovirt_proxy_add_cached_response(proxy, href, xml, NULL, ttl);
+    }
+    g_rec_mutex_unlock(&proxy->priv->lock);
+}
+
+
+/* Only "not found" errors are cached, other errors are usually
+ * transient */
+void ovirt_proxy_cache_failed_response(OvirtProxy *proxy,
+                                       RestProxyCall *call)
+{
+    const char *href;
     RestXmlNode *root;
-    OvirtProxyGetCollectionAsyncData *data;
-    gboolean parsed = FALSE;
+    GError *error = NULL;
+    guint ttl;
 
-    data = (OvirtProxyGetCollectionAsyncData *)user_data;
+    g_return_if_fail(OVIRT_IS_PROXY(proxy));
 
-    root = ovirt_rest_xml_node_from_call(call);
-    if (root == NULL) {
-        g_set_error_literal(error, OVIRT_ERROR, OVIRT_ERROR_PARSING_FAILED,
-                            _("Failed to parse response from collection"));
-        goto end;
+    if ((rest_proxy_call_get_status_code(call) != 404) ||
+        (g_strcmp0(rest_proxy_call_get_method(call), "GET") != 0)) {
+        return;
     }
 
-    /* Do the parsing */
-    g_warn_if_fail(data->parser != NULL);
-    if (data->parser != NULL) {
-        parsed = data->parser(proxy, root, data->user_data, error);
+    href = rest_proxy_call_get_function(call);
+    g_rec_mutex_lock(&proxy->priv->lock);
+    ttl = MIN(ovirt_proxy_get_response_ttl(proxy, href),
+              OVIRT_PROXY_NOT_FOUND_TTL);
+    if ((ttl != 0) && ovirt_proxy_response_is_current(proxy, call)) {
+        /* Report the same error as when the request is sent: the one
+         * described by the <fault> body, if any, or else the one
+         * librest reports for such responses */
+        root = ovirt_rest_xml_node_from_call(call);
+        if ((root == NULL) || !ovirt_utils_gerror_from_xml_fault(root, &error)) {
+            g_clear_error(&error);
+            error = g_error_new(REST_PROXY_ERROR, 404, "%s",
+                                rest_proxy_call_get_status_message(call));
+        }
+        if (root != NULL) {
+            rest_xml_node_unref(root);
+        }
+        ovirt_proxy_add_cached_response(proxy, href, NULL, error, ttl);
+        g_error_free(error);
+    }
+    g_rec_mutex_unlock(&proxy->priv->lock);
+}
+
+
+/* Adds the body of the response to @call, which is @decoded_size bytes
+ * long once decompressed, to the transfer statistics of @proxy. libsoup
+ * leaves the headers of decompressed responses untouched, so
+ * Content-Length is the size of the body as it was sent */
+G_GNUC_INTERNAL void ovirt_proxy_account_transfer(OvirtProxy *proxy,
+                                                  RestProxyCall *call,
+                                                  gsize decoded_size)
+{
+    const char *encoding;
+    const char *length;
+    guint64 received_size = decoded_size;
+
+    g_return_if_fail(OVIRT_IS_PROXY(proxy));
+
+    encoding = rest_proxy_call_lookup_response_header(call, "Content-Encoding");
+    length = rest_proxy_call_lookup_response_header(call, "Content-Length");
+    if ((encoding != NULL) && (g_ascii_strcasecmp(encoding, "identity") != 0) &&
+        (length != NULL)) {
+        received_size = g_ascii_strtoull(length, NULL, 10);
     }
 
-    rest_xml_node_unref(root);
+    g_rec_mutex_lock(&proxy->priv->lock);
+    proxy->priv->received_bytes += received_size;
+    proxy->priv->decoded_bytes += decoded_size;
+    g_rec_mutex_unlock(&proxy->priv->lock);
+}
+
+
+G_GNUC_INTERNAL void ovirt_proxy_account_response(OvirtProxy *proxy,
+                                                  RestProxyCall *call)
+{
+    ovirt_proxy_account_transfer(proxy, call,
+                                 rest_proxy_call_get_payload_length(call));
+}
+
+
+/* Responses can only be parsed incrementally when they are XML documents */
+gboolean ovirt_proxy_can_stream(OvirtProxy *proxy)
+{
+    g_return_val_if_fail(OVIRT_IS_PROXY(proxy), FALSE);
+
+    return (proxy->priv->wire_format == OVIRT_WIRE_FORMAT_XML);
+}
+
+
+void ovirt_proxy_discard_parsed_responses(OvirtProxy *proxy)
+{
+    g_return_if_fail(OVIRT_IS_PROXY(proxy));
+
+    g_rec_mutex_lock(&proxy->priv->lock);
+    g_hash_table_remove_all(proxy->priv->responses);
+    g_queue_clear_full(&proxy->priv->response_lru,
+                       (GDestroyNotify)ovirt_cached_response_free);
+    proxy->priv->response_generation++;
+    g_rec_mutex_unlock(&proxy->priv->lock);
+}
+
+
+/* Requests created now can have their response cached until the next call
+ * to ovirt_proxy_discard_parsed_responses() */
+guint ovirt_proxy_get_response_generation(OvirtProxy *proxy)
+{
+    guint generation;
+
+    g_return_val_if_fail(OVIRT_IS_PROXY(proxy), 0);
+
+    g_rec_mutex_lock(&proxy->priv->lock);
+    generation = proxy->priv->response_generation;
+    g_rec_mutex_unlock(&proxy->priv->lock);
+
+    return generation;
+}
+
+
+/**
+ * ovirt_proxy_set_response_ttl:
+ * @proxy: a #OvirtProxy
+ * @href_prefix: beginning of the hrefs this applies to, for example
+ * "/ovirt-engine/api/hosts/"
+ * @ttl: how long responses are reused, in milliseconds, or 0 to not
+ * reuse them
+ *
+ * Makes @proxy reuse the responses to the GET requests for the hrefs
+ * starting with @href_prefix for @ttl milliseconds. During that time,
+ * ovirt_resource_refresh(), ovirt_collection_fetch() and their asynchronous
+ * versions do not query the oVirt instance again. When several prefixes
+ * match an href, the longest one applies.
+ *
+ * Failures because the requested resource does not exist are also reused,
+ * for at most 5 seconds. Up to 256 responses are kept, the least recently
+ * used ones are dropped first. All of them are dropped when a request
+ * which could modify resources, such as an action, is sent.
+ *
+ * Responses are not reused by default. Collections with
+ * #OvirtCollection:streaming set never reuse responses.
+ *
+ * Since: 0.3.12
+ */
+void ovirt_proxy_set_response_ttl(OvirtProxy *proxy,
+                                  const char *href_prefix,
+                                  guint ttl)
+{
+    g_return_if_fail(OVIRT_IS_PROXY(proxy));
+    g_return_if_fail(href_prefix != NULL);
+
+    g_rec_mutex_lock(&proxy->priv->lock);
+    if (proxy->priv->response_ttls == NULL) {
+        proxy->priv->response_ttls = g_hash_table_new_full(g_str_hash, g_str_equal,
+                                                           g_free, NULL);
+    }
+    if (ttl != 0) {
+        g_hash_table_insert(proxy->priv->response_ttls, g_strdup(href_prefix),
+                            GUINT_TO_POINTER(ttl));
+    } else {
+        g_hash_table_remove(proxy->priv->response_ttls, href_prefix);
+    }
+
+    /* Cached responses may have been kept longer than they should now */
+    ovirt_proxy_discard_parsed_responses(proxy);
+    g_rec_mutex_unlock(&proxy->priv->lock);
+}
+
+
+/* Entry of the identity map of a proxy. @resource is only weakly
+ * referenced, @lru_resource holds a strong reference while the entry is
+ * in the identity LRU. A GWeakRef is used rather than a weak reference
+ * callback as resources can be released from any thread, dead entries are
+ * swept from the map as it grows. */
+typedef struct {
+    char *key;
+    GWeakRef resource;
+    OvirtResource *lru_resource;
+    GList *lru_link;
+} OvirtIdentity;
+
+#define OVIRT_PROXY_MIN_IDENTITY_SWEEP_SIZE 64
+
+static void ovirt_identity_free(OvirtIdentity *identity)
+{
+    g_warn_if_fail(identity->lru_link == NULL);
+    g_weak_ref_clear(&identity->resource);
+    g_free(identity->key);
+    g_slice_free(OvirtIdentity, identity);
+}
+
+
+static char *ovirt_proxy_get_identity_key(GType type, const char *guid)
+{
+    return g_strdup_printf("%s:%s", g_type_name(type), guid);
+}
+
+
+static void ovirt_proxy_trim_identity_lru(OvirtProxy *proxy)
+{
+    while (g_queue_get_length(&proxy->priv->identity_lru) > proxy->priv->identity_lru_size) {
+        OvirtIdentity *identity = g_queue_pop_tail(&proxy->priv->identity_lru);
+
+        identity->lru_link = NULL;
+        g_clear_object(&identity->lru_resource);
+    }
+}
+
+
+static void ovirt_proxy_touch_identity(OvirtProxy *proxy,
+                                       OvirtIdentity *identity,
+                                       OvirtResource *resource)
+{
+    if (proxy->priv->identity_lru_size == 0) {
+        return;
+    }
+
+    if (identity->lru_link != NULL) {
+        g_queue_unlink(&proxy->priv->identity_lru, identity->lru_link);
+        g_queue_push_head_link(&proxy->priv->identity_lru, identity->lru_link);
+        return;
+    }
+    identity->lru_resource = g_object_ref(resource);
+    g_queue_push_head(&proxy->priv->identity_lru, identity);
+    identity->lru_link = proxy->priv->identity_lru.head;
+    ovirt_proxy_trim_identity_lru(proxy);
+}
+
+
+static void ovirt_proxy_remove_identity(OvirtProxy *proxy,
+                                        OvirtIdentity *identity)
+{
+    if (identity->lru_link != NULL) {
+        g_queue_delete_link(&proxy->priv->identity_lru, identity->lru_link);
+        identity->lru_link = NULL;
+        g_clear_object(&identity->lru_resource);
+    }
+    g_hash_table_remove(proxy->priv->identities, identity->key);
+}
+
+
+/* Drops the entries of resources which were released, once the map
+ * doubled in size since the last time this was done */
+static void ovirt_proxy_sweep_identities(OvirtProxy *proxy)
+{
+    GHashTableIter iter;
+    gpointer identity;
+
+    if (g_hash_table_size(proxy->priv->identities) < proxy->priv->identity_sweep_size) {
+        return;
+    }
+
+    g_hash_table_iter_init(&iter, proxy->priv->identities);
+    while (g_hash_table_iter_next(&iter, NULL, &identity)) {
+        GObject *resource = g_weak_ref_get(&((OvirtIdentity *)identity)->resource);
+
+        if (resource == NULL) {
+            g_hash_table_iter_remove(&iter);
+        } else {
+            g_object_unref(resource);
+        }
+    }
+    proxy->priv->identity_sweep_size = MAX(OVIRT_PROXY_MIN_IDENTITY_SWEEP_SIZE,
+                                           2 * g_hash_table_size(proxy->priv->identities));
+}
+
+
+static void ovirt_proxy_clear_identities(OvirtProxy *proxy)
+{
+    g_rec_mutex_lock(&proxy->priv->lock);
+    if (proxy->priv->identities != NULL) {
+        proxy->priv->identity_lru_size = 0;
+        ovirt_proxy_trim_identity_lru(proxy);
+        g_clear_pointer(&proxy->priv->identities, g_hash_table_unref);
+    }
+    g_rec_mutex_unlock(&proxy->priv->lock);
+}
+
+
+/*
+ * Returns a new reference to the resource of type @type with the @guid id
+ * which was created from a response received by @proxy and which is still
+ * alive, or NULL if there is none.
+ */
+OvirtResource *ovirt_proxy_lookup_identity(OvirtProxy *proxy,
+                                           GType type,
+                                           const char *guid)
+{
+    OvirtIdentity *identity;
+    OvirtResource *resource = NULL;
+    char *key;
+
+    g_return_val_if_fail(OVIRT_IS_PROXY(proxy), NULL);
+
+    if (guid == NULL) {
+        return NULL;
+    }
+
+    key = ovirt_proxy_get_identity_key(type, guid);
+    g_rec_mutex_lock(&proxy->priv->lock);
+    if (proxy->priv->identities != NULL) {
+        identity = g_hash_table_lookup(proxy->priv->identities, key);
+        if (identity != NULL) {
+            resource = g_weak_ref_get(&identity->resource);
+            if (resource != NULL) {
+                ovirt_proxy_touch_identity(proxy, identity, resource);
+            } else {
+                ovirt_proxy_remove_identity(proxy, identity);
+            }
+        }
+    }
+    g_rec_mutex_unlock(&proxy->priv->lock);
+    g_free(key);
+
+    return resource;
+}
+
+
+/*
+ * Makes ovirt_proxy_lookup_identity() return @resource for its type and id
+ * for as long as it is alive, unless another resource is already
+ * registered for them. Both are done atomically, so that threads creating
+ * the same resource concurrently end up sharing a single instance.
+ *
+ * Returns a new reference to the registered resource, which is either
+ * @resource or the one registered before it.
+ */
+OvirtResource *ovirt_proxy_add_identity(OvirtProxy *proxy, OvirtResource *resource)
+{
+    OvirtIdentity *identity;
+    OvirtResource *registered = NULL;
+    char *guid;
+    char *key;
+
+    g_return_val_if_fail(OVIRT_IS_PROXY(proxy), NULL);
+    g_return_val_if_fail(OVIRT_IS_RESOURCE(resource), NULL);
+
+    g_object_get(G_OBJECT(resource), "guid", &guid, NULL);
+    if (guid == NULL) {
+        return g_object_ref(resource);
+    }
+    key = ovirt_proxy_get_identity_key(G_OBJECT_TYPE(resource), guid);
+    g_free(guid);
+
+    g_rec_mutex_lock(&proxy->priv->lock);
+    if (proxy->priv->identities == NULL) {
+        /* Disposed */
+        goto end;
+    }
+    identity = g_hash_table_lookup(proxy->priv->identities, key);
+    if (identity != NULL) {
+        registered = g_weak_ref_get(&identity->resource);
+        if (registered != NULL) {
+            ovirt_proxy_touch_identity(proxy, identity, registered);
+            goto end;
+        }
+        ovirt_proxy_remove_identity(proxy, identity);
+    }
+
+    identity = g_slice_new0(OvirtIdentity);
+    identity->key = g_steal_pointer(&key);
+    g_weak_ref_init(&identity->resource, resource);
+    g_hash_table_insert(proxy->priv->identities, identity->key, identity);
+    ovirt_resource_set_proxy(resource, proxy);
+    ovirt_proxy_touch_identity(proxy, identity, resource);
+    ovirt_proxy_sweep_identities(proxy);
+
+end:
+    g_rec_mutex_unlock(&proxy->priv->lock);
+    g_free(key);
+
+    if (registered == NULL) {
+        registered = g_object_ref(resource);
+    }
+
+    return registered;
+}
+
+
+/**
+ * ovirt_proxy_get_resource:
+ * @proxy: a #OvirtProxy
+ * @type: type of the resource, for example #OVIRT_TYPE_HOST
+ * @guid: id of the resource
+ *
+ * Collections fetched through @proxy share their resources: however many
+ * collections a remote object is part of, it is represented by a single
+ * #OvirtResource as long as one of them is alive, so that refreshing it
+ * from any of these collections updates it everywhere. Related objects
+ * such as the ones returned by ovirt_vm_get_host() are shared the same
+ * way. This function looks up that object. This method does not initiate
+ * any network activity.
+ *
+ * Return value: (transfer full): the #OvirtResource of type @type with
+ * the @guid id, or NULL if no such resource is alive.
+ *
+ * Since: 0.3.12
+ */
+OvirtResource *ovirt_proxy_get_resource(OvirtProxy *proxy,
+                                        GType type,
+                                        const char *guid)
+{
+    g_return_val_if_fail(OVIRT_IS_PROXY(proxy), NULL);
+    g_return_val_if_fail(g_type_is_a(type, OVIRT_TYPE_RESOURCE), NULL);
+    g_return_val_if_fail(guid != NULL, NULL);
+
+    return ovirt_proxy_lookup_identity(proxy, type, guid);
+}
+
+
+/**
+ * ovirt_proxy_set_identity_cache_size:
+ * @proxy: a #OvirtProxy
+ * @size: number of resources to keep alive, or 0
+ *
+ * Makes @proxy keep the @size most recently used resources alive even
+ * when the application does not reference them anymore, so that they are
+ * reused by the next fetch of a collection instead of being created again.
+ * By default, resources are only shared while the application references
+ * them, see ovirt_proxy_get_resource().
+ *
+ * Since: 0.3.12
+ */
+void ovirt_proxy_set_identity_cache_size(OvirtProxy *proxy, guint size)
+{
+    g_return_if_fail(OVIRT_IS_PROXY(proxy));
+
+    g_rec_mutex_lock(&proxy->priv->lock);
+    proxy->priv->identity_lru_size = size;
+    ovirt_proxy_trim_identity_lru(proxy);
+    g_rec_mutex_unlock(&proxy->priv->lock);
+}
+
+
+static RestProxyCall *ovirt_proxy_get_collection_call(OvirtProxy *proxy,
+                                                     const char *href,
+                                                     const char *root_name,
+                                                     OvirtCacheValidators *validators,
+                                                     gboolean *not_modified,
+                                                     GError **error)
+{
+    RestProxyCall *call;
+    GError *err = NULL;
+
+    call = ovirt_rest_call_new(proxy, "GET", href);
+    ovirt_rest_call_set_root_name(call, root_name);
+    ovirt_cache_validators_add_headers(validators, call, href);
+
+    if (!rest_proxy_call_sync(call, &err)) {
+        ovirt_proxy_account_response(proxy, call);
+        ovirt_proxy_cache_failed_response(proxy, call);
+        if ((not_modified != NULL) && ovirt_rest_call_is_not_modified(call)) {
+            *not_modified = TRUE;
+            g_clear_error(&err);
+        } else if (g_error_matches(err, REST_PROXY_ERROR, REST_PROXY_ERROR_CANCELLED)) {
+            g_set_error_literal(error,
+                                OVIRT_REST_CALL_ERROR, OVIRT_REST_CALL_ERROR_CANCELLED,
+                                err->message);
+            g_clear_error(&err);
+        } else if (err != NULL) {
+            g_warning("Error while getting collection: %s", err->message);
+            g_propagate_error(error, err);
+        } else {
+            g_warning("Error while getting collection");
+        }
+        g_object_unref(G_OBJECT(call));
+        return NULL;
+    }
+    ovirt_proxy_account_response(proxy, call);
+
+    return call;
+}
+
+
+RestXmlNode *ovirt_proxy_get_collection_xml(OvirtProxy *proxy,
+                                            const char *href,
+                                            GError **error)
+{
+    RestProxyCall *call;
+    RestXmlNode *root;
+
+    g_return_val_if_fail(OVIRT_IS_PROXY(proxy), NULL);
+
+    if (ovirt_proxy_lookup_parsed_response(proxy, href, &root, error))
+        return root;
+
+    call = ovirt_proxy_get_collection_call(proxy, href, NULL, NULL, NULL, error);
+    if (call == NULL)
+        return NULL;
+
+    root = ovirt_rest_xml_node_from_call(call);
+    if (root != NULL) {
+        ovirt_proxy_cache_parsed_response(proxy, call, href, root);
+    }
+    g_object_unref(G_OBJECT(call));
+
+    return root;
+}
+
+
+/*
+ * Same as ovirt_proxy_get_collection_xml(), but the request is made
+ * conditional using @validators, which are updated on success, and the
+ * root element of JSON responses is named @root_name. When the
+ * collection was not modified since @validators were obtained, TRUE is
+ * returned and @xml is set to NULL. The response is stored in the on-disk
+ * cache when it is enabled.
+ */
+gboolean ovirt_proxy_get_collection_xml_if_modified(OvirtProxy *proxy,
+                                                    const char *href,
+                                                    const char *root_name,
+                                                    OvirtCacheValidators **validators,
+                                                    RestXmlNode **xml,
+                                                    GError **error)
+{
+    RestProxyCall *call;
+    gboolean not_modified = FALSE;
+
+    g_return_val_if_fail(OVIRT_IS_PROXY(proxy), FALSE);
+    g_return_val_if_fail(validators != NULL, FALSE);
+    g_return_val_if_fail(xml != NULL, FALSE);
+
+    if (ovirt_proxy_lookup_parsed_response(proxy, href, xml, error))
+        return (*xml != NULL);
+
+    call = ovirt_proxy_get_collection_call(proxy, href, root_name, *validators,
+                                           &not_modified, error);
+    if (call == NULL)
+        return not_modified;
+
+    *xml = ovirt_rest_xml_node_from_call(call);
+    if (*xml == NULL) {
+        g_set_error_literal(error, OVIRT_ERROR, OVIRT_ERROR_PARSING_FAILED,
+                            _("Failed to parse response from collection"));
+        g_clear_pointer(validators, ovirt_cache_validators_free);
+    } else {
+        ovirt_cache_validators_update(validators, call, href);
+        ovirt_proxy_cache_response(proxy, href, call);
+        ovirt_proxy_cache_parsed_response(proxy, call, href, *xml);
+    }
+    g_object_unref(G_OBJECT(call));
+
+    return (*xml != NULL);
+}
+
+
+/*
+ * The synchronous REST API only gives access to the complete payload, so
+ * this does not save the download buffer, but the payload is never turned
+ * into a full RestXmlNode tree. @modified is set to FALSE when the
+ * collection did not change since @validators were obtained, in which case
+ * nothing is fed to @stream.
+ */
+gboolean ovirt_proxy_get_collection_xml_stream(OvirtProxy *proxy,
+                                               const char *href,
+                                               OvirtXmlStream *stream,
+                                               OvirtCacheValidators **validators,
+                                               gboolean *modified,
+                                               GError **error)
+{
+    RestProxyCall *call;
+    const char *payload;
+    gboolean parsed = FALSE;
+    gboolean not_modified = FALSE;
+
+    g_return_val_if_fail(OVIRT_IS_PROXY(proxy), FALSE);
+    g_return_val_if_fail(stream != NULL, FALSE);
+    g_return_val_if_fail(modified != NULL, FALSE);
+
+    *modified = TRUE;
+    call = ovirt_proxy_get_collection_call(proxy, href, NULL,
+                                           (validators != NULL) ? *validators : NULL,
+                                           &not_modified, error);
+    if (call == NULL) {
+        *modified = !not_modified;
+        return not_modified;
+    }
+
+    payload = rest_proxy_call_get_payload(call);
+    if (payload == NULL) {
+        g_set_error_literal(error, OVIRT_ERROR, OVIRT_ERROR_PARSING_FAILED,
+                            _("Failed to parse response from collection"));
+        goto end;
+    }
+
+    if (!ovirt_xml_stream_feed(stream, payload,
+                               rest_proxy_call_get_payload_length(call),
+                               error))
+        goto end;
+
+    parsed = ovirt_xml_stream_end(stream, error);
+
+end:
+    if (parsed && (validators != NULL)) {
+        ovirt_cache_validators_update(validators, call, href);
+        ovirt_proxy_cache_response(proxy, href, call);
+    } else if (validators != NULL) {
+        g_clear_pointer(validators, ovirt_cache_validators_free);
+    }
+    g_object_unref(G_OBJECT(call));
+
+    return parsed;
+}
+
+typedef struct {
+    OvirtProxy *proxy;
+    GTask *task;
+    OvirtProxyCallAsyncCb call_async_cb;
+    gpointer call_user_data;
+    GDestroyNotify destroy_call_data;
+} OvirtProxyCallAsyncData;
+
+static void ovirt_proxy_call_async_data_free(OvirtProxyCallAsyncData *data)
+{
+    if (data->destroy_call_data != NULL) {
+        data->destroy_call_data(data->call_user_data);
+    }
+
+    g_clear_object(&data->proxy);
+    g_clear_object(&data->task);
+
+    g_slice_free(OvirtProxyCallAsyncData, data);
+}
+
+static void rest_call_async_set_error(RestProxyCall *call, GTask *task, const GError *error)
+{
+    GError *local_error = NULL;
+    RestXmlNode *root = ovirt_rest_xml_node_from_call(call);
+
+    if (root != NULL && ovirt_utils_gerror_from_xml_fault(root, &local_error)) {
+        g_debug("ovirt_rest_call_async(): %s", local_error->message);
+        g_task_return_error(task, local_error);
+    } else {
+        g_task_return_error(task, (GError *) error);
+    }
+
+    if (root != NULL) {
+        rest_xml_node_unref(root);
+    }
+}
+
+static void
+call_async_cb(GObject *source_obj,
+              GAsyncResult *result,
+              gpointer user_data)
+{
+    RestProxyCall *call = REST_PROXY_CALL(source_obj);
+    GError *error = NULL;
+    OvirtProxyCallAsyncData *data = user_data;
+    GTask *task = data->task;
+    gboolean callback_result = TRUE;
+
+    rest_proxy_call_invoke_finish(call, result, &error);
+    ovirt_proxy_account_response(data->proxy, call);
+    ovirt_rest_call_discard_cached_responses(call);
+    if (error != NULL) {
+        ovirt_proxy_cache_failed_response(data->proxy, call);
+    }
+    if ((error != NULL) && ovirt_rest_call_is_not_modified(call)) {
+        /* Nothing to parse, the caller is already up to date */
+        g_clear_error(&error);
+        g_task_return_boolean(task, TRUE);
+        goto exit;
+    }
+    if (error != NULL) {
+        goto exit;
+    }
+
+    if (data->call_async_cb != NULL) {
+        callback_result = data->call_async_cb(data->proxy, call,
+                                              data->call_user_data,
+                                              &error);
+        if (error != NULL) {
+            goto exit;
+        }
+    }
+
+    g_task_return_boolean(task, callback_result);
+
+exit:
+    if (error != NULL) {
+        rest_call_async_set_error(call, task, error);
+    }
+    ovirt_proxy_call_async_data_free(data);
+}
+
+
+void ovirt_rest_call_async(OvirtRestCall *call,
+                           GTask *task,
+                           GCancellable *cancellable,
+                           OvirtProxyCallAsyncCb callback,
+                           gpointer user_data,
+                           GDestroyNotify destroy_func)
+{
+    OvirtProxy *proxy;
+    OvirtProxyCallAsyncData *data;
+
+    g_return_if_fail((cancellable == NULL) || G_IS_CANCELLABLE(cancellable));
+    g_object_get(G_OBJECT(call), "proxy", &proxy, NULL);
+    g_return_if_fail(OVIRT_IS_PROXY(proxy));
+
+    data = g_slice_new0(OvirtProxyCallAsyncData);
+    data->proxy = proxy;
+    data->task = task;
+    data->call_async_cb = callback;
+    data->call_user_data = user_data;
+    data->destroy_call_data = destroy_func;
+
+    rest_proxy_call_invoke_async(REST_PROXY_CALL (call), cancellable, call_async_cb, data);
+}
+
+
+gboolean ovirt_rest_call_finish(GAsyncResult *result, GError **err)
+{
+    return g_task_propagate_boolean(G_TASK(result), err);
+}
+
+
+/* A GET request sent on behalf of all the callers which asked for the same
+ * href while it was in flight */
+typedef struct {
+    OvirtProxy *proxy;
+    char *key;
+    RestProxyCall *call;
+    GCancellable *cancellable;
+    GList *waiters;
+    /* OvirtSharedGetPreparation, run in the thread parsing the response */
+    GPtrArray *preparations;
+} OvirtSharedGet;
+
+typedef struct {
+    OvirtProxyPrepareFunc prepare;
+    gpointer data;
+    GDestroyNotify destroy_data;
+} OvirtSharedGetPreparation;
+
+typedef struct {
+    OvirtSharedGet *get;
+    GTask *task;
+    gulong cancelled_id;
+    GSource *cancelled_source;
+    OvirtProxySharedGetCb callback;
+    gpointer user_data;
+    GDestroyNotify destroy_user_data;
+} OvirtSharedGetWaiter;
+
+static void ovirt_shared_get_waiter_free(OvirtSharedGetWaiter *waiter)
+{
+    if (waiter->cancelled_id != 0) {
+        g_cancellable_disconnect(g_task_get_cancellable(waiter->task),
+                                 waiter->cancelled_id);
+    }
+    if (waiter->cancelled_source != NULL) {
+        g_source_destroy(waiter->cancelled_source);
+        g_source_unref(waiter->cancelled_source);
+    }
+    if (waiter->destroy_user_data != NULL) {
+        waiter->destroy_user_data(waiter->user_data);
+    }
+    g_object_unref(waiter->task);
+    g_slice_free(OvirtSharedGetWaiter, waiter);
+}
+
+static void ovirt_shared_get_preparation_free(OvirtSharedGetPreparation *preparation)
+{
+    if (preparation->destroy_data != NULL) {
+        preparation->destroy_data(preparation->data);
+    }
+    g_slice_free(OvirtSharedGetPreparation, preparation);
+}
+
+static void ovirt_shared_get_free(OvirtSharedGet *get)
+{
+    g_warn_if_fail(get->waiters == NULL);
+
+    g_ptr_array_unref(get->preparations);
+    g_free(get->key);
+    g_object_unref(get->call);
+    g_object_unref(get->cancellable);
+    g_object_unref(get->proxy);
+    g_slice_free(OvirtSharedGet, get);
+}
+
+/* Prevents new callers from waiting for @get */
+static void ovirt_shared_get_detach(OvirtSharedGet *get)
+{
+    GHashTable *shared_gets = get->proxy->priv->shared_gets;
+
+    if (g_hash_table_lookup(shared_gets, get->key) == get) {
+        g_hash_table_remove(shared_gets, get->key);
+    }
+}
+
+static gboolean shared_get_waiter_cancelled_idle(gpointer user_data)
+{
+    OvirtSharedGetWaiter *waiter = user_data;
+    OvirtSharedGet *get = waiter->get;
+
+    get->waiters = g_list_remove(get->waiters, waiter);
+    g_task_return_error_if_cancelled(waiter->task);
+    ovirt_shared_get_waiter_free(waiter);
+
+    /* The request itself is only cancelled once nobody waits for it */
+    if (get->waiters == NULL) {
+        ovirt_shared_get_detach(get);
+        g_cancellable_cancel(get->cancellable);
+    }
+
+    return G_SOURCE_REMOVE;
+}
+
+static void shared_get_waiter_cancelled(G_GNUC_UNUSED GCancellable *cancellable,
+                                        gpointer user_data)
+{
+    OvirtSharedGetWaiter *waiter = user_data;
+
+    /* Same as in get_collection_xml_stream_cancelled(), disconnecting
+     * from this handler would deadlock */
+    if (waiter->cancelled_source != NULL) {
+        return;
+    }
+    waiter->cancelled_source = g_idle_source_new();
+    g_source_set_callback(waiter->cancelled_source,
+                          shared_get_waiter_cancelled_idle, waiter, NULL);
+    g_source_attach(waiter->cancelled_source, g_task_get_context(waiter->task));
+}
+
+/* Calls back all the callers waiting for @get, and frees it */
+static void ovirt_shared_get_complete(OvirtSharedGet *get,
+                                      RestXmlNode *root,
+                                      GError *error,
+                                      gboolean not_modified)
+{
+    GList *waiters;
+    GList *it;
+
+    waiters = get->waiters;
+    get->waiters = NULL;
+
+    for (it = waiters; it != NULL; it = it->next) {
+        OvirtSharedGetWaiter *waiter = it->data;
+        GError *waiter_error = NULL;
+        gboolean callback_result = TRUE;
+
+        if (g_task_return_error_if_cancelled(waiter->task)) {
+            /* Cancelled before the idle callback removing it from
+             * get->waiters could run */
+            ovirt_shared_get_waiter_free(waiter);
+            continue;
+        }
+        if (error != NULL) {
+            waiter_error = g_error_copy(error);
+        } else if (!not_modified) {
+            callback_result = waiter->callback(get->proxy, get->call, root,
+                                               waiter->user_data,
+                                               &waiter_error);
+        }
+        if (waiter_error != NULL) {
+            g_task_return_error(waiter->task, waiter_error);
+        } else {
+            g_task_return_boolean(waiter->task, callback_result);
+        }
+        ovirt_shared_get_waiter_free(waiter);
+    }
+    g_list_free(waiters);
+
+    g_clear_error(&error);
+    if (root != NULL) {
+        rest_xml_node_unref(root);
+    }
+    ovirt_shared_get_free(get);
+}
+
+static void shared_get_parse_thread(GTask *task,
+                                    G_GNUC_UNUSED gpointer source_object,
+                                    gpointer task_data,
+                                    GCancellable *cancellable)
+{
+    OvirtSharedGet *get = task_data;
+    RestXmlNode *root;
+    guint i;
+
+    /* The payload is only parsed once for all the callers */
+    root = ovirt_rest_xml_node_from_call(get->call);
+    if (root == NULL) {
+        g_task_return_pointer(task, NULL, NULL);
+        return;
+    }
+
+    for (i = 0; i < get->preparations->len; i++) {
+        OvirtSharedGetPreparation *preparation;
+
+        if (g_cancellable_is_cancelled(cancellable)) {
+            break;
+        }
+        preparation = g_ptr_array_index(get->preparations, i);
+        preparation->prepare(root, preparation->data, cancellable);
+    }
+
+    g_task_return_pointer(task, root, (GDestroyNotify)rest_xml_node_unref);
+}
+
+static void shared_get_parsed(G_GNUC_UNUSED GObject *source_object,
+                              GAsyncResult *result,
+                              gpointer user_data)
+{
+    OvirtSharedGet *get = user_data;
+    RestXmlNode *root;
+    GError *error = NULL;
+
+    /* Only fails when all the callers cancelled */
+    root = g_task_propagate_pointer(G_TASK(result), &error);
+    ovirt_shared_get_complete(get, root, error, FALSE);
+}
+
+static void shared_get_done(GObject *source_obj,
+                            GAsyncResult *result,
+                            gpointer user_data)
+{
+    OvirtSharedGet *get = user_data;
+    RestProxyCall *call = REST_PROXY_CALL(source_obj);
+    RestXmlNode *root = NULL;
+    GError *error = NULL;
+    gboolean not_modified = FALSE;
+    GTask *task;
+
+    ovirt_shared_get_detach(get);
+
+    rest_proxy_call_invoke_finish(call, result, &error);
+    ovirt_proxy_account_response(get->proxy, call);
+    if ((error != NULL) && ovirt_rest_call_is_not_modified(call)) {
+        /* Nothing to parse, the callers are already up to date */
+        not_modified = TRUE;
+        g_clear_error(&error);
+    } else if (error != NULL) {
+        GError *fault_error = NULL;
+
+        ovirt_proxy_cache_failed_response(get->proxy, call);
+        /* Errors may come with a <fault> body describing them */
+        root = ovirt_rest_xml_node_from_call(call);
+        if ((root != NULL) && ovirt_utils_gerror_from_xml_fault(root, &fault_error)) {
+            g_debug("ovirt_proxy_get_shared_async(): %s", fault_error->message);
+            g_clear_error(&error);
+            error = fault_error;
+        }
+    } else {
+        /* Large responses would block the main context of the callers
+         * while they are parsed, the callers are only called back once
+         * this is done. Callers cancelling in the meantime are still
+         * removed from get->waiters. */
+        task = g_task_new(get->proxy, get->cancellable, shared_get_parsed, get);
+        g_task_set_task_data(task, get, NULL);
+        g_task_run_in_thread(task, shared_get_parse_thread);
+        g_object_unref(task);
+        return;
+    }
+
+    ovirt_shared_get_complete(get, root, error, not_modified);
+}
+
+
+/*
+ * Sends the GET request @call, unless an identical request (same href and
+ * same conditional headers) is already in flight, in which case @call is
+ * dropped and the caller waits for that request instead. Either way,
+ * @callback is called with the parsed response, which is shared by all
+ * the callers; @root is NULL if the response could not be parsed.
+ * @callback is not called when the response is '304 Not Modified'.
+ *
+ * The response is parsed in a worker thread, @prepare is then called with
+ * it from the same thread, before @callback is called from the main
+ * context of the caller. @prepare_data must not be accessed from the
+ * main context until then.
+ *
+ * Cancelling @cancellable only completes @task, the request is cancelled
+ * once all the callers waiting for it cancelled.
+ */
+void ovirt_proxy_get_shared_async(OvirtProxy *proxy,
+                                  RestProxyCall *call,
+                                  GTask *task,
+                                  GCancellable *cancellable,
+                                  OvirtProxyPrepareFunc prepare,
+                                  gpointer prepare_data,
+                                  GDestroyNotify destroy_prepare_data,
+                                  OvirtProxySharedGetCb callback,
+                                  gpointer user_data,
+                                  GDestroyNotify destroy_func)
+{
+    OvirtSharedGet *get;
+    OvirtSharedGetWaiter *waiter;
+    const char *if_none_match;
+    const char *if_modified_since;
+    char *key;
+
+    g_return_if_fail(OVIRT_IS_PROXY(proxy));
+    g_return_if_fail(REST_IS_PROXY_CALL(call));
+    g_return_if_fail(callback != NULL);
+
+    if_none_match = rest_proxy_call_lookup_header(call, "If-None-Match");
+    if_modified_since = rest_proxy_call_lookup_header(call, "If-Modified-Since");
+    key = g_strdup_printf("%s\n%s\n%s", rest_proxy_call_get_function(call),
+                          (if_none_match != NULL) ? if_none_match : "",
+                          (if_modified_since != NULL) ? if_modified_since : "");
+
+    get = g_hash_table_lookup(proxy->priv->shared_gets, key);
+    if (get == NULL) {
+        get = g_slice_new0(OvirtSharedGet);
+        get->proxy = g_object_ref(proxy);
+        get->key = key;
+        get->call = g_object_ref(call);
+        get->cancellable = g_cancellable_new();
+        get->preparations = g_ptr_array_new_with_free_func((GDestroyNotify)ovirt_shared_get_preparation_free);
+        g_hash_table_insert(proxy->priv->shared_gets, get->key, get);
+        rest_proxy_call_invoke_async(call, get->cancellable, shared_get_done, get);
+    } else {
+        g_free(key);
+    }
+
+    if (prepare != NULL) {
+        OvirtSharedGetPreparation *preparation;
+
+        preparation = g_slice_new0(OvirtSharedGetPreparation);
+        preparation->prepare = prepare;
+        preparation->data = prepare_data;
+        preparation->destroy_data = destroy_prepare_data;
+        g_ptr_array_add(get->preparations, preparation);
+    } else if (destroy_prepare_data != NULL) {
+        destroy_prepare_data(prepare_data);
+    }
+
+    waiter = g_slice_new0(OvirtSharedGetWaiter);
+    waiter->get = get;
+    waiter->task = task;
+    waiter->callback = callback;
+    waiter->user_data = user_data;
+    waiter->destroy_user_data = destroy_func;
+    get->waiters = g_list_append(get->waiters, waiter);
+
+    if (cancellable != NULL) {
+        waiter->cancelled_id = g_cancellable_connect(cancellable,
+                                                     G_CALLBACK(shared_get_waiter_cancelled),
+                                                     waiter, NULL);
+    }
+}
+
+typedef struct {
+    OvirtProxyGetCollectionAsyncCb parser;
+    gpointer user_data;
+    GDestroyNotify destroy_user_data;
+    char *href;
+    OvirtCacheValidators **validators;
+} OvirtProxyGetCollectionAsyncData;
+
+static void
+ovirt_proxy_get_collection_async_data_destroy(OvirtProxyGetCollectionAsyncData *data)
+{
+    if (data->destroy_user_data != NULL) {
+        data->destroy_user_data(data->user_data);
+    }
+    g_free(data->href);
+    g_slice_free(OvirtProxyGetCollectionAsyncData, data);
+}
+
+static gboolean get_collection_xml_async_cb(OvirtProxy* proxy,
+                                            RestProxyCall *call,
+                                            RestXmlNode *root,
+                                            gpointer user_data,
+                                            GError **error)
+{
+    OvirtProxyGetCollectionAsyncData *data;
+    gboolean parsed = FALSE;
+
+    data = (OvirtProxyGetCollectionAsyncData *)user_data;
+
+    if (root == NULL) {
+        g_set_error_literal(error, OVIRT_ERROR, OVIRT_ERROR_PARSING_FAILED,
+                            _("Failed to parse response from collection"));
+        goto end;
+    }
+
+    /* Do the parsing */
+    g_warn_if_fail(data->parser != NULL);
+    if (data->parser != NULL) {
+        parsed = data->parser(proxy, root, data->user_data, error);
+    }
+    if (parsed) {
+        ovirt_proxy_cache_parsed_response(proxy, call, data->href, root);
+    }
+
+end:
+    if (parsed && (data->validators != NULL)) {
+        ovirt_cache_validators_update(data->validators, call, data->href);
+        ovirt_proxy_cache_response(proxy, data->href, call);
+    } else if (data->validators != NULL) {
+        g_clear_pointer(data->validators, ovirt_cache_validators_free);
+    }
+
+    return parsed;
+}
+
+/**
+ * ovirt_proxy_get_collection_xml_async:
+ * @proxy: a #OvirtProxy
+ * @root_name: (nullable): name of the XML element the response describes,
+ * which JSON responses do not give; it is guessed from @href when NULL
+ * @validators: (nullable): location of the validators of the last
+ * response the caller parsed, which is only downloaded again when it
+ * changed; they are updated after @callback succeeds, and the response is
+ * then stored in the on-disk cache when it is enabled
+ * @callback: (scope async): completion callback
+ * @user_data: (closure): opaque data for callback
+ */
+void ovirt_proxy_get_collection_xml_async(OvirtProxy *proxy,
+                                          const char *href,
+                                          const char *root_name,
+                                          OvirtCacheValidators **validators,
+                                          GTask *task,
+                                          GCancellable *cancellable,
+                                          OvirtProxyGetCollectionAsyncCb callback,
+                                          gpointer user_data,
+                                          GDestroyNotify destroy_func)
+{
+    ovirt_proxy_get_collection_xml_full_async(proxy, href, root_name,
+                                              validators, task, cancellable,
+                                              NULL, NULL, NULL,
+                                              callback, user_data,
+                                              destroy_func);
+}
+
+
+/*
+ * Same as ovirt_proxy_get_collection_xml_async(), except that @prepare is
+ * called from a worker thread with the downloaded response before
+ * @callback, see ovirt_proxy_get_shared_async(). It is not called when
+ * the response comes from the cache, or did not change.
+ */
+void ovirt_proxy_get_collection_xml_full_async(OvirtProxy *proxy,
+                                               const char *href,
+                                               const char *root_name,
+                                               OvirtCacheValidators **validators,
+                                               GTask *task,
+                                               GCancellable *cancellable,
+                                               OvirtProxyPrepareFunc prepare,
+                                               gpointer prepare_data,
+                                               GDestroyNotify destroy_prepare_data,
+                                               OvirtProxyGetCollectionAsyncCb callback,
+                                               gpointer user_data,
+                                               GDestroyNotify destroy_func)
+{
+    OvirtProxyGetCollectionAsyncData *data;
+    RestProxyCall *call;
+    RestXmlNode *root;
+    GError *error = NULL;
+
+    if (ovirt_proxy_lookup_parsed_response(proxy, href, &root, &error)) {
+        gboolean parsed = FALSE;
+
+        if (root != NULL) {
+            parsed = callback(proxy, root, user_data, &error);
+            rest_xml_node_unref(root);
+        }
+        if (error != NULL) {
+            g_task_return_error(task, error);
+        } else {
+            g_task_return_boolean(task, parsed);
+        }
+        g_object_unref(task);
+        if (destroy_prepare_data != NULL) {
+            destroy_prepare_data(prepare_data);
+        }
+        if (destroy_func != NULL) {
+            destroy_func(user_data);
+        }
+        return;
+    }
+
+    data = g_slice_new0(OvirtProxyGetCollectionAsyncData);
+    data->parser = callback;
+    data->user_data = user_data;
+    data->destroy_user_data = destroy_func;
+    data->href = g_strdup(href);
+    data->validators = validators;
+
+    call = ovirt_rest_call_new(proxy, "GET", href);
+    ovirt_rest_call_set_root_name(call, root_name);
+    if (validators != NULL) {
+        ovirt_cache_validators_add_headers(*validators, call, href);
+    }
+
+    ovirt_proxy_get_shared_async(proxy, call, task, cancellable,
+                                 prepare, prepare_data, destroy_prepare_data,
+                                 get_collection_xml_async_cb, data,
+                                 (GDestroyNotify)ovirt_proxy_get_collection_async_data_destroy);
+    g_object_unref(call);
+}
+
+
+typedef struct {
+    OvirtProxy *proxy;
+    GTask *task;
+    RestProxyCall *call;
+    OvirtXmlStream *stream;
+    gsize n_bytes;
+    char *href;
+    OvirtCacheValidators **validators;
+    GError *error;
+    gulong cancelled_id;
+    OvirtProxyGetCollectionStreamCb callback;
+    gpointer user_data;
+    GDestroyNotify destroy_user_data;
+} OvirtProxyGetCollectionStreamData;
+
+static void
+ovirt_proxy_get_collection_stream_data_free(OvirtProxyGetCollectionStreamData *data)
+{
+    GCancellable *cancellable;
+
+    cancellable = g_task_get_cancellable(data->task);
+    if (data->cancelled_id != 0) {
+        g_cancellable_disconnect(cancellable, data->cancelled_id);
+    }
+    ovirt_xml_stream_free(data->stream);
+    if (data->destroy_user_data != NULL) {
+        data->destroy_user_data(data->user_data);
+    }
+    g_clear_error(&data->error);
+    g_free(data->href);
+    g_clear_object(&data->call);
+    g_clear_object(&data->task);
+    g_clear_object(&data->proxy);
+
+    g_slice_free(OvirtProxyGetCollectionStreamData, data);
+}
+
+static gboolean cancel_call_idle_cb(gpointer user_data)
+{
+    rest_proxy_call_cancel(REST_PROXY_CALL(user_data));
+
+    return G_SOURCE_REMOVE;
+}
+
+static void get_collection_xml_stream_cancelled(G_GNUC_UNUSED GCancellable *cancellable,
+                                                gpointer user_data)
+{
+    OvirtProxyGetCollectionStreamData *data = user_data;
+    GSource *idle_source;
+
+    /* Cancelling the call from this handler could cause
+     * ovirt_proxy_get_collection_stream_data_free() to be called, which
+     * would then deadlock in g_cancellable_disconnect(), so this has to
+     * be done from an idle */
+    idle_source = g_idle_source_new();
+    g_source_set_callback(idle_source, cancel_call_idle_cb,
+                          g_object_ref(data->call), g_object_unref);
+    g_source_attach(idle_source, g_task_get_context(data->task));
+    g_source_unref(idle_source);
+}
+
+static void get_collection_xml_stream_cb(G_GNUC_UNUSED RestProxyCall *call,
+                                         const gchar *buf,
+                                         gsize len,
+                                         const GError *error,
+                                         G_GNUC_UNUSED GObject *weak_object,
+                                         gpointer user_data)
+{
+    OvirtProxyGetCollectionStreamData *data = user_data;
+
+    if (buf != NULL) {
+        data->n_bytes += len;
+        /* Once parsing failed, the rest of the payload is ignored */
+        if (data->error == NULL) {
+            ovirt_xml_stream_feed(data->stream, buf, len, &data->error);
+        }
+        return;
+    }
+
+    /* A NULL buffer means the call is complete */
+    ovirt_proxy_account_transfer(data->proxy, data->call, data->n_bytes);
+    if ((data->error == NULL) && (error != NULL) &&
+        ovirt_rest_call_is_not_modified(data->call)) {
+        /* Nothing was received, and nothing has to be applied */
+    } else if (data->error == NULL) {
+        if (error != NULL) {
+            /* Errors may come with a <fault> body describing them */
+            GError *fault_error = NULL;
+
+            if (!ovirt_xml_stream_end(data->stream, &fault_error) &&
+                (fault_error != NULL) && (fault_error->domain == OVIRT_ERROR)) {
+                g_debug("ovirt_proxy_get_collection_xml_stream_async(): %s",
+                        fault_error->message);
+                data->error = fault_error;
+            } else {
+                g_clear_error(&fault_error);
+                data->error = g_error_copy(error);
+            }
+        } else if (ovirt_xml_stream_end(data->stream, &data->error) &&
+                   (data->callback != NULL)) {
+            data->callback(data->proxy, data->user_data, &data->error);
+        }
+        if (data->error == NULL) {
+            ovirt_cache_validators_update(data->validators, data->call, data->href);
+        } else if (data->validators != NULL) {
+            g_clear_pointer(data->validators, ovirt_cache_validators_free);
+        }
+    }
 
-end:
-    return parsed;
+    if (data->error != NULL) {
+        g_task_return_error(data->task, data->error);
+        data->error = NULL;
+    } else {
+        g_task_return_boolean(data->task, TRUE);
+    }
+    ovirt_proxy_get_collection_stream_data_free(data);
 }
 
-/**
- * ovirt_proxy_get_collection_xml_async:
- * @proxy: a #OvirtProxy
- * @callback: (scope async): completion callback
- * @user_data: (closure): opaque data for callback
+/*
+ * Same as ovirt_proxy_get_collection_xml_async(), except that the payload is
+ * fed to @stream as it is being received, and is never kept in memory in its
+ * entirety. @callback is called once the whole payload has been successfully
+ * parsed, it is not called when the collection did not change since
+ * @validators were obtained. @stream is owned by the proxy after this call.
  */
-void ovirt_proxy_get_collection_xml_async(OvirtProxy *proxy,
-                                          const char *href,
-                                          GTask *task,
-                                          GCancellable *cancellable,
-                                          OvirtProxyGetCollectionAsyncCb callback,
-                                          gpointer user_data,
-                                          GDestroyNotify destroy_func)
+void ovirt_proxy_get_collection_xml_stream_async(OvirtProxy *proxy,
+                                                 const char *href,
+                                                 OvirtXmlStream *stream,
+                                                 OvirtCacheValidators **validators,
+                                                 GTask *task,
+                                                 GCancellable *cancellable,
+                                                 OvirtProxyGetCollectionStreamCb callback,
+                                                 gpointer user_data,
+                                                 GDestroyNotify destroy_func)
 {
-    OvirtProxyGetCollectionAsyncData *data;
-    RestProxyCall *call;
+    OvirtProxyGetCollectionStreamData *data;
+    GError *error = NULL;
 
-    data = g_slice_new0(OvirtProxyGetCollectionAsyncData);
-    data->parser = callback;
+    data = g_slice_new0(OvirtProxyGetCollectionStreamData);
+    data->proxy = g_object_ref(proxy);
+    data->task = task;
+    data->stream = stream;
+    data->callback = callback;
     data->user_data = user_data;
     data->destroy_user_data = destroy_func;
+    data->href = g_strdup(href);
+    data->validators = validators;
+    data->call = ovirt_rest_call_new(proxy, "GET", href);
+    if (validators != NULL) {
+        ovirt_cache_validators_add_headers(*validators, data->call, href);
+    }
 
-    call = ovirt_rest_call_new(proxy, "GET", href);
+    if (!rest_proxy_call_continuous(data->call, get_collection_xml_stream_cb,
+                                    NULL, data, &error)) {
+        g_task_return_error(task, error);
+        ovirt_proxy_get_collection_stream_data_free(data);
+        return;
+    }
 
-    ovirt_rest_call_async(OVIRT_REST_CALL(call), task, cancellable,
-                          get_collection_xml_async_cb, data,
-                          (GDestroyNotify)ovirt_proxy_get_collection_async_data_destroy);
-    g_object_unref(call);
+    if (cancellable != NULL) {
+        data->cancelled_id = g_cancellable_connect(cancellable,
+                                                   G_CALLBACK(get_collection_xml_stream_cancelled),
+                                                   data, NULL);
+    }
 }
 
 
@@ -419,6 +1940,7 @@ static GByteArray *get_ca_cert_data(OvirtProxy *proxy)
 
 static void ovirt_proxy_free_tmp_ca_file(OvirtProxy *proxy)
 {
+    g_rec_mutex_lock(&proxy->priv->lock);
     if (proxy->priv->tmp_ca_file != NULL) {
         int unlink_failed;
         unlink_failed = g_unlink(proxy->priv->tmp_ca_file);
@@ -428,10 +1950,12 @@ static void ovirt_proxy_free_tmp_ca_file(OvirtProxy *proxy)
         g_free(proxy->priv->tmp_ca_file);
         proxy->priv->tmp_ca_file = NULL;
     }
+    g_rec_mutex_unlock(&proxy->priv->lock);
 }
 
 static void ovirt_proxy_set_tmp_ca_file(OvirtProxy *proxy, const char *ca_file)
 {
+    g_rec_mutex_lock(&proxy->priv->lock);
     ovirt_proxy_free_tmp_ca_file(proxy);
     proxy->priv->tmp_ca_file = g_strdup(ca_file);
     if (ca_file != NULL) {
@@ -444,6 +1968,7 @@ static void ovirt_proxy_set_tmp_ca_file(OvirtProxy *proxy, const char *ca_file)
         proxy->priv->setting_ca_file = TRUE;
         g_object_set(G_OBJECT(proxy), "ssl-ca-file", ca_file, NULL);
     }
+    g_rec_mutex_unlock(&proxy->priv->lock);
 }
 
 
@@ -520,6 +2045,37 @@ end:
 }
 
 
+static void ovirt_proxy_set_vm_display_ca(OvirtProxy *proxy, OvirtVm *vm)
+{
+    OvirtVmDisplay *display;
+
+    g_object_get(G_OBJECT(vm), "display", &display, NULL);
+    if (display != NULL) {
+        GByteArray *ca_cert = NULL;
+        g_object_get(G_OBJECT(display), "ca-cert", &ca_cert, NULL);
+        if (ca_cert != NULL) {
+            g_byte_array_unref(ca_cert);
+            g_object_unref(display);
+            return;
+        }
+
+        g_rec_mutex_lock(&proxy->priv->lock);
+        if (proxy->priv->display_ca != NULL) {
+            ca_cert = g_byte_array_ref(proxy->priv->display_ca);
+        }
+        g_rec_mutex_unlock(&proxy->priv->lock);
+        g_object_set(G_OBJECT(display), "ca-cert", ca_cert, NULL);
+        g_clear_pointer(&ca_cert, g_byte_array_unref);
+        g_object_unref(display);
+    } else {
+        char *name;
+        g_object_get(vm, "name", &name, NULL);
+        g_debug("Not setting display CA for '%s' since it has no display",  name);
+        g_free(name);
+    }
+}
+
+
 static void ovirt_proxy_update_vm_display_ca(OvirtProxy *proxy)
 {
     GList *vms;
@@ -527,29 +2083,12 @@ static void ovirt_proxy_update_vm_display_ca(OvirtProxy *proxy)
 
     vms = ovirt_proxy_get_vms_internal(proxy);
     for (it = vms; it != NULL; it = it->next) {
-        OvirtVm *vm = OVIRT_VM(it->data);
-        OvirtVmDisplay *display;
-
-        g_object_get(G_OBJECT(vm), "display", &display, NULL);
-        if (display != NULL) {
-            GByteArray *ca_cert = NULL;
-            g_object_get(G_OBJECT(display), "ca-cert", &ca_cert, NULL);
-            if (ca_cert != NULL) {
-                g_byte_array_unref(ca_cert);
-                g_object_unref(display);
-                continue;
-            }
-
-            g_object_set(G_OBJECT(display),
-                         "ca-cert", proxy->priv->display_ca,
-                         NULL);
-            g_object_unref(display);
-        } else {
-            char *name;
-            g_object_get(vm, "name", &name, NULL);
-            g_debug("Not setting display CA for '%s' since it has no display",  name);
-            g_free(name);
+        /* VMs which are not materialized yet will get the CA set from
+         * vm_materialized() */
+        if (!ovirt_resource_is_materialized(OVIRT_RESOURCE(it->data))) {
+            continue;
         }
+        ovirt_proxy_set_vm_display_ca(proxy, OVIRT_VM(it->data));
     }
     g_list_free(vms);
 }
@@ -560,11 +2099,15 @@ static void set_display_ca_cert_from_data(OvirtProxy *proxy,
                                           gsize ca_cert_len)
 
 {
+    g_rec_mutex_lock(&proxy->priv->lock);
     if (proxy->priv->display_ca != NULL)
         g_byte_array_unref(proxy->priv->display_ca);
 
-    proxy->priv->display_ca = g_byte_array_new_take((guint8 *)ca_cert_data,
-                                                    ca_cert_len);
+    /* Shared with the displays whose certificate is the same */
+    proxy->priv->display_ca = ovirt_utils_byte_array_new_shared((guint8 *)ca_cert_data,
+                                                                ca_cert_len);
+    g_rec_mutex_unlock(&proxy->priv->lock);
+    g_free(ca_cert_data);
 
     /* While the fetched CA certificate has historically been used both as the CA
      * certificate used during REST API communication and as the one to use for
@@ -694,6 +2237,7 @@ static void ovirt_proxy_get_property(GObject *object,
 {
     OvirtProxy *proxy = OVIRT_PROXY(object);
 
+    g_rec_mutex_lock(&proxy->priv->lock);
     switch (prop_id) {
     case PROP_CA_CERT:
         g_value_take_boxed(value, get_ca_cert_data(proxy));
@@ -707,10 +2251,23 @@ static void ovirt_proxy_get_property(GObject *object,
     case PROP_SSO_TOKEN:
         g_value_set_string(value, proxy->priv->sso_token);
         break;
+    case PROP_CACHE_DIR:
+        g_value_set_string(value, proxy->priv->cache_dir);
+        break;
+    case PROP_WIRE_FORMAT:
+        g_value_set_enum(value, proxy->priv->wire_format);
+        break;
+    case PROP_RECEIVED_BYTES:
+        g_value_set_uint64(value, proxy->priv->received_bytes);
+        break;
+    case PROP_DECODED_BYTES:
+        g_value_set_uint64(value, proxy->priv->decoded_bytes);
+        break;
 
     default:
         G_OBJECT_WARN_INVALID_PROPERTY_ID(object, prop_id, pspec);
     }
+    g_rec_mutex_unlock(&proxy->priv->lock);
 }
 
 
@@ -727,6 +2284,7 @@ static void ovirt_proxy_set_session_id(OvirtProxy *proxy, const char *session_id
         domain = url;
     }
 
+    g_rec_mutex_lock(&proxy->priv->lock);
     if (proxy->priv->jsessionid_cookie != NULL) {
         soup_cookie_jar_delete_cookie(proxy->priv->cookie_jar,
                 proxy->priv->jsessionid_cookie);
@@ -740,6 +2298,7 @@ static void ovirt_proxy_set_session_id(OvirtProxy *proxy, const char *session_id
         soup_cookie_jar_add_cookie(proxy->priv->cookie_jar, cookie);
         proxy->priv->jsessionid_cookie = cookie;
     }
+    g_rec_mutex_unlock(&proxy->priv->lock);
     g_free(url);
 }
 
@@ -747,6 +2306,7 @@ static void ovirt_proxy_set_sso_token(OvirtProxy *proxy, const char *sso_token)
 {
     char *header_value;
 
+    g_rec_mutex_lock(&proxy->priv->lock);
     g_free(proxy->priv->sso_token);
     proxy->priv->sso_token = g_strdup(sso_token);
 
@@ -754,6 +2314,7 @@ static void ovirt_proxy_set_sso_token(OvirtProxy *proxy, const char *sso_token)
     header_value = g_strdup_printf("Bearer %s", sso_token);
     ovirt_proxy_add_header(proxy, "Authorization", header_value);
     g_free(header_value);
+    g_rec_mutex_unlock(&proxy->priv->lock);
 }
 
 
@@ -777,7 +2338,9 @@ static void ovirt_proxy_set_property(GObject *object,
     }
 
     case PROP_ADMIN:
+        g_rec_mutex_lock(&proxy->priv->lock);
         proxy->priv->admin_mode = g_value_get_boolean(value);
+        g_rec_mutex_unlock(&proxy->priv->lock);
         break;
 
     case PROP_SESSION_ID:
@@ -788,6 +2351,27 @@ static void ovirt_proxy_set_property(GObject *object,
         ovirt_proxy_set_sso_token(proxy, g_value_get_string(value));
         break;
 
+    case PROP_CACHE_DIR:
+        g_rec_mutex_lock(&proxy->priv->lock);
+        g_free(proxy->priv->cache_dir);
+        proxy->priv->cache_dir = g_value_dup_string(value);
+        g_rec_mutex_unlock(&proxy->priv->lock);
+        break;
+
+    case PROP_WIRE_FORMAT:
+#ifndef HAVE_JSON_GLIB
+        if (g_value_get_enum(value) == OVIRT_WIRE_FORMAT_JSON) {
+            g_warning("libgovirt was built without JSON support, responses stay XML");
+            break;
+        }
+#endif
+        proxy->priv->wire_format = g_value_get_enum(value);
+        /* Requests are still sent as XML */
+        ovirt_proxy_add_header(proxy, "Accept",
+                               (proxy->priv->wire_format == OVIRT_WIRE_FORMAT_JSON) ?
+                               "application/json" : NULL);
+        break;
+
     default:
         G_OBJECT_WARN_INVALID_PROPERTY_ID(object, prop_id, pspec);
     }
@@ -801,7 +2385,10 @@ ovirt_proxy_dispose(GObject *obj)
     g_clear_object(&proxy->priv->cookie_jar);
     g_clear_pointer(&proxy->priv->additional_headers, g_hash_table_unref);
     g_clear_object(&proxy->priv->api);
+    g_clear_pointer(&proxy->priv->api_validators, ovirt_cache_validators_free);
     g_clear_pointer(&proxy->priv->display_ca, g_byte_array_unref);
+    g_clear_pointer(&proxy->priv->job_poller, ovirt_job_poller_free);
+    ovirt_proxy_clear_identities(proxy);
 
     G_OBJECT_CLASS(ovirt_proxy_parent_class)->dispose(obj);
 }
@@ -814,6 +2401,13 @@ ovirt_proxy_finalize(GObject *obj)
     ovirt_proxy_free_tmp_ca_file(proxy);
     g_free(proxy->priv->jsessionid);
     g_free(proxy->priv->sso_token);
+    g_free(proxy->priv->cache_dir);
+    ovirt_proxy_discard_parsed_responses(proxy);
+    g_hash_table_unref(proxy->priv->responses);
+    g_clear_pointer(&proxy->priv->response_ttls, g_hash_table_unref);
+    g_hash_table_unref(proxy->priv->shared_gets);
+    g_mutex_clear(&proxy->priv->api_lock);
+    g_rec_mutex_clear(&proxy->priv->lock);
 
     G_OBJECT_CLASS(ovirt_proxy_parent_class)->finalize(obj);
 }
@@ -825,8 +2419,8 @@ static void ovirt_proxy_constructed(GObject *gobject)
         g_warning("Disabling strict checking of SSL certificates");
         g_object_set(OVIRT_PROXY(gobject), "ssl-strict", FALSE, NULL);
     }
-    /* FIXME: to set or not to set ?? */
-    ovirt_proxy_add_header(OVIRT_PROXY(gobject), "All-Content", "true");
+    /* All-Content is requested per collection and per resource, see
+     * OvirtCollection:content-level */
     ovirt_proxy_add_header(OVIRT_PROXY(gobject), "Prefer", "persistent-auth");
 
     /* Chain up to the parent class */
@@ -914,6 +2508,140 @@ ovirt_proxy_class_init(OvirtProxyClass *klass)
                                                         NULL,
                                                         G_PARAM_READWRITE |
                                                         G_PARAM_STATIC_STRINGS));
+
+    /**
+     * OvirtProxy:cache-dir:
+     *
+     * Directory in which the responses of the oVirt instance are cached,
+     * or NULL to disable caching. Entries are kept separately for each
+     * engine URL, user and #OvirtProxy:admin mode.
+     *
+     * When a cached response is available, the first call to
+     * ovirt_proxy_fetch_api_async(), and the first call to
+     * ovirt_collection_fetch_async() on a collection, complete immediately
+     * with the cached content. It is then revalidated in the background:
+     * the #OvirtApi instance is updated in place, and the
+     * #OvirtCollection::resource-added, #OvirtCollection::resource-changed
+     * and #OvirtCollection::resource-removed signals report the changes
+     * to the collection. This requires a running main loop. When the
+     * revalidation fails, #OvirtProxy::revalidation-failed is emitted.
+     *
+     * ovirt_proxy_fetch_api() revalidates the cached API entry point
+     * before returning, with a conditional request, and fails if this
+     * fails.
+     *
+     * Collections with #OvirtCollection:streaming set are not cached.
+     *
+     * Since: 0.3.12
+     */
+    g_object_class_install_property(oclass,
+                                    PROP_CACHE_DIR,
+                                    g_param_spec_string("cache-dir",
+                                                        "cache-dir",
+                                                        "Directory of the on-disk response cache",
+                                                        NULL,
+                                                        G_PARAM_READWRITE |
+                                                        G_PARAM_STATIC_STRINGS));
+
+    /**
+     * OvirtProxy:wire-format:
+     *
+     * Format in which the oVirt instance is asked to send its responses.
+     * JSON responses are decoded into the same #OvirtResource and
+     * #OvirtCollection objects as XML ones. Collections with
+     * #OvirtCollection:streaming set are not streamed when JSON is used.
+     *
+     * JSON responses are converted to the same trees as XML responses
+     * before being parsed, so selecting JSON does not make processing
+     * them faster, its only benefit is to reduce the amount of data
+     * sent by the server. JSON can only be selected when libgovirt was
+     * built with json-glib.
+     *
+     * Since: 0.3.12
+     */
+    g_object_class_install_property(oclass,
+                                    PROP_WIRE_FORMAT,
+                                    g_param_spec_enum("wire-format",
+                                                      "Wire format",
+                                                      "Format of the responses",
+                                                      OVIRT_TYPE_WIRE_FORMAT,
+                                                      OVIRT_WIRE_FORMAT_XML,
+                                                      G_PARAM_READWRITE |
+                                                      G_PARAM_STATIC_STRINGS));
+
+    /**
+     * OvirtProxy:received-bytes:
+     *
+     * Total size of the response bodies received by the proxy, as they
+     * were sent over the network. The libsoup session asks the server for
+     * compressed (gzip, deflate, and brotli when libsoup supports it)
+     * responses, which are decompressed while they are being received.
+     * When the server does not announce the length of a compressed
+     * response, its decompressed size is accounted for instead.
+     *
+     * Since: 0.3.12
+     */
+    g_object_class_install_property(oclass,
+                                    PROP_RECEIVED_BYTES,
+                                    g_param_spec_uint64("received-bytes",
+                                                        "Received bytes",
+                                                        "Size of the received response bodies",
+                                                        0, G_MAXUINT64, 0,
+                                                        G_PARAM_READABLE |
+                                                        G_PARAM_STATIC_STRINGS));
+
+    /**
+     * OvirtProxy:decoded-bytes:
+     *
+     * Total size of the response bodies received by the proxy once they
+     * were decompressed, see #OvirtProxy:received-bytes.
+     *
+     * Since: 0.3.12
+     */
+    g_object_class_install_property(oclass,
+                                    PROP_DECODED_BYTES,
+                                    g_param_spec_uint64("decoded-bytes",
+                                                        "Decoded bytes",
+                                                        "Size of the decompressed response bodies",
+                                                        0, G_MAXUINT64, 0,
+                                                        G_PARAM_READABLE |
+                                                        G_PARAM_STATIC_STRINGS));
+
+    /**
+     * OvirtProxy::revalidation-failed:
+     * @proxy: the #OvirtProxy
+     * @object: the #OvirtApi or #OvirtCollection which was filled from
+     * the on-disk cache
+     * @error: the #GError describing why its content could not be
+     * revalidated
+     *
+     * Emitted when the content of @object came from #OvirtProxy:cache-dir
+     * and could not be revalidated with the oVirt instance, for example
+     * because the credentials are no longer valid or because the server
+     * is failing. @object then still holds the cached content, which may
+     * be out of date.
+     *
+     * Since: 0.3.12
+     */
+    signals[REVALIDATION_FAILED] = g_signal_new("revalidation-failed",
+                                                OVIRT_TYPE_PROXY,
+                                                G_SIGNAL_RUN_LAST,
+                                                0, NULL, NULL, NULL,
+                                                G_TYPE_NONE, 2,
+                                                G_TYPE_OBJECT,
+                                                G_TYPE_ERROR);
+}
+
+
+/* Reports that the cached content of @object, an #OvirtApi or an
+ * #OvirtCollection, could not be revalidated */
+G_GNUC_INTERNAL void ovirt_proxy_revalidation_failed(OvirtProxy *proxy,
+                                                     GObject *object,
+                                                     const GError *error)
+{
+    g_debug("Failed to revalidate cached content of %p: %s",
+            object, error->message);
+    g_signal_emit(proxy, signals[REVALIDATION_FAILED], 0, object, error);
 }
 
 static void ssl_ca_file_changed(GObject *gobject,
@@ -921,11 +2649,14 @@ static void ssl_ca_file_changed(GObject *gobject,
                                 gpointer user_data)
 {
     OvirtProxy *proxy = OVIRT_PROXY(gobject);
+
+    g_rec_mutex_lock(&proxy->priv->lock);
     if (proxy->priv->setting_ca_file) {
         proxy->priv->setting_ca_file = FALSE;
-        return;
+    } else {
+        ovirt_proxy_free_tmp_ca_file(proxy);
     }
-    ovirt_proxy_free_tmp_ca_file(OVIRT_PROXY(gobject));
+    g_rec_mutex_unlock(&proxy->priv->lock);
 }
 
 static void
@@ -934,6 +2665,8 @@ ovirt_proxy_init(OvirtProxy *self)
     gulong handler_id;
 
     self->priv = ovirt_proxy_get_instance_private(self);
+    g_rec_mutex_init(&self->priv->lock);
+    g_mutex_init(&self->priv->api_lock);
 
     handler_id = g_signal_connect(G_OBJECT(self), "notify::ssl-ca-file",
                                   (GCallback)ssl_ca_file_changed, NULL);
@@ -945,8 +2678,42 @@ ovirt_proxy_init(OvirtProxy *self)
                                                            g_str_equal,
                                                            g_free,
                                                            g_free);
+    self->priv->responses = g_hash_table_new(g_str_hash, g_str_equal);
+    self->priv->shared_gets = g_hash_table_new(g_str_hash, g_str_equal);
+    g_queue_init(&self->priv->response_lru);
+    self->priv->identities = g_hash_table_new_full(g_str_hash, g_str_equal, NULL,
+                                                   (GDestroyNotify)ovirt_identity_free);
+    self->priv->identity_sweep_size = OVIRT_PROXY_MIN_IDENTITY_SWEEP_SIZE;
+    g_queue_init(&self->priv->identity_lru);
 }
 
+/**
+ * ovirt_proxy_new:
+ * @hostname: host name of the oVirt instance, optionally followed by a port
+ * and a path
+ *
+ * Creates a new #OvirtProxy to talk to the oVirt instance at @hostname.
+ *
+ * Several threads can make synchronous calls through the same proxy, such as
+ * ovirt_proxy_fetch_api(), ovirt_collection_fetch(), ovirt_resource_refresh()
+ * or ovirt_resource_action(), and share its login session, headers, caches
+ * and connections. This needs libsoup 3.2 or newer. Asynchronous calls must
+ * all be made from the thread which owns the thread-default main context of
+ * the proxy, as identical requests in flight are shared from there.
+ *
+ * Collections and resources are not locked against concurrent readers: each
+ * thread should fetch its own #OvirtCollection, for example through
+ * ovirt_api_search_vms(), and the collections of the #OvirtApi should be
+ * looked up before the #OvirtApi is shared. Updates of resources shared
+ * between collections are done one at a time, but each remote object is
+ * represented by a single #OvirtResource however many collections it
+ * belongs to, so a collection fetched by one thread can update the
+ * resources another thread is reading. Threads whose collections can
+ * overlap must serialize reading these resources with fetching and
+ * refreshing collections and resources, or use separate proxies.
+ *
+ * Returns: (transfer full): a new #OvirtProxy
+ */
 /* FIXME : "uri" should just be a base domain, foo.example.com/some/path
  * govirt will then prepend https://
  * /api/ is part of what librest call 'function'
@@ -1009,11 +2776,51 @@ OvirtProxy *ovirt_proxy_new(const char *hostname)
 }
 
 
-static void vm_collection_changed(GObject *gobject,
-                                  GParamSpec *pspec,
+static void proxy_weak_ref_free(GWeakRef *weak_ref)
+{
+    g_weak_ref_clear(weak_ref);
+    g_free(weak_ref);
+}
+
+
+static void vm_materialized(OvirtResource *resource, gpointer user_data)
+{
+    OvirtProxy *proxy;
+
+    proxy = g_weak_ref_get((GWeakRef *)user_data);
+    if (proxy == NULL) {
+        return;
+    }
+    ovirt_proxy_set_vm_display_ca(proxy, OVIRT_VM(resource));
+    g_object_unref(proxy);
+}
+
+
+static void vm_collection_added(G_GNUC_UNUSED OvirtCollection *collection,
+                                OvirtResource *resource,
+                                gpointer user_data)
+{
+    if (!ovirt_resource_is_materialized(resource)) {
+        /* Parsing the display now would defeat lazy collections */
+        GWeakRef *weak_ref = g_new0(GWeakRef, 1);
+        g_weak_ref_init(weak_ref, user_data);
+        ovirt_resource_add_materialize_hook(resource, vm_materialized, weak_ref,
+                                            (GDestroyNotify)proxy_weak_ref_free);
+        return;
+    }
+    ovirt_proxy_set_vm_display_ca(OVIRT_PROXY(user_data), OVIRT_VM(resource));
+}
+
+
+static void vm_collection_changed(G_GNUC_UNUSED OvirtCollection *collection,
+                                  OvirtResource *resource,
                                   gpointer user_data)
 {
-    ovirt_proxy_update_vm_display_ca(OVIRT_PROXY(user_data));
+    /* Lazy VMs already have a materialize hook from vm_collection_added() */
+    if (!ovirt_resource_is_materialized(resource)) {
+        return;
+    }
+    ovirt_proxy_set_vm_display_ca(OVIRT_PROXY(user_data), OVIRT_VM(resource));
 }
 
 
@@ -1031,6 +2838,7 @@ void ovirt_proxy_add_header(OvirtProxy *proxy, const char *header, const char *v
 {
     g_return_if_fail(OVIRT_IS_PROXY(proxy));
 
+    g_rec_mutex_lock(&proxy->priv->lock);
     if (value != NULL) {
         g_hash_table_replace(proxy->priv->additional_headers,
                              g_strdup(header),
@@ -1038,6 +2846,7 @@ void ovirt_proxy_add_header(OvirtProxy *proxy, const char *header, const char *v
     } else {
         g_hash_table_remove(proxy->priv->additional_headers, header);
     }
+    g_rec_mutex_unlock(&proxy->priv->lock);
 }
 
 
@@ -1097,10 +2906,12 @@ void ovirt_proxy_append_additional_headers(OvirtProxy *proxy,
     g_return_if_fail(OVIRT_IS_PROXY(proxy));
     g_return_if_fail(REST_IS_PROXY_CALL(call));
 
+    g_rec_mutex_lock(&proxy->priv->lock);
     g_hash_table_iter_init(&iter, proxy->priv->additional_headers);
     while (g_hash_table_iter_next (&iter, &key, &value)) {
         rest_proxy_call_add_header(call, key, value);
     }
+    g_rec_mutex_unlock(&proxy->priv->lock);
 }
 
 
@@ -1115,11 +2926,89 @@ static void ovirt_proxy_set_api_from_xml(OvirtProxy *proxy,
 
     vms = ovirt_api_get_vms(proxy->priv->api);
     g_return_if_fail(vms != NULL);
-    g_signal_connect(G_OBJECT(vms), "notify::resources",
+    /* Only VMs which were added or whose description changed since the
+     * previous fetch need to be updated */
+    g_signal_connect(G_OBJECT(vms), "resource-added",
+                     (GCallback)vm_collection_added, proxy);
+    g_signal_connect(G_OBJECT(vms), "resource-changed",
                      (GCallback)vm_collection_changed, proxy);
 }
 
 
+/* Once created, @api is only updated, as callers, possibly in other
+ * threads, may still use the #OvirtApi they got before */
+static gboolean ovirt_proxy_update_api_from_xml(OvirtProxy *proxy,
+                                                RestXmlNode *node,
+                                                GError **error)
+{
+    gboolean changed;
+
+    if (proxy->priv->api == NULL) {
+        ovirt_proxy_set_api_from_xml(proxy, node, error);
+        return (proxy->priv->api != NULL);
+    }
+
+    return ovirt_resource_refresh_from_xml(OVIRT_RESOURCE(proxy->priv->api),
+                                           node, &changed, error);
+}
+
+
+static gboolean revalidate_api_cb(OvirtProxy *proxy,
+                                  RestXmlNode *root_node,
+                                  G_GNUC_UNUSED gpointer user_data,
+                                  GError **error)
+{
+    gboolean updated;
+
+    g_mutex_lock(&proxy->priv->api_lock);
+    updated = ovirt_proxy_update_api_from_xml(proxy, root_node, error);
+    g_mutex_unlock(&proxy->priv->api_lock);
+
+    return updated;
+}
+
+
+static void revalidate_api_done(GObject *source_object,
+                                GAsyncResult *result,
+                                G_GNUC_UNUSED gpointer user_data)
+{
+    OvirtProxy *proxy = OVIRT_PROXY(source_object);
+    GError *error = NULL;
+
+    if (!ovirt_rest_call_finish(result, &error)) {
+        ovirt_proxy_revalidation_failed(proxy, G_OBJECT(proxy->priv->api), error);
+        g_clear_error(&error);
+    }
+}
+
+
+/* Sets the API entry point from the on-disk cache. This is only done when
+ * the API entry point was not fetched yet. The caller must then
+ * revalidate it. */
+static gboolean ovirt_proxy_set_api_from_cache(OvirtProxy *proxy)
+{
+    RestXmlNode *api_node;
+
+    if (proxy->priv->api != NULL) {
+        return FALSE;
+    }
+    if (!ovirt_proxy_get_cached_collection_xml(proxy, "/ovirt-engine/api", "api",
+                                               &api_node,
+                                               &proxy->priv->api_validators)) {
+        return FALSE;
+    }
+
+    ovirt_proxy_set_api_from_xml(proxy, api_node, NULL);
+    rest_xml_node_unref(api_node);
+    if (proxy->priv->api == NULL) {
+        g_clear_pointer(&proxy->priv->api_validators, ovirt_cache_validators_free);
+        return FALSE;
+    }
+
+    return TRUE;
+}
+
+
 /**
  * ovirt_proxy_fetch_api:
  * @proxy: a #OvirtProxy
@@ -1130,19 +3019,34 @@ static void ovirt_proxy_set_api_from_xml(OvirtProxy *proxy,
 OvirtApi *ovirt_proxy_fetch_api(OvirtProxy *proxy, GError **error)
 {
     RestXmlNode *api_node;
+    OvirtApi *api = NULL;
 
     g_return_val_if_fail(OVIRT_IS_PROXY(proxy), FALSE);
 
-    api_node = ovirt_proxy_get_collection_xml(proxy, "/ovirt-engine/api", error);
-    if (api_node == NULL) {
-        return NULL;
+    /* Threads fetching the API at the same time wait for each other, the
+     * later ones then only send a conditional request */
+    g_mutex_lock(&proxy->priv->api_lock);
+    /* The cached content is revalidated right away, by the conditional
+     * request below */
+    if (!ovirt_proxy_set_api_from_cache(proxy) && (proxy->priv->api == NULL)) {
+        g_clear_pointer(&proxy->priv->api_validators, ovirt_cache_validators_free);
     }
 
-    ovirt_proxy_set_api_from_xml(proxy, api_node, error);
+    if (!ovirt_proxy_get_collection_xml_if_modified(proxy, "/ovirt-engine/api", "api",
+                                                    &proxy->priv->api_validators,
+                                                    &api_node, error)) {
+        goto end;
+    }
+    if (api_node != NULL) {
+        ovirt_proxy_update_api_from_xml(proxy, api_node, error);
+        rest_xml_node_unref(api_node);
+    }
+    api = proxy->priv->api;
 
-    rest_xml_node_unref(api_node);
+end:
+    g_mutex_unlock(&proxy->priv->api_lock);
 
-    return proxy->priv->api;
+    return api;
 }
 
 
@@ -1151,7 +3055,9 @@ static gboolean fetch_api_async_cb(OvirtProxy* proxy,
                                    gpointer user_data,
                                    GError **error)
 {
-    ovirt_proxy_set_api_from_xml(proxy, root_node, error);
+    g_mutex_lock(&proxy->priv->api_lock);
+    ovirt_proxy_update_api_from_xml(proxy, root_node, error);
+    g_mutex_unlock(&proxy->priv->api_lock);
 
     return TRUE;
 }
@@ -1169,6 +3075,7 @@ void ovirt_proxy_fetch_api_async(OvirtProxy *proxy,
                                  gpointer user_data)
 {
     GTask *task;
+    gboolean cached;
 
     g_return_if_fail(OVIRT_IS_PROXY(proxy));
     g_return_if_fail((cancellable == NULL) || G_IS_CANCELLABLE(cancellable));
@@ -1177,7 +3084,28 @@ void ovirt_proxy_fetch_api_async(OvirtProxy *proxy,
 		              cancellable,
 		              callback,
 		              user_data);
-    ovirt_proxy_get_collection_xml_async(proxy, "/ovirt-engine/api", task, cancellable,
+    /* Synchronous fetches can run at the same time in other threads */
+    g_mutex_lock(&proxy->priv->api_lock);
+    cached = ovirt_proxy_set_api_from_cache(proxy);
+    if (!cached && (proxy->priv->api == NULL)) {
+        g_clear_pointer(&proxy->priv->api_validators, ovirt_cache_validators_free);
+    }
+    g_mutex_unlock(&proxy->priv->api_lock);
+
+    if (cached) {
+        g_task_return_boolean(task, TRUE);
+        g_object_unref(task);
+        task = g_task_new(G_OBJECT(proxy), NULL, revalidate_api_done, NULL);
+        ovirt_proxy_get_collection_xml_async(proxy, "/ovirt-engine/api", "api",
+                                             &proxy->priv->api_validators,
+                                             task, NULL,
+                                             revalidate_api_cb, NULL, NULL);
+        return;
+    }
+
+    ovirt_proxy_get_collection_xml_async(proxy, "/ovirt-engine/api", "api",
+                                         &proxy->priv->api_validators,
+                                         task, cancellable,
                                          fetch_api_async_cb, NULL, NULL);
 }
 
@@ -1223,6 +3151,241 @@ ovirt_proxy_get_api(OvirtProxy *proxy)
 }
 
 
+/* Resources of ovirt_proxy_resolve_resources_async() which refer to the
+ * same remote object, they are filled in from a single request */
+typedef struct {
+    GTask *task;
+    char *href;
+    GList *resources;
+} OvirtProxyResolveGroup;
+
+typedef struct {
+    /* OvirtProxyResolveGroup, in the order they were first referred to */
+    GPtrArray *groups;
+    guint max_in_flight;
+    guint in_flight;
+    /* Index in @groups of the next group to fetch */
+    guint next;
+    guint n_failed;
+    /* Error of the first group which could not be fetched */
+    GError *error;
+} OvirtProxyResolveData;
+
+static void ovirt_proxy_resolve_group_free(OvirtProxyResolveGroup *group)
+{
+    g_free(group->href);
+    g_list_free_full(group->resources, g_object_unref);
+    g_slice_free(OvirtProxyResolveGroup, group);
+}
+
+static void ovirt_proxy_resolve_data_free(OvirtProxyResolveData *data)
+{
+    g_ptr_array_unref(data->groups);
+    g_clear_error(&data->error);
+    g_slice_free(OvirtProxyResolveData, data);
+}
+
+static void ovirt_proxy_resolve_next(GTask *task);
+
+static gboolean ovirt_proxy_resolve_parse_cb(OvirtProxy *proxy,
+                                             RestXmlNode *root_node,
+                                             gpointer user_data,
+                                             GError **error)
+{
+    OvirtProxyResolveGroup *group = user_data;
+    GList *it;
+
+    for (it = group->resources; it != NULL; it = it->next) {
+        OvirtResource *registered;
+        gboolean changed;
+        gboolean refreshed = TRUE;
+
+        if (!ovirt_resource_refresh_from_xml(OVIRT_RESOURCE(it->data),
+                                             root_node, &changed, error)) {
+            return FALSE;
+        }
+        /* The resource replaces stale stubs in the identity map, or the
+         * resource already registered there is updated as well */
+        registered = ovirt_proxy_add_identity(proxy, OVIRT_RESOURCE(it->data));
+        if (registered != it->data) {
+            refreshed = ovirt_resource_refresh_from_xml(registered, root_node,
+                                                        &changed, error);
+        }
+        g_object_unref(registered);
+        if (!refreshed) {
+            return FALSE;
+        }
+    }
+
+    return TRUE;
+}
+
+static void ovirt_proxy_resolve_group_cb(GObject *source_object,
+                                         GAsyncResult *result,
+                                         gpointer user_data)
+{
+    OvirtProxyResolveGroup *group = user_data;
+    OvirtProxyResolveData *data = g_task_get_task_data(group->task);
+    GError *error = NULL;
+
+    data->in_flight--;
+    if (!g_task_propagate_boolean(G_TASK(result), &error)) {
+        data->n_failed++;
+        if (data->error == NULL) {
+            data->error = error;
+        } else {
+            g_clear_error(&error);
+        }
+    }
+
+    ovirt_proxy_resolve_next(group->task);
+}
+
+/* Starts fetching groups until there are max_in_flight fetches in flight,
+ * and completes @task once all of them are done. Takes ownership of a
+ * reference on @task.
+ */
+static void ovirt_proxy_resolve_next(GTask *task)
+{
+    OvirtProxy *proxy = OVIRT_PROXY(g_task_get_source_object(task));
+    OvirtProxyResolveData *data = g_task_get_task_data(task);
+
+    while (data->next < data->groups->len &&
+           ((data->max_in_flight == 0) || (data->in_flight < data->max_in_flight))) {
+        OvirtProxyResolveGroup *group;
+        GTask *group_task;
+
+        group = g_ptr_array_index(data->groups, data->next);
+        group->task = g_object_ref(task);
+        data->next++;
+        data->in_flight++;
+        group_task = g_task_new(G_OBJECT(proxy), g_task_get_cancellable(task),
+                                ovirt_proxy_resolve_group_cb, group);
+        ovirt_proxy_get_collection_xml_async(proxy, group->href, NULL, NULL,
+                                             group_task,
+                                             g_task_get_cancellable(task),
+                                             ovirt_proxy_resolve_parse_cb,
+                                             group, NULL);
+    }
+
+    if ((data->in_flight == 0) && (data->next == data->groups->len)) {
+        if (g_task_return_error_if_cancelled(task)) {
+            /* Nothing to do */
+        } else if (data->error != NULL) {
+            g_task_return_new_error(task, OVIRT_ERROR, OVIRT_ERROR_FAILED,
+                                    _("Failed to resolve %u of %u resources: %s"),
+                                    data->n_failed, data->groups->len,
+                                    data->error->message);
+        } else {
+            g_task_return_boolean(task, TRUE);
+        }
+    }
+    g_object_unref(task);
+}
+
+
+/**
+ * ovirt_proxy_resolve_resources_async:
+ * @proxy: a #OvirtProxy
+ * @resources: (element-type OvirtResource): resources to fill in, such as
+ * the stubs returned by ovirt_vm_get_host() or ovirt_vm_get_cluster()
+ * @max_in_flight: maximum number of resources being fetched at the same
+ * time, or 0 for no limit
+ * @cancellable: (allow-none): a #GCancellable
+ * @callback: (scope async): completion callback
+ * @user_data: (closure): opaque data for callback
+ *
+ * Refreshes all the resources in @resources. Resources with the same id
+ * only cause one request to be sent, whose response is then used to fill
+ * in each of them, so that resolving the hosts of hundreds of VMs only
+ * costs as many requests as there are distinct hosts. Resources which do
+ * not have an href are ignored.
+ *
+ * The resources are registered with @proxy, see
+ * ovirt_proxy_get_resource(). When another resource with the same type
+ * and id is already registered, it is filled in too.
+ *
+ * Since: 0.3.12
+ */
+void ovirt_proxy_resolve_resources_async(OvirtProxy *proxy,
+                                         GList *resources,
+                                         guint max_in_flight,
+                                         GCancellable *cancellable,
+                                         GAsyncReadyCallback callback,
+                                         gpointer user_data)
+{
+    OvirtProxyResolveData *data;
+    GHashTable *groups;
+    GTask *task;
+    GList *it;
+
+    g_return_if_fail(OVIRT_IS_PROXY(proxy));
+    g_return_if_fail((cancellable == NULL) || G_IS_CANCELLABLE(cancellable));
+
+    task = g_task_new(G_OBJECT(proxy), cancellable, callback, user_data);
+    data = g_slice_new0(OvirtProxyResolveData);
+    data->groups = g_ptr_array_new_with_free_func((GDestroyNotify)ovirt_proxy_resolve_group_free);
+    data->max_in_flight = max_in_flight;
+    g_task_set_task_data(task, data,
+                         (GDestroyNotify)ovirt_proxy_resolve_data_free);
+
+    /* guid or href -> OvirtProxyResolveGroup */
+    groups = g_hash_table_new_full(g_str_hash, g_str_equal, g_free, NULL);
+    for (it = resources; it != NULL; it = it->next) {
+        OvirtProxyResolveGroup *group;
+        char *guid;
+        char *href;
+
+        g_object_get(G_OBJECT(it->data), "guid", &guid, "href", &href, NULL);
+        if (href == NULL) {
+            g_free(guid);
+            continue;
+        }
+        if (guid == NULL) {
+            guid = g_strdup(href);
+        }
+        group = g_hash_table_lookup(groups, guid);
+        if (group == NULL) {
+            group = g_slice_new0(OvirtProxyResolveGroup);
+            group->href = href;
+            g_ptr_array_add(data->groups, group);
+            g_hash_table_insert(groups, guid, group);
+        } else {
+            g_free(guid);
+            g_free(href);
+        }
+        group->resources = g_list_prepend(group->resources,
+                                          g_object_ref(it->data));
+    }
+    g_hash_table_unref(groups);
+
+    ovirt_proxy_resolve_next(task);
+}
+
+
+/**
+ * ovirt_proxy_resolve_resources_finish:
+ * @proxy: a #OvirtProxy
+ * @result: async method result
+ * @err: #GError to set on error, or NULL
+ *
+ * Return value: TRUE if all the resources could be refreshed, FALSE
+ * otherwise. Resources which could be refreshed are filled in even when
+ * some others failed.
+ *
+ * Since: 0.3.12
+ */
+gboolean ovirt_proxy_resolve_resources_finish(OvirtProxy *proxy,
+                                              GAsyncResult *result,
+                                              GError **err)
+{
+    g_return_val_if_fail(OVIRT_IS_PROXY(proxy), FALSE);
+    g_return_val_if_fail(g_task_is_valid(G_TASK(result), proxy), FALSE);
+
+    return g_task_propagate_boolean(G_TASK(result), err);
+}
+
+
 GList *ovirt_proxy_get_vms_internal(OvirtProxy *proxy)
 {
     OvirtApi *api;
@@ -46,6 +46,19 @@ G_BEGIN_DECLS
 #define OVIRT_PROXY_GET_CLASS(obj) \
     (G_TYPE_INSTANCE_GET_CLASS ((obj), OVIRT_TYPE_PROXY, OvirtProxyClass))
 
+/**
+ * OvirtWireFormat:
+ * @OVIRT_WIRE_FORMAT_XML: responses are XML documents
+ * @OVIRT_WIRE_FORMAT_JSON: responses are JSON documents, which are smaller
+ * and cheaper to parse
+ *
+ * Since: 0.3.12
+ */
+typedef enum {
+    OVIRT_WIRE_FORMAT_XML,
+    OVIRT_WIRE_FORMAT_JSON,
+} OvirtWireFormat;
+
 typedef struct _OvirtProxyClass OvirtProxyClass;
 typedef struct _OvirtProxyPrivate OvirtProxyPrivate;
 
@@ -101,5 +114,21 @@ OvirtApi *ovirt_proxy_fetch_api_finish(OvirtProxy *proxy,
                                        GAsyncResult *result,
                                        GError **err);
 OvirtApi *ovirt_proxy_get_api(OvirtProxy *proxy);
+void ovirt_proxy_set_response_ttl(OvirtProxy *proxy,
+                                  const char *href_prefix,
+                                  guint ttl);
+void ovirt_proxy_resolve_resources_async(OvirtProxy *proxy,
+                                         GList *resources,
+                                         guint max_in_flight,
+                                         GCancellable *cancellable,
+                                         GAsyncReadyCallback callback,
+                                         gpointer user_data);
+gboolean ovirt_proxy_resolve_resources_finish(OvirtProxy *proxy,
+                                              GAsyncResult *result,
+                                              GError **err);
+OvirtResource *ovirt_proxy_get_resource(OvirtProxy *proxy,
+                                        GType type,
+                                        const char *guid);
+void ovirt_proxy_set_identity_cache_size(OvirtProxy *proxy, guint size);
 
 #endif
@@ -30,6 +30,35 @@ G_BEGIN_DECLS
 OvirtResource *ovirt_resource_new(GType type);
 OvirtResource *ovirt_resource_new_from_id(GType type, const char *id, const char *href);
 OvirtResource *ovirt_resource_new_from_xml(GType type, RestXmlNode *node, GError **error);
+OvirtResource *ovirt_resource_new_lazy_from_xml(GType type, RestXmlNode *node, GError **error);
+gboolean ovirt_resource_refresh_from_xml(OvirtResource *resource,
+                                         RestXmlNode *node,
+                                         gboolean *changed,
+                                         GError **error);
+
+typedef void (*OvirtResourceMaterializeFunc)(OvirtResource *resource, gpointer user_data);
+void ovirt_resource_materialize(OvirtResource *resource);
+void ovirt_resource_set_xml_retention(OvirtResource *resource,
+                                      OvirtXmlRetention retention);
+void ovirt_resource_hold_xml_retention(OvirtResource *resource,
+                                       OvirtXmlRetention retention);
+void ovirt_resource_release_xml_retention(OvirtResource *resource,
+                                          OvirtXmlRetention retention);
+gsize ovirt_resource_get_retained_xml_size(OvirtResource *resource);
+gboolean ovirt_resource_is_materialized(OvirtResource *resource);
+void ovirt_resource_add_materialize_hook(OvirtResource *resource,
+                                         OvirtResourceMaterializeFunc func,
+                                         gpointer user_data,
+                                         GDestroyNotify destroy);
+
+void ovirt_resource_set_proxy(OvirtResource *resource, OvirtProxy *proxy);
+OvirtProxy *ovirt_resource_get_proxy(OvirtResource *resource);
+OvirtResource *ovirt_resource_get_related(OvirtResource *resource,
+                                          GType type,
+                                          const char *id,
+                                          const char *href);
+OvirtResource *ovirt_resource_share_related(OvirtResource *resource,
+                                            OvirtResource **related);
 
 const char *ovirt_resource_get_action(OvirtResource *resource,
                                       const char *action);
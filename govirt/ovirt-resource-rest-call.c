@@ -124,6 +124,7 @@ static gboolean ovirt_resource_rest_call_class_serialize_params(RestProxyCall *c
     g_return_val_if_fail(content_len != NULL, FALSE);
 
     self = OVIRT_RESOURCE_REST_CALL(call);
+    ovirt_rest_call_discard_cached_responses(call);
 
     *content_type = g_strdup("application/xml");
     if (g_strcmp0(rest_proxy_call_get_method(call), "PUT") == 0) {
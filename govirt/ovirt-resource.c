@@ -30,6 +30,7 @@
 
 #define GOVIRT_UNSTABLE_API_ABI
 #include "govirt-private.h"
+#include "ovirt-enum-types.h"
 #include "ovirt-error.h"
 #include "ovirt-proxy-private.h"
 #include "ovirt-resource.h"
@@ -45,8 +46,52 @@ struct _OvirtResourcePrivate {
     GHashTable *sub_collections;
 
     RestXmlNode *xml;
+    /* Serialized form of the XML description, used instead of @xml with
+     * OVIRT_XML_RETENTION_COMPACT */
+    char *xml_compact;
+    OvirtXmlRetention xml_retention;
+    /* Number of collections holding each OvirtXmlRetention policy on the
+     * resource, which keeps the most any of them asks for */
+    guint xml_retention_holds[OVIRT_XML_RETENTION_COMPACT + 1];
+    /* Hash of the XML description this resource was last initialized
+     * from, 0 if unknown */
+    guint64 xml_hash;
+
+    /* Set when only guid, href and name were read from @xml, see
+     * ovirt_resource_new_lazy_from_xml(). It is only cleared once all
+     * the properties are set, so that ovirt_resource_materialize() can
+     * check it without taking the lock. */
+    gboolean lazy;
+    /* Set while the properties of a lazy resource are being read */
+    gboolean materializing;
+    /* OvirtResourceMaterializeHook to run once @lazy is cleared */
+    GSList *materialize_hooks;
+
+    /* Validators of the response to the last ovirt_resource_refresh() */
+    OvirtCacheValidators *validators;
+    /* Related objects to inline when refreshing the resource */
+    char *follow;
+    OvirtContentLevel content_level;
+
+    /* Proxy whose identity map the resource is registered in, see
+     * ovirt_proxy_add_identity() */
+    GWeakRef proxy;
 };
 
+typedef struct {
+    OvirtResourceMaterializeFunc func;
+    gpointer user_data;
+    GDestroyNotify destroy;
+} OvirtResourceMaterializeHook;
+
+static void ovirt_resource_materialize_hook_free(OvirtResourceMaterializeHook *hook)
+{
+    if (hook->destroy != NULL) {
+        hook->destroy(hook->user_data);
+    }
+    g_slice_free(OvirtResourceMaterializeHook, hook);
+}
+
 static void ovirt_resource_initable_iface_init(GInitableIface *iface);
 static gboolean ovirt_resource_init_from_xml_real(OvirtResource *resource,
                                                   RestXmlNode *node,
@@ -60,6 +105,11 @@ G_DEFINE_TYPE_WITH_CODE(OvirtResource, ovirt_resource, G_TYPE_OBJECT,
                                               ovirt_resource_initable_iface_init);
                         G_ADD_PRIVATE(OvirtResource));
 
+/* Resources are shared between the collections fetched through a proxy,
+ * possibly from several threads, so their content is only changed with
+ * this lock held */
+static GRecMutex ovirt_resource_update_lock;
+
 
 enum {
     PROP_0,
@@ -68,6 +118,8 @@ enum {
     PROP_HREF,
     PROP_NAME,
     PROP_XML_NODE,
+    PROP_FOLLOW,
+    PROP_CONTENT_LEVEL,
 };
 
 static void ovirt_resource_get_property(GObject *object,
@@ -88,8 +140,15 @@ static void ovirt_resource_get_property(GObject *object,
         g_value_set_string(value, resource->priv->name);
         break;
     case PROP_DESCRIPTION:
+        ovirt_resource_materialize(resource);
         g_value_set_string(value, resource->priv->description);
         break;
+    case PROP_FOLLOW:
+        g_value_set_string(value, resource->priv->follow);
+        break;
+    case PROP_CONTENT_LEVEL:
+        g_value_set_enum(value, resource->priv->content_level);
+        break;
     default:
         G_OBJECT_WARN_INVALID_PROPERTY_ID(object, prop_id, pspec);
     }
@@ -99,6 +158,7 @@ static void ovirt_resource_set_xml_node(OvirtResource *resource,
                                         RestXmlNode *node)
 {
     g_clear_pointer(&resource->priv->xml, &rest_xml_node_unref);
+    g_clear_pointer(&resource->priv->xml_compact, g_free);
     if (node != NULL) {
         resource->priv->xml = rest_xml_node_ref(node);
     }
@@ -111,6 +171,19 @@ static void ovirt_resource_set_property(GObject *object,
 {
     OvirtResource *resource = OVIRT_RESOURCE(object);
 
+    switch (prop_id) {
+    case PROP_GUID:
+    case PROP_HREF:
+    case PROP_NAME:
+    case PROP_DESCRIPTION:
+        /* Otherwise the value would be overwritten by the one from the
+         * XML description when the resource gets materialized */
+        ovirt_resource_materialize(resource);
+        break;
+    default:
+        break;
+    }
+
     switch (prop_id) {
     case PROP_GUID:
         g_free(resource->priv->guid);
@@ -132,17 +205,46 @@ static void ovirt_resource_set_property(GObject *object,
         ovirt_resource_set_xml_node(OVIRT_RESOURCE(object),
                                     g_value_get_boxed(value));
         break;
+    case PROP_FOLLOW:
+        g_free(resource->priv->follow);
+        resource->priv->follow = g_value_dup_string(value);
+        break;
+    case PROP_CONTENT_LEVEL:
+        resource->priv->content_level = g_value_get_enum(value);
+        break;
     default:
         G_OBJECT_WARN_INVALID_PROPERTY_ID(object, prop_id, pspec);
     }
 }
 
+static void ovirt_resource_dispatch_properties_changed(GObject *object,
+                                                       guint n_pspecs,
+                                                       GParamSpec **pspecs)
+{
+    OvirtResource *resource = OVIRT_RESOURCE(object);
+
+    /* Materializing a lazy resource only reads values which were
+     * already available from the caller's point of view, and it
+     * usually happens from a property getter, so don't emit
+     * ::notify for it */
+    if (resource->priv->materializing && resource->priv->lazy) {
+        return;
+    }
+
+    G_OBJECT_CLASS(ovirt_resource_parent_class)->dispatch_properties_changed(object,
+                                                                             n_pspecs,
+                                                                             pspecs);
+}
+
 static void ovirt_resource_dispose(GObject *object)
 {
     OvirtResource *resource = OVIRT_RESOURCE(object);
 
     g_clear_pointer(&resource->priv->actions, g_hash_table_unref);
     g_clear_pointer(&resource->priv->sub_collections, g_hash_table_unref);
+    g_slist_free_full(resource->priv->materialize_hooks,
+                      (GDestroyNotify)ovirt_resource_materialize_hook_free);
+    resource->priv->materialize_hooks = NULL;
 
     if (resource->priv->xml != NULL) {
         g_boxed_free(REST_TYPE_XML_NODE, resource->priv->xml);
@@ -160,6 +262,10 @@ static void ovirt_resource_finalize(GObject *object)
     g_free(resource->priv->guid);
     g_free(resource->priv->href);
     g_free(resource->priv->name);
+    g_free(resource->priv->xml_compact);
+    g_free(resource->priv->follow);
+    ovirt_cache_validators_free(resource->priv->validators);
+    g_weak_ref_clear(&resource->priv->proxy);
 
     G_OBJECT_CLASS(ovirt_resource_parent_class)->finalize(object);
 }
@@ -202,6 +308,7 @@ static void ovirt_resource_class_init(OvirtResourceClass *klass)
     object_class->finalize = ovirt_resource_finalize;
     object_class->get_property = ovirt_resource_get_property;
     object_class->set_property = ovirt_resource_set_property;
+    object_class->dispatch_properties_changed = ovirt_resource_dispatch_properties_changed;
 
     g_object_class_install_property(object_class,
                                     PROP_DESCRIPTION,
@@ -244,11 +351,48 @@ static void ovirt_resource_class_init(OvirtResourceClass *klass)
                                                        G_PARAM_WRITABLE |
                                                        G_PARAM_CONSTRUCT_ONLY |
                                                        G_PARAM_STATIC_STRINGS));
+
+    /**
+     * OvirtResource:follow:
+     *
+     * Comma-separated list of the related objects the server should inline
+     * when the resource is refreshed, for example "host,cluster".
+     *
+     * Since: 0.3.12
+     */
+    g_object_class_install_property(object_class,
+                                    PROP_FOLLOW,
+                                    g_param_spec_string("follow",
+                                                        "Follow",
+                                                        "Related objects to inline when refreshing",
+                                                        NULL,
+                                                        G_PARAM_READWRITE |
+                                                        G_PARAM_STATIC_STRINGS));
+
+    /**
+     * OvirtResource:content-level:
+     *
+     * How much of the resource is requested when it is refreshed, and in
+     * the responses to the actions run on it.
+     *
+     * Since: 0.3.12
+     */
+    g_object_class_install_property(object_class,
+                                    PROP_CONTENT_LEVEL,
+                                    g_param_spec_enum("content-level",
+                                                      "Content level",
+                                                      "How much of the resource is requested",
+                                                      OVIRT_TYPE_CONTENT_LEVEL,
+                                                      OVIRT_CONTENT_LEVEL_FULL,
+                                                      G_PARAM_READWRITE |
+                                                      G_PARAM_STATIC_STRINGS));
 }
 
 static void ovirt_resource_init(OvirtResource *resource)
 {
     resource->priv = ovirt_resource_get_instance_private(resource);
+    resource->priv->content_level = OVIRT_CONTENT_LEVEL_FULL;
+    g_weak_ref_init(&resource->priv->proxy, NULL);
     resource->priv->actions = g_hash_table_new_full(g_str_hash, g_str_equal,
                                                     g_free, g_free);
     resource->priv->sub_collections = g_hash_table_new_full(g_str_hash,
@@ -277,6 +421,8 @@ ovirt_resource_get_action(OvirtResource *resource, const char *action)
     g_return_val_if_fail(OVIRT_IS_RESOURCE(resource), NULL);
     g_return_val_if_fail(resource->priv->actions != NULL, NULL);
 
+    ovirt_resource_materialize(resource);
+
     return g_hash_table_lookup(resource->priv->actions, action);
 }
 
@@ -301,6 +447,8 @@ ovirt_resource_get_sub_collection(OvirtResource *resource,
     g_return_val_if_fail(OVIRT_IS_RESOURCE(resource), NULL);
     g_return_val_if_fail(resource->priv->sub_collections != NULL, NULL);
 
+    ovirt_resource_materialize(resource);
+
     return g_hash_table_lookup(resource->priv->sub_collections,
                                sub_collection);
 }
@@ -446,9 +594,9 @@ static gboolean ovirt_resource_init_from_xml_real(OvirtResource *resource,
     return TRUE;
 }
 
-static gboolean ovirt_resource_init_from_xml(OvirtResource *resource,
-                                             RestXmlNode *node,
-                                             GError **error)
+static gboolean ovirt_resource_init_from_xml_unlocked(OvirtResource *resource,
+                                                      RestXmlNode *node,
+                                                      GError **error)
 {
     OvirtResourceClass *klass;
 
@@ -457,7 +605,543 @@ static gboolean ovirt_resource_init_from_xml(OvirtResource *resource,
     klass = OVIRT_RESOURCE_GET_CLASS(resource);
     g_return_val_if_fail(klass->init_from_xml != NULL, FALSE);
 
-    return klass->init_from_xml(resource, node, error);
+    /* Getters called while @resource is initialized must not try to
+     * materialize it again */
+    resource->priv->materializing = TRUE;
+    g_clear_pointer(&resource->priv->validators, ovirt_cache_validators_free);
+    if (!klass->init_from_xml(resource, node, error)) {
+        resource->priv->materializing = FALSE;
+        g_atomic_int_set(&resource->priv->lazy, FALSE);
+        return FALSE;
+    }
+    resource->priv->xml_hash = ovirt_rest_xml_node_hash(node);
+
+    while (resource->priv->materialize_hooks != NULL) {
+        OvirtResourceMaterializeHook *hook;
+
+        hook = resource->priv->materialize_hooks->data;
+        resource->priv->materialize_hooks =
+            g_slist_delete_link(resource->priv->materialize_hooks,
+                                resource->priv->materialize_hooks);
+        hook->func(resource, hook->user_data);
+        ovirt_resource_materialize_hook_free(hook);
+    }
+    resource->priv->materializing = FALSE;
+    /* Other threads can now read the properties without locking */
+    g_atomic_int_set(&resource->priv->lazy, FALSE);
+
+    return TRUE;
+}
+
+static gboolean ovirt_resource_init_from_xml(OvirtResource *resource,
+                                             RestXmlNode *node,
+                                             GError **error)
+{
+    gboolean initialized;
+
+    g_rec_mutex_lock(&ovirt_resource_update_lock);
+    initialized = ovirt_resource_init_from_xml_unlocked(resource, node, error);
+    g_rec_mutex_unlock(&ovirt_resource_update_lock);
+
+    return initialized;
+}
+
+
+/* Releases the XML tree @resource was parsed from according to its
+ * OvirtXmlRetention policy. Resources which are not materialized yet
+ * always need the XML description, so it is at most compacted. */
+static void ovirt_resource_apply_xml_retention(OvirtResource *resource)
+{
+    switch (resource->priv->xml_retention) {
+    case OVIRT_XML_RETENTION_KEEP:
+        break;
+    case OVIRT_XML_RETENTION_DROP:
+        if (!resource->priv->lazy) {
+            g_clear_pointer(&resource->priv->xml, &rest_xml_node_unref);
+            g_clear_pointer(&resource->priv->xml_compact, g_free);
+        }
+        break;
+    case OVIRT_XML_RETENTION_COMPACT:
+        if (resource->priv->xml == NULL) {
+            break;
+        }
+        g_free(resource->priv->xml_compact);
+        resource->priv->xml_compact = ovirt_rest_xml_node_to_string(resource->priv->xml);
+        g_clear_pointer(&resource->priv->xml, &rest_xml_node_unref);
+        break;
+    default:
+        g_warn_if_reached();
+    }
+}
+
+
+G_GNUC_INTERNAL void
+ovirt_resource_set_xml_retention(OvirtResource *resource,
+                                 OvirtXmlRetention retention)
+{
+    g_return_if_fail(OVIRT_IS_RESOURCE(resource));
+
+    resource->priv->xml_retention = retention;
+    ovirt_resource_apply_xml_retention(resource);
+}
+
+
+/* Applies the policy which keeps the most among the ones held on
+ * @resource. Its policy is left alone once nothing holds any. */
+static void ovirt_resource_update_xml_retention(OvirtResource *resource)
+{
+    static const OvirtXmlRetention by_priority[] = {
+        OVIRT_XML_RETENTION_KEEP,
+        OVIRT_XML_RETENTION_COMPACT,
+        OVIRT_XML_RETENTION_DROP,
+    };
+    guint i;
+
+    for (i = 0; i < G_N_ELEMENTS(by_priority); i++) {
+        if (resource->priv->xml_retention_holds[by_priority[i]] == 0) {
+            continue;
+        }
+        if (resource->priv->xml_retention != by_priority[i]) {
+            ovirt_resource_set_xml_retention(resource, by_priority[i]);
+        }
+        return;
+    }
+}
+
+
+/* Collections hold their OvirtXmlRetention policy on each of their
+ * resources. Resources can be shared by several collections, and must not
+ * release XML one of them asked to keep. */
+G_GNUC_INTERNAL void
+ovirt_resource_hold_xml_retention(OvirtResource *resource,
+                                  OvirtXmlRetention retention)
+{
+    g_return_if_fail(OVIRT_IS_RESOURCE(resource));
+    g_return_if_fail(retention <= OVIRT_XML_RETENTION_COMPACT);
+
+    g_rec_mutex_lock(&ovirt_resource_update_lock);
+    resource->priv->xml_retention_holds[retention]++;
+    ovirt_resource_update_xml_retention(resource);
+    g_rec_mutex_unlock(&ovirt_resource_update_lock);
+}
+
+
+G_GNUC_INTERNAL void
+ovirt_resource_release_xml_retention(OvirtResource *resource,
+                                     OvirtXmlRetention retention)
+{
+    g_return_if_fail(OVIRT_IS_RESOURCE(resource));
+    g_return_if_fail(retention <= OVIRT_XML_RETENTION_COMPACT);
+
+    g_rec_mutex_lock(&ovirt_resource_update_lock);
+    g_warn_if_fail(resource->priv->xml_retention_holds[retention] > 0);
+    if (resource->priv->xml_retention_holds[retention] > 0) {
+        resource->priv->xml_retention_holds[retention]--;
+    }
+    ovirt_resource_update_xml_retention(resource);
+    g_rec_mutex_unlock(&ovirt_resource_update_lock);
+}
+
+
+/* Returns an estimate of the memory used by the XML description retained
+ * by @resource */
+G_GNUC_INTERNAL gsize
+ovirt_resource_get_retained_xml_size(OvirtResource *resource)
+{
+    gsize size = 0;
+
+    g_return_val_if_fail(OVIRT_IS_RESOURCE(resource), 0);
+
+    if (resource->priv->xml != NULL) {
+        size += ovirt_rest_xml_node_get_size(resource->priv->xml);
+    }
+    if (resource->priv->xml_compact != NULL) {
+        size += strlen(resource->priv->xml_compact) + 1;
+    }
+
+    return size;
+}
+
+
+/* Reads the cheap properties of @resource (guid, href and name) from
+ * @node, and keeps @node around so that the others can be read from it by
+ * ovirt_resource_materialize() when they are first needed. */
+static gboolean ovirt_resource_init_lazy_from_xml_unlocked(OvirtResource *resource,
+                                                           RestXmlNode *node,
+                                                           GError **error)
+{
+    const char *guid;
+    const char *href;
+    RestXmlNode *name_node;
+
+    guid = rest_xml_node_get_attr(node, "id");
+    href = rest_xml_node_get_attr(node, "href");
+    name_node = rest_xml_node_find(node, "name");
+    if ((guid == NULL) || (href == NULL) ||
+        (name_node == NULL) || (name_node->content == NULL)) {
+        /* Let the full parser report errors, or build a fallback name */
+        if (!ovirt_resource_init_from_xml(resource, node, error)) {
+            return FALSE;
+        }
+        ovirt_resource_apply_xml_retention(resource);
+        return TRUE;
+    }
+
+    g_free(resource->priv->guid);
+    resource->priv->guid = g_strdup(guid);
+    g_free(resource->priv->href);
+    resource->priv->href = g_strdup(href);
+    if (g_strcmp0(resource->priv->name, name_node->content) != 0) {
+        g_free(resource->priv->name);
+        resource->priv->name = g_strdup(name_node->content);
+        g_object_notify(G_OBJECT(resource), "name");
+    }
+    ovirt_resource_set_xml_node(resource, node);
+    resource->priv->xml_hash = ovirt_rest_xml_node_hash(node);
+    g_atomic_int_set(&resource->priv->lazy, TRUE);
+    g_clear_pointer(&resource->priv->validators, ovirt_cache_validators_free);
+    ovirt_resource_apply_xml_retention(resource);
+
+    return TRUE;
+}
+
+static gboolean ovirt_resource_init_lazy_from_xml(OvirtResource *resource,
+                                                  RestXmlNode *node,
+                                                  GError **error)
+{
+    gboolean initialized;
+
+    g_rec_mutex_lock(&ovirt_resource_update_lock);
+    initialized = ovirt_resource_init_lazy_from_xml_unlocked(resource, node, error);
+    g_rec_mutex_unlock(&ovirt_resource_update_lock);
+
+    return initialized;
+}
+
+
+G_GNUC_INTERNAL OvirtResource *
+ovirt_resource_new_lazy_from_xml(GType type, RestXmlNode *node, GError **error)
+{
+    OvirtResource *resource;
+
+    g_return_val_if_fail(g_type_is_a(type, OVIRT_TYPE_RESOURCE), NULL);
+    g_return_val_if_fail(node != NULL, NULL);
+
+    resource = ovirt_resource_new(type);
+    if (!ovirt_resource_init_lazy_from_xml(resource, node, error)) {
+        g_object_unref(resource);
+        return NULL;
+    }
+
+    return resource;
+}
+
+
+static void ovirt_resource_materialize_unlocked(OvirtResource *resource)
+{
+    RestXmlNode *node;
+    char *compact;
+    GError *error = NULL;
+
+    if (!resource->priv->lazy || resource->priv->materializing) {
+        /* Materialized by another thread in the meantime, or being
+         * materialized by this one */
+        return;
+    }
+
+    compact = g_steal_pointer(&resource->priv->xml_compact);
+    if (compact != NULL) {
+        node = ovirt_rest_xml_node_from_data(compact, -1);
+    } else {
+        node = rest_xml_node_ref(resource->priv->xml);
+    }
+    if (node == NULL) {
+        g_message("Failed to parse '%s' resource: invalid XML data",
+                  resource->priv->name);
+        g_atomic_int_set(&resource->priv->lazy, FALSE);
+        g_free(compact);
+        return;
+    }
+
+    if (!ovirt_resource_init_from_xml(resource, node, &error)) {
+        g_message("Failed to parse '%s' resource: %s",
+                  resource->priv->name, error->message);
+        g_clear_error(&error);
+    }
+    rest_xml_node_unref(node);
+
+    if ((compact != NULL) &&
+        (resource->priv->xml_retention == OVIRT_XML_RETENTION_COMPACT)) {
+        /* No need to serialize the same XML again */
+        g_clear_pointer(&resource->priv->xml, &rest_xml_node_unref);
+        g_free(resource->priv->xml_compact);
+        resource->priv->xml_compact = compact;
+    } else {
+        g_free(compact);
+        ovirt_resource_apply_xml_retention(resource);
+    }
+}
+
+
+/* Reads all the properties of a resource created with
+ * ovirt_resource_new_lazy_from_xml(), this is a no-op for other
+ * resources. Subclasses must call this before reading or writing their
+ * own properties. No ::notify signal is emitted for the values it reads. */
+G_GNUC_INTERNAL void ovirt_resource_materialize(OvirtResource *resource)
+{
+    g_return_if_fail(OVIRT_IS_RESOURCE(resource));
+
+    if (!g_atomic_int_get(&resource->priv->lazy)) {
+        return;
+    }
+
+    g_rec_mutex_lock(&ovirt_resource_update_lock);
+    ovirt_resource_materialize_unlocked(resource);
+    g_rec_mutex_unlock(&ovirt_resource_update_lock);
+}
+
+
+G_GNUC_INTERNAL gboolean ovirt_resource_is_materialized(OvirtResource *resource)
+{
+    g_return_val_if_fail(OVIRT_IS_RESOURCE(resource), FALSE);
+
+    return !g_atomic_int_get(&resource->priv->lazy);
+}
+
+
+/* Runs @func when @resource gets materialized, or right away if it
+ * already is */
+G_GNUC_INTERNAL void
+ovirt_resource_add_materialize_hook(OvirtResource *resource,
+                                    OvirtResourceMaterializeFunc func,
+                                    gpointer user_data,
+                                    GDestroyNotify destroy)
+{
+    OvirtResourceMaterializeHook *hook;
+
+    g_return_if_fail(OVIRT_IS_RESOURCE(resource));
+    g_return_if_fail(func != NULL);
+
+    g_rec_mutex_lock(&ovirt_resource_update_lock);
+    if (!resource->priv->lazy) {
+        g_rec_mutex_unlock(&ovirt_resource_update_lock);
+        func(resource, user_data);
+        if (destroy != NULL) {
+            destroy(user_data);
+        }
+        return;
+    }
+
+    hook = g_slice_new0(OvirtResourceMaterializeHook);
+    hook->func = func;
+    hook->user_data = user_data;
+    hook->destroy = destroy;
+    resource->priv->materialize_hooks = g_slist_append(resource->priv->materialize_hooks,
+                                                       hook);
+    g_rec_mutex_unlock(&ovirt_resource_update_lock);
+}
+
+
+static RestXmlNode *ovirt_resource_get_retained_xml(OvirtResource *resource);
+
+/* Returns TRUE when @node is the XML @resource was last initialized from.
+ * Hashes are only trusted to tell that they differ: when they are equal,
+ * the trees are compared, unless @resource did not retain its XML. */
+static gboolean ovirt_resource_xml_is_unchanged(OvirtResource *resource,
+                                                RestXmlNode *node)
+{
+    RestXmlNode *retained;
+    gboolean unchanged;
+
+    if ((resource->priv->xml_hash == 0) ||
+        (resource->priv->xml_hash != ovirt_rest_xml_node_hash(node))) {
+        return FALSE;
+    }
+
+    retained = ovirt_resource_get_retained_xml(resource);
+    if (retained == NULL) {
+        /* OVIRT_XML_RETENTION_DROP, only the hash is left */
+        return TRUE;
+    }
+    unchanged = (retained == node) || ovirt_rest_xml_node_equal(retained, node);
+    rest_xml_node_unref(retained);
+
+    return unchanged;
+}
+
+/* Updates @resource from @node, which must describe the same remote
+ * resource. When @node is identical to the XML @resource was last
+ * initialized from, @resource is left untouched and @changed is set to
+ * FALSE. */
+static gboolean ovirt_resource_refresh_from_xml_unlocked(OvirtResource *resource,
+                                                        RestXmlNode *node,
+                                                        gboolean *changed,
+                                                        GError **error)
+{
+    *changed = FALSE;
+    if (resource->priv->lazy) {
+        /* Stay lazy, only the new XML needs to be kept */
+        if (ovirt_resource_xml_is_unchanged(resource, node)) {
+            return TRUE;
+        }
+        *changed = TRUE;
+        return ovirt_resource_init_lazy_from_xml_unlocked(resource, node, error);
+    }
+    if (ovirt_resource_xml_is_unchanged(resource, node)) {
+        return TRUE;
+    }
+
+    if (!ovirt_resource_init_from_xml_unlocked(resource, node, error)) {
+        return FALSE;
+    }
+    ovirt_resource_apply_xml_retention(resource);
+    *changed = TRUE;
+
+    return TRUE;
+}
+
+
+G_GNUC_INTERNAL
+gboolean ovirt_resource_refresh_from_xml(OvirtResource *resource,
+                                         RestXmlNode *node,
+                                         gboolean *changed,
+                                         GError **error)
+{
+    gboolean refreshed;
+
+    g_return_val_if_fail(OVIRT_IS_RESOURCE(resource), FALSE);
+    g_return_val_if_fail(node != NULL, FALSE);
+    g_return_val_if_fail(changed != NULL, FALSE);
+
+    g_rec_mutex_lock(&ovirt_resource_update_lock);
+    refreshed = ovirt_resource_refresh_from_xml_unlocked(resource, node, changed, error);
+    g_rec_mutex_unlock(&ovirt_resource_update_lock);
+
+    return refreshed;
+}
+
+
+/* Called by ovirt_proxy_add_identity() when @resource gets registered */
+G_GNUC_INTERNAL void ovirt_resource_set_proxy(OvirtResource *resource,
+                                              OvirtProxy *proxy)
+{
+    g_return_if_fail(OVIRT_IS_RESOURCE(resource));
+
+    g_weak_ref_set(&resource->priv->proxy, proxy);
+}
+
+
+/* Returns a new reference to the proxy whose identity map @resource is
+ * registered in, or NULL */
+G_GNUC_INTERNAL OvirtProxy *ovirt_resource_get_proxy(OvirtResource *resource)
+{
+    g_return_val_if_fail(OVIRT_IS_RESOURCE(resource), NULL);
+
+    return g_weak_ref_get(&resource->priv->proxy);
+}
+
+
+/* Returns a new reference to the XML description retained by @resource,
+ * or NULL if it was released */
+static RestXmlNode *ovirt_resource_get_retained_xml(OvirtResource *resource)
+{
+    if (resource->priv->xml != NULL) {
+        return rest_xml_node_ref(resource->priv->xml);
+    }
+    if (resource->priv->xml_compact != NULL) {
+        return ovirt_rest_xml_node_from_data(resource->priv->xml_compact, -1);
+    }
+
+    return NULL;
+}
+
+
+/* Returns the resource of type @type with the @id id which @resource
+ * refers to. When @resource was created from a response of a proxy, this
+ * is the resource shared through the identity map of that proxy, which is
+ * created as an uninitialized stub when there is none yet. */
+G_GNUC_INTERNAL OvirtResource *
+ovirt_resource_get_related(OvirtResource *resource,
+                           GType type,
+                           const char *id,
+                           const char *href)
+{
+    OvirtProxy *proxy;
+    OvirtResource *related;
+    OvirtResource *registered;
+
+    g_return_val_if_fail(OVIRT_IS_RESOURCE(resource), NULL);
+    g_return_val_if_fail(id != NULL, NULL);
+
+    proxy = ovirt_resource_get_proxy(resource);
+    if (proxy == NULL) {
+        return ovirt_resource_new_from_id(type, id, href);
+    }
+
+    related = ovirt_proxy_lookup_identity(proxy, type, id);
+    if (related == NULL) {
+        related = ovirt_resource_new_from_id(type, id, href);
+        registered = ovirt_proxy_add_identity(proxy, related);
+        g_object_unref(related);
+        related = registered;
+    }
+    g_object_unref(proxy);
+
+    return related;
+}
+
+
+/* Replaces @related, an object which was inlined in the XML description
+ * of @resource, with the resource shared through the identity map of the
+ * proxy @resource is registered in, and updates the shared resource from
+ * the XML description of @related. Returns a new reference to the
+ * resulting @related. */
+G_GNUC_INTERNAL OvirtResource *
+ovirt_resource_share_related(OvirtResource *resource,
+                             OvirtResource **related)
+{
+    OvirtProxy *proxy;
+    OvirtProxy *related_proxy;
+    OvirtResource *registered;
+    OvirtResource *shared;
+
+    g_return_val_if_fail(OVIRT_IS_RESOURCE(resource), NULL);
+    g_return_val_if_fail((related != NULL) && OVIRT_IS_RESOURCE(*related), NULL);
+
+    g_rec_mutex_lock(&ovirt_resource_update_lock);
+    proxy = ovirt_resource_get_proxy(resource);
+    related_proxy = ovirt_resource_get_proxy(*related);
+    if ((proxy == NULL) || (related_proxy != NULL)) {
+        /* Not shared, or already shared */
+        goto end;
+    }
+
+    registered = ovirt_proxy_add_identity(proxy, *related);
+    if (registered != *related) {
+        RestXmlNode *node = ovirt_resource_get_retained_xml(*related);
+
+        if (node != NULL) {
+            gboolean changed;
+            GError *error = NULL;
+
+            if (!ovirt_resource_refresh_from_xml_unlocked(registered, node,
+                                                          &changed, &error)) {
+                g_debug("Failed to update shared resource: %s", error->message);
+                g_clear_error(&error);
+            }
+            rest_xml_node_unref(node);
+        }
+    }
+    g_object_unref(*related);
+    *related = registered;
+
+end:
+    shared = g_object_ref(*related);
+    g_rec_mutex_unlock(&ovirt_resource_update_lock);
+    g_clear_object(&proxy);
+    g_clear_object(&related_proxy);
+
+    return shared;
 }
 
 
@@ -471,6 +1155,8 @@ char *ovirt_resource_to_xml(OvirtResource *resource)
     if (klass->to_xml == NULL)
         return NULL;
 
+    ovirt_resource_materialize(resource);
+
     return klass->to_xml(resource);
 }
 
@@ -479,7 +1165,15 @@ G_GNUC_INTERNAL RestXmlNode *ovirt_resource_rest_call_sync(OvirtRestCall *call,
                                                            GError **error)
 {
     RestXmlNode *root = NULL;
-    if (!rest_proxy_call_sync(REST_PROXY_CALL(call), error)) {
+    OvirtProxy *proxy;
+    gboolean succeeded;
+
+    succeeded = rest_proxy_call_sync(REST_PROXY_CALL(call), error);
+    g_object_get(G_OBJECT(call), "proxy", &proxy, NULL);
+    ovirt_proxy_account_response(proxy, REST_PROXY_CALL(call));
+    g_object_unref(proxy);
+    ovirt_rest_call_discard_cached_responses(REST_PROXY_CALL(call));
+    if (!succeeded) {
         GError *local_error = NULL;
 
         root = ovirt_rest_xml_node_from_call(REST_PROXY_CALL(call));
@@ -614,7 +1308,8 @@ static gboolean parse_action_response(RestProxyCall *call, OvirtResource *resour
 static RestProxyCall *
 ovirt_resource_create_rest_call_for_action(OvirtResource *resource,
                                            OvirtProxy *proxy,
-                                           const char *action)
+                                           const char *action,
+                                           gboolean async)
 {
     RestProxyCall *call;
     const char *function;
@@ -625,7 +1320,10 @@ ovirt_resource_create_rest_call_for_action(OvirtResource *resource,
     call = REST_PROXY_CALL(ovirt_action_rest_call_new(REST_PROXY(proxy)));
     rest_proxy_call_set_method(call, "POST");
     rest_proxy_call_set_function(call, function);
-    rest_proxy_call_add_param(call, "async", "false");
+    rest_proxy_call_add_param(call, "async", async ? "true" : "false");
+    if (resource->priv->content_level == OVIRT_CONTENT_LEVEL_FULL) {
+        rest_proxy_call_add_header(call, "All-Content", "true");
+    }
     ovirt_resource_add_rest_params(resource, call);
 
     return call;
@@ -638,6 +1336,7 @@ ovirt_resource_action(OvirtResource *resource, OvirtProxy *proxy,
                       GError **error)
 {
     RestProxyCall *call;
+    gboolean succeeded;
 
     g_return_val_if_fail(OVIRT_IS_RESOURCE(resource), FALSE);
     g_return_val_if_fail(action != NULL, FALSE);
@@ -646,10 +1345,13 @@ ovirt_resource_action(OvirtResource *resource, OvirtProxy *proxy,
 
     call = ovirt_resource_create_rest_call_for_action(resource,
                                                       proxy,
-						      action);
+						      action, FALSE);
     g_return_val_if_fail(call != NULL, FALSE);
 
-    if (!rest_proxy_call_sync(call, error)) {
+    succeeded = rest_proxy_call_sync(call, error);
+    ovirt_proxy_account_response(proxy, call);
+    ovirt_rest_call_discard_cached_responses(call);
+    if (!succeeded) {
         GError *call_error = NULL;
         g_warning("Error while running %s on %p", action, resource);
         /* Even in error cases we may have a response body describing
@@ -712,6 +1414,24 @@ static enum OvirtResponseStatus parse_action_status(RestXmlNode *root,
 }
 
 
+/* Replaces @error with the fault the engine described in @root, if any */
+static void parse_action_fault(RestXmlNode *root, GError **error)
+{
+    const char *fault_key = g_intern_string("fault");
+    GError *fault_error = NULL;
+    RestXmlNode *fault_node = NULL;
+
+    fault_node = g_hash_table_lookup(root->children, fault_key);
+    if (fault_node != NULL) {
+        ovirt_utils_gerror_from_xml_fault(fault_node, &fault_error);
+        if (fault_error != NULL) {
+            g_clear_error(error);
+            g_propagate_error(error, fault_error);
+        }
+    }
+}
+
+
 static gboolean
 parse_action_response(RestProxyCall *call, OvirtResource *resource,
                       ActionResponseParser response_parser, GError **error)
@@ -738,18 +1458,7 @@ parse_action_response(RestProxyCall *call, OvirtResource *resource,
                 result = TRUE;
             }
         } if (status == OVIRT_RESPONSE_FAILED) {
-            const char *fault_key = g_intern_string("fault");
-            GError *fault_error = NULL;
-            RestXmlNode *fault_node = NULL;
-
-            fault_node = g_hash_table_lookup(root->children, fault_key);
-            if (fault_node != NULL) {
-                ovirt_utils_gerror_from_xml_fault(fault_node, &fault_error);
-                if (fault_error != NULL) {
-                    g_clear_error(error);
-                    g_propagate_error(error, fault_error);
-                }
-            }
+            parse_action_fault(root, error);
         }
     } else {
         g_warn_if_reached();
@@ -814,7 +1523,7 @@ ovirt_resource_invoke_action_async(OvirtResource *resource,
     g_debug("invoking '%s' action on %p using %p", action, resource, proxy);
     call = ovirt_resource_create_rest_call_for_action(resource,
                                                       proxy,
-						      action);
+						      action, FALSE);
     g_return_if_fail(call != NULL);
 
     task = g_task_new(G_OBJECT(resource),
@@ -845,31 +1554,179 @@ ovirt_resource_action_finish(OvirtResource *resource,
 }
 
 
+static gboolean ovirt_resource_submit_action_async_cb(G_GNUC_UNUSED OvirtProxy *proxy,
+                                                      RestProxyCall *call,
+                                                      gpointer user_data,
+                                                      GError **error)
+{
+    GTask *task = G_TASK(user_data);
+    RestXmlNode *root;
+    RestXmlNode *status_node;
+    RestXmlNode *job_node;
+    OvirtJob *job = NULL;
+    const char *status;
+
+    root = ovirt_rest_xml_node_from_call(call);
+    if ((root == NULL) || (g_strcmp0(root->name, "action") != 0)) {
+        g_set_error_literal(error, OVIRT_ERROR, OVIRT_ERROR_PARSING_FAILED,
+                            _("Failed to parse response from action"));
+        goto end;
+    }
+
+    status_node = g_hash_table_lookup(root->children, g_intern_string("status"));
+    status = (status_node != NULL) ? status_node->content : NULL;
+    if (g_strcmp0(status, "failed") == 0) {
+        g_set_error_literal(error, OVIRT_ERROR, OVIRT_ERROR_ACTION_FAILED,
+                            _("Action has failed"));
+        parse_action_fault(root, error);
+        goto end;
+    }
+
+    job_node = g_hash_table_lookup(root->children, g_intern_string("job"));
+    if (job_node != NULL) {
+        job = ovirt_job_new_from_xml(job_node, error);
+    } else if (g_strcmp0(status, "complete") == 0) {
+        /* The engine may complete quick actions before replying */
+        job = ovirt_job_new();
+        ovirt_job_set_status(job, OVIRT_JOB_STATUS_FINISHED);
+    } else {
+        g_set_error_literal(error, OVIRT_ERROR, OVIRT_ERROR_NOT_SUPPORTED,
+                            _("Action response does not reference a job"));
+    }
+
+end:
+    if (root != NULL) {
+        rest_xml_node_unref(root);
+    }
+    if (job == NULL) {
+        return FALSE;
+    }
+    g_task_set_task_data(task, job, g_object_unref);
+
+    return TRUE;
+}
+
+
+/**
+ * ovirt_resource_submit_action_async:
+ * @resource: a #OvirtResource
+ * @proxy: a #OvirtProxy
+ * @action: name of the action to run, for example "start"
+ * @cancellable: (allow-none): a #GCancellable
+ * @callback: (scope async): completion callback
+ * @user_data: (closure): opaque data for callback
+ *
+ * Asks the engine to run @action on @resource without waiting for it to be
+ * over. The HTTP request completes as soon as the engine accepted the
+ * action, ovirt_resource_submit_action_finish() then returns a #OvirtJob
+ * which can be used to track its progress.
+ *
+ * Since: 0.3.12
+ */
+void ovirt_resource_submit_action_async(OvirtResource *resource,
+                                        OvirtProxy *proxy,
+                                        const char *action,
+                                        GCancellable *cancellable,
+                                        GAsyncReadyCallback callback,
+                                        gpointer user_data)
+{
+    RestProxyCall *call;
+    GTask *task;
+
+    g_return_if_fail(OVIRT_IS_RESOURCE(resource));
+    g_return_if_fail(action != NULL);
+    g_return_if_fail(OVIRT_IS_PROXY(proxy));
+    g_return_if_fail((cancellable == NULL) || G_IS_CANCELLABLE(cancellable));
+
+    task = g_task_new(G_OBJECT(resource), cancellable, callback, user_data);
+    if (ovirt_resource_get_action(resource, action) == NULL) {
+        g_task_return_new_error(task, OVIRT_ERROR, OVIRT_ERROR_NOT_SUPPORTED,
+                                _("Action '%s' is not available for this resource"),
+                                action);
+        g_object_unref(task);
+        return;
+    }
+
+    g_debug("submitting '%s' action on %p using %p", action, resource, proxy);
+    call = ovirt_resource_create_rest_call_for_action(resource, proxy,
+                                                      action, TRUE);
+    ovirt_rest_call_async(OVIRT_REST_CALL(call), task, cancellable,
+                          ovirt_resource_submit_action_async_cb, task, NULL);
+    g_object_unref(G_OBJECT(call));
+}
+
+
+/**
+ * ovirt_resource_submit_action_finish:
+ * @resource: a #OvirtResource
+ * @result: async method result
+ * @err: #GError to set on error, or NULL
+ *
+ * Return value: (transfer full): a #OvirtJob tracking the action, or NULL
+ * if the engine did not accept it, with @err set.
+ *
+ * Since: 0.3.12
+ */
+OvirtJob *ovirt_resource_submit_action_finish(OvirtResource *resource,
+                                              GAsyncResult *result,
+                                              GError **err)
+{
+    g_return_val_if_fail(OVIRT_IS_RESOURCE(resource), NULL);
+    g_return_val_if_fail(g_task_is_valid(G_TASK(result), G_OBJECT(resource)),
+                         NULL);
+
+    if (!ovirt_rest_call_finish(result, err)) {
+        return NULL;
+    }
+
+    return g_object_ref(g_task_get_task_data(G_TASK(result)));
+}
+
+
+/* Href the resource is refreshed from, which differs from its href when
+ * related objects are inlined or all of its content is requested */
+static char *ovirt_resource_get_refresh_href(OvirtResource *resource)
+{
+    char *content_href;
+    char *href;
+
+    content_href = ovirt_utils_href_add_all_content(resource->priv->href,
+                                                    resource->priv->content_level == OVIRT_CONTENT_LEVEL_FULL);
+    href = ovirt_utils_href_add_query_param(content_href, "follow",
+                                            resource->priv->follow);
+    g_free(content_href);
+
+    return href;
+}
+
+
 static gboolean ovirt_resource_refresh_async_cb(OvirtProxy *proxy,
                                                 RestProxyCall *call,
+                                                RestXmlNode *root,
                                                 gpointer user_data,
                                                 GError **error)
 {
     OvirtResource *resource;
-    RestXmlNode *root;
-    gboolean refreshed = FALSE;
+    gboolean refreshed;
 
     g_return_val_if_fail(REST_IS_PROXY_CALL(call), FALSE);
     g_return_val_if_fail(OVIRT_IS_RESOURCE(user_data), FALSE);
 
-    root = ovirt_rest_xml_node_from_call(call);
     if (root == NULL) {
         g_set_error_literal(error, OVIRT_ERROR, OVIRT_ERROR_PARSING_FAILED,
                             _("Failed to parse response from resource"));
-        goto end;
+        return FALSE;
     }
 
     resource = OVIRT_RESOURCE(user_data);
     refreshed = ovirt_resource_init_from_xml(resource, root, error);
+    if (refreshed) {
+        const char *href = rest_proxy_call_get_function(call);
 
-    rest_xml_node_unref(root);
+        ovirt_cache_validators_update(&resource->priv->validators, call, href);
+        ovirt_proxy_cache_parsed_response(proxy, call, href, root);
+    }
 
-end:
     return refreshed;
 }
 
@@ -881,6 +1738,9 @@ void ovirt_resource_refresh_async(OvirtResource *resource,
 {
     OvirtResourceRestCall *call;
     GTask *task;
+    RestXmlNode *root;
+    GError *error = NULL;
+    char *href;
 
     g_return_if_fail(OVIRT_IS_RESOURCE(resource));
     g_return_if_fail(OVIRT_IS_PROXY(proxy));
@@ -890,15 +1750,35 @@ void ovirt_resource_refresh_async(OvirtResource *resource,
                       cancellable,
                       callback,
                       user_data);
+    href = ovirt_resource_get_refresh_href(resource);
+    if (ovirt_proxy_lookup_parsed_response(proxy, href, &root, &error)) {
+        if ((root != NULL) && ovirt_resource_init_from_xml(resource, root, &error)) {
+            g_task_return_boolean(task, TRUE);
+        } else {
+            g_task_return_error(task, error);
+        }
+        if (root != NULL) {
+            rest_xml_node_unref(root);
+        }
+        g_object_unref(task);
+        g_free(href);
+        return;
+    }
+
     call = ovirt_resource_rest_call_new(REST_PROXY(proxy),
                                         OVIRT_RESOURCE(resource));
-    /* FIXME: to set or not to set ?? */
-    rest_proxy_call_add_header(REST_PROXY_CALL(call),
-                               "All-Content", "true");
+    g_object_set(G_OBJECT(call), "href", href, NULL);
     rest_proxy_call_set_method(REST_PROXY_CALL(call), "GET");
-    ovirt_rest_call_async(OVIRT_REST_CALL(call), task, cancellable,
-                          ovirt_resource_refresh_async_cb, resource,
-                          NULL);
+    /* Nothing is parsed when the resource did not change */
+    ovirt_cache_validators_add_headers(resource->priv->validators,
+                                       REST_PROXY_CALL(call), href);
+    g_free(href);
+    /* Resources with the same href which are refreshed at the same time
+     * share the request */
+    ovirt_proxy_get_shared_async(proxy, REST_PROXY_CALL(call), task,
+                                 cancellable, NULL, NULL, NULL,
+                                 ovirt_resource_refresh_async_cb, resource,
+                                 NULL);
     g_object_unref(G_OBJECT(call));
 }
 
@@ -919,19 +1799,58 @@ gboolean ovirt_resource_refresh(OvirtResource *resource,
                                 OvirtProxy *proxy,
                                 GError **error)
 {
+    OvirtRestCall *call;
     RestXmlNode *root_node;
+    GError *local_error = NULL;
     gboolean success;
+    char *href;
 
     g_return_val_if_fail(OVIRT_IS_RESOURCE(resource), FALSE);
     g_return_val_if_fail(OVIRT_IS_PROXY(proxy), FALSE);
 
-    root_node = ovirt_resource_rest_call(resource, proxy, "GET", error);
+    href = ovirt_resource_get_refresh_href(resource);
+    if (ovirt_proxy_lookup_parsed_response(proxy, href, &root_node, error)) {
+        g_free(href);
+        if (root_node == NULL) {
+            return FALSE;
+        }
+        success = ovirt_resource_init_from_xml(resource, root_node, error);
+        rest_xml_node_unref(root_node);
+
+        return success;
+    }
+
+    call = OVIRT_REST_CALL(ovirt_resource_rest_call_new(REST_PROXY(proxy),
+                                                        resource));
+    g_object_set(G_OBJECT(call), "href", href, NULL);
+    rest_proxy_call_set_method(REST_PROXY_CALL(call), "GET");
+    ovirt_cache_validators_add_headers(resource->priv->validators,
+                                       REST_PROXY_CALL(call), href);
+
+    root_node = ovirt_resource_rest_call_sync(call, &local_error);
     if (root_node == NULL) {
-        return FALSE;
+        ovirt_proxy_cache_failed_response(proxy, REST_PROXY_CALL(call));
+        success = ovirt_rest_call_is_not_modified(REST_PROXY_CALL(call));
+        if (success) {
+            g_clear_error(&local_error);
+        } else if (local_error != NULL) {
+            g_propagate_error(error, local_error);
+        }
+        g_object_unref(G_OBJECT(call));
+        g_free(href);
+        return success;
     }
 
     success = ovirt_resource_init_from_xml(resource, root_node, error);
+    if (success) {
+        ovirt_cache_validators_update(&resource->priv->validators,
+                                      REST_PROXY_CALL(call), href);
+        ovirt_proxy_cache_parsed_response(proxy, REST_PROXY_CALL(call),
+                                          href, root_node);
+    }
     rest_xml_node_unref(root_node);
+    g_object_unref(G_OBJECT(call));
+    g_free(href);
 
     return success;
 }
@@ -945,8 +1864,10 @@ void ovirt_resource_add_rest_params(OvirtResource *resource,
     g_return_if_fail(OVIRT_IS_REST_CALL(call));
 
     klass = OVIRT_RESOURCE_GET_CLASS(resource);
-    if (klass->add_rest_params != NULL)
+    if (klass->add_rest_params != NULL) {
+        ovirt_resource_materialize(resource);
         klass->add_rest_params(resource, call);
+    }
 }
 
 
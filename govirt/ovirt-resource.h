@@ -41,6 +41,34 @@ typedef struct _OvirtResource OvirtResource;
 typedef struct _OvirtResourcePrivate OvirtResourcePrivate;
 typedef struct _OvirtResourceClass OvirtResourceClass;
 
+/**
+ * OvirtXmlRetention:
+ * @OVIRT_XML_RETENTION_KEEP: keep the XML tree the resource was parsed from
+ * @OVIRT_XML_RETENTION_DROP: release the XML tree once it has been parsed
+ * @OVIRT_XML_RETENTION_COMPACT: only keep a serialized copy of the XML
+ *
+ * Since: 0.3.12
+ */
+typedef enum {
+    OVIRT_XML_RETENTION_KEEP,
+    OVIRT_XML_RETENTION_DROP,
+    OVIRT_XML_RETENTION_COMPACT,
+} OvirtXmlRetention;
+
+/**
+ * OvirtContentLevel:
+ * @OVIRT_CONTENT_LEVEL_SUMMARY: only request the attributes the server
+ * returns by default
+ * @OVIRT_CONTENT_LEVEL_FULL: also request the attributes which are only
+ * returned on demand, such as the complete configuration of VMs
+ *
+ * Since: 0.3.12
+ */
+typedef enum {
+    OVIRT_CONTENT_LEVEL_SUMMARY,
+    OVIRT_CONTENT_LEVEL_FULL,
+} OvirtContentLevel;
+
 struct _OvirtResource
 {
     GObject parent;
@@ -108,6 +136,16 @@ gboolean ovirt_resource_delete_finish(OvirtResource *resource,
                                       GAsyncResult *result,
                                       GError **err);
 
+void ovirt_resource_submit_action_async(OvirtResource *resource,
+                                        OvirtProxy *proxy,
+                                        const char *action,
+                                        GCancellable *cancellable,
+                                        GAsyncReadyCallback callback,
+                                        gpointer user_data);
+OvirtJob *ovirt_resource_submit_action_finish(OvirtResource *resource,
+                                              GAsyncResult *result,
+                                              GError **err);
+
 G_END_DECLS
 
 #endif /* __OVIRT_RESOURCE_H__ */
@@ -32,6 +32,11 @@
 
 struct _OvirtRestCallPrivate {
     char *href;
+    /* Generation of the responses cached by the proxy when the call was
+     * created, see ovirt_proxy_get_response_generation() */
+    guint response_generation;
+    /* Name of the XML element the response is expected to describe */
+    char *root_name;
 };
 
 
@@ -103,6 +108,7 @@ static void ovirt_rest_call_finalize(GObject *object)
     OvirtRestCall *call = OVIRT_REST_CALL(object);
 
     g_free(call->priv->href);
+    g_free(call->priv->root_name);
 
     G_OBJECT_CLASS(ovirt_rest_call_parent_class)->finalize(object);
 }
@@ -124,12 +130,66 @@ static void ovirt_rest_call_constructed(GObject *object)
             rest_proxy_call_add_header(REST_PROXY_CALL(object), "Filter", "true");
         }
         ovirt_proxy_append_additional_headers(proxy, REST_PROXY_CALL(object));
+        OVIRT_REST_CALL(object)->priv->response_generation =
+            ovirt_proxy_get_response_generation(proxy);
 
         g_object_unref(proxy);
     }
 }
 
 
+/* Called before @call is sent, and again once it completed: any request
+ * other than GET can modify resources, so the responses the proxy reuses
+ * may no longer be accurate. GET requests which are in flight in the
+ * meantime can return the state of the resources from before the change,
+ * the proxy does not cache their responses */
+void ovirt_rest_call_discard_cached_responses(RestProxyCall *call)
+{
+    OvirtProxy *proxy;
+
+    if (g_strcmp0(rest_proxy_call_get_method(call), "GET") == 0) {
+        return;
+    }
+
+    g_object_get(G_OBJECT(call), "proxy", &proxy, NULL);
+    if (proxy != NULL) {
+        ovirt_proxy_discard_parsed_responses(proxy);
+        g_object_unref(proxy);
+    }
+}
+
+
+guint ovirt_rest_call_get_response_generation(RestProxyCall *call)
+{
+    g_return_val_if_fail(OVIRT_IS_REST_CALL(call), 0);
+
+    return OVIRT_REST_CALL(call)->priv->response_generation;
+}
+
+
+/* JSON documents do not name their root object: when the response to @call
+ * is JSON, the root element of the equivalent XML tree is named
+ * @root_name, see ovirt_rest_xml_node_from_call() */
+void ovirt_rest_call_set_root_name(RestProxyCall *call, const char *root_name)
+{
+    OvirtRestCall *self;
+
+    g_return_if_fail(OVIRT_IS_REST_CALL(call));
+
+    self = OVIRT_REST_CALL(call);
+    g_free(self->priv->root_name);
+    self->priv->root_name = g_strdup(root_name);
+}
+
+
+const char *ovirt_rest_call_get_root_name(RestProxyCall *call)
+{
+    g_return_val_if_fail(OVIRT_IS_REST_CALL(call), NULL);
+
+    return OVIRT_REST_CALL(call)->priv->root_name;
+}
+
+
 static void ovirt_rest_call_class_init(OvirtRestCallClass *klass)
 {
     GObjectClass *object_class = G_OBJECT_CLASS(klass);
@@ -54,6 +54,11 @@ struct _OvirtRestCallClass
 };
 
 G_GNUC_INTERNAL GType ovirt_rest_call_get_type(void);
+G_GNUC_INTERNAL void ovirt_rest_call_discard_cached_responses(RestProxyCall *call);
+G_GNUC_INTERNAL guint ovirt_rest_call_get_response_generation(RestProxyCall *call);
+G_GNUC_INTERNAL void ovirt_rest_call_set_root_name(RestProxyCall *call,
+                                                   const char *root_name);
+G_GNUC_INTERNAL const char *ovirt_rest_call_get_root_name(RestProxyCall *call);
 
 G_END_DECLS
 
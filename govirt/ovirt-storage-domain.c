@@ -60,19 +60,24 @@ enum {
     PROP_STORAGE_TYPE,
 };
 
-static char *ensure_href_from_id(const char *id,
-                                 const char *path)
+static void ensure_href_from_id(char **href,
+                                const char *id,
+                                const char *path)
 {
-    if (id == NULL)
-        return NULL;
+    char *value;
 
-    return g_strdup_printf("%s/%s", path, id);
+    if (*href != NULL || id == NULL)
+        return;
+
+    value = g_strdup_printf("%s/%s", path, id);
+    ovirt_utils_set_interned_string(href, value);
+    g_free(value);
 }
 
 static const char *get_data_center_href(OvirtStorageDomain *domain)
 {
-    if (domain->priv->data_center_href == NULL)
-        domain->priv->data_center_href = ensure_href_from_id(domain->priv->data_center_id, "/ovirt-engine/api/datacenters");
+    ensure_href_from_id(&domain->priv->data_center_href, domain->priv->data_center_id,
+                        "/ovirt-engine/api/datacenters");
 
     return domain->priv->data_center_href;
 }
@@ -84,6 +89,8 @@ static void ovirt_storage_domain_get_property(GObject *object,
 {
     OvirtStorageDomain *domain = OVIRT_STORAGE_DOMAIN(object);
 
+    ovirt_resource_materialize(OVIRT_RESOURCE(object));
+
     switch (prop_id) {
     case PROP_TYPE:
         g_value_set_enum(value, domain->priv->type);
@@ -131,6 +138,8 @@ static void ovirt_storage_domain_set_property(GObject *object,
 {
     OvirtStorageDomain *domain = OVIRT_STORAGE_DOMAIN(object);
 
+    ovirt_resource_materialize(OVIRT_RESOURCE(object));
+
     switch (prop_id) {
     case PROP_TYPE:
         domain->priv->type = g_value_get_enum(value);
@@ -158,12 +167,10 @@ static void ovirt_storage_domain_set_property(GObject *object,
         domain->priv->data_center_ids = g_value_dup_boxed(value);
         break;
     case PROP_DATA_CENTER_HREF:
-        g_free(domain->priv->data_center_href);
-        domain->priv->data_center_href = g_value_dup_string(value);
+        ovirt_utils_set_interned_string(&domain->priv->data_center_href, g_value_get_string(value));
         break;
     case PROP_DATA_CENTER_ID:
-        g_free(domain->priv->data_center_id);
-        domain->priv->data_center_id = g_value_dup_string(value);
+        ovirt_utils_set_interned_string(&domain->priv->data_center_id, g_value_get_string(value));
         break;
     case PROP_STORAGE_TYPE:
         domain->priv->storage_type = g_value_get_enum(value);
@@ -183,8 +190,8 @@ ovirt_storage_domain_dispose(GObject *obj)
     g_clear_object(&domain->priv->files);
     g_clear_object(&domain->priv->disks);
     g_clear_pointer(&domain->priv->data_center_ids, g_strfreev);
-    g_clear_pointer(&domain->priv->data_center_href, g_free);
-    g_clear_pointer(&domain->priv->data_center_id, g_free);
+    g_clear_pointer(&domain->priv->data_center_href, g_ref_string_release);
+    g_clear_pointer(&domain->priv->data_center_id, g_ref_string_release);
 
     G_OBJECT_CLASS(ovirt_storage_domain_parent_class)->dispose(obj);
 }
@@ -196,7 +203,7 @@ static gboolean ovirt_storage_domain_init_from_xml(OvirtResource *resource,
 {
     gboolean parsed_ok;
     OvirtResourceClass *parent_class;
-    OvirtXmlElement storage_domain_elements[] = {
+    static const OvirtXmlElement storage_domain_elements[] = {
         { .prop_name = "type",
           .xml_path = "type",
         },
@@ -26,12 +26,16 @@
 G_BEGIN_DECLS
 
 typedef struct _OvirtApi OvirtApi;
+typedef struct _OvirtBulkAction OvirtBulkAction;
 typedef struct _OvirtCdrom OvirtCdrom;
 typedef struct _OvirtCluster OvirtCluster;
 typedef struct _OvirtCollection OvirtCollection;
+typedef struct _OvirtCollectionPager OvirtCollectionPager;
 typedef struct _OvirtDisk OvirtDisk;
 typedef struct _OvirtDataCenter OvirtDataCenter;
+typedef struct _OvirtEventSync OvirtEventSync;
 typedef struct _OvirtHost OvirtHost;
+typedef struct _OvirtJob OvirtJob;
 typedef struct _OvirtProxy OvirtProxy;
 typedef struct _OvirtStorageDomain OvirtStorageDomain;
 typedef struct _OvirtVmDisplay OvirtVmDisplay;
@@ -27,6 +27,9 @@
 #include <string.h>
 
 #include <glib/gi18n-lib.h>
+#ifdef HAVE_JSON_GLIB
+#include <json-glib/json-glib.h>
+#endif
 #include <rest/rest-xml-parser.h>
 
 #include "ovirt-utils.h"
@@ -34,83 +37,558 @@
 #include "ovirt-error.h"
 #include "ovirt-resource.h"
 #include "ovirt-resource-private.h"
+#include "ovirt-rest-call.h"
 
 RestXmlNode *
-ovirt_rest_xml_node_from_call(RestProxyCall *call)
+ovirt_rest_xml_node_from_data(const char *data, gssize length)
 {
     RestXmlParser *parser;
     RestXmlNode *node;
-    const char * data = rest_proxy_call_get_payload (call);
 
-    if (data == NULL)
-        return NULL;
+    g_return_val_if_fail(data != NULL, NULL);
+
+    if (length < 0)
+        length = strlen(data);
 
     parser = rest_xml_parser_new ();
 
-    node = rest_xml_parser_parse_from_data (parser, data,
-            rest_proxy_call_get_payload_length (call));
+    node = rest_xml_parser_parse_from_data (parser, data, length);
 
     g_object_unref(G_OBJECT(parser));
 
     return node;
 }
 
-static RestXmlNode *
-ovirt_rest_xml_node_find(RestXmlNode *node, const char *path)
+#ifdef HAVE_JSON_GLIB
+/* Members of the JSON objects which are attributes of the corresponding
+ * XML elements */
+static const char * const ovirt_json_attributes[] = {
+    "href",
+    "id",
+    "rel",
+};
+#endif
+
+/* Collections whose XML root element is not named after the last
+ * component of their href */
+static const struct {
+    const char *href_name;
+    const char *xml_name;
+} ovirt_json_collection_names[] = {
+    { "datacenters", "data_centers" },
+    { "storagedomains", "storage_domains" },
+};
+
+
+#ifdef HAVE_JSON_GLIB
+static gboolean ovirt_json_is_attribute(const char *name)
 {
     guint i;
-    GStrv pathv;
 
-    g_return_val_if_fail((path != NULL), NULL);
+    for (i = 0; i < G_N_ELEMENTS(ovirt_json_attributes); i++) {
+        if (strcmp(name, ovirt_json_attributes[i]) == 0) {
+            return TRUE;
+        }
+    }
+
+    return FALSE;
+}
+
+
+static char *ovirt_json_value_to_string(JsonNode *value)
+{
+    switch (json_node_get_value_type(value)) {
+    case G_TYPE_STRING:
+        return json_node_dup_string(value);
+    case G_TYPE_INT64:
+        return g_strdup_printf("%" G_GINT64_FORMAT, json_node_get_int(value));
+    case G_TYPE_BOOLEAN:
+        return g_strdup(json_node_get_boolean(value) ? "true" : "false");
+    case G_TYPE_DOUBLE: {
+        char buffer[G_ASCII_DTOSTR_BUF_SIZE];
+
+        return g_strdup(g_ascii_dtostr(buffer, sizeof(buffer),
+                                       json_node_get_double(value)));
+    }
+    default:
+        return NULL;
+    }
+}
+
 
-    pathv = g_strsplit(path, "/", -1);
+static void ovirt_json_fill_node(RestXmlNode *node, JsonObject *object);
 
-    for (i = 0; i < g_strv_length(pathv); ++i) {
-        gchar *name = node->name;
-        node = rest_xml_node_find(node, pathv[i]);
-        if (node == NULL) {
-            g_debug("could not find subnode '%s' of XML node '%s' (search: %s)", pathv[i], name, path);
+/* Adds the XML equivalent of the @name member of a JSON object to @parent:
+ * objects become child elements, arrays become one child element per
+ * item, and scalar values become either attributes or text elements */
+static void ovirt_json_add_member(RestXmlNode *parent,
+                                  const char *name,
+                                  JsonNode *value)
+{
+    RestXmlNode *child;
+    char *str;
+
+    switch (JSON_NODE_TYPE(value)) {
+    case JSON_NODE_OBJECT:
+        child = rest_xml_node_add_child(parent, name);
+        ovirt_json_fill_node(child, json_node_get_object(value));
+        break;
+    case JSON_NODE_ARRAY: {
+        JsonArray *array = json_node_get_array(value);
+        guint i;
+
+        for (i = 0; i < json_array_get_length(array); i++) {
+            ovirt_json_add_member(parent, name,
+                                  json_array_get_element(array, i));
+        }
+        break;
+    }
+    case JSON_NODE_VALUE:
+        str = ovirt_json_value_to_string(value);
+        if (str == NULL) {
             break;
         }
+        if (ovirt_json_is_attribute(name)) {
+            rest_xml_node_add_attr(parent, name, str);
+        } else {
+            child = rest_xml_node_add_child(parent, name);
+            rest_xml_node_set_content(child, str);
+        }
+        g_free(str);
+        break;
+    case JSON_NODE_NULL:
+        break;
+    }
+}
+
+
+static void ovirt_json_fill_node(RestXmlNode *node, JsonObject *object)
+{
+    JsonObjectIter iter;
+    const char *name;
+    JsonNode *value;
+
+    json_object_iter_init(&iter, object);
+    while (json_object_iter_next(&iter, &name, &value)) {
+        ovirt_json_add_member(node, name, value);
+    }
+}
+#endif
+
+
+/* Name of the XML root element equivalent to the JSON response to a GET
+ * request for @href, JSON documents do not name their root object. This
+ * is only a fallback for callers which do not say which element they
+ * expect, and it is wrong for responses describing a single resource,
+ * whose href ends with its id */
+static char *ovirt_json_guess_root_name(const char *href)
+{
+    const char *end;
+    const char *start;
+    char *name;
+    guint i;
+
+    end = strchr(href, '?');
+    if (end == NULL) {
+        end = href + strlen(href);
+    }
+    while ((end > href) && (end[-1] == '/')) {
+        end--;
+    }
+    start = end;
+    while ((start > href) && (start[-1] != '/')) {
+        start--;
+    }
+    if (start == end) {
+        return g_strdup("response");
+    }
+    name = g_strndup(start, end - start);
+
+    for (i = 0; i < G_N_ELEMENTS(ovirt_json_collection_names); i++) {
+        if (strcmp(name, ovirt_json_collection_names[i].href_name) == 0) {
+            g_free(name);
+            return g_strdup(ovirt_json_collection_names[i].xml_name);
+        }
     }
 
-    g_strfreev(pathv);
+    return name;
+}
+
+
+static gboolean ovirt_utils_is_json(const char *data, gsize length)
+{
+    gsize i;
+
+    for (i = 0; i < length; i++) {
+        if (!g_ascii_isspace(data[i])) {
+            return (data[i] == '{');
+        }
+    }
+
+    return FALSE;
+}
+
+
+/* Parses a JSON document into the RestXmlNode tree of the equivalent XML
+ * document, whose root element is named @root_name, so that the code
+ * parsing XML responses can be used for both formats */
+G_GNUC_INTERNAL RestXmlNode *
+ovirt_rest_xml_node_from_json_data(const char *data,
+                                   gssize length,
+                                   const char *root_name)
+{
+#ifdef HAVE_JSON_GLIB
+    JsonParser *parser;
+    JsonNode *json_root;
+    RestXmlNode *root = NULL;
+    GError *error = NULL;
+
+    g_return_val_if_fail(data != NULL, NULL);
+    g_return_val_if_fail(root_name != NULL, NULL);
+
+    parser = json_parser_new();
+    if (!json_parser_load_from_data(parser, data, length, &error)) {
+        g_debug("Failed to parse JSON document: %s", error->message);
+        g_clear_error(&error);
+        goto end;
+    }
+    json_root = json_parser_get_root(parser);
+    if ((json_root == NULL) || !JSON_NODE_HOLDS_OBJECT(json_root)) {
+        goto end;
+    }
+
+    root = rest_xml_node_add_child(NULL, root_name);
+    ovirt_json_fill_node(root, json_node_get_object(json_root));
+
+end:
+    g_object_unref(G_OBJECT(parser));
+
+    return root;
+#else
+    g_return_val_if_fail(data != NULL, NULL);
+    g_return_val_if_fail(root_name != NULL, NULL);
+
+    g_debug("Failed to parse JSON document: libgovirt was built without JSON support");
+
+    return NULL;
+#endif
+}
+
+
+/* Same as ovirt_rest_xml_node_from_data(), except that @data can also be
+ * the JSON response to a GET request for @href. Its root element is then
+ * named @root_name, or guessed from @href when @root_name is NULL */
+G_GNUC_INTERNAL RestXmlNode *
+ovirt_rest_xml_node_from_response(const char *data,
+                                  gssize length,
+                                  const char *href,
+                                  const char *root_name)
+{
+    RestXmlNode *node;
+    char *guessed_name;
+
+    g_return_val_if_fail(data != NULL, NULL);
+
+    if (length < 0)
+        length = strlen(data);
+
+    if (!ovirt_utils_is_json(data, length)) {
+        return ovirt_rest_xml_node_from_data(data, length);
+    }
+    if (root_name != NULL) {
+        return ovirt_rest_xml_node_from_json_data(data, length, root_name);
+    }
+
+    guessed_name = (href != NULL) ? ovirt_json_guess_root_name(href) : g_strdup("response");
+    node = ovirt_rest_xml_node_from_json_data(data, length, guessed_name);
+    g_free(guessed_name);
 
     return node;
 }
 
-static const char *
-ovirt_rest_xml_node_get_content_from_path(RestXmlNode *node, const char *path)
+
+/* The root element of the tree built from a successful JSON response to a
+ * GET request is named after the root name of @call, see
+ * ovirt_rest_call_set_root_name(), when it has one */
+RestXmlNode *
+ovirt_rest_xml_node_from_call(RestProxyCall *call)
 {
-    node = ovirt_rest_xml_node_find(node, path);
+    const char *root_name = NULL;
 
-    if (node == NULL)
-        return NULL;
+    if (OVIRT_IS_REST_CALL(call)) {
+        root_name = ovirt_rest_call_get_root_name(call);
+    }
 
-    return node->content;
+    return ovirt_rest_xml_node_from_call_full(call, root_name);
 }
 
-static const char *
-ovirt_rest_xml_node_get_attr_from_path(RestXmlNode *node, const char *path, const char *attr)
+
+/* Same as ovirt_rest_xml_node_from_call(), except that the root element of
+ * the tree built from a successful JSON response to a GET request is named
+ * @root_name, instead of being guessed from the href of @call, when
+ * @root_name is not NULL */
+RestXmlNode *
+ovirt_rest_xml_node_from_call_full(RestProxyCall *call, const char *root_name)
 {
-    node = ovirt_rest_xml_node_find(node, path);
-    if (node == NULL)
+    const char *data = rest_proxy_call_get_payload (call);
+    gsize length;
+
+    if (data == NULL)
         return NULL;
 
-    return rest_xml_node_get_attr(node, attr);
+    length = rest_proxy_call_get_payload_length (call);
+    if (!ovirt_utils_is_json(data, length)) {
+        return ovirt_rest_xml_node_from_data(data, length);
+    }
+
+    /* The root element of JSON errors and action results can't be
+     * guessed from the href */
+    if (rest_proxy_call_get_status_code(call) >= 400) {
+        return ovirt_rest_xml_node_from_json_data(data, length, "fault");
+    }
+    if (g_strcmp0(rest_proxy_call_get_method(call), "POST") == 0) {
+        return ovirt_rest_xml_node_from_json_data(data, length, "action");
+    }
+    return ovirt_rest_xml_node_from_response(data, length,
+                                             rest_proxy_call_get_function(call),
+                                             root_name);
+}
+
+
+static void
+ovirt_rest_xml_node_append_to_string(RestXmlNode *node, GString *str)
+{
+    GHashTableIter iter;
+    gpointer key;
+    gpointer value;
+
+    g_string_append_printf(str, "<%s", node->name);
+    g_hash_table_iter_init(&iter, node->attrs);
+    while (g_hash_table_iter_next(&iter, &key, &value)) {
+        char *escaped = g_markup_escape_text(value, -1);
+        g_string_append_printf(str, " %s=\"%s\"", (char *)key, escaped);
+        g_free(escaped);
+    }
+    g_string_append_c(str, '>');
+
+    if (node->content != NULL) {
+        char *escaped = g_markup_escape_text(node->content, -1);
+        g_string_append(str, escaped);
+        g_free(escaped);
+    }
+
+    g_hash_table_iter_init(&iter, node->children);
+    while (g_hash_table_iter_next(&iter, NULL, &value)) {
+        RestXmlNode *child;
+
+        for (child = value; child != NULL; child = child->next) {
+            ovirt_rest_xml_node_append_to_string(child, str);
+        }
+    }
+
+    g_string_append_printf(str, "</%s>", node->name);
+}
+
+/* Serializes @node and its descendants (but not its siblings) so that
+ * ovirt_rest_xml_node_from_data() gives back an equivalent tree. This
+ * differs from rest_xml_node_print() which does not escape text. */
+G_GNUC_INTERNAL char *
+ovirt_rest_xml_node_to_string(RestXmlNode *node)
+{
+    GString *str;
+
+    g_return_val_if_fail(node != NULL, NULL);
+
+    str = g_string_new(NULL);
+    ovirt_rest_xml_node_append_to_string(node, str);
+
+    return g_string_free(str, FALSE);
+}
+
+
+/* Rough estimate of the memory used by an empty GHashTable, and by each of
+ * its entries */
+#define OVIRT_HASH_TABLE_SIZE (16 * sizeof(gpointer))
+#define OVIRT_HASH_TABLE_ENTRY_SIZE (2 * sizeof(gpointer) + sizeof(guint))
+
+/* Estimates the memory used by @node and its descendants (but not its
+ * siblings). Element and attribute names are interned by librest, so they
+ * are not accounted for. */
+G_GNUC_INTERNAL gsize
+ovirt_rest_xml_node_get_size(RestXmlNode *node)
+{
+    GHashTableIter iter;
+    gpointer value;
+    gsize size;
+
+    g_return_val_if_fail(node != NULL, 0);
+
+    size = sizeof(RestXmlNode) + 2 * OVIRT_HASH_TABLE_SIZE;
+    if (node->content != NULL) {
+        size += strlen(node->content) + 1;
+    }
+
+    g_hash_table_iter_init(&iter, node->attrs);
+    while (g_hash_table_iter_next(&iter, NULL, &value)) {
+        size += OVIRT_HASH_TABLE_ENTRY_SIZE + strlen(value) + 1;
+    }
+
+    g_hash_table_iter_init(&iter, node->children);
+    while (g_hash_table_iter_next(&iter, NULL, &value)) {
+        RestXmlNode *child;
+
+        size += OVIRT_HASH_TABLE_ENTRY_SIZE;
+        for (child = value; child != NULL; child = child->next) {
+            size += ovirt_rest_xml_node_get_size(child);
+        }
+    }
+
+    return size;
+}
+
+/* OvirtXmlElement tables are compiled the first time they are used: the
+ * GParamSpec of each property is looked up once, paths are split in
+ * interned components which can be used directly as keys of
+ * RestXmlNode::children, and enum classes are kept around. Tables are
+ * identified by their address, so they must be static.
+ */
+typedef enum {
+    OVIRT_XML_BINDING_BASIC,
+    OVIRT_XML_BINDING_ENUM,
+    OVIRT_XML_BINDING_RESOURCE,
+    OVIRT_XML_BINDING_STRV,
+    OVIRT_XML_BINDING_BYTE_ARRAY,
+} OvirtXmlBindingKind;
+
+typedef struct {
+    GParamSpec *pspec;
+    /* Class whose set_property() handles @pspec, NULL if
+     * g_object_set_property() has to be used */
+    GObjectClass *owner_class;
+    OvirtXmlBindingKind kind;
+    const char **path;
+    const char *attr;
+    GEnumClass *enum_class;
+} OvirtXmlBinding;
+
+typedef struct {
+    GType type;
+    guint n_bindings;
+    OvirtXmlBinding *bindings;
+} OvirtXmlBindings;
+
+static GMutex ovirt_xml_bindings_lock;
+/* const OvirtXmlElement * -> OvirtXmlBindings, never freed */
+static GHashTable *ovirt_xml_bindings;
+
+
+static OvirtXmlBindings *
+ovirt_xml_bindings_compile(GObjectClass *klass, const OvirtXmlElement *elements)
+{
+    OvirtXmlBindings *bindings;
+    guint i;
+
+    bindings = g_new0(OvirtXmlBindings, 1);
+    bindings->type = G_OBJECT_CLASS_TYPE(klass);
+    while (elements[bindings->n_bindings].xml_path != NULL) {
+        bindings->n_bindings++;
+    }
+    bindings->bindings = g_new0(OvirtXmlBinding, bindings->n_bindings);
+
+    for (i = 0; i < bindings->n_bindings; i++) {
+        OvirtXmlBinding *binding = &bindings->bindings[i];
+        GType type;
+        GStrv pathv;
+        guint j;
+
+        binding->pspec = g_object_class_find_property(klass, elements[i].prop_name);
+        if (binding->pspec == NULL) {
+            g_critical("Could not find property '%s' in %s",
+                       elements[i].prop_name, G_OBJECT_CLASS_NAME(klass));
+            continue;
+        }
+        if (!G_TYPE_IS_INTERFACE(binding->pspec->owner_type)) {
+            binding->owner_class = g_type_class_ref(binding->pspec->owner_type);
+        }
+
+        type = binding->pspec->value_type;
+        if (g_type_is_a(type, OVIRT_TYPE_RESOURCE)) {
+            binding->kind = OVIRT_XML_BINDING_RESOURCE;
+        } else if (g_type_is_a(type, G_TYPE_STRV)) {
+            binding->kind = OVIRT_XML_BINDING_STRV;
+        } else if (G_TYPE_IS_ENUM(type)) {
+            binding->kind = OVIRT_XML_BINDING_ENUM;
+            binding->enum_class = g_type_class_ref(type);
+        } else if (g_type_is_a(type, G_TYPE_BYTE_ARRAY)) {
+            binding->kind = OVIRT_XML_BINDING_BYTE_ARRAY;
+        } else {
+            binding->kind = OVIRT_XML_BINDING_BASIC;
+        }
+
+        pathv = g_strsplit(elements[i].xml_path, "/", -1);
+        binding->path = g_new0(const char *, g_strv_length(pathv) + 1);
+        for (j = 0; pathv[j] != NULL; j++) {
+            binding->path[j] = g_intern_string(pathv[j]);
+        }
+        g_strfreev(pathv);
+        binding->attr = g_intern_string(elements[i].xml_attr);
+    }
+
+    return bindings;
+}
+
+
+static const OvirtXmlBindings *
+ovirt_xml_bindings_get(GObject *object, const OvirtXmlElement *elements)
+{
+    OvirtXmlBindings *bindings;
+
+    g_mutex_lock(&ovirt_xml_bindings_lock);
+    if (ovirt_xml_bindings == NULL) {
+        ovirt_xml_bindings = g_hash_table_new(g_direct_hash, g_direct_equal);
+    }
+    bindings = g_hash_table_lookup(ovirt_xml_bindings, elements);
+    if (bindings == NULL) {
+        bindings = ovirt_xml_bindings_compile(G_OBJECT_GET_CLASS(object), elements);
+        g_hash_table_insert(ovirt_xml_bindings, (gpointer)elements, bindings);
+    }
+    g_mutex_unlock(&ovirt_xml_bindings_lock);
+
+    g_warn_if_fail(g_type_is_a(G_OBJECT_TYPE(object), bindings->type));
+
+    return bindings;
+}
+
+
+/* @path components are interned strings. Nodes are usually direct
+ * children of their parent and are then found with a single hash table
+ * lookup, rest_xml_node_find() is only needed for deeper descendants. */
+static RestXmlNode *
+ovirt_rest_xml_node_find_path(RestXmlNode *node, const char **path)
+{
+    for (; *path != NULL; path++) {
+        RestXmlNode *child;
+
+        child = g_hash_table_lookup(node->children, *path);
+        if (child == NULL) {
+            child = rest_xml_node_find(node, *path);
+        }
+        if (child == NULL) {
+            return NULL;
+        }
+        node = child;
+    }
+
+    return node;
 }
 
 static GStrv
-ovirt_rest_xml_node_get_str_array_from_path(RestXmlNode *node, const char *path, const char *attr)
+ovirt_rest_xml_node_get_str_array(RestXmlNode *node, const char *attr)
 {
     GArray *array;
     GHashTableIter iter;
     gpointer sub_node;
 
-    node = ovirt_rest_xml_node_find(node, path);
-    if (node == NULL)
-        return NULL;
-
     array = g_array_new(TRUE, FALSE, sizeof(gchar *));
 
     g_hash_table_iter_init(&iter, node->children);
@@ -171,83 +649,257 @@ _set_property_value_from_basic_type(GValue *value,
 }
 
 static gboolean
-_set_property_value_from_type(GValue *value,
-                              GParamSpec *prop,
-                              const char *path,
-                              const char *attr,
-                              RestXmlNode *node)
+_set_property_value_from_binding(GValue *value,
+                                 const OvirtXmlBinding *binding,
+                                 RestXmlNode *node)
 {
-    gboolean ret = TRUE;
     const char *value_str;
-    GType type = prop->value_type;
+    GType type = binding->pspec->value_type;
 
     /* These types do not require a value associated */
-    if (g_type_is_a(type, OVIRT_TYPE_RESOURCE)) {
+    if (binding->kind == OVIRT_XML_BINDING_RESOURCE) {
         OvirtResource *resource_value = ovirt_resource_new_from_xml(type, node, NULL);
-        g_value_set_object(value, resource_value);
-        goto end;
-    } else if (g_type_is_a(type, G_TYPE_STRV)) {
-        GStrv strv_value = ovirt_rest_xml_node_get_str_array_from_path(node, path, attr);
-        if (strv_value == NULL) {
-            ret = FALSE;
-            goto end;
-        }
+        g_value_take_object(value, resource_value);
+        return TRUE;
+    }
 
-        g_value_take_boxed(value, strv_value);
-        goto end;
+    node = ovirt_rest_xml_node_find_path(node, binding->path);
+    if (node == NULL)
+        return FALSE;
+
+    if (binding->kind == OVIRT_XML_BINDING_STRV) {
+        g_value_take_boxed(value, ovirt_rest_xml_node_get_str_array(node, binding->attr));
+        return TRUE;
     }
 
-    if (attr != NULL)
-        value_str = ovirt_rest_xml_node_get_attr_from_path(node, path, attr);
+    if (binding->attr != NULL)
+        value_str = rest_xml_node_get_attr(node, binding->attr);
     else
-        value_str = ovirt_rest_xml_node_get_content_from_path(node, path);
+        value_str = node->content;
 
     /* All other types require valid value_str */
     if (value_str == NULL)
         return FALSE;
 
-    if (G_TYPE_IS_ENUM(type)) {
-        GParamSpecEnum *enum_prop = G_PARAM_SPEC_ENUM(prop);
-        int enum_value = ovirt_utils_genum_get_value(type, value_str, enum_prop->default_value);
-        g_value_set_enum(value, enum_value);
-        goto end;
-    } else if (g_type_is_a(type, G_TYPE_BYTE_ARRAY)) {
-        GByteArray *array = g_byte_array_new_take((guchar *)g_strdup(value_str), strlen(value_str));
+    switch (binding->kind) {
+    case OVIRT_XML_BINDING_ENUM: {
+        GEnumValue *enum_value = g_enum_get_value_by_nick(binding->enum_class, value_str);
+        if (enum_value == NULL) {
+            GParamSpecEnum *enum_prop = G_PARAM_SPEC_ENUM(binding->pspec);
+            g_critical("Unknown value '%s' for enum %s", value_str, g_type_name(type));
+            g_value_set_enum(value, enum_prop->default_value);
+        } else {
+            g_value_set_enum(value, enum_value->value);
+        }
+        return TRUE;
+    }
+    case OVIRT_XML_BINDING_BYTE_ARRAY: {
+        GByteArray *array = ovirt_utils_byte_array_new_shared((const guint8 *)value_str,
+                                                              strlen(value_str));
         g_value_take_boxed(value, array);
-        goto end;
+        return TRUE;
+    }
+    default:
+        return _set_property_value_from_basic_type(value, type, value_str);
     }
+}
 
-    ret = _set_property_value_from_basic_type(value, type, value_str);
+/* Same as g_object_set_property(), without looking up the property by
+ * name */
+static void
+ovirt_xml_binding_set_property(GObject *object,
+                               const OvirtXmlBinding *binding,
+                               GValue *value)
+{
+    GParamSpec *pspec = binding->pspec;
 
-end:
-    return ret;
+    if (binding->owner_class == NULL) {
+        g_object_set_property(object, pspec->name, value);
+        return;
+    }
+
+    if (g_param_value_validate(pspec, value)) {
+        g_warning("Invalid value for property '%s' of type '%s'",
+                  pspec->name, G_OBJECT_TYPE_NAME(object));
+        return;
+    }
+    binding->owner_class->set_property(object, pspec->param_id, value, pspec);
+    if ((pspec->flags & G_PARAM_EXPLICIT_NOTIFY) == 0) {
+        g_object_notify_by_pspec(object, pspec);
+    }
 }
 
 gboolean
 ovirt_rest_xml_node_parse(RestXmlNode *node,
                           GObject *object,
-                          OvirtXmlElement *elements)
+                          const OvirtXmlElement *elements)
 {
+    const OvirtXmlBindings *bindings;
+    guint i;
+
     g_return_val_if_fail(G_IS_OBJECT(object), FALSE);
     g_return_val_if_fail(elements != NULL, FALSE);
 
-    for (;elements->xml_path != NULL; elements++) {
-        GValue value = { 0, };
-        GParamSpec *prop;
+    bindings = ovirt_xml_bindings_get(object, elements);
 
-        prop = g_object_class_find_property(G_OBJECT_GET_CLASS(object), elements->prop_name);
-        g_return_val_if_fail(prop != NULL, FALSE);
+    g_object_freeze_notify(object);
+    for (i = 0; i < bindings->n_bindings; i++) {
+        const OvirtXmlBinding *binding = &bindings->bindings[i];
+        GValue value = G_VALUE_INIT;
 
-        g_value_init(&value, prop->value_type);
-        if (_set_property_value_from_type(&value, prop, elements->xml_path, elements->xml_attr, node))
-            g_object_set_property(object, elements->prop_name, &value);
+        if (binding->pspec == NULL) {
+            continue;
+        }
+        g_value_init(&value, binding->pspec->value_type);
+        if (_set_property_value_from_binding(&value, binding, node))
+            ovirt_xml_binding_set_property(object, binding, &value);
         g_value_unset(&value);
     }
+    g_object_thaw_notify(object);
 
     return TRUE;
 }
 
 
+#define OVIRT_HASH_OFFSET G_GUINT64_CONSTANT(14695981039346656037)
+#define OVIRT_HASH_PRIME G_GUINT64_CONSTANT(1099511628211)
+
+/* FNV-1a, the string terminator is hashed too so that ("ab", "c") and
+ * ("a", "bc") do not collide */
+static guint64 ovirt_hash_string(guint64 hash, const char *str)
+{
+    if (str != NULL) {
+        for (; *str != '\0'; str++) {
+            hash ^= (guchar)*str;
+            hash *= OVIRT_HASH_PRIME;
+        }
+    }
+    hash ^= (str != NULL) ? 0xff : 0xfe;
+    hash *= OVIRT_HASH_PRIME;
+
+    return hash;
+}
+
+static guint64 ovirt_hash_guint64(guint64 hash, guint64 value)
+{
+    guint i;
+
+    for (i = 0; i < sizeof(value); i++) {
+        hash ^= (value >> (i * 8)) & 0xff;
+        hash *= OVIRT_HASH_PRIME;
+    }
+
+    return hash;
+}
+
+/* Computes a hash of @node and of its descendants (but not of its
+ * siblings) which only depends on the content of the XML tree: attributes
+ * and children with different names are combined regardless of the order
+ * in which they are stored in their hash tables, while the order of
+ * children with the same name is significant.
+ */
+G_GNUC_INTERNAL guint64
+ovirt_rest_xml_node_hash(RestXmlNode *node)
+{
+    GHashTableIter iter;
+    gpointer key;
+    gpointer value;
+    guint64 hash;
+    guint64 attrs_hash = 0;
+    guint64 children_hash = 0;
+
+    g_return_val_if_fail(node != NULL, 0);
+
+    hash = ovirt_hash_string(OVIRT_HASH_OFFSET, node->name);
+    hash = ovirt_hash_string(hash, node->content);
+
+    g_hash_table_iter_init(&iter, node->attrs);
+    while (g_hash_table_iter_next(&iter, &key, &value)) {
+        attrs_hash += ovirt_hash_string(ovirt_hash_string(OVIRT_HASH_OFFSET, key),
+                                        value);
+    }
+
+    g_hash_table_iter_init(&iter, node->children);
+    while (g_hash_table_iter_next(&iter, NULL, &value)) {
+        RestXmlNode *child;
+        guint64 siblings_hash = OVIRT_HASH_OFFSET;
+
+        for (child = value; child != NULL; child = child->next) {
+            siblings_hash = ovirt_hash_guint64(siblings_hash,
+                                               ovirt_rest_xml_node_hash(child));
+        }
+        children_hash += siblings_hash;
+    }
+
+    hash = ovirt_hash_guint64(hash, attrs_hash);
+    hash = ovirt_hash_guint64(hash, children_hash);
+
+    return hash;
+}
+
+
+/* Returns TRUE when @node1 and @node2 have the same content, using the same
+ * definition as ovirt_rest_xml_node_hash() */
+G_GNUC_INTERNAL gboolean
+ovirt_rest_xml_node_equal(RestXmlNode *node1, RestXmlNode *node2)
+{
+    GHashTableIter iter;
+    gpointer key;
+    gpointer value;
+
+    g_return_val_if_fail(node1 != NULL, FALSE);
+    g_return_val_if_fail(node2 != NULL, FALSE);
+
+    if ((g_strcmp0(node1->name, node2->name) != 0) ||
+        (g_strcmp0(node1->content, node2->content) != 0) ||
+        (g_hash_table_size(node1->attrs) != g_hash_table_size(node2->attrs)) ||
+        (g_hash_table_size(node1->children) != g_hash_table_size(node2->children))) {
+        return FALSE;
+    }
+
+    g_hash_table_iter_init(&iter, node1->attrs);
+    while (g_hash_table_iter_next(&iter, &key, &value)) {
+        if (g_strcmp0(value, g_hash_table_lookup(node2->attrs, key)) != 0) {
+            return FALSE;
+        }
+    }
+
+    g_hash_table_iter_init(&iter, node1->children);
+    while (g_hash_table_iter_next(&iter, &key, &value)) {
+        RestXmlNode *child1;
+        RestXmlNode *child2;
+
+        child2 = g_hash_table_lookup(node2->children, key);
+        for (child1 = value; (child1 != NULL) && (child2 != NULL);
+             child1 = child1->next, child2 = child2->next) {
+            if (!ovirt_rest_xml_node_equal(child1, child2)) {
+                return FALSE;
+            }
+        }
+        if ((child1 != NULL) || (child2 != NULL)) {
+            return FALSE;
+        }
+    }
+
+    return TRUE;
+}
+
+
+/* Enum classes are never unloaded once referenced, peeking them avoids
+ * taking and dropping a reference on each lookup */
+static GEnumClass *
+ovirt_utils_genum_get_class(GType enum_type)
+{
+    GEnumClass *enum_class;
+
+    enum_class = g_type_class_peek(enum_type);
+    if (enum_class == NULL) {
+        enum_class = g_type_class_ref(enum_type);
+    }
+
+    return enum_class;
+}
+
 /* These 2 functions come from
  * libvirt-glib/libvirt-gconfig/libvirt-gconfig-helpers.c
  * Copyright (C) 2010, 2011 Red Hat, Inc.
@@ -260,9 +912,8 @@ ovirt_utils_genum_get_nick (GType enum_type, gint value)
 
     g_return_val_if_fail (G_TYPE_IS_ENUM (enum_type), NULL);
 
-    enum_class = g_type_class_ref(enum_type);
+    enum_class = ovirt_utils_genum_get_class(enum_type);
     enum_value = g_enum_get_value(enum_class, value);
-    g_type_class_unref(enum_class);
 
     if (enum_value != NULL)
         return enum_value->value_nick;
@@ -280,9 +931,8 @@ ovirt_utils_genum_get_value (GType enum_type, const char *nick,
     g_return_val_if_fail(G_TYPE_IS_ENUM(enum_type), default_value);
     g_return_val_if_fail(nick != NULL, default_value);
 
-    enum_class = g_type_class_ref(enum_type);
+    enum_class = ovirt_utils_genum_get_class(enum_type);
     enum_value = g_enum_get_value_by_nick(enum_class, nick);
-    g_type_class_unref(enum_class);
 
     if (enum_value != NULL)
         return enum_value->value;
@@ -397,3 +1047,117 @@ G_GNUC_INTERNAL gboolean g_object_set_guint_property_from_xml(GObject *g_object,
     }
     return FALSE;
 }
+
+
+/* Replaces the string in @field, which must be NULL or have been set by
+ * this function, with an interned copy of @value. Strings such as hrefs
+ * of the cluster or host of a resource are repeated across many objects,
+ * interning them makes these objects share a single copy. */
+G_GNUC_INTERNAL void
+ovirt_utils_set_interned_string(char **field, const char *value)
+{
+    char *old_value = *field;
+
+    if (value != NULL) {
+        *field = g_ref_string_new_intern(value);
+    } else {
+        *field = NULL;
+    }
+    if (old_value != NULL) {
+        g_ref_string_release(old_value);
+    }
+}
+
+
+/* Distinct certificates are few, but each VM display holds one. The pool
+ * is cleared once it holds that many entries so that it does not grow
+ * forever; arrays which are still in use are not affected. */
+#define OVIRT_BYTE_ARRAY_POOL_MAX_SIZE 64
+
+static GMutex ovirt_byte_array_pool_lock;
+/* GBytes wrapping the data of a GByteArray -> the GByteArray, the GBytes
+ * holds a reference on the GByteArray */
+static GHashTable *ovirt_byte_array_pool;
+
+/* Returns a GByteArray holding a copy of @data. Arrays with the same
+ * content are shared, so they must not be modified. As with strings, the
+ * data is followed by a nul byte which is not counted in the array
+ * length. */
+G_GNUC_INTERNAL GByteArray *
+ovirt_utils_byte_array_new_shared(const guint8 *data, gsize length)
+{
+    GByteArray *array;
+    GBytes *key;
+
+    g_mutex_lock(&ovirt_byte_array_pool_lock);
+    if (ovirt_byte_array_pool == NULL) {
+        ovirt_byte_array_pool = g_hash_table_new_full(g_bytes_hash, g_bytes_equal,
+                                                      (GDestroyNotify)g_bytes_unref,
+                                                      NULL);
+    }
+
+    key = g_bytes_new_static(data, length);
+    array = g_hash_table_lookup(ovirt_byte_array_pool, key);
+    g_bytes_unref(key);
+    if (array != NULL) {
+        g_byte_array_ref(array);
+        g_mutex_unlock(&ovirt_byte_array_pool_lock);
+        return array;
+    }
+
+    if (g_hash_table_size(ovirt_byte_array_pool) >= OVIRT_BYTE_ARRAY_POOL_MAX_SIZE) {
+        g_hash_table_remove_all(ovirt_byte_array_pool);
+    }
+
+    array = g_byte_array_sized_new(length + 1);
+    g_byte_array_append(array, data, length);
+    g_byte_array_append(array, (const guint8 *)"", 1);
+    g_byte_array_set_size(array, length);
+
+    key = g_bytes_new_with_free_func(array->data, length,
+                                     (GDestroyNotify)g_byte_array_unref,
+                                     g_byte_array_ref(array));
+    g_hash_table_insert(ovirt_byte_array_pool, key, array);
+    g_mutex_unlock(&ovirt_byte_array_pool_lock);
+
+    return array;
+}
+
+
+/* Returns a copy of @href with the @name=@value query parameter appended,
+ * or a plain copy of @href when @value is NULL or empty */
+G_GNUC_INTERNAL char *
+ovirt_utils_href_add_query_param(const char *href,
+                                 const char *name,
+                                 const char *value)
+{
+    char *escaped_value;
+    char *new_href;
+
+    g_return_val_if_fail(href != NULL, NULL);
+    g_return_val_if_fail(name != NULL, NULL);
+
+    if ((value == NULL) || (*value == '\0')) {
+        return g_strdup(href);
+    }
+
+    escaped_value = g_uri_escape_string(value, ",", FALSE);
+    new_href = g_strdup_printf("%s%c%s=%s", href,
+                               (strchr(href, '?') != NULL) ? '&' : '?',
+                               name, escaped_value);
+    g_free(escaped_value);
+
+    return new_href;
+}
+
+
+/* Returns a copy of @href requesting all the attributes of the resources
+ * when @all_content is TRUE. The query parameter is used rather than the
+ * All-Content header so that responses of both kinds are cached and
+ * shared separately. */
+G_GNUC_INTERNAL char *
+ovirt_utils_href_add_all_content(const char *href, gboolean all_content)
+{
+    return ovirt_utils_href_add_query_param(href, "all_content",
+                                            all_content ? "true" : NULL);
+}
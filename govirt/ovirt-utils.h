@@ -36,9 +36,23 @@ struct _OvirtXmlElement
 };
 
 RestXmlNode *ovirt_rest_xml_node_from_call(RestProxyCall *call);
+RestXmlNode *ovirt_rest_xml_node_from_call_full(RestProxyCall *call,
+                                                const char *root_name);
+RestXmlNode *ovirt_rest_xml_node_from_data(const char *data, gssize length);
+RestXmlNode *ovirt_rest_xml_node_from_json_data(const char *data,
+                                                gssize length,
+                                                const char *root_name);
+RestXmlNode *ovirt_rest_xml_node_from_response(const char *data,
+                                               gssize length,
+                                               const char *href,
+                                               const char *root_name);
+char *ovirt_rest_xml_node_to_string(RestXmlNode *node);
+gsize ovirt_rest_xml_node_get_size(RestXmlNode *node);
 gboolean ovirt_rest_xml_node_parse(RestXmlNode *node,
                                    GObject *object,
-                                   OvirtXmlElement *elements);
+                                   const OvirtXmlElement *elements);
+guint64 ovirt_rest_xml_node_hash(RestXmlNode *node);
+gboolean ovirt_rest_xml_node_equal(RestXmlNode *node1, RestXmlNode *node2);
 gboolean ovirt_utils_gerror_from_xml_fault(RestXmlNode *root, GError **error);
 gboolean g_object_set_guint_property_from_xml(GObject *g_object,
                                                    RestXmlNode *node,
@@ -51,6 +65,12 @@ int ovirt_utils_genum_get_value (GType enum_type, const char *nick,
 gboolean ovirt_utils_guint64_from_string(const char *value_str, guint64 *value);
 gboolean ovirt_utils_guint_from_string(const char *value_str, guint *value);
 gboolean ovirt_utils_boolean_from_string(const char *value);
+void ovirt_utils_set_interned_string(char **field, const char *value);
+GByteArray *ovirt_utils_byte_array_new_shared(const guint8 *data, gsize length);
+char *ovirt_utils_href_add_query_param(const char *href,
+                                       const char *name,
+                                       const char *value);
+char *ovirt_utils_href_add_all_content(const char *href, gboolean all_content);
 
 G_END_DECLS
 
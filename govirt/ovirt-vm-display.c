@@ -89,7 +89,21 @@ static void ovirt_vm_display_get_property(GObject *object,
         g_value_set_uint(value, display->priv->expiry);
         break;
     case PROP_CA_CERT:
-        g_value_set_boxed(value, display->priv->ca_cert);
+        /* The array may be shared with other displays, callers get
+         * their own copy */
+        if (display->priv->ca_cert != NULL) {
+            GByteArray *ca_cert;
+
+            ca_cert = g_byte_array_sized_new(display->priv->ca_cert->len + 1);
+            g_byte_array_append(ca_cert, display->priv->ca_cert->data,
+                                display->priv->ca_cert->len);
+            /* Same trailing nul byte as in the shared array */
+            g_byte_array_append(ca_cert, (const guint8 *)"", 1);
+            g_byte_array_set_size(ca_cert, display->priv->ca_cert->len);
+            g_value_take_boxed(value, ca_cert);
+        } else {
+            g_value_set_boxed(value, NULL);
+        }
         break;
     case PROP_HOST_SUBJECT:
         g_value_set_string(value, display->priv->host_subject);
@@ -146,8 +160,8 @@ static void ovirt_vm_display_set_property(GObject *object,
         display->priv->ca_cert = g_value_dup_boxed(value);
         break;
     case PROP_HOST_SUBJECT:
-        g_free(display->priv->host_subject);
-        display->priv->host_subject = g_value_dup_string(value);
+        ovirt_utils_set_interned_string(&display->priv->host_subject,
+                                        g_value_get_string(value));
         break;
     case PROP_SMARTCARD:
         display->priv->smartcard = g_value_get_boolean(value);
@@ -156,8 +170,8 @@ static void ovirt_vm_display_set_property(GObject *object,
         display->priv->allow_override = g_value_get_boolean(value);
         break;
     case PROP_PROXY_URL:
-        g_free(display->priv->proxy_url);
-        display->priv->proxy_url = g_value_dup_string(value);
+        ovirt_utils_set_interned_string(&display->priv->proxy_url,
+                                        g_value_get_string(value));
         break;
     default:
         G_OBJECT_WARN_INVALID_PROPERTY_ID(object, prop_id, pspec);
@@ -170,8 +184,8 @@ static void ovirt_vm_display_finalize(GObject *object)
 
     g_free(display->priv->address);
     g_free(display->priv->ticket);
-    g_free(display->priv->host_subject);
-    g_free(display->priv->proxy_url);
+    g_clear_pointer(&display->priv->host_subject, g_ref_string_release);
+    g_clear_pointer(&display->priv->proxy_url, g_ref_string_release);
     if (display->priv->ca_cert != NULL) {
         g_byte_array_unref(display->priv->ca_cert);
     }
@@ -303,7 +317,7 @@ OvirtVmDisplay *ovirt_vm_display_new(void)
 static gboolean ovirt_vm_display_set_from_xml(OvirtVmDisplay *display, RestXmlNode *node)
 {
     OvirtVmDisplayType type;
-    OvirtXmlElement display_elements[] = {
+    static const OvirtXmlElement display_elements[] = {
         { .prop_name = "type",
           .xml_path = "type",
         },
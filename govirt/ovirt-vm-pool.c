@@ -60,6 +60,8 @@ static void ovirt_vm_pool_get_property(GObject *object,
 {
     OvirtVmPool *vm_pool = OVIRT_VM_POOL(object);
 
+    ovirt_resource_materialize(OVIRT_RESOURCE(object));
+
     switch (prop_id) {
     case PROP_SIZE:
         g_value_set_uint(value, vm_pool->priv->size);
@@ -82,6 +84,8 @@ static void ovirt_vm_pool_set_property(GObject *object,
 {
     OvirtVmPool *vm_pool = OVIRT_VM_POOL(object);
 
+    ovirt_resource_materialize(OVIRT_RESOURCE(object));
+
     switch (prop_id) {
     case PROP_SIZE:
         vm_pool->priv->size = g_value_get_uint(value);
@@ -23,6 +23,7 @@
 #ifndef __OVIRT_VM_PRIVATE_H__
 #define __OVIRT_VM_PRIVATE_H__
 
+#include <govirt/ovirt-resource-private.h>
 #include <govirt/ovirt-vm.h>
 #include <rest/rest-xml-node.h>
 
@@ -42,6 +43,7 @@ typedef enum {
 
 gboolean ovirt_vm_refresh_from_xml(OvirtVm *vm, RestXmlNode *node);
 OvirtVm *ovirt_vm_new_from_xml(RestXmlNode *node, GError **error);
+ActionResponseParser ovirt_vm_get_action_response_parser(const char *action);
 
 G_END_DECLS
 
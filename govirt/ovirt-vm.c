@@ -43,6 +43,9 @@ struct _OvirtVmPrivate {
     gchar *host_id;
     gchar *cluster_href;
     gchar *cluster_id;
+    /* Set when the server inlined the host or cluster description */
+    OvirtHost *host;
+    OvirtCluster *cluster;
 } ;
 
 G_DEFINE_TYPE_WITH_PRIVATE(OvirtVm, ovirt_vm, OVIRT_TYPE_RESOURCE);
@@ -65,27 +68,30 @@ enum {
     PROP_CLUSTER_ID,
 };
 
-static char *ensure_href_from_id(const char *id,
-                                 const char *path)
+static void ensure_href_from_id(char **href,
+                                const char *id,
+                                const char *path)
 {
-    if (id == NULL)
-        return NULL;
+    char *value;
+
+    if (*href != NULL || id == NULL)
+        return;
 
-    return g_strdup_printf("%s/%s", path, id);
+    value = g_strdup_printf("%s/%s", path, id);
+    ovirt_utils_set_interned_string(href, value);
+    g_free(value);
 }
 
 static const char *get_host_href(OvirtVm *vm)
 {
-    if (vm->priv->host_href == NULL)
-        vm->priv->host_href = ensure_href_from_id(vm->priv->host_id, "/ovirt-engine/api/hosts");
+    ensure_href_from_id(&vm->priv->host_href, vm->priv->host_id, "/ovirt-engine/api/hosts");
 
     return vm->priv->host_href;
 }
 
 static const char *get_cluster_href(OvirtVm *vm)
 {
-    if (vm->priv->cluster_href == NULL)
-        vm->priv->cluster_href = ensure_href_from_id(vm->priv->cluster_id, "/ovirt-engine/api/clusters");
+    ensure_href_from_id(&vm->priv->cluster_href, vm->priv->cluster_id, "/ovirt-engine/api/clusters");
 
     return vm->priv->cluster_href;
 }
@@ -97,6 +103,8 @@ static void ovirt_vm_get_property(GObject *object,
 {
     OvirtVm *vm = OVIRT_VM(object);
 
+    ovirt_resource_materialize(OVIRT_RESOURCE(object));
+
     switch (prop_id) {
     case PROP_STATE:
         g_value_set_enum(value, vm->priv->state);
@@ -128,6 +136,8 @@ static void ovirt_vm_set_property(GObject *object,
 {
     OvirtVm *vm = OVIRT_VM(object);
 
+    ovirt_resource_materialize(OVIRT_RESOURCE(object));
+
     switch (prop_id) {
     case PROP_STATE:
         vm->priv->state = g_value_get_enum(value);
@@ -137,20 +147,16 @@ static void ovirt_vm_set_property(GObject *object,
         vm->priv->display = g_value_dup_object(value);
         break;
     case PROP_HOST_HREF:
-        g_free(vm->priv->host_href);
-        vm->priv->host_href = g_value_dup_string(value);
+        ovirt_utils_set_interned_string(&vm->priv->host_href, g_value_get_string(value));
         break;
     case PROP_HOST_ID:
-        g_free(vm->priv->host_id);
-        vm->priv->host_id = g_value_dup_string(value);
+        ovirt_utils_set_interned_string(&vm->priv->host_id, g_value_get_string(value));
         break;
     case PROP_CLUSTER_HREF:
-        g_free(vm->priv->cluster_href);
-        vm->priv->cluster_href = g_value_dup_string(value);
+        ovirt_utils_set_interned_string(&vm->priv->cluster_href, g_value_get_string(value));
         break;
     case PROP_CLUSTER_ID:
-        g_free(vm->priv->cluster_id);
-        vm->priv->cluster_id = g_value_dup_string(value);
+        ovirt_utils_set_interned_string(&vm->priv->cluster_id, g_value_get_string(value));
         break;
     default:
         G_OBJECT_WARN_INVALID_PROPERTY_ID(object, prop_id, pspec);
@@ -164,15 +170,71 @@ static void ovirt_vm_dispose(GObject *object)
 
     g_clear_object(&vm->priv->cdroms);
     g_clear_object(&vm->priv->display);
-    g_clear_pointer(&vm->priv->host_href, g_free);
-    g_clear_pointer(&vm->priv->host_id, g_free);
-    g_clear_pointer(&vm->priv->cluster_href, g_free);
-    g_clear_pointer(&vm->priv->cluster_id, g_free);
+    g_clear_pointer(&vm->priv->host_href, g_ref_string_release);
+    g_clear_pointer(&vm->priv->host_id, g_ref_string_release);
+    g_clear_pointer(&vm->priv->cluster_href, g_ref_string_release);
+    g_clear_pointer(&vm->priv->cluster_id, g_ref_string_release);
+    g_clear_object(&vm->priv->host);
+    g_clear_object(&vm->priv->cluster);
 
     G_OBJECT_CLASS(ovirt_vm_parent_class)->dispose(object);
 }
 
 
+/* Related objects are only references holding an id and an href, unless
+ * they were inlined with the 'follow' parameter */
+static RestXmlNode *ovirt_vm_get_inlined_node(RestXmlNode *node,
+                                              const char *name)
+{
+    RestXmlNode *child;
+
+    child = g_hash_table_lookup(node->children, g_intern_string(name));
+    if ((child == NULL) || (g_hash_table_size(child->children) == 0)) {
+        return NULL;
+    }
+
+    return child;
+}
+
+
+/* Inlined objects are shared through the identity map of the proxy @vm
+ * was registered in. When @vm is not registered yet, they are shared when
+ * they are first looked up. */
+static void ovirt_vm_set_inlined_objects(OvirtVm *vm, RestXmlNode *node)
+{
+    RestXmlNode *child;
+    GError *error = NULL;
+
+    g_clear_object(&vm->priv->host);
+    g_clear_object(&vm->priv->cluster);
+
+    child = ovirt_vm_get_inlined_node(node, "host");
+    if (child != NULL) {
+        vm->priv->host = ovirt_host_new_from_xml(child, &error);
+        if (vm->priv->host == NULL) {
+            g_debug("Failed to parse inlined host: %s",
+                    (error != NULL) ? error->message : "");
+            g_clear_error(&error);
+        } else {
+            g_object_unref(ovirt_resource_share_related(OVIRT_RESOURCE(vm),
+                                                        (OvirtResource **)&vm->priv->host));
+        }
+    }
+    child = ovirt_vm_get_inlined_node(node, "cluster");
+    if (child != NULL) {
+        vm->priv->cluster = ovirt_cluster_new_from_xml(child, &error);
+        if (vm->priv->cluster == NULL) {
+            g_debug("Failed to parse inlined cluster: %s",
+                    (error != NULL) ? error->message : "");
+            g_clear_error(&error);
+        } else {
+            g_object_unref(ovirt_resource_share_related(OVIRT_RESOURCE(vm),
+                                                        (OvirtResource **)&vm->priv->cluster));
+        }
+    }
+}
+
+
 static gboolean ovirt_vm_init_from_xml(OvirtResource *resource,
                                        RestXmlNode *node,
                                        GError **error)
@@ -180,7 +242,7 @@ static gboolean ovirt_vm_init_from_xml(OvirtResource *resource,
     OvirtVmDisplay *display;
     RestXmlNode *display_node;
     OvirtResourceClass *parent_class;
-    OvirtXmlElement vm_elements[] = {
+    static const OvirtXmlElement vm_elements[] = {
         { .prop_name = "host-href",
           .xml_path = "host",
           .xml_attr = "href",
@@ -219,6 +281,8 @@ static gboolean ovirt_vm_init_from_xml(OvirtResource *resource,
     if (!ovirt_rest_xml_node_parse(node, G_OBJECT(resource), vm_elements))
         return FALSE;
 
+    ovirt_vm_set_inlined_objects(OVIRT_VM(resource), node);
+
     parent_class = OVIRT_RESOURCE_CLASS(ovirt_vm_parent_class);
 
     return parent_class->init_from_xml(resource, node, error);
@@ -374,13 +438,26 @@ gboolean ovirt_vm_stop(OvirtVm *vm, OvirtProxy *proxy, GError **error)
                                  NULL, error);
 }
 
+
+/* Returns the parser to use for the response to @action, NULL if checking
+ * the status of the action is enough */
+G_GNUC_INTERNAL
+ActionResponseParser ovirt_vm_get_action_response_parser(const char *action)
+{
+    if (g_strcmp0(action, "ticket") == 0) {
+        return parse_ticket_status;
+    }
+
+    return NULL;
+}
+
 static gboolean parse_ticket_status(RestXmlNode *root, OvirtResource *resource, GError **error)
 {
     OvirtVmDisplay *display;
     gchar *ticket = NULL;
     guint expiry = 0;
     gboolean ret = FALSE;
-    OvirtXmlElement ticket_elements[] = {
+    static const OvirtXmlElement ticket_elements[] = {
         { .prop_name = "ticket",
           .xml_path = "value",
         },
@@ -486,7 +563,11 @@ OvirtCollection *ovirt_vm_get_cdroms(OvirtVm *vm)
  * Gets a #OvirtHost representing the host the virtual machine belongs to.
  * This method does not initiate any network activity, the remote host must be
  * then be fetched using ovirt_resource_refresh() or
- * ovirt_resource_refresh_async().
+ * ovirt_resource_refresh_async(), unless "host" was part of the
+ * #OvirtResource:follow property when @vm was fetched, in which case the
+ * returned host is already fully initialized. When @vm was fetched
+ * through a collection, the returned host is the one shared by all the
+ * collections of its #OvirtProxy, see ovirt_proxy_get_resource().
  *
  * Return value: (transfer full): a #OvirtHost representing host the @vm
  * belongs to.
@@ -494,8 +575,16 @@ OvirtCollection *ovirt_vm_get_cdroms(OvirtVm *vm)
 OvirtHost *ovirt_vm_get_host(OvirtVm *vm)
 {
     g_return_val_if_fail(OVIRT_IS_VM(vm), NULL);
+
+    ovirt_resource_materialize(OVIRT_RESOURCE(vm));
     g_return_val_if_fail(vm->priv->host_id != NULL, NULL);
-    return ovirt_host_new_from_id(vm->priv->host_id, get_host_href(vm));
+    if (vm->priv->host != NULL)
+        return OVIRT_HOST(ovirt_resource_share_related(OVIRT_RESOURCE(vm),
+                                                       (OvirtResource **)&vm->priv->host));
+    return OVIRT_HOST(ovirt_resource_get_related(OVIRT_RESOURCE(vm),
+                                                 OVIRT_TYPE_HOST,
+                                                 vm->priv->host_id,
+                                                 get_host_href(vm)));
 }
 
 
@@ -506,7 +595,11 @@ OvirtHost *ovirt_vm_get_host(OvirtVm *vm)
  * Gets a #OvirtCluster representing the cluster the virtual machine belongs
  * to. This method does not initiate any network activity, the remote host must
  * be then be fetched using ovirt_resource_refresh() or
- * ovirt_resource_refresh_async().
+ * ovirt_resource_refresh_async(), unless "cluster" was part of the
+ * #OvirtResource:follow property when @vm was fetched, in which case the
+ * returned cluster is already fully initialized. When @vm was fetched
+ * through a collection, the returned cluster is the one shared by all the
+ * collections of its #OvirtProxy, see ovirt_proxy_get_resource().
  *
  * Return value: (transfer full): a #OvirtCluster representing cluster the @vm
  * belongs to.
@@ -514,6 +607,14 @@ OvirtHost *ovirt_vm_get_host(OvirtVm *vm)
 OvirtCluster *ovirt_vm_get_cluster(OvirtVm *vm)
 {
     g_return_val_if_fail(OVIRT_IS_VM(vm), NULL);
+
+    ovirt_resource_materialize(OVIRT_RESOURCE(vm));
     g_return_val_if_fail(vm->priv->cluster_id != NULL, NULL);
-    return ovirt_cluster_new_from_id(vm->priv->cluster_id, get_cluster_href(vm));
+    if (vm->priv->cluster != NULL)
+        return OVIRT_CLUSTER(ovirt_resource_share_related(OVIRT_RESOURCE(vm),
+                                                          (OvirtResource **)&vm->priv->cluster));
+    return OVIRT_CLUSTER(ovirt_resource_get_related(OVIRT_RESOURCE(vm),
+                                                    OVIRT_TYPE_CLUSTER,
+                                                    vm->priv->cluster_id,
+                                                    get_cluster_href(vm)));
 }
@@ -0,0 +1,273 @@
+/*
+ * ovirt-xml-stream.c: incremental parsing of oVirt collections
+ *
+ * Copyright (C) 2026 Red Hat, Inc.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library. If not, see
+ * <http://www.gnu.org/licenses/>.
+ */
+
+#include <config.h>
+
+#include <string.h>
+
+#include <glib/gi18n-lib.h>
+
+#include "ovirt-error.h"
+#include "ovirt-utils.h"
+#include "ovirt-xml-stream.h"
+
+/* OvirtXmlStream is fed a collection document (<vms><vm/><vm/>...</vms>)
+ * chunk by chunk. Only the subtree of the child element which is currently
+ * being parsed is kept in memory: once its closing tag is seen, it is
+ * handed to the node callback and freed. This keeps memory usage bounded by
+ * the size of a single resource rather than by the size of the whole
+ * collection.
+ */
+struct _OvirtXmlStream {
+    GMarkupParseContext *context;
+
+    const char *root_name;
+    const char *element_name;
+    OvirtXmlStreamNodeFunc func;
+    gpointer user_data;
+
+    guint depth;
+    gboolean failed;
+    GQueue open_nodes;
+    GString *text;
+
+    /* When the server replies with an error, the whole document is a
+     * <fault> element which we keep to build a GError from it */
+    RestXmlNode *fault;
+};
+
+
+static gboolean is_blank(const char *str)
+{
+    for (; *str != '\0'; str++) {
+        if (!g_ascii_isspace(*str))
+            return FALSE;
+    }
+
+    return TRUE;
+}
+
+
+static RestXmlNode *
+ovirt_xml_stream_node_new(RestXmlNode *parent,
+                          const char *element_name,
+                          const char **attribute_names,
+                          const char **attribute_values)
+{
+    RestXmlNode *node;
+    guint i;
+
+    node = rest_xml_node_add_child(parent, element_name);
+    /* rest_xml_node_add_attr() escapes the values it is given, while
+     * RestXmlParser stores them unescaped, set them directly so that
+     * nodes are identical whichever parser built them */
+    for (i = 0; attribute_names[i] != NULL; i++) {
+        g_hash_table_insert(node->attrs,
+                            g_strdup(attribute_names[i]),
+                            g_strdup(attribute_values[i]));
+    }
+
+    return node;
+}
+
+
+static void ovirt_xml_stream_start_element(G_GNUC_UNUSED GMarkupParseContext *context,
+                                           const char *element_name,
+                                           const char **attribute_names,
+                                           const char **attribute_values,
+                                           gpointer user_data,
+                                           GError **error)
+{
+    OvirtXmlStream *stream = user_data;
+    RestXmlNode *parent;
+    RestXmlNode *node;
+
+    stream->depth++;
+    g_string_truncate(stream->text, 0);
+
+    if (stream->depth == 1) {
+        if (strcmp(element_name, "fault") == 0) {
+            stream->fault = ovirt_xml_stream_node_new(NULL, element_name,
+                                                      attribute_names,
+                                                      attribute_values);
+            g_queue_push_head(&stream->open_nodes, stream->fault);
+        } else if (strcmp(element_name, stream->root_name) != 0) {
+            g_set_error(error, OVIRT_ERROR, OVIRT_ERROR_PARSING_FAILED,
+                        _("Got '%s' node, expected '%s'"), element_name,
+                        stream->root_name);
+        }
+        return;
+    }
+
+    parent = g_queue_peek_head(&stream->open_nodes);
+    if (parent == NULL) {
+        if ((stream->depth != 2) ||
+            (strcmp(element_name, stream->element_name) != 0)) {
+            /* Not something we are interested in, skip it */
+            return;
+        }
+    }
+
+    node = ovirt_xml_stream_node_new(parent, element_name,
+                                     attribute_names, attribute_values);
+    g_queue_push_head(&stream->open_nodes, node);
+}
+
+
+static void ovirt_xml_stream_end_element(G_GNUC_UNUSED GMarkupParseContext *context,
+                                         G_GNUC_UNUSED const char *element_name,
+                                         gpointer user_data,
+                                         GError **error)
+{
+    OvirtXmlStream *stream = user_data;
+    RestXmlNode *node;
+
+    stream->depth--;
+
+    node = g_queue_pop_head(&stream->open_nodes);
+    if (node == NULL) {
+        return;
+    }
+
+    if (!is_blank(stream->text->str)) {
+        g_free(node->content);
+        node->content = g_strdup(stream->text->str);
+    }
+    g_string_truncate(stream->text, 0);
+
+    if (!g_queue_is_empty(&stream->open_nodes) || (node == stream->fault)) {
+        return;
+    }
+
+    if (!stream->func(node, stream->user_data, error) && (*error == NULL)) {
+        g_set_error(error, OVIRT_ERROR, OVIRT_ERROR_PARSING_FAILED,
+                    _("Failed to parse '%s' node"), node->name);
+    }
+    rest_xml_node_unref(node);
+}
+
+
+static void ovirt_xml_stream_text(G_GNUC_UNUSED GMarkupParseContext *context,
+                                  const char *text,
+                                  gsize text_len,
+                                  gpointer user_data,
+                                  G_GNUC_UNUSED GError **error)
+{
+    OvirtXmlStream *stream = user_data;
+
+    if (g_queue_is_empty(&stream->open_nodes)) {
+        return;
+    }
+
+    g_string_append_len(stream->text, text, text_len);
+}
+
+
+static const GMarkupParser ovirt_xml_stream_parser = {
+    ovirt_xml_stream_start_element,
+    ovirt_xml_stream_end_element,
+    ovirt_xml_stream_text,
+    NULL,
+    NULL
+};
+
+
+OvirtXmlStream *ovirt_xml_stream_new(const char *root_name,
+                                     const char *element_name,
+                                     OvirtXmlStreamNodeFunc func,
+                                     gpointer user_data)
+{
+    OvirtXmlStream *stream;
+
+    g_return_val_if_fail(root_name != NULL, NULL);
+    g_return_val_if_fail(element_name != NULL, NULL);
+    g_return_val_if_fail(func != NULL, NULL);
+
+    stream = g_slice_new0(OvirtXmlStream);
+    stream->context = g_markup_parse_context_new(&ovirt_xml_stream_parser,
+                                                 G_MARKUP_TREAT_CDATA_AS_TEXT,
+                                                 stream, NULL);
+    stream->root_name = g_intern_string(root_name);
+    stream->element_name = g_intern_string(element_name);
+    stream->func = func;
+    stream->user_data = user_data;
+    stream->text = g_string_new(NULL);
+    g_queue_init(&stream->open_nodes);
+
+    return stream;
+}
+
+
+void ovirt_xml_stream_free(OvirtXmlStream *stream)
+{
+    RestXmlNode *node;
+
+    if (stream == NULL)
+        return;
+
+    g_markup_parse_context_free(stream->context);
+    /* Only the outermost open node owns the others */
+    node = g_queue_peek_tail(&stream->open_nodes);
+    if ((node != NULL) && (node != stream->fault)) {
+        rest_xml_node_unref(node);
+    }
+    g_queue_clear(&stream->open_nodes);
+    g_clear_pointer(&stream->fault, rest_xml_node_unref);
+    g_string_free(stream->text, TRUE);
+
+    g_slice_free(OvirtXmlStream, stream);
+}
+
+
+gboolean ovirt_xml_stream_feed(OvirtXmlStream *stream,
+                               const char *data,
+                               gsize len,
+                               GError **error)
+{
+    g_return_val_if_fail(stream != NULL, FALSE);
+    g_return_val_if_fail(!stream->failed, FALSE);
+
+    if (!g_markup_parse_context_parse(stream->context, data, len, error)) {
+        stream->failed = TRUE;
+        return FALSE;
+    }
+
+    return TRUE;
+}
+
+
+gboolean ovirt_xml_stream_end(OvirtXmlStream *stream, GError **error)
+{
+    g_return_val_if_fail(stream != NULL, FALSE);
+    g_return_val_if_fail(!stream->failed, FALSE);
+
+    if (!g_markup_parse_context_end_parse(stream->context, error)) {
+        stream->failed = TRUE;
+        return FALSE;
+    }
+
+    if (stream->fault != NULL) {
+        ovirt_utils_gerror_from_xml_fault(stream->fault, error);
+        stream->failed = TRUE;
+        return FALSE;
+    }
+
+    return TRUE;
+}
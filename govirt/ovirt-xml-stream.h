@@ -0,0 +1,50 @@
+/*
+ * ovirt-xml-stream.h: incremental parsing of oVirt collections
+ *
+ * Copyright (C) 2026 Red Hat, Inc.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library. If not, see
+ * <http://www.gnu.org/licenses/>.
+ */
+#ifndef __OVIRT_XML_STREAM_H__
+#define __OVIRT_XML_STREAM_H__
+
+#include <glib.h>
+#include <rest/rest-xml-node.h>
+
+G_BEGIN_DECLS
+
+typedef struct _OvirtXmlStream OvirtXmlStream;
+
+/* Called each time a complete @node has been parsed. @node is only valid
+ * during the call, callers must ref it if they need to keep it around.
+ * Returning FALSE aborts the parsing. */
+typedef gboolean (*OvirtXmlStreamNodeFunc)(RestXmlNode *node,
+                                           gpointer user_data,
+                                           GError **error);
+
+OvirtXmlStream *ovirt_xml_stream_new(const char *root_name,
+                                     const char *element_name,
+                                     OvirtXmlStreamNodeFunc func,
+                                     gpointer user_data);
+void ovirt_xml_stream_free(OvirtXmlStream *stream);
+gboolean ovirt_xml_stream_feed(OvirtXmlStream *stream,
+                               const char *data,
+                               gsize len,
+                               GError **error);
+gboolean ovirt_xml_stream_end(OvirtXmlStream *stream, GError **error);
+
+G_END_DECLS
+
+#endif /* __OVIRT_XML_STREAM_H__ */
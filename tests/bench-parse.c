@@ -0,0 +1,97 @@
+/* Copyright 2026 Red Hat, Inc. and/or its affiliates.
+ *
+ * Permission is hereby granted, free of charge, to any person
+ * obtaining a copy of this software and associated documentation files
+ * (the "Software"), to deal in the Software without restriction,
+ * including without limitation the rights to use, copy, modify, merge,
+ * publish, distribute, sublicense, and/or sell copies of the Software,
+ * and to permit persons to whom the Software is furnished to do so,
+ * subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ * NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS
+ * BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN
+ * ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+ * CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+/* Measures how long it takes to build an OvirtVm from an already parsed
+ * XML document, which is what dominates the cost of fetching large VM
+ * collections once the data has been received.
+ *
+ * Usage: bench-parse [ITERATIONS]
+ */
+#include <config.h>
+
+#include <govirt/govirt.h>
+#include <rest/rest-xml-parser.h>
+
+#include <stdlib.h>
+
+#define DEFAULT_ITERATIONS 20000
+
+int
+main(int argc, char **argv)
+{
+    RestXmlParser *parser;
+    RestXmlNode *node;
+    GError *error = NULL;
+    char *path;
+    char *data;
+    gsize size;
+    guint iterations = DEFAULT_ITERATIONS;
+    guint i;
+    gint64 start;
+    gint64 elapsed;
+
+    if (argc > 1) {
+        iterations = strtoul(argv[1], NULL, 0);
+    }
+
+    path = g_build_filename(srcdir, "mock-xml-data",
+                            "test-parse-vm-host-cluster.xml", NULL);
+    if (!g_file_get_contents(path, &data, &size, &error)) {
+        g_printerr("Failed to read %s: %s\n", path, error->message);
+        return EXIT_FAILURE;
+    }
+    g_free(path);
+
+    parser = rest_xml_parser_new();
+    node = rest_xml_parser_parse_from_data(parser, data, size);
+    g_object_unref(parser);
+    g_free(data);
+    if (node == NULL) {
+        g_printerr("Failed to parse VM XML\n");
+        return EXIT_FAILURE;
+    }
+
+    /* Warm up, so that one-time type and class initialization is not
+     * accounted for */
+    g_object_unref(g_initable_new(OVIRT_TYPE_VM, NULL, NULL, "xml-node", node, NULL));
+
+    start = g_get_monotonic_time();
+    for (i = 0; i < iterations; i++) {
+        GObject *vm;
+
+        vm = g_initable_new(OVIRT_TYPE_VM, NULL, &error, "xml-node", node, NULL);
+        if (vm == NULL) {
+            g_printerr("Failed to create VM: %s\n", error->message);
+            return EXIT_FAILURE;
+        }
+        g_object_unref(vm);
+    }
+    elapsed = g_get_monotonic_time() - start;
+
+    g_print("%u VMs parsed in %.3f ms, %.3f us per VM\n", iterations,
+            elapsed / 1000.0, (double)elapsed / MAX(iterations, 1));
+
+    rest_xml_node_unref(node);
+
+    return EXIT_SUCCESS;
+}
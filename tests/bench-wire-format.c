@@ -0,0 +1,169 @@
+/* Copyright 2026 Red Hat, Inc. and/or its affiliates.
+ *
+ * Permission is hereby granted, free of charge, to any person
+ * obtaining a copy of this software and associated documentation files
+ * (the "Software"), to deal in the Software without restriction,
+ * including without limitation the rights to use, copy, modify, merge,
+ * publish, distribute, sublicense, and/or sell copies of the Software,
+ * and to permit persons to whom the Software is furnished to do so,
+ * subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ * NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS
+ * BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN
+ * ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+ * CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+/* Compares the XML and JSON wire formats when fetching a large VM
+ * collection from the mock server: bytes sent by the server, and time
+ * spent fetching and building the OvirtVm objects.
+ *
+ * JSON documents are converted into the same RestXmlNode trees as XML
+ * ones before the objects are built, so the JSON format is not expected
+ * to be faster to process: what it can save is the number of bytes on
+ * the wire. Both numbers are printed so that this can be checked
+ * against a given server.
+ *
+ * Usage: bench-wire-format [N_VMS]
+ */
+#include <config.h>
+
+#include <govirt/govirt.h>
+
+#include <stdlib.h>
+
+#include "mock-httpd.h"
+
+#define GOVIRT_HTTPS_PORT 8088
+#define DEFAULT_N_VMS 10000
+
+static char *generate_vms(OvirtWireFormat format, guint n_vms)
+{
+    GString *vms;
+    guint i;
+
+    if (format == OVIRT_WIRE_FORMAT_JSON) {
+        vms = g_string_new("{\"vm\": [");
+    } else {
+        vms = g_string_new("<vms>");
+    }
+
+    for (i = 0; i < n_vms; i++) {
+        if (format == OVIRT_WIRE_FORMAT_JSON) {
+            g_string_append_printf(vms,
+                                   "%s{\"href\": \"/ovirt-engine/api/vms/uuid%u\", \"id\": \"uuid%u\","
+                                   " \"name\": \"vm%u\", \"status\": \"up\", \"memory\": 1073741824,"
+                                   " \"cpu\": {\"topology\": {\"sockets\": 1, \"cores\": 2, \"threads\": 1}},"
+                                   " \"display\": {\"type\": \"spice\", \"address\": \"10.0.0.1\","
+                                   " \"port\": 5900, \"secure_port\": 5901, \"monitors\": 1},"
+                                   " \"host\": {\"href\": \"/ovirt-engine/api/hosts/host%u\", \"id\": \"host%u\"},"
+                                   " \"cluster\": {\"href\": \"/ovirt-engine/api/clusters/cluster0\", \"id\": \"cluster0\"}}",
+                                   (i == 0) ? "" : ", ", i, i, i, i % 16, i % 16);
+        } else {
+            g_string_append_printf(vms,
+                                   "<vm href=\"/ovirt-engine/api/vms/uuid%u\" id=\"uuid%u\">"
+                                   "<name>vm%u</name><status>up</status><memory>1073741824</memory>"
+                                   "<cpu><topology><sockets>1</sockets><cores>2</cores><threads>1</threads></topology></cpu>"
+                                   "<display><type>spice</type><address>10.0.0.1</address>"
+                                   "<port>5900</port><secure_port>5901</secure_port><monitors>1</monitors></display>"
+                                   "<host href=\"/ovirt-engine/api/hosts/host%u\" id=\"host%u\"/>"
+                                   "<cluster href=\"/ovirt-engine/api/clusters/cluster0\" id=\"cluster0\"/>"
+                                   "</vm>",
+                                   i, i, i, i % 16, i % 16);
+        }
+    }
+
+    if (format == OVIRT_WIRE_FORMAT_JSON) {
+        g_string_append(vms, "]}");
+    } else {
+        g_string_append(vms, "</vms>");
+    }
+
+    return g_string_free(vms, FALSE);
+}
+
+static gboolean run(OvirtWireFormat format, guint n_vms)
+{
+    GovirtMockHttpd *httpd;
+    OvirtProxy *proxy;
+    OvirtApi *api;
+    OvirtCollection *vms;
+    GByteArray *cacert;
+    GError *error = NULL;
+    char *data;
+    gsize size;
+    gsize n_bytes;
+    gint64 start;
+    gint64 elapsed;
+
+    httpd = govirt_mock_httpd_new(GOVIRT_HTTPS_PORT);
+    if (format == OVIRT_WIRE_FORMAT_JSON) {
+        govirt_mock_httpd_add_request(httpd, "GET", "/ovirt-engine/api",
+                                      "{\"link\": [{\"href\": \"/ovirt-engine/api/vms\", \"rel\": \"vms\"}]}");
+    } else {
+        govirt_mock_httpd_add_request(httpd, "GET", "/ovirt-engine/api",
+                                      "<api><link href=\"/ovirt-engine/api/vms\" rel=\"vms\"/></api>");
+    }
+    data = generate_vms(format, n_vms);
+    govirt_mock_httpd_add_request(httpd, "GET", "/ovirt-engine/api/vms", data);
+    g_free(data);
+    govirt_mock_httpd_start(httpd);
+
+    proxy = ovirt_proxy_new("localhost:" G_STRINGIFY(GOVIRT_HTTPS_PORT));
+    if (!g_file_get_contents(abs_srcdir "/https-cert/ca-cert.pem", &data, &size, &error)) {
+        g_printerr("Failed to read CA certificate: %s\n", error->message);
+        return FALSE;
+    }
+    cacert = g_byte_array_new_take((guint8 *)data, size);
+    g_object_set(proxy, "ca-cert", cacert, "wire-format", format, NULL);
+    g_byte_array_unref(cacert);
+
+    api = ovirt_proxy_fetch_api(proxy, &error);
+    if (api == NULL) {
+        g_printerr("Failed to fetch API: %s\n", error->message);
+        return FALSE;
+    }
+
+    vms = ovirt_api_get_vms(api);
+    n_bytes = govirt_mock_httpd_get_n_bytes_sent(httpd);
+    start = g_get_monotonic_time();
+    if (!ovirt_collection_fetch(vms, proxy, &error)) {
+        g_printerr("Failed to fetch VMs: %s\n", error->message);
+        return FALSE;
+    }
+    elapsed = g_get_monotonic_time() - start;
+    n_bytes = govirt_mock_httpd_get_n_bytes_sent(httpd) - n_bytes;
+
+    g_print("%-4s: %u VMs, %" G_GSIZE_FORMAT " bytes, fetched and parsed in %.3f ms\n",
+            (format == OVIRT_WIRE_FORMAT_JSON) ? "JSON" : "XML",
+            g_hash_table_size(ovirt_collection_get_resources(vms)),
+            n_bytes, elapsed / 1000.0);
+
+    g_object_unref(proxy);
+    govirt_mock_httpd_stop(httpd);
+
+    return TRUE;
+}
+
+int
+main(int argc, char **argv)
+{
+    guint n_vms = DEFAULT_N_VMS;
+
+    if (argc > 1) {
+        n_vms = strtoul(argv[1], NULL, 0);
+    }
+
+    if (!run(OVIRT_WIRE_FORMAT_XML, n_vms) || !run(OVIRT_WIRE_FORMAT_JSON, n_vms)) {
+        return EXIT_FAILURE;
+    }
+
+    return EXIT_SUCCESS;
+}
@@ -26,10 +26,23 @@ struct GovirtMockHttpd {
 
     guint port;
     gboolean disable_tls;
+    gboolean compression;
 
+    GMutex requests_mutex;
     GHashTable *requests;
+    guint n_not_modified;
+    guint n_requests;
+    /* Size of the bodies of the successful responses, as they were sent */
+    gsize n_bytes_sent;
+
+    /* GovirtMockHttpdEvent sorted by increasing id, served at EVENTS_PATH
+     * once an event was added */
+    GList *events;
+    gboolean has_events;
 };
 
+#define EVENTS_PATH "/ovirt-engine/api/events"
+
 
 typedef struct {
     char *method;
@@ -38,23 +51,113 @@ typedef struct {
 } GovirtMockHttpdRequest;
 
 
-static const char *
+typedef struct {
+    guint id;
+    char *content;
+} GovirtMockHttpdEvent;
+
+
+static void
+govirt_mock_httpd_event_free (GovirtMockHttpdEvent *event)
+{
+	g_free (event->content);
+	g_free (event);
+}
+
+
+/* Events are returned from the most recent one, like the engine does.
+ * 'from' only returns the events following the given id, and 'max' limits
+ * the number of returned events */
+static char *
+govirt_mock_httpd_get_events (GovirtMockHttpd *mock_httpd, GHashTable *query)
+{
+	const char *from = NULL;
+	const char *max = NULL;
+	guint64 from_id = 0;
+	guint64 max_events = G_MAXUINT64;
+	guint64 n_events = 0;
+	GString *content;
+	GList *it;
+
+	if (query != NULL) {
+		from = g_hash_table_lookup (query, "from");
+		max = g_hash_table_lookup (query, "max");
+	}
+	if (from != NULL) {
+		from_id = g_ascii_strtoull (from, NULL, 10);
+	}
+	if (max != NULL) {
+		max_events = g_ascii_strtoull (max, NULL, 10);
+	}
+
+	g_mutex_lock (&mock_httpd->requests_mutex);
+	if (!mock_httpd->has_events) {
+		g_mutex_unlock (&mock_httpd->requests_mutex);
+		return NULL;
+	}
+	content = g_string_new ("<events>");
+	for (it = g_list_last (mock_httpd->events);
+	     (it != NULL) && (n_events < max_events);
+	     it = it->prev) {
+		GovirtMockHttpdEvent *event = it->data;
+
+		if (event->id <= from_id) {
+			break;
+		}
+		g_string_append_printf (content,
+					"<event href=\"" EVENTS_PATH "/%u\" id=\"%u\">%s</event>",
+					event->id, event->id, event->content);
+		n_events++;
+	}
+	g_string_append (content, "</events>");
+	g_mutex_unlock (&mock_httpd->requests_mutex);
+
+	return g_string_free (content, FALSE);
+}
+
+
+static char *
 govirt_mock_httpd_find_request (GovirtMockHttpd *mock_httpd,
 				const char *method,
 				const char *path)
 {
 	GovirtMockHttpdRequest *request;
+	char *content = NULL;
 
+	g_mutex_lock (&mock_httpd->requests_mutex);
 	request = g_hash_table_lookup (mock_httpd->requests, path);
+	if ((request != NULL) && (g_strcmp0 (request->method, method) == 0)) {
+		content = g_strdup (request->content);
+	}
+	g_mutex_unlock (&mock_httpd->requests_mutex);
 
-	if (request == NULL) {
-		return NULL;
+	return content;
+}
+
+
+/* Requests with a query string are registered as "path?key1=value1&key2=value2",
+ * with unescaped values and keys sorted alphabetically. When no request
+ * matches the query, the request registered for the path alone is used. */
+static char *
+govirt_mock_httpd_request_key (const char *path, GHashTable *query)
+{
+	GString *key;
+	GList *names, *it;
+
+	key = g_string_new (path);
+	if (query == NULL) {
+		return g_string_free (key, FALSE);
 	}
-	if (g_strcmp0 (request->method, method) != 0) {
-		return NULL;
+
+	names = g_list_sort (g_hash_table_get_keys (query), (GCompareFunc) strcmp);
+	for (it = names; it != NULL; it = it->next) {
+		g_string_append_c (key, (it == names) ? '?' : '&');
+		g_string_append_printf (key, "%s=%s", (char *) it->data,
+					(char *) g_hash_table_lookup (query, it->data));
 	}
+	g_list_free (names);
 
-	return request->content;
+	return g_string_free (key, FALSE);
 }
 
 
@@ -68,6 +171,28 @@ govirt_mock_htttpd_request_free (GovirtMockHttpdRequest *request)
 }
 
 
+static GBytes *
+govirt_mock_httpd_gzip (const char *content)
+{
+	GZlibCompressor *compressor;
+	GOutputStream *memory;
+	GOutputStream *gzip;
+	GBytes *bytes;
+
+	compressor = g_zlib_compressor_new (G_ZLIB_COMPRESSOR_FORMAT_GZIP, -1);
+	memory = g_memory_output_stream_new_resizable ();
+	gzip = g_converter_output_stream_new (memory, G_CONVERTER (compressor));
+	g_output_stream_write_all (gzip, content, strlen (content), NULL, NULL, NULL);
+	g_output_stream_close (gzip, NULL, NULL);
+	bytes = g_memory_output_stream_steal_as_bytes (G_MEMORY_OUTPUT_STREAM (memory));
+	g_object_unref (gzip);
+	g_object_unref (memory);
+	g_object_unref (compressor);
+
+	return bytes;
+}
+
+
 static void
 server_callback (SoupServer *server, SoupServerMessage *msg,
 		 const char *path, GHashTable *query,
@@ -75,8 +200,9 @@ server_callback (SoupServer *server, SoupServerMessage *msg,
 {
 	SoupMessageHeadersIter iter;
 	const char *name, *value;
-	const char *content;
+	char *content;
 	GovirtMockHttpd *mock_httpd = data;
+	char *key;
 
 	g_debug ("%s %s HTTP/1.%d", soup_server_message_get_method(msg), path,
 		 soup_server_message_get_http_version (msg));
@@ -86,13 +212,61 @@ server_callback (SoupServer *server, SoupServerMessage *msg,
 	if (soup_server_message_get_request_body(msg)->length)
 		g_debug ("%s", soup_server_message_get_request_body(msg)->data);
 
-	content = govirt_mock_httpd_find_request(mock_httpd, soup_server_message_get_method(msg), path);
+	g_mutex_lock (&mock_httpd->requests_mutex);
+	mock_httpd->n_requests++;
+	g_mutex_unlock (&mock_httpd->requests_mutex);
+
+	key = govirt_mock_httpd_request_key (path, query);
+	content = NULL;
+	if ((g_strcmp0 (soup_server_message_get_method(msg), "GET") == 0) &&
+	    (g_strcmp0 (path, EVENTS_PATH) == 0)) {
+		content = govirt_mock_httpd_get_events (mock_httpd, query);
+	}
+	if (content == NULL) {
+		content = govirt_mock_httpd_find_request(mock_httpd, soup_server_message_get_method(msg), key);
+	}
+	if (content == NULL) {
+		content = govirt_mock_httpd_find_request(mock_httpd, soup_server_message_get_method(msg), path);
+	}
+	g_free (key);
 	if (content == NULL) {
 		soup_server_message_set_status (msg, SOUP_STATUS_NOT_FOUND, NULL);
 	} else {
-		soup_message_body_append (soup_server_message_get_response_body(msg), SOUP_MEMORY_STATIC,
-					  content, strlen(content));
-		soup_server_message_set_status (msg, SOUP_STATUS_OK, NULL);
+		/* The ETag only depends on the content of the reply */
+		char *etag = g_strdup_printf ("\"%08x\"", g_str_hash (content));
+		const char *if_none_match;
+
+		if_none_match = soup_message_headers_get_one (soup_server_message_get_request_headers(msg),
+							      "If-None-Match");
+		soup_message_headers_replace (soup_server_message_get_response_headers(msg),
+					      "ETag", etag);
+		if (g_strcmp0 (if_none_match, etag) == 0) {
+			g_free (content);
+			soup_server_message_set_status (msg, SOUP_STATUS_NOT_MODIFIED, NULL);
+			g_mutex_lock (&mock_httpd->requests_mutex);
+			mock_httpd->n_not_modified++;
+			g_mutex_unlock (&mock_httpd->requests_mutex);
+		} else {
+			GBytes *body;
+
+			if (mock_httpd->compression &&
+			    soup_message_headers_header_contains (soup_server_message_get_request_headers(msg),
+								  "Accept-Encoding", "gzip")) {
+				body = govirt_mock_httpd_gzip (content);
+				g_free (content);
+				soup_message_headers_replace (soup_server_message_get_response_headers(msg),
+							      "Content-Encoding", "gzip");
+			} else {
+				body = g_bytes_new_take (content, strlen (content));
+			}
+			g_mutex_lock (&mock_httpd->requests_mutex);
+			mock_httpd->n_bytes_sent += g_bytes_get_size (body);
+			g_mutex_unlock (&mock_httpd->requests_mutex);
+			soup_message_body_append_bytes (soup_server_message_get_response_body(msg), body);
+			g_bytes_unref (body);
+			soup_server_message_set_status (msg, SOUP_STATUS_OK, NULL);
+		}
+		g_free (etag);
 	}
 	g_debug ("  -> %d %s\n\n",
 		 soup_server_message_get_status(msg),
@@ -171,6 +345,7 @@ govirt_mock_httpd_new (guint port)
 	g_main_context_unref (context);
 	g_mutex_lock(&run_mutex);
 
+	g_mutex_init (&mock_httpd->requests_mutex);
 	mock_httpd->requests = g_hash_table_new_full (g_str_hash, g_str_equal,
 						      NULL,
 						     (GDestroyNotify) govirt_mock_htttpd_request_free);
@@ -188,6 +363,16 @@ govirt_mock_httpd_disable_tls (GovirtMockHttpd *mock_httpd, gboolean disable_tls
 }
 
 
+/* Responses are gzip-compressed when the client accepts it */
+void
+govirt_mock_httpd_enable_compression (GovirtMockHttpd *mock_httpd, gboolean compression)
+{
+	g_return_if_fail(mock_httpd->thread == NULL);
+
+	mock_httpd->compression = compression;
+}
+
+
 void
 govirt_mock_httpd_add_request (GovirtMockHttpd *mock_httpd,
 			       const char *method,
@@ -196,8 +381,7 @@ govirt_mock_httpd_add_request (GovirtMockHttpd *mock_httpd,
 {
 	GovirtMockHttpdRequest *request;
 
-	g_return_if_fail(mock_httpd->thread == NULL);
-
+	g_mutex_lock (&mock_httpd->requests_mutex);
 	/* FIXME: just one method is supported for a given path right now */
 	request = g_hash_table_lookup (mock_httpd->requests, path);
 	if (request != NULL) {
@@ -210,6 +394,106 @@ govirt_mock_httpd_add_request (GovirtMockHttpd *mock_httpd,
 	request->content = g_strdup (content);
 
 	g_hash_table_replace (mock_httpd->requests, request->path, request);
+	g_mutex_unlock (&mock_httpd->requests_mutex);
+}
+
+
+void
+govirt_mock_httpd_remove_request (GovirtMockHttpd *mock_httpd,
+				  const char *path)
+{
+	g_mutex_lock (&mock_httpd->requests_mutex);
+	g_hash_table_remove (mock_httpd->requests, path);
+	g_mutex_unlock (&mock_httpd->requests_mutex);
+}
+
+
+/* @content is the content of the <event> node, ids must be increasing */
+void
+govirt_mock_httpd_add_event (GovirtMockHttpd *mock_httpd,
+			     guint id,
+			     const char *content)
+{
+	GovirtMockHttpdEvent *event;
+	GList *last;
+
+	g_mutex_lock (&mock_httpd->requests_mutex);
+	last = g_list_last (mock_httpd->events);
+	if (last != NULL) {
+		g_assert_cmpuint (((GovirtMockHttpdEvent *) last->data)->id, <, id);
+	}
+
+	event = g_new0 (GovirtMockHttpdEvent, 1);
+	event->id = id;
+	event->content = g_strdup (content);
+	mock_httpd->events = g_list_append (mock_httpd->events, event);
+	mock_httpd->has_events = TRUE;
+	g_mutex_unlock (&mock_httpd->requests_mutex);
+}
+
+
+/* Removes the events up to @up_to_id, like the engine does for old
+ * events */
+void
+govirt_mock_httpd_purge_events (GovirtMockHttpd *mock_httpd,
+				guint up_to_id)
+{
+	g_mutex_lock (&mock_httpd->requests_mutex);
+	while (mock_httpd->events != NULL) {
+		GovirtMockHttpdEvent *event = mock_httpd->events->data;
+
+		if (event->id > up_to_id) {
+			break;
+		}
+		mock_httpd->events = g_list_delete_link (mock_httpd->events,
+							 mock_httpd->events);
+		govirt_mock_httpd_event_free (event);
+	}
+	g_mutex_unlock (&mock_httpd->requests_mutex);
+}
+
+
+/* Number of conditional requests which were answered with
+ * '304 Not Modified' */
+guint
+govirt_mock_httpd_get_n_not_modified (GovirtMockHttpd *mock_httpd)
+{
+	guint n_not_modified;
+
+	g_mutex_lock (&mock_httpd->requests_mutex);
+	n_not_modified = mock_httpd->n_not_modified;
+	g_mutex_unlock (&mock_httpd->requests_mutex);
+
+	return n_not_modified;
+}
+
+
+/* Number of requests received since the server was created */
+guint
+govirt_mock_httpd_get_n_requests (GovirtMockHttpd *mock_httpd)
+{
+	guint n_requests;
+
+	g_mutex_lock (&mock_httpd->requests_mutex);
+	n_requests = mock_httpd->n_requests;
+	g_mutex_unlock (&mock_httpd->requests_mutex);
+
+	return n_requests;
+}
+
+
+/* Number of bytes of content sent since the server was created, not
+ * counting the headers */
+gsize
+govirt_mock_httpd_get_n_bytes_sent (GovirtMockHttpd *mock_httpd)
+{
+	gsize n_bytes_sent;
+
+	g_mutex_lock (&mock_httpd->requests_mutex);
+	n_bytes_sent = mock_httpd->n_bytes_sent;
+	g_mutex_unlock (&mock_httpd->requests_mutex);
+
+	return n_bytes_sent;
 }
 
 
@@ -254,6 +538,9 @@ govirt_mock_httpd_stop (GovirtMockHttpd *mock_httpd)
 
 	g_thread_join (mock_httpd->thread);
 	g_hash_table_unref (mock_httpd->requests);
+	g_list_free_full (mock_httpd->events,
+			  (GDestroyNotify) govirt_mock_httpd_event_free);
+	g_mutex_clear (&mock_httpd->requests_mutex);
 	g_main_loop_unref (mock_httpd->loop);
 	g_free (mock_httpd);
 	g_mutex_unlock(&run_mutex);
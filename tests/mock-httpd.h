@@ -31,8 +31,15 @@ GovirtMockHttpd *govirt_mock_httpd_new (guint port);
 void govirt_mock_httpd_start (GovirtMockHttpd *mock_httpd);
 void govirt_mock_httpd_stop (GovirtMockHttpd *mock_httpd);
 void govirt_mock_httpd_disable_tls (GovirtMockHttpd *mock_httpd, gboolean disable_tls);
+void govirt_mock_httpd_enable_compression (GovirtMockHttpd *mock_httpd, gboolean compression);
 void govirt_mock_httpd_add_request (GovirtMockHttpd *mock_httpd, const char *method,
                                     const char *path, const char *content);
+void govirt_mock_httpd_remove_request (GovirtMockHttpd *mock_httpd, const char *path);
+void govirt_mock_httpd_add_event (GovirtMockHttpd *mock_httpd, guint id, const char *content);
+void govirt_mock_httpd_purge_events (GovirtMockHttpd *mock_httpd, guint up_to_id);
+guint govirt_mock_httpd_get_n_not_modified (GovirtMockHttpd *mock_httpd);
+guint govirt_mock_httpd_get_n_requests (GovirtMockHttpd *mock_httpd);
+gsize govirt_mock_httpd_get_n_bytes_sent (GovirtMockHttpd *mock_httpd);
 
 G_END_DECLS
 
@@ -25,6 +25,9 @@
 #include <govirt/govirt.h>
 
 #include <stdlib.h>
+#include <string.h>
+
+#include <glib/gstdio.h>
 
 #include "mock-httpd.h"
 
@@ -347,6 +350,7 @@ static void test_govirt_list_duplicate_vms(void)
     OvirtApi *api;
     OvirtCollection *vms;
     OvirtResource *vm;
+    OvirtResource *dup_vm;
     GError *error = NULL;
     GovirtMockHttpd *httpd;
 
@@ -391,6 +395,2392 @@ static void test_govirt_list_duplicate_vms(void)
     g_assert_nonnull(vm);
     g_object_unref(vm);
 
+    /* Both resources are reachable through their id and href */
+    vm = ovirt_collection_lookup_resource_by_id(vms, "uuid0");
+    g_assert_nonnull(vm);
+    g_object_unref(vm);
+    vm = ovirt_collection_lookup_resource_by_id(vms, "uuid1");
+    g_assert_nonnull(vm);
+    dup_vm = ovirt_collection_lookup_resource_by_href(vms, "/ovirt-engine/api/vms/uuid1");
+    g_assert_true(vm == dup_vm);
+    g_object_unref(dup_vm);
+    g_object_unref(vm);
+    g_assert_null(ovirt_collection_lookup_resource_by_id(vms, "uuid2"));
+
+    g_object_unref(proxy);
+
+    govirt_mock_httpd_stop(httpd);
+}
+
+static void fetch_async_cb(GObject *source_object,
+                           GAsyncResult *result,
+                           gpointer user_data)
+{
+    GMainLoop *loop = user_data;
+    GError *error = NULL;
+
+    ovirt_collection_fetch_finish(OVIRT_COLLECTION(source_object), result, &error);
+    g_assert_no_error(error);
+    g_main_loop_quit(loop);
+}
+
+static void test_govirt_list_vms_streaming(void)
+{
+    OvirtProxy *proxy;
+    OvirtApi *api;
+    OvirtCollection *vms;
+    OvirtResource *vm;
+    GError *error = NULL;
+    GovirtMockHttpd *httpd;
+    GMainLoop *loop;
+    char *name;
+
+    const char *vms_body = "<vms> \
+                              <link href=\"/ovirt-engine/api/vms/link\" rel=\"vm\"/> \
+                              <vm href=\"/ovirt-engine/api/vms/uuid0\" id=\"uuid0\"> \
+                                <name>vm0</name> \
+                              </vm> \
+                              <vm href=\"/ovirt-engine/api/vms/uuid1\" id=\"uuid1\"> \
+                                <name>vm1</name> \
+                                <type>desktop</type> \
+                                <status>up</status> \
+                                <display> \
+                                    <type>spice</type> \
+                                    <address>10.0.0.123</address> \
+                                    <secure_port>5900</secure_port> \
+                                    <monitors>1</monitors> \
+                                    <single_qxl_pci>true</single_qxl_pci> \
+                                    <allow_override>false</allow_override> \
+                                    <smartcard_enabled>false</smartcard_enabled> \
+                                    <proxy>10.0.0.10</proxy> \
+                                    <file_transfer_enabled>true</file_transfer_enabled> \
+                                    <copy_paste_enabled>true</copy_paste_enabled> \
+                                </display> \
+                              </vm> \
+                              <vm href=\"/ovirt-engine/api/vms/uuid2\" id=\"uuid2\"> \
+                                <name>vm&amp;2</name> \
+                                <display> \
+                                  <type>spice</type> \
+                                  <monitors>1</monitors> \
+                                </display> \
+                              </vm> \
+                            </vms>";
+
+    httpd = govirt_mock_httpd_new(GOVIRT_HTTPS_PORT);
+    govirt_mock_httpd_add_request(httpd, "GET", "/ovirt-engine/api",
+                                  "<api><link href=\"/ovirt-engine/api/vms\" rel=\"vms\"/></api>");
+    govirt_mock_httpd_add_request(httpd, "GET", "/ovirt-engine/api/vms", vms_body);
+    govirt_mock_httpd_start(httpd);
+
+    proxy = ovirt_proxy_new("localhost:" G_STRINGIFY(GOVIRT_HTTPS_PORT));
+    ovirt_proxy_set_mock_ca(proxy);
+    api = ovirt_proxy_fetch_api(proxy, &error);
+    g_assert_nonnull(api);
+    g_assert_no_error(error);
+
+    vms = ovirt_api_get_vms(api);
+    g_object_set(G_OBJECT(vms), "streaming", TRUE, NULL);
+
+    /* vm0 has no display node */
+    g_test_expect_message("libgovirt", G_LOG_LEVEL_MESSAGE,
+                          "Failed to parse 'vm' node*");
+    ovirt_collection_fetch(vms, proxy, &error);
+    g_test_assert_expected_messages();
+    g_assert_no_error(error);
+    g_assert_cmpuint(g_hash_table_size(ovirt_collection_get_resources(vms)), ==, 2);
+
+    vm = ovirt_collection_lookup_resource(vms, "vm1");
+    g_assert_nonnull(vm);
+    check_vm_display(OVIRT_VM(vm));
+    g_object_unref(vm);
+
+    vm = ovirt_collection_lookup_resource(vms, "vm&2");
+    g_assert_nonnull(vm);
+    g_object_get(G_OBJECT(vm), "guid", &name, NULL);
+    g_assert_cmpstr(name, ==, "uuid2");
+    g_free(name);
+    g_object_unref(vm);
+
+    g_object_set(G_OBJECT(vms), "resources", NULL, NULL);
+    loop = g_main_loop_new(NULL, FALSE);
+    g_test_expect_message("libgovirt", G_LOG_LEVEL_MESSAGE,
+                          "Failed to parse 'vm' node*");
+    ovirt_collection_fetch_async(vms, proxy, NULL, fetch_async_cb, loop);
+    g_main_loop_run(loop);
+    g_test_assert_expected_messages();
+    g_main_loop_unref(loop);
+
+    vm = ovirt_collection_lookup_resource(vms, "vm1");
+    g_assert_nonnull(vm);
+    check_vm_display(OVIRT_VM(vm));
+    g_object_unref(vm);
+
+    g_object_unref(proxy);
+
+    govirt_mock_httpd_stop(httpd);
+}
+
+static char *paged_vms_xml(guint first, guint count)
+{
+    GString *xml;
+    guint i;
+
+    xml = g_string_new("<vms>");
+    for (i = first; i < first + count; i++) {
+        g_string_append_printf(xml,
+                               "<vm href=\"/ovirt-engine/api/vms/uuid%u\" id=\"uuid%u\">"
+                               "  <name>vm%u</name>"
+                               "  <display>"
+                               "    <type>spice</type>"
+                               "    <monitors>1</monitors>"
+                               "  </display>"
+                               "</vm>", i, i, i);
+    }
+    g_string_append(xml, "</vms>");
+
+    return g_string_free(xml, FALSE);
+}
+
+typedef struct {
+    OvirtCollection *page;
+    gboolean done;
+} PagerNextData;
+
+static void pager_next_cb(GObject *source_object,
+                          GAsyncResult *result,
+                          gpointer user_data)
+{
+    PagerNextData *data = user_data;
+    GError *error = NULL;
+
+    data->page = ovirt_collection_pager_next_finish(OVIRT_COLLECTION_PAGER(source_object),
+                                                    result, &error);
+    g_assert_no_error(error);
+    data->done = TRUE;
+}
+
+static OvirtCollection *pager_next(OvirtCollectionPager *pager)
+{
+    PagerNextData data = { NULL, FALSE };
+
+    ovirt_collection_pager_next_async(pager, NULL, pager_next_cb, &data);
+    while (!data.done) {
+        g_main_context_iteration(NULL, TRUE);
+    }
+
+    return data.page;
+}
+
+static void test_govirt_list_vms_paged(void)
+{
+    OvirtProxy *proxy;
+    OvirtApi *api;
+    OvirtCollection *vms;
+    OvirtCollection *page;
+    OvirtCollectionPager *pager;
+    OvirtResource *vm;
+    GError *error = NULL;
+    GovirtMockHttpd *httpd;
+    char *body;
+
+    httpd = govirt_mock_httpd_new(GOVIRT_HTTPS_PORT);
+    govirt_mock_httpd_add_request(httpd, "GET", "/ovirt-engine/api",
+                                  "<api>"
+                                  "  <link href=\"/ovirt-engine/api/vms\" rel=\"vms\"/>"
+                                  "  <link href=\"/ovirt-engine/api/vms?search={query}\" rel=\"vms/search\"/>"
+                                  "</api>");
+    body = paged_vms_xml(0, 2);
+    govirt_mock_httpd_add_request(httpd, "GET", "/ovirt-engine/api/vms?max=2&search=page 1", body);
+    g_free(body);
+    body = paged_vms_xml(2, 2);
+    govirt_mock_httpd_add_request(httpd, "GET", "/ovirt-engine/api/vms?max=2&search=page 2", body);
+    g_free(body);
+    body = paged_vms_xml(4, 1);
+    govirt_mock_httpd_add_request(httpd, "GET", "/ovirt-engine/api/vms?max=2&search=page 3", body);
+    g_free(body);
+    body = paged_vms_xml(2, 2);
+    govirt_mock_httpd_add_request(httpd, "GET", "/ovirt-engine/api/vms?max=2&search=name=vm* page 2", body);
+    g_free(body);
+    govirt_mock_httpd_start(httpd);
+
+    proxy = ovirt_proxy_new("localhost:" G_STRINGIFY(GOVIRT_HTTPS_PORT));
+    ovirt_proxy_set_mock_ca(proxy);
+    api = ovirt_proxy_fetch_api(proxy, &error);
+    g_assert_nonnull(api);
+    g_assert_no_error(error);
+
+    /* Search queries are kept when paging */
+    vms = ovirt_api_search_vms(api, "name=vm*");
+    ovirt_collection_fetch_page(vms, proxy, 2, 2, &error);
+    g_assert_no_error(error);
+    g_assert_cmpuint(g_hash_table_size(ovirt_collection_get_resources(vms)), ==, 2);
+    vm = ovirt_collection_lookup_resource(vms, "vm3");
+    g_assert_nonnull(vm);
+    g_object_unref(vm);
+    g_object_unref(vms);
+
+    vms = ovirt_api_get_vms(api);
+    pager = ovirt_collection_pager_new(vms, proxy, 2);
+
+    page = pager_next(pager);
+    g_assert_nonnull(page);
+    g_assert_cmpuint(g_hash_table_size(ovirt_collection_get_resources(page)), ==, 2);
+    vm = ovirt_collection_lookup_resource(page, "vm0");
+    g_assert_nonnull(vm);
+    g_object_unref(vm);
+    g_object_unref(page);
+
+    page = pager_next(pager);
+    g_assert_nonnull(page);
+    g_assert_cmpuint(g_hash_table_size(ovirt_collection_get_resources(page)), ==, 2);
+    g_object_unref(page);
+
+    /* The last page is shorter than the page size */
+    page = pager_next(pager);
+    g_assert_nonnull(page);
+    g_assert_cmpuint(g_hash_table_size(ovirt_collection_get_resources(page)), ==, 1);
+    vm = ovirt_collection_lookup_resource(page, "vm4");
+    g_assert_nonnull(vm);
+    g_object_unref(vm);
+    g_object_unref(page);
+
+    page = pager_next(pager);
+    g_assert_null(page);
+
+    /* The collection used to create the pager is left untouched */
+    g_assert_null(ovirt_collection_get_resources(vms));
+
+    g_object_unref(pager);
+    g_object_unref(proxy);
+
+    govirt_mock_httpd_stop(httpd);
+}
+
+static void count_resource_signal_cb(G_GNUC_UNUSED OvirtCollection *collection,
+                                     G_GNUC_UNUSED OvirtResource *resource,
+                                     gpointer user_data)
+{
+    guint *count = user_data;
+
+    (*count)++;
+}
+
+static void count_notify_cb(G_GNUC_UNUSED GObject *object,
+                            G_GNUC_UNUSED GParamSpec *pspec,
+                            gpointer user_data)
+{
+    guint *count = user_data;
+
+    (*count)++;
+}
+
+static void test_govirt_refresh_vms(void)
+{
+    OvirtProxy *proxy;
+    OvirtApi *api;
+    OvirtCollection *vms;
+    OvirtResource *vm0;
+    OvirtResource *vm1;
+    OvirtResource *vm;
+    GHashTable *resources;
+    GError *error = NULL;
+    GovirtMockHttpd *httpd;
+    guint added = 0;
+    guint removed = 0;
+    guint changed = 0;
+    guint notified = 0;
+    OvirtVmState state;
+
+#define REFRESH_VM(index, status) \
+    "<vm href=\"/ovirt-engine/api/vms/uuid" index "\" id=\"uuid" index "\">" \
+    "  <name>vm" index "</name>" \
+    "  <status>" status "</status>" \
+    "  <display>" \
+    "    <type>spice</type>" \
+    "    <monitors>1</monitors>" \
+    "  </display>" \
+    "</vm>"
+
+    httpd = govirt_mock_httpd_new(GOVIRT_HTTPS_PORT);
+    govirt_mock_httpd_add_request(httpd, "GET", "/ovirt-engine/api",
+                                  "<api><link href=\"/ovirt-engine/api/vms\" rel=\"vms\"/></api>");
+    govirt_mock_httpd_add_request(httpd, "GET", "/ovirt-engine/api/vms",
+                                  "<vms>"
+                                  REFRESH_VM("0", "down")
+                                  REFRESH_VM("1", "up")
+                                  REFRESH_VM("2", "up")
+                                  "</vms>");
+    govirt_mock_httpd_start(httpd);
+
+    proxy = ovirt_proxy_new("localhost:" G_STRINGIFY(GOVIRT_HTTPS_PORT));
+    ovirt_proxy_set_mock_ca(proxy);
+    api = ovirt_proxy_fetch_api(proxy, &error);
+    g_assert_nonnull(api);
+    g_assert_no_error(error);
+
+    vms = ovirt_api_get_vms(api);
+    g_signal_connect(vms, "resource-added",
+                     G_CALLBACK(count_resource_signal_cb), &added);
+    g_signal_connect(vms, "resource-removed",
+                     G_CALLBACK(count_resource_signal_cb), &removed);
+    g_signal_connect(vms, "resource-changed",
+                     G_CALLBACK(count_resource_signal_cb), &changed);
+    g_signal_connect(vms, "notify::resources",
+                     G_CALLBACK(count_notify_cb), &notified);
+
+    ovirt_collection_fetch(vms, proxy, &error);
+    g_assert_no_error(error);
+    g_assert_cmpuint(added, ==, 3);
+    g_assert_cmpuint(removed, ==, 0);
+    g_assert_cmpuint(changed, ==, 0);
+    g_assert_cmpuint(notified, ==, 1);
+    vm0 = ovirt_collection_lookup_resource(vms, "vm0");
+    vm1 = ovirt_collection_lookup_resource(vms, "vm1");
+    g_assert_nonnull(vm0);
+    g_assert_nonnull(vm1);
+
+    /* Nothing changed on the server, nothing should be reported */
+    resources = ovirt_collection_get_resources(vms);
+    ovirt_collection_fetch(vms, proxy, &error);
+    g_assert_no_error(error);
+    g_assert_cmpuint(added, ==, 3);
+    g_assert_cmpuint(removed, ==, 0);
+    g_assert_cmpuint(changed, ==, 0);
+    g_assert_cmpuint(notified, ==, 1);
+    g_assert_true(ovirt_collection_get_resources(vms) == resources);
+
+    govirt_mock_httpd_add_request(httpd, "GET", "/ovirt-engine/api/vms",
+                                  "<vms>"
+                                  REFRESH_VM("0", "up")
+                                  REFRESH_VM("1", "up")
+                                  REFRESH_VM("3", "up")
+                                  "</vms>");
+    ovirt_collection_fetch(vms, proxy, &error);
+    g_assert_no_error(error);
+    g_assert_cmpuint(added, ==, 4);
+    g_assert_cmpuint(removed, ==, 1);
+    g_assert_cmpuint(changed, ==, 1);
+    g_assert_cmpuint(notified, ==, 2);
+    g_assert_cmpuint(g_hash_table_size(ovirt_collection_get_resources(vms)), ==, 3);
+
+    /* Known resources are updated in place */
+    vm = ovirt_collection_lookup_resource(vms, "vm0");
+    g_assert_true(vm == vm0);
+    g_object_get(G_OBJECT(vm), "state", &state, NULL);
+    g_assert_cmpint(state, ==, OVIRT_VM_STATE_UP);
+    g_object_unref(vm);
+    vm = ovirt_collection_lookup_resource(vms, "vm1");
+    g_assert_true(vm == vm1);
+    g_object_unref(vm);
+    g_assert_null(ovirt_collection_lookup_resource(vms, "vm2"));
+
+#undef REFRESH_VM
+
+    g_object_unref(vm0);
+    g_object_unref(vm1);
+    g_object_unref(proxy);
+
+    govirt_mock_httpd_stop(httpd);
+}
+
+static void fetch_collections_cb(GObject *source_object,
+                                 GAsyncResult *result,
+                                 gpointer user_data)
+{
+    GHashTable **errors = user_data;
+    GError *error = NULL;
+    gboolean fetched;
+
+    fetched = ovirt_api_fetch_collections_finish(OVIRT_API(source_object),
+                                                 result, errors, &error);
+    g_assert_false(fetched);
+    g_assert_error(error, OVIRT_ERROR, OVIRT_ERROR_FAILED);
+    g_assert_cmpstr(error->message, ==, "Failed to fetch collections: clusters");
+    g_clear_error(&error);
+}
+
+static void test_govirt_list_vms_lazy(void)
+{
+    OvirtProxy *proxy;
+    OvirtApi *api;
+    OvirtCollection *vms;
+    OvirtCollection *cdroms;
+    OvirtResource *vm;
+    GError *error = NULL;
+    GovirtMockHttpd *httpd;
+    guint changed = 0;
+    char *name;
+    char *description;
+
+    const char *vms_body = "<vms> \
+                              <vm href=\"/ovirt-engine/api/vms/uuid0\" id=\"uuid0\"> \
+                                <name>vm0</name> \
+                                <description>first vm</description> \
+                              </vm> \
+                              <vm href=\"/ovirt-engine/api/vms/uuid1\" id=\"uuid1\"> \
+                                <name>vm1</name> \
+                                <type>desktop</type> \
+                                <status>up</status> \
+                                <link href=\"/ovirt-engine/api/vms/uuid1/cdroms\" rel=\"cdroms\"/> \
+                                <display> \
+                                    <type>spice</type> \
+                                    <address>10.0.0.123</address> \
+                                    <secure_port>5900</secure_port> \
+                                    <monitors>1</monitors> \
+                                    <single_qxl_pci>true</single_qxl_pci> \
+                                    <allow_override>false</allow_override> \
+                                    <smartcard_enabled>false</smartcard_enabled> \
+                                    <proxy>10.0.0.10</proxy> \
+                                    <file_transfer_enabled>true</file_transfer_enabled> \
+                                    <copy_paste_enabled>true</copy_paste_enabled> \
+                                </display> \
+                              </vm> \
+                            </vms>";
+    const char *vms_renamed_body = "<vms> \
+                              <vm href=\"/ovirt-engine/api/vms/uuid0\" id=\"uuid0\"> \
+                                <name>vm0-renamed</name> \
+                                <description>first vm</description> \
+                              </vm> \
+                              <vm href=\"/ovirt-engine/api/vms/uuid1\" id=\"uuid1\"> \
+                                <name>vm1</name> \
+                                <type>desktop</type> \
+                                <status>up</status> \
+                                <link href=\"/ovirt-engine/api/vms/uuid1/cdroms\" rel=\"cdroms\"/> \
+                                <display> \
+                                    <type>spice</type> \
+                                    <address>10.0.0.123</address> \
+                                    <secure_port>5900</secure_port> \
+                                    <monitors>1</monitors> \
+                                    <single_qxl_pci>true</single_qxl_pci> \
+                                    <allow_override>false</allow_override> \
+                                    <smartcard_enabled>false</smartcard_enabled> \
+                                    <proxy>10.0.0.10</proxy> \
+                                    <file_transfer_enabled>true</file_transfer_enabled> \
+                                    <copy_paste_enabled>true</copy_paste_enabled> \
+                                </display> \
+                              </vm> \
+                            </vms>";
+
+    httpd = govirt_mock_httpd_new(GOVIRT_HTTPS_PORT);
+    govirt_mock_httpd_add_request(httpd, "GET", "/ovirt-engine/api",
+                                  "<api><link href=\"/ovirt-engine/api/vms\" rel=\"vms\"/></api>");
+    govirt_mock_httpd_add_request(httpd, "GET", "/ovirt-engine/api/vms", vms_body);
+    govirt_mock_httpd_start(httpd);
+
+    proxy = ovirt_proxy_new("localhost:" G_STRINGIFY(GOVIRT_HTTPS_PORT));
+    ovirt_proxy_set_mock_ca(proxy);
+    api = ovirt_proxy_fetch_api(proxy, &error);
+    g_assert_nonnull(api);
+    g_assert_no_error(error);
+
+    vms = ovirt_api_get_vms(api);
+    g_object_set(G_OBJECT(vms), "lazy", TRUE, NULL);
+    ovirt_collection_fetch(vms, proxy, &error);
+    g_assert_no_error(error);
+    g_assert_cmpuint(g_hash_table_size(ovirt_collection_get_resources(vms)), ==, 2);
+
+    /* Name lookups only need the cheap properties */
+    vm = ovirt_collection_lookup_resource_by_id(vms, "uuid0");
+    g_assert_nonnull(vm);
+    g_object_get(G_OBJECT(vm), "name", &name, NULL);
+    g_assert_cmpstr(name, ==, "vm0");
+    g_free(name);
+
+    /* Refreshing a resource which was not materialized yet */
+    g_signal_connect(vms, "resource-changed",
+                     G_CALLBACK(count_resource_signal_cb), &changed);
+    govirt_mock_httpd_add_request(httpd, "GET", "/ovirt-engine/api/vms", vms_renamed_body);
+    ovirt_collection_fetch(vms, proxy, &error);
+    g_assert_no_error(error);
+    g_assert_cmpuint(changed, ==, 1);
+    g_object_get(G_OBJECT(vm), "name", &name, "description", &description, NULL);
+    g_assert_cmpstr(name, ==, "vm0-renamed");
+    g_assert_cmpstr(description, ==, "first vm");
+    g_free(name);
+    g_free(description);
+    g_object_unref(vm);
+
+    /* Other properties are parsed on first access */
+    vm = ovirt_collection_lookup_resource(vms, "vm1");
+    g_assert_nonnull(vm);
+    check_vm_display(OVIRT_VM(vm));
+    cdroms = ovirt_vm_get_cdroms(OVIRT_VM(vm));
+    g_assert_nonnull(cdroms);
+    g_object_unref(vm);
+
+    g_object_unref(proxy);
+
+    govirt_mock_httpd_stop(httpd);
+}
+
+
+static void test_govirt_xml_retention(void)
+{
+    OvirtProxy *proxy;
+    OvirtApi *api;
+    OvirtCollection *vms;
+    OvirtResource *vm;
+    GError *error = NULL;
+    GovirtMockHttpd *httpd;
+    gsize kept_size;
+    gsize compact_size;
+    char *description;
+
+    const char *vms_body = "<vms> \
+                              <vm href=\"/ovirt-engine/api/vms/uuid0\" id=\"uuid0\"> \
+                                <name>vm0</name> \
+                                <description>&lt;test&gt; &amp; vm</description> \
+                                <display> \
+                                    <type>spice</type> \
+                                    <monitors>1</monitors> \
+                                </display> \
+                              </vm> \
+                              <vm href=\"/ovirt-engine/api/vms/uuid1\" id=\"uuid1\"> \
+                                <name>vm1</name> \
+                                <type>desktop</type> \
+                                <status>up</status> \
+                                <display> \
+                                    <type>spice</type> \
+                                    <address>10.0.0.123</address> \
+                                    <secure_port>5900</secure_port> \
+                                    <monitors>1</monitors> \
+                                    <single_qxl_pci>true</single_qxl_pci> \
+                                    <allow_override>false</allow_override> \
+                                    <smartcard_enabled>false</smartcard_enabled> \
+                                    <proxy>10.0.0.10</proxy> \
+                                    <file_transfer_enabled>true</file_transfer_enabled> \
+                                    <copy_paste_enabled>true</copy_paste_enabled> \
+                                </display> \
+                              </vm> \
+                            </vms>";
+
+    httpd = govirt_mock_httpd_new(GOVIRT_HTTPS_PORT);
+    govirt_mock_httpd_add_request(httpd, "GET", "/ovirt-engine/api",
+                                  "<api><link href=\"/ovirt-engine/api/vms\" rel=\"vms\"/></api>");
+    govirt_mock_httpd_add_request(httpd, "GET", "/ovirt-engine/api/vms", vms_body);
+    govirt_mock_httpd_start(httpd);
+
+    proxy = ovirt_proxy_new("localhost:" G_STRINGIFY(GOVIRT_HTTPS_PORT));
+    ovirt_proxy_set_mock_ca(proxy);
+    api = ovirt_proxy_fetch_api(proxy, &error);
+    g_assert_nonnull(api);
+    g_assert_no_error(error);
+
+    vms = ovirt_api_get_vms(api);
+    g_object_set(G_OBJECT(vms), "lazy", TRUE, NULL);
+    ovirt_collection_fetch(vms, proxy, &error);
+    g_assert_no_error(error);
+    kept_size = ovirt_collection_get_retained_xml_size(vms);
+    g_assert_cmpuint(kept_size, >, 0);
+
+    /* Lazy resources are materialized from their serialized XML */
+    g_object_set(G_OBJECT(vms), "xml-retention", OVIRT_XML_RETENTION_COMPACT, NULL);
+    compact_size = ovirt_collection_get_retained_xml_size(vms);
+    g_assert_cmpuint(compact_size, >, 0);
+    g_assert_cmpuint(compact_size, <, kept_size);
+
+    vm = ovirt_collection_lookup_resource(vms, "vm0");
+    g_assert_nonnull(vm);
+    g_object_get(G_OBJECT(vm), "description", &description, NULL);
+    g_assert_cmpstr(description, ==, "<test> & vm");
+    g_free(description);
+    g_object_unref(vm);
+
+    vm = ovirt_collection_lookup_resource(vms, "vm1");
+    g_assert_nonnull(vm);
+    check_vm_display(OVIRT_VM(vm));
+    g_object_unref(vm);
+
+    /* Materialized resources no longer need any XML */
+    g_object_set(G_OBJECT(vms), "xml-retention", OVIRT_XML_RETENTION_DROP, NULL);
+    g_assert_cmpuint(ovirt_collection_get_retained_xml_size(vms), ==, 0);
+
+    g_object_unref(proxy);
+
+    govirt_mock_httpd_stop(httpd);
+}
+
+
+static void test_govirt_shared_display_ca(void)
+{
+    OvirtProxy *proxy;
+    OvirtApi *api;
+    OvirtCollection *vms;
+    OvirtResource *vm;
+    OvirtVmDisplay *display;
+    GByteArray *ca_certs[2];
+    char *subject;
+    GError *error = NULL;
+    GovirtMockHttpd *httpd;
+    guint i;
+
+#define SHARED_CA_VM(index) \
+    "<vm href=\"/ovirt-engine/api/vms/uuid" index "\" id=\"uuid" index "\">" \
+    "  <name>vm" index "</name>" \
+    "  <display>" \
+    "    <type>spice</type>" \
+    "    <monitors>1</monitors>" \
+    "    <certificate>" \
+    "      <content>shared certificate</content>" \
+    "      <subject>O=example,CN=host</subject>" \
+    "    </certificate>" \
+    "  </display>" \
+    "</vm>"
+
+    httpd = govirt_mock_httpd_new(GOVIRT_HTTPS_PORT);
+    govirt_mock_httpd_add_request(httpd, "GET", "/ovirt-engine/api",
+                                  "<api><link href=\"/ovirt-engine/api/vms\" rel=\"vms\"/></api>");
+    govirt_mock_httpd_add_request(httpd, "GET", "/ovirt-engine/api/vms",
+                                  "<vms>" SHARED_CA_VM("0") SHARED_CA_VM("1") "</vms>");
+    govirt_mock_httpd_start(httpd);
+
+#undef SHARED_CA_VM
+
+    proxy = ovirt_proxy_new("localhost:" G_STRINGIFY(GOVIRT_HTTPS_PORT));
+    ovirt_proxy_set_mock_ca(proxy);
+    api = ovirt_proxy_fetch_api(proxy, &error);
+    g_assert_nonnull(api);
+    g_assert_no_error(error);
+
+    vms = ovirt_api_get_vms(api);
+    ovirt_collection_fetch(vms, proxy, &error);
+    g_assert_no_error(error);
+
+    for (i = 0; i < G_N_ELEMENTS(ca_certs); i++) {
+        char *name = g_strdup_printf("vm%u", i);
+
+        vm = ovirt_collection_lookup_resource(vms, name);
+        g_assert_nonnull(vm);
+        g_object_get(vm, "display", &display, NULL);
+        g_assert_nonnull(display);
+        g_object_get(display, "ca-cert", &ca_certs[i], "host-subject", &subject, NULL);
+        g_assert_nonnull(ca_certs[i]);
+        g_assert_cmpstr(subject, ==, "O=example,CN=host");
+        g_free(subject);
+        g_object_unref(display);
+        g_object_unref(vm);
+        g_free(name);
+    }
+
+    /* Each caller gets its own copy of the certificate, whether or not
+     * the displays share it */
+    g_assert_true(ca_certs[0] != ca_certs[1]);
+    g_assert_cmpmem(ca_certs[0]->data, ca_certs[0]->len,
+                    "shared certificate", strlen("shared certificate"));
+    g_assert_cmpmem(ca_certs[1]->data, ca_certs[1]->len,
+                    ca_certs[0]->data, ca_certs[0]->len);
+    g_byte_array_unref(ca_certs[0]);
+    g_byte_array_unref(ca_certs[1]);
+
+    g_object_unref(proxy);
+
+    govirt_mock_httpd_stop(httpd);
+}
+
+
+static void test_govirt_conditional_fetch(void)
+{
+    OvirtProxy *proxy;
+    OvirtApi *api;
+    OvirtCollection *vms;
+    OvirtResource *vm;
+    GError *error = NULL;
+    GovirtMockHttpd *httpd;
+    GMainLoop *loop;
+    guint added = 0;
+    guint changed = 0;
+    OvirtVmState state;
+
+#define CONDITIONAL_VM(index, status) \
+    "<vm href=\"/ovirt-engine/api/vms/uuid" index "\" id=\"uuid" index "\">" \
+    "  <name>vm" index "</name>" \
+    "  <status>" status "</status>" \
+    "  <display>" \
+    "    <type>spice</type>" \
+    "    <monitors>1</monitors>" \
+    "  </display>" \
+    "</vm>"
+
+    httpd = govirt_mock_httpd_new(GOVIRT_HTTPS_PORT);
+    govirt_mock_httpd_add_request(httpd, "GET", "/ovirt-engine/api",
+                                  "<api><link href=\"/ovirt-engine/api/vms\" rel=\"vms\"/></api>");
+    govirt_mock_httpd_add_request(httpd, "GET", "/ovirt-engine/api/vms",
+                                  "<vms>" CONDITIONAL_VM("0", "down") CONDITIONAL_VM("1", "up") "</vms>");
+    govirt_mock_httpd_add_request(httpd, "GET", "/ovirt-engine/api/vms/uuid0",
+                                  CONDITIONAL_VM("0", "down"));
+    govirt_mock_httpd_start(httpd);
+
+    proxy = ovirt_proxy_new("localhost:" G_STRINGIFY(GOVIRT_HTTPS_PORT));
+    ovirt_proxy_set_mock_ca(proxy);
+    api = ovirt_proxy_fetch_api(proxy, &error);
+    g_assert_nonnull(api);
+    g_assert_no_error(error);
+
+    vms = ovirt_api_get_vms(api);
+    g_signal_connect(vms, "resource-added",
+                     G_CALLBACK(count_resource_signal_cb), &added);
+    g_signal_connect(vms, "resource-changed",
+                     G_CALLBACK(count_resource_signal_cb), &changed);
+    ovirt_collection_fetch(vms, proxy, &error);
+    g_assert_no_error(error);
+    g_assert_cmpuint(added, ==, 2);
+    g_assert_cmpuint(govirt_mock_httpd_get_n_not_modified(httpd), ==, 0);
+
+    /* Unchanged collections are not downloaded again */
+    ovirt_collection_fetch(vms, proxy, &error);
+    g_assert_no_error(error);
+    g_assert_cmpuint(govirt_mock_httpd_get_n_not_modified(httpd), ==, 1);
+
+    loop = g_main_loop_new(NULL, FALSE);
+    ovirt_collection_fetch_async(vms, proxy, NULL, fetch_async_cb, loop);
+    g_main_loop_run(loop);
+    g_assert_cmpuint(govirt_mock_httpd_get_n_not_modified(httpd), ==, 2);
+    g_assert_cmpuint(added, ==, 2);
+    g_assert_cmpuint(changed, ==, 0);
+    g_assert_cmpuint(g_hash_table_size(ovirt_collection_get_resources(vms)), ==, 2);
+
+    /* Modified collections are */
+    govirt_mock_httpd_add_request(httpd, "GET", "/ovirt-engine/api/vms",
+                                  "<vms>" CONDITIONAL_VM("0", "up") CONDITIONAL_VM("1", "up") "</vms>");
+    ovirt_collection_fetch_async(vms, proxy, NULL, fetch_async_cb, loop);
+    g_main_loop_run(loop);
+    g_main_loop_unref(loop);
+    g_assert_cmpuint(govirt_mock_httpd_get_n_not_modified(httpd), ==, 2);
+    g_assert_cmpuint(changed, ==, 1);
+
+    /* Resources only send validators once they were refreshed on their own */
+    vm = ovirt_collection_lookup_resource(vms, "vm0");
+    g_assert_nonnull(vm);
+    ovirt_resource_refresh(vm, proxy, &error);
+    g_assert_no_error(error);
+    g_object_get(G_OBJECT(vm), "state", &state, NULL);
+    g_assert_cmpint(state, ==, OVIRT_VM_STATE_DOWN);
+    g_assert_cmpuint(govirt_mock_httpd_get_n_not_modified(httpd), ==, 2);
+
+    g_assert_true(ovirt_resource_refresh(vm, proxy, &error));
+    g_assert_no_error(error);
+    g_assert_cmpuint(govirt_mock_httpd_get_n_not_modified(httpd), ==, 3);
+    g_object_unref(vm);
+
+#undef CONDITIONAL_VM
+
+    g_object_unref(proxy);
+
+    govirt_mock_httpd_stop(httpd);
+}
+
+
+static void remove_cache_dir(const char *path)
+{
+    GDir *dir;
+    const char *name;
+
+    dir = g_dir_open(path, 0, NULL);
+    if (dir != NULL) {
+        while ((name = g_dir_read_name(dir)) != NULL) {
+            char *child = g_build_filename(path, name, NULL);
+
+            if (g_file_test(child, G_FILE_TEST_IS_DIR)) {
+                remove_cache_dir(child);
+            } else {
+                g_unlink(child);
+            }
+            g_free(child);
+        }
+        g_dir_close(dir);
+    }
+    g_rmdir(path);
+}
+
+static void revalidation_failed_cb(G_GNUC_UNUSED OvirtProxy *proxy,
+                                   GObject *object,
+                                   const GError *error,
+                                   gpointer user_data)
+{
+    GObject **failed = user_data;
+
+    g_assert_nonnull(error);
+    g_assert_null(*failed);
+    *failed = object;
+}
+
+static void test_govirt_response_cache(void)
+{
+    OvirtProxy *proxy;
+    OvirtApi *api;
+    OvirtCollection *vms;
+    OvirtResource *vm;
+    GError *error = NULL;
+    GovirtMockHttpd *httpd;
+    GMainLoop *loop;
+    char *cache_dir;
+    GObject *failed = NULL;
+    guint added = 0;
+
+#define CACHED_VM(index) \
+    "<vm href=\"/ovirt-engine/api/vms/uuid" index "\" id=\"uuid" index "\">" \
+    "  <name>vm" index "</name>" \
+    "  <display>" \
+    "    <type>spice</type>" \
+    "  </display>" \
+    "</vm>"
+
+    cache_dir = g_dir_make_tmp("govirt-cache-XXXXXX", &error);
+    g_assert_no_error(error);
+
+    httpd = govirt_mock_httpd_new(GOVIRT_HTTPS_PORT);
+    govirt_mock_httpd_add_request(httpd, "GET", "/ovirt-engine/api",
+                                  "<api><link href=\"/ovirt-engine/api/vms\" rel=\"vms\"/></api>");
+    govirt_mock_httpd_add_request(httpd, "GET", "/ovirt-engine/api/vms",
+                                  "<vms>" CACHED_VM("0") "</vms>");
+    govirt_mock_httpd_start(httpd);
+
+    /* Fill the cache */
+    proxy = ovirt_proxy_new("localhost:" G_STRINGIFY(GOVIRT_HTTPS_PORT));
+    ovirt_proxy_set_mock_ca(proxy);
+    g_object_set(G_OBJECT(proxy), "cache-dir", cache_dir, NULL);
+    api = ovirt_proxy_fetch_api(proxy, &error);
+    g_assert_nonnull(api);
+    g_assert_no_error(error);
+    ovirt_collection_fetch(ovirt_api_get_vms(api), proxy, &error);
+    g_assert_no_error(error);
+    g_object_unref(proxy);
+
+    govirt_mock_httpd_add_request(httpd, "GET", "/ovirt-engine/api/vms",
+                                  "<vms>" CACHED_VM("0") CACHED_VM("1") "</vms>");
+
+    /* A new proxy first gets the cached content */
+    proxy = ovirt_proxy_new("localhost:" G_STRINGIFY(GOVIRT_HTTPS_PORT));
+    ovirt_proxy_set_mock_ca(proxy);
+    g_object_set(G_OBJECT(proxy), "cache-dir", cache_dir, NULL);
+    api = ovirt_proxy_fetch_api(proxy, &error);
+    g_assert_nonnull(api);
+    g_assert_no_error(error);
+
+    vms = ovirt_api_get_vms(api);
+    g_assert_nonnull(vms);
+    g_signal_connect(vms, "resource-added",
+                     G_CALLBACK(count_resource_signal_cb), &added);
+    loop = g_main_loop_new(NULL, FALSE);
+    ovirt_collection_fetch_async(vms, proxy, NULL, fetch_async_cb, loop);
+    g_main_loop_run(loop);
+    g_main_loop_unref(loop);
+    g_assert_cmpuint(added, ==, 1);
+    vm = ovirt_collection_lookup_resource_by_id(vms, "uuid0");
+    g_assert_nonnull(vm);
+    g_object_unref(vm);
+
+    /* Then the revalidation updates what changed */
+    while ((added < 2) || (govirt_mock_httpd_get_n_not_modified(httpd) < 1)) {
+        g_main_context_iteration(NULL, TRUE);
+    }
+    g_assert_cmpuint(g_hash_table_size(ovirt_collection_get_resources(vms)), ==, 2);
+    g_assert_true(ovirt_proxy_get_api(proxy) == api);
+    g_object_unref(proxy);
+
+    /* Failures to revalidate cached content are reported */
+    govirt_mock_httpd_remove_request(httpd, "/ovirt-engine/api/vms");
+    proxy = ovirt_proxy_new("localhost:" G_STRINGIFY(GOVIRT_HTTPS_PORT));
+    ovirt_proxy_set_mock_ca(proxy);
+    g_object_set(G_OBJECT(proxy), "cache-dir", cache_dir, NULL);
+    g_signal_connect(proxy, "revalidation-failed",
+                     G_CALLBACK(revalidation_failed_cb), &failed);
+    api = ovirt_proxy_fetch_api(proxy, &error);
+    g_assert_nonnull(api);
+    g_assert_no_error(error);
+
+    vms = ovirt_api_get_vms(api);
+    loop = g_main_loop_new(NULL, FALSE);
+    ovirt_collection_fetch_async(vms, proxy, NULL, fetch_async_cb, loop);
+    g_main_loop_run(loop);
+    g_main_loop_unref(loop);
+    g_assert_cmpuint(g_hash_table_size(ovirt_collection_get_resources(vms)), ==, 2);
+    while (failed == NULL) {
+        g_main_context_iteration(NULL, TRUE);
+    }
+    g_assert_true(failed == G_OBJECT(vms));
+    g_object_unref(proxy);
+
+    /* The synchronous API fetch revalidates the cached entry point before
+     * returning */
+    govirt_mock_httpd_remove_request(httpd, "/ovirt-engine/api");
+    proxy = ovirt_proxy_new("localhost:" G_STRINGIFY(GOVIRT_HTTPS_PORT));
+    ovirt_proxy_set_mock_ca(proxy);
+    g_object_set(G_OBJECT(proxy), "cache-dir", cache_dir, NULL);
+    api = ovirt_proxy_fetch_api(proxy, &error);
+    g_assert_null(api);
+    g_assert_nonnull(error);
+    g_clear_error(&error);
+
+#undef CACHED_VM
+
+    g_object_unref(proxy);
+
+    govirt_mock_httpd_stop(httpd);
+
+    remove_cache_dir(cache_dir);
+    g_free(cache_dir);
+}
+
+static void test_govirt_response_ttl(void)
+{
+    OvirtProxy *proxy;
+    OvirtApi *api;
+    OvirtCollection *vms;
+    OvirtResource *vm;
+    OvirtHost *host;
+    OvirtCluster *cluster;
+    GError *error = NULL;
+    GovirtMockHttpd *httpd;
+    char *name;
+
+#define TTL_VM(index, cluster) \
+    "<vm href=\"/ovirt-engine/api/vms/uuid" index "\" id=\"uuid" index "\">" \
+    "  <name>vm" index "</name>" \
+    "  <host href=\"/ovirt-engine/api/hosts/host0\" id=\"host0\"/>" \
+    "  <cluster href=\"/ovirt-engine/api/clusters/" cluster "\" id=\"" cluster "\"/>" \
+    "  <display>" \
+    "    <type>spice</type>" \
+    "  </display>" \
+    "</vm>"
+
+    httpd = govirt_mock_httpd_new(GOVIRT_HTTPS_PORT);
+    govirt_mock_httpd_add_request(httpd, "GET", "/ovirt-engine/api",
+                                  "<api><link href=\"/ovirt-engine/api/vms\" rel=\"vms\"/></api>");
+    govirt_mock_httpd_add_request(httpd, "GET", "/ovirt-engine/api/vms",
+                                  "<vms>" TTL_VM("0", "missing") TTL_VM("1", "missing") "</vms>");
+    govirt_mock_httpd_add_request(httpd, "GET", "/ovirt-engine/api/hosts/host0",
+                                  "<host href=\"/ovirt-engine/api/hosts/host0\" id=\"host0\">"
+                                  "  <name>host0</name>"
+                                  "</host>");
+    govirt_mock_httpd_start(httpd);
+
+    proxy = ovirt_proxy_new("localhost:" G_STRINGIFY(GOVIRT_HTTPS_PORT));
+    ovirt_proxy_set_mock_ca(proxy);
+    ovirt_proxy_set_response_ttl(proxy, "/ovirt-engine/api/hosts/", 60000);
+    ovirt_proxy_set_response_ttl(proxy, "/ovirt-engine/api/clusters/", 60000);
+    api = ovirt_proxy_fetch_api(proxy, &error);
+    g_assert_nonnull(api);
+    g_assert_no_error(error);
+    vms = ovirt_api_get_vms(api);
+    ovirt_collection_fetch(vms, proxy, &error);
+    g_assert_no_error(error);
+
+    vm = ovirt_collection_lookup_resource(vms, "vm0");
+    host = ovirt_vm_get_host(OVIRT_VM(vm));
+    g_assert_true(ovirt_resource_refresh(OVIRT_RESOURCE(host), proxy, &error));
+    g_assert_no_error(error);
+    g_object_unref(host);
+    g_object_unref(vm);
+
+    /* The same host is not fetched again */
+    govirt_mock_httpd_add_request(httpd, "GET", "/ovirt-engine/api/hosts/host0",
+                                  "<host href=\"/ovirt-engine/api/hosts/host0\" id=\"host0\">"
+                                  "  <name>renamed</name>"
+                                  "</host>");
+    vm = ovirt_collection_lookup_resource(vms, "vm1");
+    host = ovirt_vm_get_host(OVIRT_VM(vm));
+    g_assert_true(ovirt_resource_refresh(OVIRT_RESOURCE(host), proxy, &error));
+    g_assert_no_error(error);
+    g_object_get(G_OBJECT(host), "name", &name, NULL);
+    g_assert_cmpstr(name, ==, "host0");
+    g_free(name);
+    g_object_unref(host);
+
+    /* Neither is a missing cluster */
+    cluster = ovirt_vm_get_cluster(OVIRT_VM(vm));
+    g_assert_false(ovirt_resource_refresh(OVIRT_RESOURCE(cluster), proxy, &error));
+    g_assert_error(error, REST_PROXY_ERROR, 404);
+    g_clear_error(&error);
+    govirt_mock_httpd_add_request(httpd, "GET", "/ovirt-engine/api/clusters/missing",
+                                  "<cluster href=\"/ovirt-engine/api/clusters/missing\" id=\"missing\"/>");
+    g_assert_false(ovirt_resource_refresh(OVIRT_RESOURCE(cluster), proxy, &error));
+    g_assert_error(error, REST_PROXY_ERROR, 404);
+    g_clear_error(&error);
+
+    /* Until the responses are no longer cached */
+    ovirt_proxy_set_response_ttl(proxy, "/ovirt-engine/api/clusters/", 0);
+    g_assert_true(ovirt_resource_refresh(OVIRT_RESOURCE(cluster), proxy, &error));
+    g_assert_no_error(error);
+    g_object_unref(cluster);
+    g_object_unref(vm);
+
+#undef TTL_VM
+
+    g_object_unref(proxy);
+
+    govirt_mock_httpd_stop(httpd);
+}
+
+static void shared_refresh_cb(GObject *source_object,
+                              GAsyncResult *result,
+                              gpointer user_data)
+{
+    guint *pending = user_data;
+    GError *error = NULL;
+
+    g_assert_true(ovirt_resource_refresh_finish(OVIRT_RESOURCE(source_object),
+                                                result, &error));
+    g_assert_no_error(error);
+    (*pending)--;
+}
+
+static void shared_refresh_cancelled_cb(GObject *source_object,
+                                        GAsyncResult *result,
+                                        gpointer user_data)
+{
+    guint *pending = user_data;
+    GError *error = NULL;
+
+    g_assert_false(ovirt_resource_refresh_finish(OVIRT_RESOURCE(source_object),
+                                                 result, &error));
+    g_assert_error(error, G_IO_ERROR, G_IO_ERROR_CANCELLED);
+    g_clear_error(&error);
+    (*pending)--;
+}
+
+static void test_govirt_shared_refresh(void)
+{
+    OvirtProxy *proxy;
+    OvirtApi *api;
+    OvirtCollection *vms;
+    OvirtResource *vm;
+    OvirtHost *hosts[3];
+    GCancellable *cancellable;
+    GError *error = NULL;
+    GovirtMockHttpd *httpd;
+    guint n_requests;
+    guint pending;
+    char *name;
+    guint i;
+
+#define SHARED_VM(index) \
+    "<vm href=\"/ovirt-engine/api/vms/uuid" index "\" id=\"uuid" index "\">" \
+    "  <name>vm" index "</name>" \
+    "  <host href=\"/ovirt-engine/api/hosts/host0\" id=\"host0\"/>" \
+    "  <display>" \
+    "    <type>spice</type>" \
+    "  </display>" \
+    "</vm>"
+
+    httpd = govirt_mock_httpd_new(GOVIRT_HTTPS_PORT);
+    govirt_mock_httpd_add_request(httpd, "GET", "/ovirt-engine/api",
+                                  "<api><link href=\"/ovirt-engine/api/vms\" rel=\"vms\"/></api>");
+    govirt_mock_httpd_add_request(httpd, "GET", "/ovirt-engine/api/vms",
+                                  "<vms>" SHARED_VM("0") SHARED_VM("1") SHARED_VM("2") "</vms>");
+    govirt_mock_httpd_add_request(httpd, "GET", "/ovirt-engine/api/hosts/host0",
+                                  "<host href=\"/ovirt-engine/api/hosts/host0\" id=\"host0\">"
+                                  "  <name>host0</name>"
+                                  "</host>");
+    govirt_mock_httpd_start(httpd);
+
+    proxy = ovirt_proxy_new("localhost:" G_STRINGIFY(GOVIRT_HTTPS_PORT));
+    ovirt_proxy_set_mock_ca(proxy);
+    api = ovirt_proxy_fetch_api(proxy, &error);
+    g_assert_nonnull(api);
+    g_assert_no_error(error);
+    vms = ovirt_api_get_vms(api);
+    ovirt_collection_fetch(vms, proxy, &error);
+    g_assert_no_error(error);
+
+    for (i = 0; i < G_N_ELEMENTS(hosts); i++) {
+        char *vm_name = g_strdup_printf("vm%u", i);
+
+        vm = ovirt_collection_lookup_resource(vms, vm_name);
+        g_assert_nonnull(vm);
+        hosts[i] = ovirt_vm_get_host(OVIRT_VM(vm));
+        g_object_unref(vm);
+        g_free(vm_name);
+    }
+
+    /* The hosts are distinct objects, but they are only fetched once,
+     * and cancelling one of the refreshes does not affect the others */
+    n_requests = govirt_mock_httpd_get_n_requests(httpd);
+    cancellable = g_cancellable_new();
+    pending = G_N_ELEMENTS(hosts);
+    ovirt_resource_refresh_async(OVIRT_RESOURCE(hosts[0]), proxy, cancellable,
+                                 shared_refresh_cancelled_cb, &pending);
+    ovirt_resource_refresh_async(OVIRT_RESOURCE(hosts[1]), proxy, NULL,
+                                 shared_refresh_cb, &pending);
+    ovirt_resource_refresh_async(OVIRT_RESOURCE(hosts[2]), proxy, NULL,
+                                 shared_refresh_cb, &pending);
+    g_cancellable_cancel(cancellable);
+    while (pending > 0) {
+        g_main_context_iteration(NULL, TRUE);
+    }
+    g_object_unref(cancellable);
+    g_assert_cmpuint(govirt_mock_httpd_get_n_requests(httpd), ==, n_requests + 1);
+
+    for (i = 1; i < G_N_ELEMENTS(hosts); i++) {
+        g_object_get(G_OBJECT(hosts[i]), "name", &name, NULL);
+        g_assert_cmpstr(name, ==, "host0");
+        g_free(name);
+    }
+    for (i = 0; i < G_N_ELEMENTS(hosts); i++) {
+        g_object_unref(hosts[i]);
+    }
+
+#undef SHARED_VM
+
+    g_object_unref(proxy);
+
+    govirt_mock_httpd_stop(httpd);
+}
+
+static void test_govirt_follow(void)
+{
+    OvirtProxy *proxy;
+    OvirtApi *api;
+    OvirtCollection *vms;
+    OvirtResource *vm;
+    OvirtHost *host;
+    OvirtCluster *cluster;
+    GError *error = NULL;
+    GovirtMockHttpd *httpd;
+    guint n_requests;
+    char *name;
+
+#define FOLLOW_VM(host_name) \
+    "<vm href=\"/ovirt-engine/api/vms/uuid0\" id=\"uuid0\">" \
+    "  <name>vm0</name>" \
+    "  <host href=\"/ovirt-engine/api/hosts/host0\" id=\"host0\">" \
+    "    <name>" host_name "</name>" \
+    "  </host>" \
+    "  <cluster href=\"/ovirt-engine/api/clusters/cluster0\" id=\"cluster0\">" \
+    "    <name>cluster0</name>" \
+    "  </cluster>" \
+    "  <display>" \
+    "    <type>spice</type>" \
+    "  </display>" \
+    "</vm>"
+
+    httpd = govirt_mock_httpd_new(GOVIRT_HTTPS_PORT);
+    govirt_mock_httpd_add_request(httpd, "GET", "/ovirt-engine/api",
+                                  "<api><link href=\"/ovirt-engine/api/vms\" rel=\"vms\"/></api>");
+    govirt_mock_httpd_add_request(httpd, "GET", "/ovirt-engine/api/vms?follow=host,cluster",
+                                  "<vms>" FOLLOW_VM("host0") "</vms>");
+    govirt_mock_httpd_add_request(httpd, "GET", "/ovirt-engine/api/vms/uuid0?all_content=true&follow=host,cluster",
+                                  FOLLOW_VM("host0-renamed"));
+    govirt_mock_httpd_start(httpd);
+
+    proxy = ovirt_proxy_new("localhost:" G_STRINGIFY(GOVIRT_HTTPS_PORT));
+    ovirt_proxy_set_mock_ca(proxy);
+    api = ovirt_proxy_fetch_api(proxy, &error);
+    g_assert_nonnull(api);
+    g_assert_no_error(error);
+
+    /* The related objects come with the virtual machine */
+    vms = ovirt_api_get_vms(api);
+    g_object_set(G_OBJECT(vms), "follow", "host,cluster", NULL);
+    n_requests = govirt_mock_httpd_get_n_requests(httpd);
+    ovirt_collection_fetch(vms, proxy, &error);
+    g_assert_no_error(error);
+    vm = ovirt_collection_lookup_resource(vms, "vm0");
+    g_assert_nonnull(vm);
+    host = ovirt_vm_get_host(OVIRT_VM(vm));
+    g_object_get(G_OBJECT(host), "name", &name, NULL);
+    g_assert_cmpstr(name, ==, "host0");
+    g_free(name);
+    g_object_unref(host);
+    cluster = ovirt_vm_get_cluster(OVIRT_VM(vm));
+    g_object_get(G_OBJECT(cluster), "name", &name, NULL);
+    g_assert_cmpstr(name, ==, "cluster0");
+    g_free(name);
+    g_object_unref(cluster);
+    g_assert_cmpuint(govirt_mock_httpd_get_n_requests(httpd), ==, n_requests + 1);
+
+    /* Resources of the collection inline the same objects when refreshed */
+    g_assert_true(ovirt_resource_refresh(vm, proxy, &error));
+    g_assert_no_error(error);
+    host = ovirt_vm_get_host(OVIRT_VM(vm));
+    g_object_get(G_OBJECT(host), "name", &name, NULL);
+    g_assert_cmpstr(name, ==, "host0-renamed");
+    g_free(name);
+    g_object_unref(host);
+    g_object_unref(vm);
+
+#undef FOLLOW_VM
+
+    g_object_unref(proxy);
+
+    govirt_mock_httpd_stop(httpd);
+}
+
+static void event_sync_cb(GObject *source_object,
+                          GAsyncResult *result,
+                          gpointer user_data)
+{
+    GMainLoop *loop = user_data;
+    GError *error = NULL;
+
+    g_assert_true(ovirt_event_sync_run_finish(OVIRT_EVENT_SYNC(source_object),
+                                              result, &error));
+    g_assert_no_error(error);
+    g_main_loop_quit(loop);
+}
+
+static void test_govirt_event_sync(void)
+{
+    OvirtProxy *proxy;
+    OvirtApi *api;
+    OvirtCollection *vms;
+    OvirtResource *vm;
+    OvirtEventSync *sync;
+    GError *error = NULL;
+    GovirtMockHttpd *httpd;
+    GMainLoop *loop;
+    guint n_requests;
+    guint added = 0;
+    guint removed = 0;
+    guint changed = 0;
+    guint64 last_event_id;
+
+#define EVENT_VM(index, name) \
+    "<vm href=\"/ovirt-engine/api/vms/uuid" index "\" id=\"uuid" index "\">" \
+    "  <name>" name "</name>" \
+    "  <display>" \
+    "    <type>spice</type>" \
+    "  </display>" \
+    "</vm>"
+#define VM_EVENT(index) \
+    "<description>VM changed</description>" \
+    "<vm href=\"/ovirt-engine/api/vms/uuid" index "\" id=\"uuid" index "\"/>"
+
+    httpd = govirt_mock_httpd_new(GOVIRT_HTTPS_PORT);
+    govirt_mock_httpd_add_request(httpd, "GET", "/ovirt-engine/api",
+                                  "<api>"
+                                  "  <link href=\"/ovirt-engine/api/events\" rel=\"events\"/>"
+                                  "  <link href=\"/ovirt-engine/api/hosts\" rel=\"hosts\"/>"
+                                  "  <link href=\"/ovirt-engine/api/vms\" rel=\"vms\"/>"
+                                  "</api>");
+    govirt_mock_httpd_add_request(httpd, "GET", "/ovirt-engine/api/vms",
+                                  "<vms>" EVENT_VM("0", "vm0") EVENT_VM("1", "vm1") "</vms>");
+    govirt_mock_httpd_add_request(httpd, "GET", "/ovirt-engine/api/vms/uuid0",
+                                  EVENT_VM("0", "vm0-renamed"));
+    govirt_mock_httpd_add_request(httpd, "GET", "/ovirt-engine/api/vms/uuid2",
+                                  EVENT_VM("2", "vm2"));
+    govirt_mock_httpd_add_event(httpd, 1, VM_EVENT("0"));
+    govirt_mock_httpd_add_event(httpd, 2, VM_EVENT("1"));
+    govirt_mock_httpd_start(httpd);
+
+    loop = g_main_loop_new(NULL, FALSE);
+    proxy = ovirt_proxy_new("localhost:" G_STRINGIFY(GOVIRT_HTTPS_PORT));
+    ovirt_proxy_set_mock_ca(proxy);
+    api = ovirt_proxy_fetch_api(proxy, &error);
+    g_assert_nonnull(api);
+    g_assert_no_error(error);
+    vms = ovirt_api_get_vms(api);
+    ovirt_collection_fetch(vms, proxy, &error);
+    g_assert_no_error(error);
+    g_signal_connect(vms, "resource-added",
+                     G_CALLBACK(count_resource_signal_cb), &added);
+    g_signal_connect(vms, "resource-removed",
+                     G_CALLBACK(count_resource_signal_cb), &removed);
+    g_signal_connect(vms, "resource-changed",
+                     G_CALLBACK(count_resource_signal_cb), &changed);
+
+    /* The first run only records the position in the event feed */
+    sync = ovirt_event_sync_new(proxy);
+    ovirt_event_sync_run_async(sync, NULL, event_sync_cb, loop);
+    g_main_loop_run(loop);
+    g_object_get(G_OBJECT(sync), "last-event-id", &last_event_id, NULL);
+    g_assert_cmpuint(last_event_id, ==, 2);
+    g_assert_cmpuint(added + removed + changed, ==, 0);
+
+    /* Only the resources the new events refer to are fetched, once each,
+     * and events about collections which were never fetched are ignored */
+    govirt_mock_httpd_remove_request(httpd, "/ovirt-engine/api/vms/uuid1");
+    govirt_mock_httpd_add_event(httpd, 3, VM_EVENT("0"));
+    govirt_mock_httpd_add_event(httpd, 4, VM_EVENT("1"));
+    govirt_mock_httpd_add_event(httpd, 5, VM_EVENT("2"));
+    govirt_mock_httpd_add_event(httpd, 6, VM_EVENT("0"));
+    govirt_mock_httpd_add_event(httpd, 7,
+                                "<host href=\"/ovirt-engine/api/hosts/host0\" id=\"host0\"/>");
+    n_requests = govirt_mock_httpd_get_n_requests(httpd);
+    ovirt_event_sync_run_async(sync, NULL, event_sync_cb, loop);
+    g_main_loop_run(loop);
+    g_assert_cmpuint(govirt_mock_httpd_get_n_requests(httpd), ==, n_requests + 4);
+    g_object_get(G_OBJECT(sync), "last-event-id", &last_event_id, NULL);
+    g_assert_cmpuint(last_event_id, ==, 7);
+    g_assert_cmpuint(added, ==, 1);
+    g_assert_cmpuint(removed, ==, 1);
+    g_assert_cmpuint(changed, ==, 1);
+    g_assert_null(ovirt_collection_lookup_resource(vms, "vm1"));
+    vm = ovirt_collection_lookup_resource(vms, "vm0-renamed");
+    g_assert_nonnull(vm);
+    g_object_unref(vm);
+    vm = ovirt_collection_lookup_resource_by_id(vms, "uuid2");
+    g_assert_nonnull(vm);
+    g_object_unref(vm);
+
+    /* When events were lost, the collection is fetched again */
+    govirt_mock_httpd_add_request(httpd, "GET", "/ovirt-engine/api/vms",
+                                  "<vms>" EVENT_VM("0", "vm0-renamed") EVENT_VM("2", "vm2")
+                                  EVENT_VM("3", "vm3") "</vms>");
+    govirt_mock_httpd_add_event(httpd, 8, VM_EVENT("3"));
+    govirt_mock_httpd_add_event(httpd, 9, VM_EVENT("3"));
+    govirt_mock_httpd_purge_events(httpd, 8);
+    ovirt_event_sync_run_async(sync, NULL, event_sync_cb, loop);
+    g_main_loop_run(loop);
+    g_object_get(G_OBJECT(sync), "last-event-id", &last_event_id, NULL);
+    g_assert_cmpuint(last_event_id, ==, 9);
+    g_assert_cmpuint(added, ==, 2);
+    g_assert_cmpuint(removed, ==, 1);
+    vm = ovirt_collection_lookup_resource(vms, "vm3");
+    g_assert_nonnull(vm);
+    g_object_unref(vm);
+
+#undef VM_EVENT
+#undef EVENT_VM
+
+    g_object_unref(sync);
+    g_object_unref(proxy);
+    g_main_loop_unref(loop);
+
+    govirt_mock_httpd_stop(httpd);
+}
+
+static void resolve_resources_cb(GObject *source_object,
+                                 GAsyncResult *result,
+                                 gpointer user_data)
+{
+    GMainLoop *loop = user_data;
+    GError *error = NULL;
+
+    g_assert_true(ovirt_proxy_resolve_resources_finish(OVIRT_PROXY(source_object),
+                                                       result, &error));
+    g_assert_no_error(error);
+    g_main_loop_quit(loop);
+}
+
+static void test_govirt_resolve_resources(void)
+{
+    OvirtProxy *proxy;
+    OvirtApi *api;
+    OvirtCollection *vms;
+    OvirtResource *vm;
+    GList *hosts = NULL;
+    GList *it;
+    GMainLoop *loop;
+    GError *error = NULL;
+    GovirtMockHttpd *httpd;
+    guint n_requests;
+    char *name;
+    guint i;
+
+#define RESOLVE_VM(index, host) \
+    "<vm href=\"/ovirt-engine/api/vms/uuid" index "\" id=\"uuid" index "\">" \
+    "  <name>vm" index "</name>" \
+    "  <host href=\"/ovirt-engine/api/hosts/" host "\" id=\"" host "\"/>" \
+    "  <display>" \
+    "    <type>spice</type>" \
+    "  </display>" \
+    "</vm>"
+#define RESOLVE_HOST(name) \
+    "<host href=\"/ovirt-engine/api/hosts/" name "\" id=\"" name "\">" \
+    "  <name>" name "</name>" \
+    "</host>"
+
+    httpd = govirt_mock_httpd_new(GOVIRT_HTTPS_PORT);
+    govirt_mock_httpd_add_request(httpd, "GET", "/ovirt-engine/api",
+                                  "<api><link href=\"/ovirt-engine/api/vms\" rel=\"vms\"/></api>");
+    govirt_mock_httpd_add_request(httpd, "GET", "/ovirt-engine/api/vms",
+                                  "<vms>"
+                                  RESOLVE_VM("0", "host0") RESOLVE_VM("1", "host1")
+                                  RESOLVE_VM("2", "host0") RESOLVE_VM("3", "host1")
+                                  "</vms>");
+    govirt_mock_httpd_add_request(httpd, "GET", "/ovirt-engine/api/hosts/host0",
+                                  RESOLVE_HOST("host0"));
+    govirt_mock_httpd_add_request(httpd, "GET", "/ovirt-engine/api/hosts/host1",
+                                  RESOLVE_HOST("host1"));
+    govirt_mock_httpd_start(httpd);
+
+    proxy = ovirt_proxy_new("localhost:" G_STRINGIFY(GOVIRT_HTTPS_PORT));
+    ovirt_proxy_set_mock_ca(proxy);
+    api = ovirt_proxy_fetch_api(proxy, &error);
+    g_assert_nonnull(api);
+    g_assert_no_error(error);
+    vms = ovirt_api_get_vms(api);
+    ovirt_collection_fetch(vms, proxy, &error);
+    g_assert_no_error(error);
+
+    for (i = 0; i < 4; i++) {
+        char *vm_name = g_strdup_printf("vm%u", i);
+
+        vm = ovirt_collection_lookup_resource(vms, vm_name);
+        g_assert_nonnull(vm);
+        hosts = g_list_append(hosts, ovirt_vm_get_host(OVIRT_VM(vm)));
+        g_object_unref(vm);
+        g_free(vm_name);
+    }
+
+    /* Each distinct host is only fetched once */
+    n_requests = govirt_mock_httpd_get_n_requests(httpd);
+    loop = g_main_loop_new(NULL, FALSE);
+    ovirt_proxy_resolve_resources_async(proxy, hosts, 1, NULL,
+                                        resolve_resources_cb, loop);
+    g_main_loop_run(loop);
+    g_main_loop_unref(loop);
+    g_assert_cmpuint(govirt_mock_httpd_get_n_requests(httpd), ==, n_requests + 2);
+
+    for (it = hosts, i = 0; it != NULL; it = it->next, i++) {
+        char *host_name = g_strdup_printf("host%u", i % 2);
+
+        g_object_get(G_OBJECT(it->data), "name", &name, NULL);
+        g_assert_cmpstr(name, ==, host_name);
+        g_free(name);
+        g_free(host_name);
+    }
+    g_list_free_full(hosts, g_object_unref);
+
+#undef RESOLVE_HOST
+#undef RESOLVE_VM
+
+    g_object_unref(proxy);
+
+    govirt_mock_httpd_stop(httpd);
+}
+
+static void test_govirt_identity_map(void)
+{
+    OvirtProxy *proxy;
+    OvirtApi *api;
+    OvirtCollection *vms;
+    OvirtCollection *search;
+    OvirtResource *vm;
+    OvirtResource *found;
+    OvirtHost *host;
+    GError *error = NULL;
+    GovirtMockHttpd *httpd;
+    char *name;
+    guint vms_changed = 0;
+    guint search_changed = 0;
+
+#define IDENTITY_VM(name) \
+    "<vm href=\"/ovirt-engine/api/vms/uuid0\" id=\"uuid0\">" \
+    "  <name>" name "</name>" \
+    "  <host href=\"/ovirt-engine/api/hosts/host0\" id=\"host0\"/>" \
+    "  <display>" \
+    "    <type>spice</type>" \
+    "  </display>" \
+    "</vm>"
+
+    httpd = govirt_mock_httpd_new(GOVIRT_HTTPS_PORT);
+    govirt_mock_httpd_add_request(httpd, "GET", "/ovirt-engine/api",
+                                  "<api>"
+                                  "  <link href=\"/ovirt-engine/api/vms?search={query}\" rel=\"vms/search\"/>"
+                                  "</api>");
+    govirt_mock_httpd_add_request(httpd, "GET", "/ovirt-engine/api/vms?search=name=vm*",
+                                  "<vms>" IDENTITY_VM("vm0") "</vms>");
+    govirt_mock_httpd_add_request(httpd, "GET", "/ovirt-engine/api/vms/uuid0",
+                                  IDENTITY_VM("vm0-renamed"));
+    govirt_mock_httpd_start(httpd);
+
+    proxy = ovirt_proxy_new("localhost:" G_STRINGIFY(GOVIRT_HTTPS_PORT));
+    ovirt_proxy_set_mock_ca(proxy);
+    api = ovirt_proxy_fetch_api(proxy, &error);
+    g_assert_nonnull(api);
+    g_assert_no_error(error);
+
+    /* The same remote VM is a single object in all the collections */
+    vms = ovirt_api_search_vms(api, "name=vm*");
+    ovirt_collection_fetch(vms, proxy, &error);
+    g_assert_no_error(error);
+    search = ovirt_api_search_vms(api, "name=vm*");
+    ovirt_collection_fetch(search, proxy, &error);
+    g_assert_no_error(error);
+    vm = ovirt_collection_lookup_resource_by_id(vms, "uuid0");
+    g_assert_nonnull(vm);
+    found = ovirt_collection_lookup_resource_by_id(search, "uuid0");
+    g_assert_true(found == vm);
+    g_object_unref(found);
+    found = ovirt_proxy_get_resource(proxy, OVIRT_TYPE_VM, "uuid0");
+    g_assert_true(found == vm);
+    g_object_unref(found);
+    g_assert_null(ovirt_proxy_get_resource(proxy, OVIRT_TYPE_HOST, "uuid0"));
+
+    /* Related objects are shared as well */
+    host = ovirt_vm_get_host(OVIRT_VM(vm));
+    g_assert_nonnull(host);
+    found = ovirt_proxy_get_resource(proxy, OVIRT_TYPE_HOST, "host0");
+    g_assert_true(found == OVIRT_RESOURCE(host));
+    g_object_unref(found);
+    g_object_unref(host);
+
+    /* Each collection keeps the XML description as long as one of them
+     * asks for it */
+    g_object_set(G_OBJECT(vms), "xml-retention", OVIRT_XML_RETENTION_DROP, NULL);
+    g_assert_cmpuint(ovirt_collection_get_retained_xml_size(vms), >, 0);
+    g_object_set(G_OBJECT(search), "xml-retention", OVIRT_XML_RETENTION_DROP, NULL);
+    g_assert_cmpuint(ovirt_collection_get_retained_xml_size(vms), ==, 0);
+
+    /* Refreshing it through one collection is visible in the other */
+    g_assert_true(ovirt_resource_refresh(vm, proxy, &error));
+    g_assert_no_error(error);
+    found = ovirt_collection_lookup_resource_by_id(search, "uuid0");
+    g_object_get(G_OBJECT(found), "name", &name, NULL);
+    g_assert_cmpstr(name, ==, "vm0-renamed");
+    g_free(name);
+    g_object_unref(found);
+    g_object_unref(vm);
+
+    /* Each collection reports the change the first time it sees it */
+    govirt_mock_httpd_add_request(httpd, "GET", "/ovirt-engine/api/vms?search=name=vm*",
+                                  "<vms>" IDENTITY_VM("vm0-renamed") "</vms>");
+    g_signal_connect(vms, "resource-changed",
+                     G_CALLBACK(count_resource_signal_cb), &vms_changed);
+    g_signal_connect(search, "resource-changed",
+                     G_CALLBACK(count_resource_signal_cb), &search_changed);
+    ovirt_collection_fetch(vms, proxy, &error);
+    g_assert_no_error(error);
+    ovirt_collection_fetch(search, proxy, &error);
+    g_assert_no_error(error);
+    ovirt_collection_fetch(search, proxy, &error);
+    g_assert_no_error(error);
+    g_assert_cmpuint(vms_changed, ==, 1);
+    g_assert_cmpuint(search_changed, ==, 1);
+
+    /* Resources are only weakly referenced, unless they are in the
+     * identity cache */
+    g_object_unref(search);
+    g_object_unref(vms);
+    g_assert_null(ovirt_proxy_get_resource(proxy, OVIRT_TYPE_VM, "uuid0"));
+
+    ovirt_proxy_set_identity_cache_size(proxy, 1);
+    search = ovirt_api_search_vms(api, "name=vm*");
+    ovirt_collection_fetch(search, proxy, &error);
+    g_assert_no_error(error);
+    g_object_unref(search);
+    found = ovirt_proxy_get_resource(proxy, OVIRT_TYPE_VM, "uuid0");
+    g_assert_nonnull(found);
+    g_object_unref(found);
+    ovirt_proxy_set_identity_cache_size(proxy, 0);
+    g_assert_null(ovirt_proxy_get_resource(proxy, OVIRT_TYPE_VM, "uuid0"));
+
+#undef IDENTITY_VM
+
+    g_object_unref(proxy);
+
+    govirt_mock_httpd_stop(httpd);
+}
+
+static void test_govirt_content_level(void)
+{
+    OvirtProxy *proxy;
+    OvirtApi *api;
+    OvirtCollection *vms;
+    OvirtResource *vm;
+    GError *error = NULL;
+    GovirtMockHttpd *httpd;
+    gsize n_bytes;
+    gsize summary_size;
+    gsize full_size;
+    char *name;
+
+#define CONTENT_VM(index, details) \
+    "<vm href=\"/ovirt-engine/api/vms/uuid" index "\" id=\"uuid" index "\">" \
+    "  <name>vm" index "</name>" \
+    "  <display>" \
+    "    <type>spice</type>" \
+    "  </display>" \
+    details \
+    "</vm>"
+#define CONTENT_VM_DETAILS \
+    "  <initialization>" \
+    "    <custom_script>#cloud-config\nruncmd:\n  - echo configured</custom_script>" \
+    "  </initialization>" \
+    "  <console><enabled>true</enabled></console>" \
+    "  <payloads><payload type=\"cdrom\"><files><file><name>data</name>" \
+    "    <content>payload data which is only returned on demand</content>" \
+    "  </file></files></payload></payloads>"
+
+    httpd = govirt_mock_httpd_new(GOVIRT_HTTPS_PORT);
+    govirt_mock_httpd_add_request(httpd, "GET", "/ovirt-engine/api",
+                                  "<api><link href=\"/ovirt-engine/api/vms\" rel=\"vms\"/></api>");
+    govirt_mock_httpd_add_request(httpd, "GET", "/ovirt-engine/api/vms",
+                                  "<vms>"
+                                  CONTENT_VM("0", "") CONTENT_VM("1", "")
+                                  "</vms>");
+    govirt_mock_httpd_add_request(httpd, "GET", "/ovirt-engine/api/vms?all_content=true",
+                                  "<vms>"
+                                  CONTENT_VM("0", CONTENT_VM_DETAILS)
+                                  CONTENT_VM("1", CONTENT_VM_DETAILS)
+                                  "</vms>");
+    govirt_mock_httpd_add_request(httpd, "GET", "/ovirt-engine/api/vms/uuid0?all_content=true",
+                                  CONTENT_VM("0", CONTENT_VM_DETAILS));
+    govirt_mock_httpd_start(httpd);
+
+    proxy = ovirt_proxy_new("localhost:" G_STRINGIFY(GOVIRT_HTTPS_PORT));
+    ovirt_proxy_set_mock_ca(proxy);
+    api = ovirt_proxy_fetch_api(proxy, &error);
+    g_assert_nonnull(api);
+    g_assert_no_error(error);
+
+    /* Collections only request a summary of their resources by default */
+    vms = ovirt_api_get_vms(api);
+    n_bytes = govirt_mock_httpd_get_n_bytes_sent(httpd);
+    ovirt_collection_fetch(vms, proxy, &error);
+    g_assert_no_error(error);
+    summary_size = govirt_mock_httpd_get_n_bytes_sent(httpd) - n_bytes;
+    g_assert_cmpuint(g_hash_table_size(ovirt_collection_get_resources(vms)), ==, 2);
+
+    g_object_set(G_OBJECT(vms), "content-level", OVIRT_CONTENT_LEVEL_FULL, NULL);
+    n_bytes = govirt_mock_httpd_get_n_bytes_sent(httpd);
+    ovirt_collection_fetch(vms, proxy, &error);
+    g_assert_no_error(error);
+    full_size = govirt_mock_httpd_get_n_bytes_sent(httpd) - n_bytes;
+    g_assert_cmpuint(g_hash_table_size(ovirt_collection_get_resources(vms)), ==, 2);
+    g_test_message("summary: %" G_GSIZE_FORMAT " bytes, full: %" G_GSIZE_FORMAT " bytes",
+                   summary_size, full_size);
+    g_assert_cmpuint(summary_size, <, full_size / 2);
+
+    /* Resources are refreshed with all their content by default */
+    vm = ovirt_collection_lookup_resource(vms, "vm0");
+    g_assert_nonnull(vm);
+    g_assert_true(ovirt_resource_refresh(vm, proxy, &error));
+    g_assert_no_error(error);
+    g_object_get(G_OBJECT(vm), "name", &name, NULL);
+    g_assert_cmpstr(name, ==, "vm0");
+    g_free(name);
+    g_object_unref(vm);
+
+#undef CONTENT_VM_DETAILS
+#undef CONTENT_VM
+
+    g_object_unref(proxy);
+
+    govirt_mock_httpd_stop(httpd);
+}
+
+#ifdef HAVE_JSON_GLIB
+static void test_govirt_json(void)
+{
+    OvirtProxy *proxy;
+    OvirtApi *api;
+    OvirtCollection *vms;
+    OvirtResource *vm;
+    OvirtEventSync *sync;
+    GError *error = NULL;
+    GovirtMockHttpd *httpd;
+    GMainLoop *loop;
+    char *name;
+    guint changed = 0;
+
+#define JSON_VM(index) \
+    "{\"href\": \"/ovirt-engine/api/vms/uuid" index "\", \"id\": \"uuid" index "\"," \
+    " \"name\": \"vm" index "\", \"memory\": 1073741824," \
+    " \"display\": {\"type\": \"spice\", \"port\": 5900}}"
+
+    httpd = govirt_mock_httpd_new(GOVIRT_HTTPS_PORT);
+    govirt_mock_httpd_add_request(httpd, "GET", "/ovirt-engine/api",
+                                  "{\"link\": [{\"href\": \"/ovirt-engine/api/vms\", \"rel\": \"vms\"},"
+                                  " {\"href\": \"/ovirt-engine/api/events\", \"rel\": \"events\"}]}");
+    govirt_mock_httpd_add_request(httpd, "GET", "/ovirt-engine/api/vms",
+                                  "{\"vm\": [" JSON_VM("0") ", " JSON_VM("1") "]}");
+    govirt_mock_httpd_add_request(httpd, "GET", "/ovirt-engine/api/vms/uuid0?all_content=true",
+                                  JSON_VM("0"));
+    govirt_mock_httpd_add_request(httpd, "GET", "/ovirt-engine/api/vms/uuid1",
+                                  "{\"href\": \"/ovirt-engine/api/vms/uuid1\", \"id\": \"uuid1\","
+                                  " \"name\": \"vm1-renamed\","
+                                  " \"display\": {\"type\": \"spice\", \"port\": 5900}}");
+    govirt_mock_httpd_add_event(httpd, 1,
+                                "<vm href=\"/ovirt-engine/api/vms/uuid0\" id=\"uuid0\"/>");
+    govirt_mock_httpd_start(httpd);
+
+    proxy = ovirt_proxy_new("localhost:" G_STRINGIFY(GOVIRT_HTTPS_PORT));
+    ovirt_proxy_set_mock_ca(proxy);
+    g_object_set(G_OBJECT(proxy), "wire-format", OVIRT_WIRE_FORMAT_JSON, NULL);
+    api = ovirt_proxy_fetch_api(proxy, &error);
+    g_assert_nonnull(api);
+    g_assert_no_error(error);
+
+    /* JSON responses end up in the same objects as XML ones, streaming
+     * falls back to parsing the whole document */
+    vms = ovirt_api_get_vms(api);
+    g_object_set(G_OBJECT(vms), "streaming", TRUE, NULL);
+    ovirt_collection_fetch(vms, proxy, &error);
+    g_assert_no_error(error);
+    g_assert_cmpuint(g_hash_table_size(ovirt_collection_get_resources(vms)), ==, 2);
+
+    vm = ovirt_collection_lookup_resource(vms, "vm1");
+    g_assert_nonnull(vm);
+    g_object_get(G_OBJECT(vm), "name", &name, NULL);
+    g_assert_cmpstr(name, ==, "vm1");
+    g_free(name);
+    g_object_unref(vm);
+
+    vm = ovirt_collection_lookup_resource(vms, "vm0");
+    g_assert_nonnull(vm);
+    g_assert_true(ovirt_resource_refresh(vm, proxy, &error));
+    g_assert_no_error(error);
+    g_object_get(G_OBJECT(vm), "guid", &name, NULL);
+    g_assert_cmpstr(name, ==, "uuid0");
+    g_free(name);
+    g_object_unref(vm);
+
+    /* The JSON description of a single resource, whose root element can't
+     * be guessed from its href, updates the collection it belongs to */
+    g_signal_connect(vms, "resource-changed",
+                     G_CALLBACK(count_resource_signal_cb), &changed);
+    loop = g_main_loop_new(NULL, FALSE);
+    sync = ovirt_event_sync_new(proxy);
+    ovirt_event_sync_run_async(sync, NULL, event_sync_cb, loop);
+    g_main_loop_run(loop);
+    govirt_mock_httpd_add_event(httpd, 2,
+                                "<vm href=\"/ovirt-engine/api/vms/uuid1\" id=\"uuid1\"/>");
+    ovirt_event_sync_run_async(sync, NULL, event_sync_cb, loop);
+    g_main_loop_run(loop);
+    g_assert_cmpuint(changed, ==, 1);
+    vm = ovirt_collection_lookup_resource(vms, "vm1-renamed");
+    g_assert_nonnull(vm);
+    g_object_unref(vm);
+    g_object_unref(sync);
+    g_main_loop_unref(loop);
+
+#undef JSON_VM
+
+    g_object_unref(proxy);
+
+    govirt_mock_httpd_stop(httpd);
+}
+#endif
+
+static void test_govirt_compression(void)
+{
+    OvirtProxy *proxy;
+    OvirtApi *api;
+    OvirtCollection *vms;
+    GError *error = NULL;
+    GovirtMockHttpd *httpd;
+    GString *content;
+    gsize n_bytes;
+    guint64 received_bytes;
+    guint64 decoded_bytes;
+    guint i;
+
+    content = g_string_new("<vms>");
+    for (i = 0; i < 100; i++) {
+        g_string_append_printf(content,
+                               "<vm href=\"/ovirt-engine/api/vms/uuid%u\" id=\"uuid%u\">"
+                               "  <name>vm%u</name>"
+                               "  <display>"
+                               "    <type>spice</type>"
+                               "  </display>"
+                               "</vm>", i, i, i);
+    }
+    g_string_append(content, "</vms>");
+
+    httpd = govirt_mock_httpd_new(GOVIRT_HTTPS_PORT);
+    govirt_mock_httpd_enable_compression(httpd, TRUE);
+    govirt_mock_httpd_add_request(httpd, "GET", "/ovirt-engine/api",
+                                  "<api><link href=\"/ovirt-engine/api/vms\" rel=\"vms\"/></api>");
+    govirt_mock_httpd_add_request(httpd, "GET", "/ovirt-engine/api/vms", content->str);
+    govirt_mock_httpd_start(httpd);
+
+    proxy = ovirt_proxy_new("localhost:" G_STRINGIFY(GOVIRT_HTTPS_PORT));
+    ovirt_proxy_set_mock_ca(proxy);
+    api = ovirt_proxy_fetch_api(proxy, &error);
+    g_assert_nonnull(api);
+    g_assert_no_error(error);
+
+    /* Compressed responses are decoded before being parsed, both when
+     * they are received in one go and when they are streamed */
+    vms = ovirt_api_get_vms(api);
+    n_bytes = govirt_mock_httpd_get_n_bytes_sent(httpd);
+    ovirt_collection_fetch(vms, proxy, &error);
+    g_assert_no_error(error);
+    g_assert_cmpuint(g_hash_table_size(ovirt_collection_get_resources(vms)), ==, 100);
+
+    g_object_get(G_OBJECT(proxy),
+                 "received-bytes", &received_bytes,
+                 "decoded-bytes", &decoded_bytes,
+                 NULL);
+    g_test_message("received: %" G_GUINT64_FORMAT " bytes, decoded: %" G_GUINT64_FORMAT " bytes",
+                   received_bytes, decoded_bytes);
+    g_assert_cmpuint(received_bytes, ==, govirt_mock_httpd_get_n_bytes_sent(httpd));
+    g_assert_cmpuint(govirt_mock_httpd_get_n_bytes_sent(httpd) - n_bytes, <, content->len / 4);
+    g_assert_cmpuint(received_bytes, <, decoded_bytes);
+
+    g_object_set(G_OBJECT(vms), "streaming", TRUE, NULL);
+    ovirt_collection_fetch(vms, proxy, &error);
+    g_assert_no_error(error);
+    g_assert_cmpuint(g_hash_table_size(ovirt_collection_get_resources(vms)), ==, 100);
+
+    g_string_free(content, TRUE);
+    g_object_unref(proxy);
+
+    govirt_mock_httpd_stop(httpd);
+}
+
+static void main_context_resource_signal_cb(G_GNUC_UNUSED OvirtCollection *collection,
+                                            G_GNUC_UNUSED OvirtResource *resource,
+                                            gpointer user_data)
+{
+    guint *count = user_data;
+
+    /* Resources may be built in another thread, not signalled from it */
+    g_assert_true(g_main_context_is_owner(g_main_context_default()));
+    (*count)++;
+}
+
+static void test_govirt_parse_in_thread(void)
+{
+    OvirtProxy *proxy;
+    OvirtApi *api;
+    OvirtCollection *vms;
+    OvirtResource *vm0;
+    OvirtResource *vm;
+    GMainLoop *loop;
+    GError *error = NULL;
+    GovirtMockHttpd *httpd;
+    guint added = 0;
+    char *guid;
+    char *body;
+
+    httpd = govirt_mock_httpd_new(GOVIRT_HTTPS_PORT);
+    govirt_mock_httpd_add_request(httpd, "GET", "/ovirt-engine/api",
+                                  "<api><link href=\"/ovirt-engine/api/vms\" rel=\"vms\"/></api>");
+    body = paged_vms_xml(0, 2);
+    govirt_mock_httpd_add_request(httpd, "GET", "/ovirt-engine/api/vms", body);
+    g_free(body);
+    govirt_mock_httpd_start(httpd);
+
+    proxy = ovirt_proxy_new("localhost:" G_STRINGIFY(GOVIRT_HTTPS_PORT));
+    ovirt_proxy_set_mock_ca(proxy);
+    api = ovirt_proxy_fetch_api(proxy, &error);
+    g_assert_nonnull(api);
+    g_assert_no_error(error);
+
+    vms = ovirt_api_get_vms(api);
+    g_signal_connect(vms, "resource-added",
+                     G_CALLBACK(main_context_resource_signal_cb), &added);
+    loop = g_main_loop_new(NULL, FALSE);
+    ovirt_collection_fetch_async(vms, proxy, NULL, fetch_async_cb, loop);
+    g_main_loop_run(loop);
+    g_assert_cmpuint(added, ==, 2);
+    vm0 = ovirt_collection_lookup_resource(vms, "vm0");
+    g_assert_nonnull(vm0);
+
+    /* Known resources are updated in place, only new ones are built */
+    body = paged_vms_xml(0, 3);
+    govirt_mock_httpd_add_request(httpd, "GET", "/ovirt-engine/api/vms", body);
+    g_free(body);
+    ovirt_collection_fetch_async(vms, proxy, NULL, fetch_async_cb, loop);
+    g_main_loop_run(loop);
+    g_main_loop_unref(loop);
+    g_assert_cmpuint(added, ==, 3);
+    g_assert_cmpuint(g_hash_table_size(ovirt_collection_get_resources(vms)), ==, 3);
+    vm = ovirt_collection_lookup_resource(vms, "vm0");
+    g_assert_true(vm == vm0);
+    g_object_unref(vm);
+    vm = ovirt_collection_lookup_resource(vms, "vm2");
+    g_assert_nonnull(vm);
+    g_object_get(G_OBJECT(vm), "guid", &guid, NULL);
+    g_assert_cmpstr(guid, ==, "uuid2");
+    g_free(guid);
+    g_object_unref(vm);
+
+    g_object_unref(vm0);
+    g_object_unref(proxy);
+
+    govirt_mock_httpd_stop(httpd);
+}
+
+#define GOVIRT_TEST_N_THREADS 8
+#define GOVIRT_TEST_N_ITERATIONS 20
+
+typedef struct {
+    OvirtProxy *proxy;
+    OvirtApi *api;
+} ThreadsData;
+
+static gpointer threads_fetch_thread(gpointer user_data)
+{
+    ThreadsData *data = user_data;
+    guint i;
+
+    for (i = 0; i < GOVIRT_TEST_N_ITERATIONS; i++) {
+        OvirtCollection *vms;
+        OvirtResource *vm;
+        GError *error = NULL;
+        guint64 received_bytes;
+
+        vms = ovirt_api_search_vms(data->api, "name=vm*");
+        g_assert_true(ovirt_collection_fetch(vms, data->proxy, &error));
+        g_assert_no_error(error);
+        g_assert_cmpuint(g_hash_table_size(ovirt_collection_get_resources(vms)), ==, 2);
+
+        vm = ovirt_collection_lookup_resource(vms, "vm0");
+        g_assert_nonnull(vm);
+        g_assert_true(ovirt_resource_refresh(vm, data->proxy, &error));
+        g_assert_no_error(error);
+
+        /* Synchronous requests are accounted for as well */
+        g_object_get(G_OBJECT(data->proxy), "received-bytes", &received_bytes, NULL);
+        g_assert_cmpuint(received_bytes, >, 0);
+
+        g_object_unref(vm);
+        g_object_unref(vms);
+    }
+
+    return NULL;
+}
+
+static void test_govirt_threads(void)
+{
+    ThreadsData data;
+    GThread *threads[GOVIRT_TEST_N_THREADS];
+    GError *error = NULL;
+    GovirtMockHttpd *httpd;
+    char *body;
+    guint i;
+
+    httpd = govirt_mock_httpd_new(GOVIRT_HTTPS_PORT);
+    govirt_mock_httpd_add_request(httpd, "GET", "/ovirt-engine/api",
+                                  "<api>"
+                                  "  <link href=\"/ovirt-engine/api/vms\" rel=\"vms\"/>"
+                                  "  <link href=\"/ovirt-engine/api/vms?search={query}\" rel=\"vms/search\"/>"
+                                  "</api>");
+    body = paged_vms_xml(0, 2);
+    govirt_mock_httpd_add_request(httpd, "GET", "/ovirt-engine/api/vms?search=name=vm*", body);
+    g_free(body);
+    govirt_mock_httpd_add_request(httpd, "GET", "/ovirt-engine/api/vms/uuid0",
+                                  "<vm href=\"/ovirt-engine/api/vms/uuid0\" id=\"uuid0\">"
+                                  "  <name>vm0</name>"
+                                  "</vm>");
+    govirt_mock_httpd_start(httpd);
+
+    data.proxy = ovirt_proxy_new("localhost:" G_STRINGIFY(GOVIRT_HTTPS_PORT));
+    ovirt_proxy_set_mock_ca(data.proxy);
+    data.api = ovirt_proxy_fetch_api(data.proxy, &error);
+    g_assert_nonnull(data.api);
+    g_assert_no_error(error);
+
+    /* Synchronous calls from several threads share the same proxy */
+    for (i = 0; i < GOVIRT_TEST_N_THREADS; i++) {
+        threads[i] = g_thread_new("govirt-test", threads_fetch_thread, &data);
+    }
+    for (i = 0; i < GOVIRT_TEST_N_THREADS; i++) {
+        g_thread_join(threads[i]);
+    }
+
+    g_object_unref(data.proxy);
+
+    govirt_mock_httpd_stop(httpd);
+}
+
+static void test_govirt_fetch_collections(void)
+{
+    OvirtProxy *proxy;
+    OvirtApi *api;
+    OvirtResource *resource;
+    GHashTable *errors = NULL;
+    GError *error = NULL;
+    GovirtMockHttpd *httpd;
+
+    const char *vms_body = "<vms> \
+                              <vm href=\"/ovirt-engine/api/vms/uuid0\" id=\"uuid0\"> \
+                                <name>vm0</name> \
+                                <display> \
+                                  <type>spice</type> \
+                                  <monitors>1</monitors> \
+                                </display> \
+                              </vm> \
+                            </vms>";
+    const char *hosts_body = "<hosts> \
+                                <host href=\"/ovirt-engine/api/hosts/host0\" id=\"host0\"> \
+                                  <name>host0</name> \
+                                </host> \
+                              </hosts>";
+
+    httpd = govirt_mock_httpd_new(GOVIRT_HTTPS_PORT);
+    govirt_mock_httpd_add_request(httpd, "GET", "/ovirt-engine/api",
+                                  "<api>"
+                                  "  <link href=\"/ovirt-engine/api/clusters\" rel=\"clusters\"/>"
+                                  "  <link href=\"/ovirt-engine/api/hosts\" rel=\"hosts\"/>"
+                                  "  <link href=\"/ovirt-engine/api/vms\" rel=\"vms\"/>"
+                                  "</api>");
+    govirt_mock_httpd_add_request(httpd, "GET", "/ovirt-engine/api/vms", vms_body);
+    govirt_mock_httpd_add_request(httpd, "GET", "/ovirt-engine/api/hosts", hosts_body);
+    govirt_mock_httpd_start(httpd);
+
+    proxy = ovirt_proxy_new("localhost:" G_STRINGIFY(GOVIRT_HTTPS_PORT));
+    ovirt_proxy_set_mock_ca(proxy);
+    api = ovirt_proxy_fetch_api(proxy, &error);
+    g_assert_nonnull(api);
+    g_assert_no_error(error);
+
+    /* clusters are advertised but not available */
+    ovirt_api_fetch_collections_async(api, proxy, 2, NULL,
+                                      fetch_collections_cb, &errors);
+    while (errors == NULL) {
+        g_main_context_iteration(NULL, TRUE);
+    }
+    g_assert_cmpuint(g_hash_table_size(errors), ==, 1);
+    error = g_hash_table_lookup(errors, "clusters");
+    g_assert_error(error, REST_PROXY_ERROR, 404);
+    error = NULL;
+    g_hash_table_unref(errors);
+
+    resource = ovirt_collection_lookup_resource(ovirt_api_get_vms(api), "vm0");
+    g_assert_nonnull(resource);
+    g_object_unref(resource);
+    resource = ovirt_collection_lookup_resource(ovirt_api_get_hosts(api), "host0");
+    g_assert_nonnull(resource);
+    g_object_unref(resource);
+
+    g_object_unref(proxy);
+
+    govirt_mock_httpd_stop(httpd);
+}
+
+typedef struct {
+    guint n_progress;
+    guint n_failed;
+    gboolean done;
+    gboolean success;
+    GHashTable *results;
+    GError *error;
+} BulkActionData;
+
+static void bulk_action_progress_cb(G_GNUC_UNUSED OvirtBulkAction *bulk,
+                                    G_GNUC_UNUSED OvirtResource *resource,
+                                    GError *error,
+                                    guint completed,
+                                    guint total,
+                                    gpointer user_data)
+{
+    BulkActionData *data = user_data;
+
+    data->n_progress++;
+    if (error != NULL) {
+        data->n_failed++;
+    }
+    g_assert_cmpuint(completed, ==, data->n_progress);
+    g_assert_cmpuint(total, ==, 4);
+}
+
+static void bulk_action_run_cb(GObject *source_object,
+                               GAsyncResult *result,
+                               gpointer user_data)
+{
+    BulkActionData *data = user_data;
+
+    data->success = ovirt_bulk_action_run_finish(OVIRT_BULK_ACTION(source_object),
+                                                 result, &data->results,
+                                                 &data->error);
+    data->done = TRUE;
+}
+
+static void test_govirt_bulk_action(void)
+{
+    OvirtProxy *proxy;
+    OvirtApi *api;
+    OvirtCollection *vms;
+    OvirtBulkAction *bulk;
+    OvirtResource *vm;
+    GList *resources = NULL;
+    BulkActionData data = { 0, };
+    GError *error = NULL;
+    GovirtMockHttpd *httpd;
+    guint i;
+
+    const char *vms_body = "<vms> \
+                              <vm href=\"/ovirt-engine/api/vms/uuid0\" id=\"uuid0\"> \
+                                <name>vm0</name> \
+                                <actions> \
+                                  <link href=\"/ovirt-engine/api/vms/uuid0/start\" rel=\"start\"/> \
+                                </actions> \
+                              </vm> \
+                              <vm href=\"/ovirt-engine/api/vms/uuid1\" id=\"uuid1\"> \
+                                <name>vm1</name> \
+                                <actions> \
+                                  <link href=\"/ovirt-engine/api/vms/uuid1/start\" rel=\"start\"/> \
+                                </actions> \
+                              </vm> \
+                              <vm href=\"/ovirt-engine/api/vms/uuid2\" id=\"uuid2\"> \
+                                <name>vm2</name> \
+                                <actions> \
+                                  <link href=\"/ovirt-engine/api/vms/uuid2/start\" rel=\"start\"/> \
+                                </actions> \
+                              </vm> \
+                              <vm href=\"/ovirt-engine/api/vms/uuid3\" id=\"uuid3\"> \
+                                <name>vm3</name> \
+                              </vm> \
+                            </vms>";
+
+    httpd = govirt_mock_httpd_new(GOVIRT_HTTPS_PORT);
+    govirt_mock_httpd_add_request(httpd, "GET", "/ovirt-engine/api",
+                                  "<api><link href=\"/ovirt-engine/api/vms\" rel=\"vms\"/></api>");
+    govirt_mock_httpd_add_request(httpd, "GET", "/ovirt-engine/api/vms", vms_body);
+    govirt_mock_httpd_add_request(httpd, "POST", "/ovirt-engine/api/vms/uuid0/start",
+                                  "<action><status>complete</status></action>");
+    govirt_mock_httpd_add_request(httpd, "POST", "/ovirt-engine/api/vms/uuid1/start",
+                                  "<action><status>complete</status></action>");
+    govirt_mock_httpd_start(httpd);
+
+    proxy = ovirt_proxy_new("localhost:" G_STRINGIFY(GOVIRT_HTTPS_PORT));
+    ovirt_proxy_set_mock_ca(proxy);
+    api = ovirt_proxy_fetch_api(proxy, &error);
+    g_assert_nonnull(api);
+    g_assert_no_error(error);
+
+    vms = ovirt_api_get_vms(api);
+    ovirt_collection_fetch(vms, proxy, &error);
+    g_assert_no_error(error);
+    for (i = 0; i < 4; i++) {
+        char *name = g_strdup_printf("vm%u", i);
+        resources = g_list_append(resources,
+                                  ovirt_collection_lookup_resource(vms, name));
+        g_free(name);
+    }
+
+    /* uuid2/start is not served, and vm3 has no 'start' action */
+    bulk = ovirt_bulk_action_new(proxy, "start");
+    g_object_set(G_OBJECT(bulk), "window", 2, NULL);
+    g_signal_connect(G_OBJECT(bulk), "progress",
+                     G_CALLBACK(bulk_action_progress_cb), &data);
+    ovirt_bulk_action_run_async(bulk, resources, NULL, bulk_action_run_cb, &data);
+    while (!data.done) {
+        g_main_context_iteration(NULL, TRUE);
+    }
+    g_assert_false(data.success);
+    g_assert_error(data.error, OVIRT_ERROR, OVIRT_ERROR_ACTION_FAILED);
+    g_clear_error(&data.error);
+    g_assert_cmpuint(data.n_progress, ==, 4);
+    g_assert_cmpuint(data.n_failed, ==, 2);
+    g_assert_cmpuint(g_hash_table_size(data.results), ==, 4);
+
+    vm = g_list_nth_data(resources, 0);
+    g_assert_true(g_hash_table_contains(data.results, vm));
+    g_assert_null(g_hash_table_lookup(data.results, vm));
+    vm = g_list_nth_data(resources, 2);
+    error = g_hash_table_lookup(data.results, vm);
+    g_assert_error(error, REST_PROXY_ERROR, 404);
+    vm = g_list_nth_data(resources, 3);
+    error = g_hash_table_lookup(data.results, vm);
+    g_assert_error(error, OVIRT_ERROR, OVIRT_ERROR_NOT_SUPPORTED);
+    error = NULL;
+    g_clear_pointer(&data.results, g_hash_table_unref);
+
+    /* Nothing is sent once an action failed */
+    memset(&data, 0, sizeof(data));
+    g_object_set(G_OBJECT(bulk), "window", 1, "stop-on-error", TRUE, NULL);
+    ovirt_bulk_action_run_async(bulk, g_list_nth(resources, 2), NULL,
+                                bulk_action_run_cb, &data);
+    while (!data.done) {
+        g_main_context_iteration(NULL, TRUE);
+    }
+    g_assert_false(data.success);
+    g_assert_error(data.error, OVIRT_ERROR, OVIRT_ERROR_ACTION_FAILED);
+    g_clear_error(&data.error);
+    g_assert_cmpuint(data.n_progress, ==, 1);
+    g_assert_cmpuint(g_hash_table_size(data.results), ==, 1);
+    g_clear_pointer(&data.results, g_hash_table_unref);
+
+    g_object_unref(bulk);
+    g_list_free_full(resources, g_object_unref);
+    g_object_unref(proxy);
+
+    govirt_mock_httpd_stop(httpd);
+}
+
+typedef struct {
+    OvirtJob *job;
+    gboolean done;
+    gboolean success;
+    GError *error;
+} JobData;
+
+static void submit_action_cb(GObject *source_object,
+                             GAsyncResult *result,
+                             gpointer user_data)
+{
+    JobData *data = user_data;
+
+    data->job = ovirt_resource_submit_action_finish(OVIRT_RESOURCE(source_object),
+                                                    result, &data->error);
+    data->done = TRUE;
+}
+
+static void job_wait_cb(GObject *source_object,
+                        GAsyncResult *result,
+                        gpointer user_data)
+{
+    JobData *data = user_data;
+
+    data->success = ovirt_job_wait_finish(OVIRT_JOB(source_object),
+                                          result, &data->error);
+    data->done = TRUE;
+}
+
+static void job_status_changed_cb(GObject *object,
+                                  G_GNUC_UNUSED GParamSpec *pspec,
+                                  gpointer user_data)
+{
+    GovirtMockHttpd *httpd = user_data;
+    OvirtJobStatus status;
+
+    g_object_get(object, "status", &status, NULL);
+    if (status == OVIRT_JOB_STATUS_STARTED) {
+        govirt_mock_httpd_add_request(httpd, "GET", "/ovirt-engine/api/jobs",
+                                      "<jobs>"
+                                      "  <job href=\"/ovirt-engine/api/jobs/job0\" id=\"job0\">"
+                                      "    <description>Starting vm0</description>"
+                                      "    <status>finished</status>"
+                                      "  </job>"
+                                      "</jobs>");
+    }
+}
+
+static void test_govirt_submit_action(void)
+{
+    OvirtProxy *proxy;
+    OvirtApi *api;
+    OvirtCollection *vms;
+    OvirtResource *vm0;
+    OvirtResource *vm1;
+    OvirtResource *vm2;
+    JobData data0 = { NULL, };
+    JobData data1 = { NULL, };
+    JobData data2 = { NULL, };
+    JobData data3 = { NULL, };
+    OvirtJob *job3;
+    OvirtJobStatus status;
+    GError *error = NULL;
+    GovirtMockHttpd *httpd;
+
+    const char *vms_body = "<vms> \
+                              <vm href=\"/ovirt-engine/api/vms/uuid0\" id=\"uuid0\"> \
+                                <name>vm0</name> \
+                                <actions> \
+                                  <link href=\"/ovirt-engine/api/vms/uuid0/start\" rel=\"start\"/> \
+                                </actions> \
+                              </vm> \
+                              <vm href=\"/ovirt-engine/api/vms/uuid1\" id=\"uuid1\"> \
+                                <name>vm1</name> \
+                                <actions> \
+                                  <link href=\"/ovirt-engine/api/vms/uuid1/start\" rel=\"start\"/> \
+                                </actions> \
+                              </vm> \
+                              <vm href=\"/ovirt-engine/api/vms/uuid2\" id=\"uuid2\"> \
+                                <name>vm2</name> \
+                              </vm> \
+                            </vms>";
+
+    httpd = govirt_mock_httpd_new(GOVIRT_HTTPS_PORT);
+    govirt_mock_httpd_add_request(httpd, "GET", "/ovirt-engine/api",
+                                  "<api><link href=\"/ovirt-engine/api/vms\" rel=\"vms\"/></api>");
+    govirt_mock_httpd_add_request(httpd, "GET", "/ovirt-engine/api/vms", vms_body);
+    govirt_mock_httpd_add_request(httpd, "POST", "/ovirt-engine/api/vms/uuid0/start",
+                                  "<action>"
+                                  "  <status>pending</status>"
+                                  "  <job href=\"/ovirt-engine/api/jobs/job0\" id=\"job0\"/>"
+                                  "</action>");
+    govirt_mock_httpd_add_request(httpd, "POST", "/ovirt-engine/api/vms/uuid1/start",
+                                  "<action>"
+                                  "  <status>pending</status>"
+                                  "  <job href=\"/ovirt-engine/api/jobs/job1\" id=\"job1\"/>"
+                                  "</action>");
+    govirt_mock_httpd_add_request(httpd, "GET", "/ovirt-engine/api/jobs",
+                                  "<jobs>"
+                                  "  <job href=\"/ovirt-engine/api/jobs/job0\" id=\"job0\">"
+                                  "    <description>Starting vm0</description>"
+                                  "    <status>started</status>"
+                                  "  </job>"
+                                  "  <job href=\"/ovirt-engine/api/jobs/job1\" id=\"job1\">"
+                                  "    <description>Starting vm1</description>"
+                                  "    <status>failed</status>"
+                                  "  </job>"
+                                  "</jobs>");
+    govirt_mock_httpd_start(httpd);
+
+    proxy = ovirt_proxy_new("localhost:" G_STRINGIFY(GOVIRT_HTTPS_PORT));
+    ovirt_proxy_set_mock_ca(proxy);
+    api = ovirt_proxy_fetch_api(proxy, &error);
+    g_assert_nonnull(api);
+    g_assert_no_error(error);
+
+    vms = ovirt_api_get_vms(api);
+    ovirt_collection_fetch(vms, proxy, &error);
+    g_assert_no_error(error);
+    vm0 = ovirt_collection_lookup_resource(vms, "vm0");
+    vm1 = ovirt_collection_lookup_resource(vms, "vm1");
+    vm2 = ovirt_collection_lookup_resource(vms, "vm2");
+
+    ovirt_resource_submit_action_async(vm0, proxy, "start", NULL,
+                                       submit_action_cb, &data0);
+    ovirt_resource_submit_action_async(vm1, proxy, "start", NULL,
+                                       submit_action_cb, &data1);
+    ovirt_resource_submit_action_async(vm2, proxy, "start", NULL,
+                                       submit_action_cb, &data2);
+    while (!data0.done || !data1.done || !data2.done) {
+        g_main_context_iteration(NULL, TRUE);
+    }
+    g_assert_no_error(data0.error);
+    g_assert_nonnull(data0.job);
+    g_assert_no_error(data1.error);
+    g_assert_nonnull(data1.job);
+    g_assert_error(data2.error, OVIRT_ERROR, OVIRT_ERROR_NOT_SUPPORTED);
+    g_assert_null(data2.job);
+    g_clear_error(&data2.error);
+
+    /* Both jobs are polled together, job0 finishes on the second poll */
+    g_signal_connect(G_OBJECT(data0.job), "notify::status",
+                     G_CALLBACK(job_status_changed_cb), httpd);
+    data0.done = FALSE;
+    data1.done = FALSE;
+    ovirt_job_wait_async(data0.job, proxy, NULL, job_wait_cb, &data0);
+    ovirt_job_wait_async(data1.job, proxy, NULL, job_wait_cb, &data1);
+    while (!data0.done || !data1.done) {
+        g_main_context_iteration(NULL, TRUE);
+    }
+    g_assert_true(data0.success);
+    g_assert_no_error(data0.error);
+    g_object_get(G_OBJECT(data0.job), "status", &status, NULL);
+    g_assert_cmpint(status, ==, OVIRT_JOB_STATUS_FINISHED);
+    g_assert_false(data1.success);
+    g_assert_error(data1.error, OVIRT_ERROR, OVIRT_ERROR_ACTION_FAILED);
+    g_clear_error(&data1.error);
+    g_object_get(G_OBJECT(data1.job), "status", &status, NULL);
+    g_assert_cmpint(status, ==, OVIRT_JOB_STATUS_FAILED);
+
+    /* Jobs missing from the jobs collection are refreshed on their own,
+     * and given up on when they no longer exist */
+    govirt_mock_httpd_add_request(httpd, "GET", "/ovirt-engine/api/jobs/job2",
+                                  "<job href=\"/ovirt-engine/api/jobs/job2\" id=\"job2\">"
+                                  "  <description>Stopping vm2</description>"
+                                  "  <status>finished</status>"
+                                  "</job>");
+    data2.job = ovirt_job_new();
+    g_object_set(G_OBJECT(data2.job),
+                 "href", "/ovirt-engine/api/jobs/job2",
+                 "guid", "job2",
+                 NULL);
+    job3 = ovirt_job_new();
+    g_object_set(G_OBJECT(job3),
+                 "href", "/ovirt-engine/api/jobs/job3",
+                 "guid", "job3",
+                 NULL);
+    data2.done = FALSE;
+    ovirt_job_wait_async(data2.job, proxy, NULL, job_wait_cb, &data2);
+    ovirt_job_wait_async(job3, proxy, NULL, job_wait_cb, &data3);
+    while (!data2.done || !data3.done) {
+        g_main_context_iteration(NULL, TRUE);
+    }
+    g_assert_true(data2.success);
+    g_assert_no_error(data2.error);
+    g_assert_false(data3.success);
+    g_assert_nonnull(data3.error);
+    g_clear_error(&data3.error);
+
+    g_object_unref(job3);
+    g_object_unref(data0.job);
+    g_object_unref(data1.job);
+    g_object_unref(data2.job);
+    g_object_unref(vm0);
+    g_object_unref(vm1);
+    g_object_unref(vm2);
     g_object_unref(proxy);
 
     govirt_mock_httpd_stop(httpd);
@@ -485,6 +2875,30 @@ main(int argc, char **argv)
     g_test_add_func("/govirt/test-list-duplicate-vms", test_govirt_list_duplicate_vms);
     g_test_add_func("/govirt/test-parse-vm-host-cluster", test_govirt_parse_vm_host_cluster);
     g_test_add_func("/govirt/test-404", test_govirt_http_404);
+    g_test_add_func("/govirt/test-list-vms-streaming", test_govirt_list_vms_streaming);
+    g_test_add_func("/govirt/test-list-vms-paged", test_govirt_list_vms_paged);
+    g_test_add_func("/govirt/test-list-vms-lazy", test_govirt_list_vms_lazy);
+    g_test_add_func("/govirt/test-xml-retention", test_govirt_xml_retention);
+    g_test_add_func("/govirt/test-shared-display-ca", test_govirt_shared_display_ca);
+    g_test_add_func("/govirt/test-conditional-fetch", test_govirt_conditional_fetch);
+    g_test_add_func("/govirt/test-response-cache", test_govirt_response_cache);
+    g_test_add_func("/govirt/test-response-ttl", test_govirt_response_ttl);
+    g_test_add_func("/govirt/test-shared-refresh", test_govirt_shared_refresh);
+    g_test_add_func("/govirt/test-event-sync", test_govirt_event_sync);
+    g_test_add_func("/govirt/test-follow", test_govirt_follow);
+    g_test_add_func("/govirt/test-resolve-resources", test_govirt_resolve_resources);
+    g_test_add_func("/govirt/test-identity-map", test_govirt_identity_map);
+    g_test_add_func("/govirt/test-content-level", test_govirt_content_level);
+#ifdef HAVE_JSON_GLIB
+    g_test_add_func("/govirt/test-json", test_govirt_json);
+#endif
+    g_test_add_func("/govirt/test-compression", test_govirt_compression);
+    g_test_add_func("/govirt/test-threads", test_govirt_threads);
+    g_test_add_func("/govirt/test-parse-in-thread", test_govirt_parse_in_thread);
+    g_test_add_func("/govirt/test-refresh-vms", test_govirt_refresh_vms);
+    g_test_add_func("/govirt/test-fetch-collections", test_govirt_fetch_collections);
+    g_test_add_func("/govirt/test-bulk-action", test_govirt_bulk_action);
+    g_test_add_func("/govirt/test-submit-action", test_govirt_submit_action);
 
     return g_test_run();
 }